@@ -108,6 +108,20 @@ void	zbx_gethost_by_ip(const char *ip, char *host, size_t hostlen);
 void	zbx_getip_by_host(const char *host, char *ip, size_t iplen);
 #endif
 
+/* the maximum length of numeric IPv4 or IPv6 address with terminating zero */
+#define ZBX_RESOLVE_ADDR_LEN	46
+
+/* the maximum number of addresses returned for one host name */
+#define ZBX_RESOLVE_ADDR_MAX	4
+
+/* the maximum length of comma separated address list with terminating zero */
+#define ZBX_RESOLVE_ADDRS_LEN	(ZBX_RESOLVE_ADDR_MAX * ZBX_RESOLVE_ADDR_LEN)
+
+typedef int	(*zbx_resolve_func_t)(const char *host, char *addr, size_t addr_len);
+
+void	zbx_set_resolve_func(zbx_resolve_func_t func);
+int	zbx_resolve_host(const char *host, char *addr, size_t addr_len);
+
 int	zbx_tcp_connect(zbx_socket_t *s, const char *source_ip, const char *ip, unsigned short port, int timeout,
 		unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2);
 
@@ -139,6 +153,7 @@ int	get_address_family(const char *addr, int *family, char *error, int max_error
 int	zbx_tcp_listen(zbx_socket_t *s, const char *listen_ip, unsigned short listen_port);
 
 int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept);
+int	zbx_tcp_accept_connection(zbx_socket_t *s, ZBX_SOCKET accepted_socket, unsigned int tls_accept);
 void	zbx_tcp_unaccept(zbx_socket_t *s);
 
 #define ZBX_TCP_READ_UNTIL_CLOSE 0x01
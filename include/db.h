@@ -739,6 +739,7 @@ typedef struct
 	unsigned char	state;
 	int		mtime;
 	int		lastclock;
+	int		lastns;
 	const char	*error;
 
 	zbx_uint64_t	flags;
@@ -748,6 +749,7 @@ typedef struct
 #define ZBX_FLAGS_ITEM_DIFF_UPDATE_MTIME		__UINT64_C(0x0004)
 #define ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTLOGSIZE		__UINT64_C(0x0008)
 #define ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTCLOCK		__UINT64_C(0x1000)
+#define ZBX_FLAGS_ITEM_DIFF_UPDATE_VALUE		__UINT64_C(0x2000)	/* value was added to value cache */
 #define ZBX_FLAGS_ITEM_DIFF_UPDATE_DB			\
 	(ZBX_FLAGS_ITEM_DIFF_UPDATE_STATE | ZBX_FLAGS_ITEM_DIFF_UPDATE_ERROR |\
 	ZBX_FLAGS_ITEM_DIFF_UPDATE_MTIME | ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTLOGSIZE)
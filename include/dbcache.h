@@ -35,12 +35,19 @@
 #define	ZBX_POLLER_TYPE_IPMI		2
 #define	ZBX_POLLER_TYPE_PINGER		3
 #define	ZBX_POLLER_TYPE_JAVA		4
-#define	ZBX_POLLER_TYPE_COUNT		5	/* number of poller types */
+#define	ZBX_POLLER_TYPE_HTTPAGENT	5
+#define	ZBX_POLLER_TYPE_COUNT		6	/* number of poller types */
 
-#define MAX_JAVA_ITEMS		32
+/* the number of poller queue lateness histogram buckets */
+#define ZBX_POLLER_LATENESS_BUCKETS	6
+
+#define MAX_JAVA_ITEMS		128
 #define MAX_SNMP_ITEMS		128
-#define MAX_POLLER_ITEMS	128	/* MAX(MAX_JAVA_ITEMS, MAX_SNMP_ITEMS) */
+#define MAX_CALCULATED_ITEMS	128
+#define MAX_EXTERNAL_ITEMS	32
+#define MAX_POLLER_ITEMS	128	/* MAX(MAX_JAVA_ITEMS, MAX_SNMP_ITEMS, MAX_CALCULATED_ITEMS, MAX_EXTERNAL_ITEMS) */
 #define MAX_PINGER_ITEMS	128
+#define MAX_HTTPAGENT_ITEMS	128
 
 #define ZBX_TRIGGER_DEPENDENCY_LEVELS_MAX	32
 
@@ -64,6 +71,7 @@ extern int	CONFIG_POLLER_FORKS;
 extern int	CONFIG_UNREACHABLE_POLLER_FORKS;
 extern int	CONFIG_IPMIPOLLER_FORKS;
 extern int	CONFIG_JAVAPOLLER_FORKS;
+extern int	CONFIG_HTTPAGENT_POLLER_FORKS;
 extern int	CONFIG_PINGER_FORKS;
 extern int	CONFIG_UNAVAILABLE_DELAY;
 extern int	CONFIG_UNREACHABLE_PERIOD;
@@ -177,6 +185,8 @@ typedef struct
 	int			nextcheck;
 	int			lastclock;
 	int			mtime;
+	zbx_uint64_t		value_revision;
+	zbx_timespec_t		value_ts;
 	char			trapper_hosts[ITEM_TRAPPER_HOSTS_LEN_MAX];
 	char			logtimefmt[ITEM_LOGTIMEFMT_LEN_MAX];
 	char			snmp_community_orig[ITEM_SNMP_COMMUNITY_LEN_MAX], *snmp_community;
@@ -575,6 +585,9 @@ typedef struct
 }
 zbx_config_cache_info_t;
 
+/* the number of web scenario scheduling lag histogram buckets */
+#define ZBX_HTTPTEST_LAG_BUCKETS	6
+
 typedef struct
 {
 	zbx_uint64_t	history_counter;	/* the total number of processed values */
@@ -584,6 +597,9 @@ typedef struct
 	zbx_uint64_t	history_log_counter;	/* the number of processed log values */
 	zbx_uint64_t	history_text_counter;	/* the number of processed text values */
 	zbx_uint64_t	notsupported_counter;	/* the number of processed not supported items */
+	zbx_uint64_t	functions_evaluated;	/* the number of evaluated trigger functions */
+	zbx_uint64_t	functions_cached;	/* the number of trigger functions with reused results */
+	zbx_uint64_t	httptest_lag[ZBX_HTTPTEST_LAG_BUCKETS];	/* web scenario scheduling lag histogram */
 }
 ZBX_DC_STATS;
 
@@ -634,8 +650,12 @@ void	free_database_cache(void);
 #define ZBX_STATS_HISTORY_INDEX_FREE	19
 #define ZBX_STATS_HISTORY_INDEX_PUSED	20
 #define ZBX_STATS_HISTORY_INDEX_PFREE	21
+#define ZBX_STATS_FUNCTIONS_EVALUATED	22
+#define ZBX_STATS_FUNCTIONS_CACHED	23
 void	*DCget_stats(int request);
 void	DCget_stats_all(zbx_wcache_info_t *wcache_info);
+void	zbx_dc_add_httptest_lag(const double *lags, int lags_num);
+int	zbx_dc_get_httptest_lag(const char *bucket, zbx_uint64_t *value);
 
 zbx_uint64_t	DCget_nextid(const char *table_name, int num);
 
@@ -675,6 +695,10 @@ int	DCconfig_get_interface_by_type(DC_INTERFACE *interface, zbx_uint64_t hostid,
 int	DCconfig_get_interface(DC_INTERFACE *interface, zbx_uint64_t hostid, zbx_uint64_t itemid);
 int	DCconfig_get_poller_nextcheck(unsigned char poller_type);
 int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items);
+double	DCconfig_get_poller_lock_wait(void);
+zbx_uint64_t	DCconfig_get_poller_revision(void);
+int	zbx_dc_get_poller_lateness(unsigned char poller_type, const char *bucket, zbx_uint64_t *value);
+double	zbx_dc_get_poller_lock_wait(unsigned char poller_type);
 int	DCconfig_get_ipmi_poller_items(int now, DC_ITEM *items, int items_num, int *nextcheck);
 int	DCconfig_get_snmp_interfaceids_by_addr(const char *addr, zbx_uint64_t **interfaceids);
 size_t	DCconfig_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, DC_ITEM **items);
@@ -761,6 +785,7 @@ void	DCget_status(zbx_vector_ptr_t *hosts_monitored, zbx_vector_ptr_t *hosts_not
 		zbx_vector_ptr_t *required_performance);
 
 void	DCget_expressions_by_names(zbx_vector_ptr_t *expressions, const char * const *names, int names_num);
+int	DCget_active_checks_revision(zbx_uint64_t hostid, zbx_uint64_t *revision);
 void	DCget_expressions_by_name(zbx_vector_ptr_t *expressions, const char *name);
 
 int	DCget_data_expected_from(zbx_uint64_t itemid, int *seconds);
@@ -798,7 +823,9 @@ void	zbx_dc_correlation_rules_free(zbx_correlation_rules_t *rules);
 void	zbx_dc_correlation_rules_get(zbx_correlation_rules_t *rules);
 
 void	zbx_dc_get_nested_hostgroupids(zbx_uint64_t *groupids, int groupids_num, zbx_vector_uint64_t *nested_groupids);
-void	zbx_dc_get_nested_hostgroupids_by_names(zbx_vector_str_t *groups, zbx_vector_uint64_t *nested_groupids);
+void	zbx_dc_get_nested_hostgroupids_by_names(const zbx_vector_str_t *groups, zbx_vector_uint64_t *nested_groupids);
+int	zbx_dc_get_aggregate_items(const zbx_vector_str_t *groups, const char *itemkey,
+		zbx_vector_uint64_pair_t *items);
 
 #define ZBX_HC_ITEM_STATUS_NORMAL	0
 #define ZBX_HC_ITEM_STATUS_BUSY		1
@@ -962,5 +989,7 @@ char	*zbx_dc_expand_user_macros(const char *text, zbx_uint64_t hostid);
 char	*zbx_dc_expand_user_macros_in_func_params(const char *params, zbx_uint64_t hostid);
 
 int	zbx_hc_check_proxy(zbx_uint64_t proxyid);
+void	zbx_hc_set_preprocessing_queue(zbx_uint64_t queued_num);
+zbx_uint64_t	zbx_hc_get_preprocessing_queue(void);
 
 #endif
@@ -44,6 +44,7 @@ typedef enum
 	ZBX_MUTEX_SQLITE3,
 	ZBX_MUTEX_PROCSTAT,
 	ZBX_MUTEX_PROXY_HISTORY,
+	ZBX_MUTEX_DNSCACHE,
 #ifdef HAVE_VMINFO_T_UPDATES
 	ZBX_MUTEX_KSTAT,
 #endif
@@ -60,7 +60,8 @@ void	calc_timestamp(const char *line, int *timestamp, const char *format);
 
 int	process_history_data(DC_ITEM *items, zbx_agent_value_t *values, int *errcodes, size_t values_num);
 
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error);
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, zbx_uint64_t *fingerprint,
+		char **error);
 
 int	proxy_get_history_count(void);
 
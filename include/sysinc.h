@@ -339,6 +339,10 @@
 #	include <sys/file.h>
 #endif
 
+#ifdef HAVE_SYS_INOTIFY_H
+#	include <sys/inotify.h>
+#endif
+
 #ifdef HAVE_MATH_H
 #	include <math.h>
 #endif
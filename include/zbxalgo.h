@@ -347,6 +347,25 @@ void	umul64_64(zbx_uint128_t *result, zbx_uint64_t value, zbx_uint64_t factor);
 
 unsigned int	zbx_isqrt32(unsigned int value);
 
+/* histogram with fixed bucket upper bounds, the last bucket is unbounded */
+typedef struct
+{
+	const double	*bounds;	/* buckets_num - 1 bucket upper bounds */
+	const char	*const *names;	/* buckets_num bucket names, the last one is "inf" */
+	int		buckets_num;
+}
+zbx_histogram_buckets_t;
+
+void		zbx_histogram_add(const zbx_histogram_buckets_t *buckets, zbx_uint64_t *histogram, double value);
+int		zbx_histogram_get_bucket(const zbx_histogram_buckets_t *buckets, const char *name);
+zbx_uint64_t	zbx_histogram_get_cumulative(const zbx_uint64_t *histogram, int bucket);
+
+/* number of latency histogram buckets, the last bucket counts values above 10 seconds */
+#define ZBX_LATENCY_BUCKETS	6
+
+/* latency histogram buckets with 0.001, 0.01, 0.1, 1 and 10 second bounds */
+extern const zbx_histogram_buckets_t	zbx_latency_buckets;
+
 /* expression evaluation */
 
 #define ZBX_INFINITY	(1.0 / 0.0)	/* "Positive infinity" value used as a fatal error code */
@@ -360,6 +379,56 @@ int	evaluate(double *value, const char *expression, char *error, size_t max_erro
 int	evaluate_unknown(const char *expression, double *value, char *error, size_t max_error_len);
 double	evaluate_string_to_double(const char *in);
 
+/* compiled expression operations */
+#define ZBX_EVAL_OP_VALUE	0	/* push constant value */
+#define ZBX_EVAL_OP_FUNCTION	1	/* push function value, referenced by index in functionids vector */
+#define ZBX_EVAL_OP_NEG		2
+#define ZBX_EVAL_OP_NOT		3
+#define ZBX_EVAL_OP_MUL		4
+#define ZBX_EVAL_OP_DIV		5
+#define ZBX_EVAL_OP_ADD		6
+#define ZBX_EVAL_OP_SUB		7
+#define ZBX_EVAL_OP_LT		8
+#define ZBX_EVAL_OP_LE		9
+#define ZBX_EVAL_OP_GE		10
+#define ZBX_EVAL_OP_GT		11
+#define ZBX_EVAL_OP_EQ		12
+#define ZBX_EVAL_OP_NE		13
+#define ZBX_EVAL_OP_AND		14
+#define ZBX_EVAL_OP_OR		15
+
+#define ZBX_EVAL_STACK_MAX	256
+
+typedef struct
+{
+	unsigned char	type;
+	int		index;
+	double		value;
+}
+zbx_eval_op_t;
+
+/* expression like "{12}>10 or {13}=1" compiled into postfix notation */
+typedef struct
+{
+	zbx_eval_op_t		*ops;
+	int			ops_num;
+	int			ops_alloc;
+	zbx_vector_uint64_t	functionids;
+}
+zbx_eval_code_t;
+
+typedef struct
+{
+	double	value;
+	int	unknown_idx;	/* index of 'unknown' message if value is ZBX_UNKNOWN */
+}
+zbx_eval_value_t;
+
+int	zbx_eval_compile(const char *expression, zbx_eval_code_t *code, char *error, size_t max_error_len);
+int	zbx_eval_execute(const zbx_eval_code_t *code, const zbx_eval_value_t *values, zbx_eval_value_t *result,
+		char *error, size_t max_error_len);
+void	zbx_eval_code_clear(zbx_eval_code_t *code);
+
 /* forecasting */
 
 #define ZBX_MATH_ERROR	-1.0
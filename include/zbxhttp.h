@@ -32,6 +32,9 @@ int	zbx_http_prepare_ssl(CURL *easyhandle, const char *ssl_cert_file, const char
 int	zbx_http_prepare_auth(CURL *easyhandle, unsigned char authtype, const char *username, const char *password,
 		char **error);
 char	*zbx_http_get_header(char **headers);
+
+int	zbx_http_multi_create(CURLM **multi, CURLSH **share, int max_connections, char **error);
+void	zbx_http_multi_wait(CURLM *multi, int timeout_ms);
 #endif
 
 #endif
@@ -39,6 +39,10 @@ int	send_email(const char *smtp_server, unsigned short smtp_port, const char *sm
 		unsigned char smtp_security, unsigned char smtp_verify_peer, unsigned char smtp_verify_host,
 		unsigned char smtp_authentication, const char *username, const char *password,
 		unsigned char content_type, int timeout, char *error, size_t max_error_len);
+void	zbx_smtp_pool_init(int idle_timeout);
+void	zbx_smtp_pool_destroy(void);
+void	zbx_smtp_pool_get_stats(int *connected_num, int *reused_num);
+
 int	send_sms(const char *device, const char *number, const char *message, char *error, int max_error_len);
 
 #endif
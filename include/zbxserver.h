@@ -64,7 +64,14 @@ int	substitute_simple_macros(zbx_uint64_t *actionid, const DB_EVENT *event, cons
 		zbx_uint64_t *userid, const zbx_uint64_t *hostid, const DC_HOST *dc_host, const DC_ITEM *dc_item,
 		DB_ALERT *alert, const DB_ACKNOWLEDGE *ack, char **data, int macro_type, char *error, int maxerrlen);
 
-void	evaluate_expressions(zbx_vector_ptr_t *triggers);
+typedef struct
+{
+	int	evaluated;	/* number of evaluated trigger functions */
+	int	cached;		/* number of trigger functions with reused cached results */
+}
+zbx_trigger_eval_stats_t;
+
+void	evaluate_expressions(zbx_vector_ptr_t *triggers, zbx_trigger_eval_stats_t *stats);
 
 void	zbx_format_value(char *value, size_t max_len, zbx_uint64_t valuemapid,
 		const char *units, unsigned char value_type);
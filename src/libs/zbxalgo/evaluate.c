@@ -812,3 +812,601 @@ double	evaluate_string_to_double(const char *in)
 
 	return result_double_value;
 }
+
+/******************************************************************************
+ *                                                                            *
+ *                     Expression compiler and evaluator                      *
+ *                  ---------------------------------------                   *
+ *                                                                            *
+ * Trigger expressions with function references like "{12}>10 or {13}=1"      *
+ * are compiled into postfix notation once and then evaluated with function   *
+ * values on a stack without substituting values into the expression text and *
+ * parsing it again.                                                          *
+ *                                                                            *
+ * The compiler follows the evaluate_termX() grammar, so a successfully       *
+ * compiled expression is evaluated exactly like its textual form with        *
+ * function values substituted. Expressions the compiler cannot prove to be   *
+ * equivalent are rejected and must be evaluated with evaluate().             *
+ *                                                                            *
+ ******************************************************************************/
+
+static zbx_eval_code_t	*code;		/* code being compiled             */
+static int		depth;		/* current stack depth of the code */
+
+static int	compile_term1(void);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: append operation to the code being compiled                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_op(unsigned char type, int index, double value)
+{
+	zbx_eval_op_t	*op;
+
+	if (ZBX_EVAL_OP_VALUE == type || ZBX_EVAL_OP_FUNCTION == type)
+	{
+		if (ZBX_EVAL_STACK_MAX == depth)
+		{
+			zbx_strlcpy(buffer, "Cannot compile expression: expression is too complex.", max_buffer_len);
+			return FAIL;
+		}
+
+		depth++;
+	}
+	else if (ZBX_EVAL_OP_NEG != type && ZBX_EVAL_OP_NOT != type)
+		depth--;
+
+	if (code->ops_num == code->ops_alloc)
+	{
+		code->ops_alloc = (0 == code->ops_alloc ? 16 : code->ops_alloc * 2);
+		code->ops = (zbx_eval_op_t *)zbx_realloc(code->ops, sizeof(zbx_eval_op_t) * (size_t)code->ops_alloc);
+	}
+
+	op = &code->ops[code->ops_num++];
+	op->type = type;
+	op->index = index;
+	op->value = value;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile a suffixed number like "12.345K" or a function reference  *
+ *          like "{12}"                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_number(void)
+{
+	int		len, index;
+	double		value;
+	zbx_uint64_t	functionid;
+
+	if ('{' == *ptr)
+	{
+		for (len = 1; 0 != isdigit((unsigned char)ptr[len]); len++)
+			;
+
+		/* the substituted function value is followed by the same character as function reference */
+		if (1 == len || '}' != ptr[len] || SUCCEED != is_number_delimiter(ptr[len + 1]) ||
+				SUCCEED != is_uint64_n(ptr + 1, (size_t)len - 1, &functionid))
+		{
+			return FAIL;
+		}
+
+		if (FAIL == (index = zbx_vector_uint64_search(&code->functionids, functionid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+		{
+			index = code->functionids.values_num;
+			zbx_vector_uint64_append(&code->functionids, functionid);
+		}
+
+		ptr += len + 1;
+
+		return compile_op(ZBX_EVAL_OP_FUNCTION, index, 0);
+	}
+
+	if (SUCCEED != zbx_suffixed_number_parse(ptr, &len) || SUCCEED != is_number_delimiter(*(ptr + len)))
+		return FAIL;
+
+	value = atof(ptr) * suffix2factor(*(ptr + len - 1));
+
+	if (ZBX_INFINITY == value || ZBX_UNKNOWN == value)
+		return FAIL;
+
+	ptr += len;
+
+	return compile_op(ZBX_EVAL_OP_VALUE, 0, value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile a number, a function reference or a parenthesized         *
+ *          expression                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term9(void)
+{
+	while (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr)
+		ptr++;
+
+	if ('\0' == *ptr)
+	{
+		zbx_strlcpy(buffer, "Cannot compile expression: unexpected end of expression.", max_buffer_len);
+		return FAIL;
+	}
+
+	if ('(' == *ptr)
+	{
+		ptr++;
+
+		if (SUCCEED != compile_term1())
+			return FAIL;
+
+		if (')' != *ptr)
+		{
+			zbx_snprintf(buffer, max_buffer_len, "Cannot compile expression:"
+					" expected closing parenthesis at \"%s\".", ptr);
+			return FAIL;
+		}
+
+		ptr++;
+	}
+	else if (SUCCEED != compile_number())
+	{
+		zbx_snprintf(buffer, max_buffer_len, "Cannot compile expression: expected numeric token at \"%s\".",
+				ptr);
+		return FAIL;
+	}
+
+	while ('\0' != *ptr && (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr))
+		ptr++;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "-" (unary)                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term8(void)
+{
+	while (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr)
+		ptr++;
+
+	if ('-' == *ptr)
+	{
+		ptr++;
+
+		if (SUCCEED != compile_term9())
+			return FAIL;
+
+		return compile_op(ZBX_EVAL_OP_NEG, 0, 0);
+	}
+
+	return compile_term9();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "not"                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term7(void)
+{
+	while (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr)
+		ptr++;
+
+	if ('n' == ptr[0] && 'o' == ptr[1] && 't' == ptr[2] && SUCCEED == is_operator_delimiter(ptr[3]))
+	{
+		ptr += 3;
+
+		if (SUCCEED != compile_term8())
+			return FAIL;
+
+		return compile_op(ZBX_EVAL_OP_NOT, 0, 0);
+	}
+
+	return compile_term8();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "*" and "/"                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term6(void)
+{
+	unsigned char	type;
+
+	if (SUCCEED != compile_term7())
+		return FAIL;
+
+	while ('*' == *ptr || '/' == *ptr)
+	{
+		type = ('*' == *ptr++ ? ZBX_EVAL_OP_MUL : ZBX_EVAL_OP_DIV);
+
+		if (SUCCEED != compile_term7() || SUCCEED != compile_op(type, 0, 0))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "+" and "-"                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term5(void)
+{
+	unsigned char	type;
+
+	if (SUCCEED != compile_term6())
+		return FAIL;
+
+	while ('+' == *ptr || '-' == *ptr)
+	{
+		type = ('+' == *ptr++ ? ZBX_EVAL_OP_ADD : ZBX_EVAL_OP_SUB);
+
+		if (SUCCEED != compile_term6() || SUCCEED != compile_op(type, 0, 0))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "<", "<=", ">=", ">"                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term4(void)
+{
+	unsigned char	type;
+
+	if (SUCCEED != compile_term5())
+		return FAIL;
+
+	while (1)
+	{
+		if ('<' == ptr[0] && '=' == ptr[1])
+		{
+			type = ZBX_EVAL_OP_LE;
+			ptr += 2;
+		}
+		else if ('>' == ptr[0] && '=' == ptr[1])
+		{
+			type = ZBX_EVAL_OP_GE;
+			ptr += 2;
+		}
+		else if ('<' == ptr[0] && '>' != ptr[1])
+		{
+			type = ZBX_EVAL_OP_LT;
+			ptr++;
+		}
+		else if ('>' == ptr[0])
+		{
+			type = ZBX_EVAL_OP_GT;
+			ptr++;
+		}
+		else
+			break;
+
+		if (SUCCEED != compile_term5() || SUCCEED != compile_op(type, 0, 0))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "=" and "<>"                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term3(void)
+{
+	unsigned char	type;
+
+	if (SUCCEED != compile_term4())
+		return FAIL;
+
+	while (1)
+	{
+		if ('=' == *ptr)
+		{
+			type = ZBX_EVAL_OP_EQ;
+			ptr++;
+		}
+		else if ('<' == ptr[0] && '>' == ptr[1])
+		{
+			type = ZBX_EVAL_OP_NE;
+			ptr += 2;
+		}
+		else
+			break;
+
+		if (SUCCEED != compile_term4() || SUCCEED != compile_op(type, 0, 0))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "and"                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term2(void)
+{
+	if (SUCCEED != compile_term3())
+		return FAIL;
+
+	while ('a' == ptr[0] && 'n' == ptr[1] && 'd' == ptr[2] && SUCCEED == is_operator_delimiter(ptr[3]))
+	{
+		ptr += 3;
+
+		if (SUCCEED != compile_term3() || SUCCEED != compile_op(ZBX_EVAL_OP_AND, 0, 0))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "or"                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term1(void)
+{
+	level++;
+
+	if (32 < level)
+	{
+		zbx_strlcpy(buffer, "Cannot compile expression: nesting level is too deep.", max_buffer_len);
+		return FAIL;
+	}
+
+	if (SUCCEED != compile_term2())
+		return FAIL;
+
+	while ('o' == ptr[0] && 'r' == ptr[1] && SUCCEED == is_operator_delimiter(ptr[2]))
+	{
+		ptr += 2;
+
+		if (SUCCEED != compile_term2() || SUCCEED != compile_op(ZBX_EVAL_OP_OR, 0, 0))
+			return FAIL;
+	}
+
+	level--;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile an expression like "({12}>10) or ({13}=1)"                *
+ *                                                                            *
+ * Parameters: expression    - [IN] the expression to compile                 *
+ *             code          - [OUT] the compiled expression                  *
+ *             error         - [OUT] the error message buffer                 *
+ *             max_error_len - [IN] the error buffer size                     *
+ *                                                                            *
+ * Return value: SUCCEED - the expression was compiled successfully           *
+ *               FAIL    - the expression cannot be compiled and must be      *
+ *                         evaluated with evaluate() after function values    *
+ *                         are substituted                                    *
+ *                                                                            *
+ * Comments: The compiled code must be freed with zbx_eval_code_clear() also  *
+ *           when the compilation fails.                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_eval_compile(const char *expression, zbx_eval_code_t *eval_code, char *error, size_t max_error_len)
+{
+	int	ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() expression:'%s'", __func__, expression);
+
+	eval_code->ops = NULL;
+	eval_code->ops_num = 0;
+	eval_code->ops_alloc = 0;
+	zbx_vector_uint64_create(&eval_code->functionids);
+
+	ptr = expression;
+	level = 0;
+	depth = 0;
+	code = eval_code;
+
+	buffer = error;
+	max_buffer_len = max_error_len;
+
+	if (SUCCEED == (ret = compile_term1()) && '\0' != *ptr)
+	{
+		zbx_snprintf(error, max_error_len, "Cannot compile expression: unexpected token at \"%s\".", ptr);
+		ret = FAIL;
+	}
+
+	code = NULL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s ops:%d", __func__, zbx_result_string(ret), eval_code->ops_num);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: evaluate a compiled expression                                    *
+ *                                                                            *
+ * Parameters: code          - [IN] the compiled expression                   *
+ *             values        - [IN] the function values, indexed as           *
+ *                                  code->functionids                         *
+ *             result        - [OUT] the evaluation result, can be            *
+ *                                   ZBX_UNKNOWN                              *
+ *             error         - [OUT] the error message buffer                 *
+ *             max_error_len - [IN] the error buffer size                     *
+ *                                                                            *
+ * Return value: SUCCEED      - the expression was evaluated successfully     *
+ *               FAIL         - the expression evaluation failed              *
+ *               NOTSUPPORTED - an intermediate result overflowed, the        *
+ *                              expression must be evaluated with evaluate()  *
+ *                                                                            *
+ * Comments: Unknown values are handled as described for evaluate_termX()     *
+ *           functions. The evaluate_termX() functions use infinities as      *
+ *           error and unknown codes, so an intermediate result overflowing   *
+ *           to positive infinity fails with undefined error message and one  *
+ *           overflowing to negative infinity is treated as unknown. Instead  *
+ *           of reproducing that the compiled evaluation gives up, so that    *
+ *           the result is exactly the same as evaluate() would return.       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_eval_execute(const zbx_eval_code_t *eval_code, const zbx_eval_value_t *values, zbx_eval_value_t *result,
+		char *error, size_t max_error_len)
+{
+	zbx_eval_value_t	stack[ZBX_EVAL_STACK_MAX], *left, *right;
+	const zbx_eval_op_t	*op;
+	int			i, top = 0;
+
+	for (i = 0; i < eval_code->ops_num; i++)
+	{
+		op = &eval_code->ops[i];
+
+		switch (op->type)
+		{
+			case ZBX_EVAL_OP_VALUE:
+				stack[top].value = op->value;
+				stack[top++].unknown_idx = -1;
+				continue;
+			case ZBX_EVAL_OP_FUNCTION:
+				stack[top++] = values[op->index];
+				continue;
+			case ZBX_EVAL_OP_NEG:
+				if (ZBX_UNKNOWN != stack[top - 1].value)
+					stack[top - 1].value = -stack[top - 1].value;
+				continue;
+			case ZBX_EVAL_OP_NOT:
+				if (ZBX_UNKNOWN != stack[top - 1].value)
+				{
+					stack[top - 1].value = (SUCCEED == zbx_double_compare(stack[top - 1].value, 0.0) ?
+							1.0 : 0.0);
+				}
+				continue;
+		}
+
+		right = &stack[--top];
+		left = &stack[top - 1];
+
+		/* catch division by 0 even if 1st operand is Unknown */
+		if (ZBX_EVAL_OP_DIV == op->type && ZBX_UNKNOWN != right->value &&
+				SUCCEED == zbx_double_compare(right->value, 0.0))
+		{
+			zbx_strlcpy(error, "Cannot evaluate expression: division by zero.", max_error_len);
+			return FAIL;
+		}
+
+		if (ZBX_EVAL_OP_AND == op->type && (ZBX_UNKNOWN == left->value || ZBX_UNKNOWN == right->value))
+		{
+			/* 0 and Unknown, Unknown and 0 */
+			if ((ZBX_UNKNOWN != left->value && SUCCEED == zbx_double_compare(left->value, 0.0)) ||
+					(ZBX_UNKNOWN != right->value && SUCCEED == zbx_double_compare(right->value, 0.0)))
+			{
+				left->value = 0.0;
+			}
+			else if (ZBX_UNKNOWN == right->value)
+				*left = *right;
+
+			continue;
+		}
+
+		if (ZBX_EVAL_OP_OR == op->type && (ZBX_UNKNOWN == left->value || ZBX_UNKNOWN == right->value))
+		{
+			/* 1 or Unknown, Unknown or 1 */
+			if ((ZBX_UNKNOWN != left->value && SUCCEED != zbx_double_compare(left->value, 0.0)) ||
+					(ZBX_UNKNOWN != right->value && SUCCEED != zbx_double_compare(right->value, 0.0)))
+			{
+				left->value = 1.0;
+			}
+			else if (ZBX_UNKNOWN == right->value)
+				*left = *right;
+
+			continue;
+		}
+
+		if (ZBX_UNKNOWN == right->value)	/* (anything) op Unknown */
+		{
+			*left = *right;
+			continue;
+		}
+
+		if (ZBX_UNKNOWN == left->value)		/* Unknown op known */
+			continue;
+
+		switch (op->type)
+		{
+			case ZBX_EVAL_OP_MUL:
+				left->value *= right->value;
+				break;
+			case ZBX_EVAL_OP_DIV:
+				left->value /= right->value;
+				break;
+			case ZBX_EVAL_OP_ADD:
+				left->value += right->value;
+				break;
+			case ZBX_EVAL_OP_SUB:
+				left->value -= right->value;
+				break;
+			case ZBX_EVAL_OP_LT:
+				left->value = (left->value < right->value - ZBX_DOUBLE_EPSILON);
+				break;
+			case ZBX_EVAL_OP_LE:
+				left->value = (left->value <= right->value + ZBX_DOUBLE_EPSILON);
+				break;
+			case ZBX_EVAL_OP_GE:
+				left->value = (left->value >= right->value - ZBX_DOUBLE_EPSILON);
+				break;
+			case ZBX_EVAL_OP_GT:
+				left->value = (left->value > right->value + ZBX_DOUBLE_EPSILON);
+				break;
+			case ZBX_EVAL_OP_EQ:
+				left->value = (SUCCEED == zbx_double_compare(left->value, right->value));
+				break;
+			case ZBX_EVAL_OP_NE:
+				left->value = (SUCCEED != zbx_double_compare(left->value, right->value));
+				break;
+			case ZBX_EVAL_OP_AND:
+				left->value = (SUCCEED != zbx_double_compare(left->value, 0.0) &&
+						SUCCEED != zbx_double_compare(right->value, 0.0));
+				break;
+			case ZBX_EVAL_OP_OR:
+				left->value = (SUCCEED != zbx_double_compare(left->value, 0.0) ||
+						SUCCEED != zbx_double_compare(right->value, 0.0));
+				break;
+			default:
+				THIS_SHOULD_NEVER_HAPPEN;
+				zbx_strlcpy(error, "Cannot evaluate expression: invalid operation.", max_error_len);
+				return FAIL;
+		}
+
+		if (ZBX_INFINITY == left->value || ZBX_UNKNOWN == left->value)
+			return NOTSUPPORTED;
+	}
+
+	*result = stack[0];
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free resources allocated by compiled expression                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_eval_code_clear(zbx_eval_code_t *eval_code)
+{
+	zbx_free(eval_code->ops);
+	zbx_vector_uint64_destroy(&eval_code->functionids);
+}
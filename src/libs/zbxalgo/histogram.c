@@ -0,0 +1,92 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "zbxalgo.h"
+
+static const double	latency_bounds[ZBX_LATENCY_BUCKETS - 1] = {0.001, 0.01, 0.1, 1, 10};
+static const char	*const latency_names[ZBX_LATENCY_BUCKETS] = {"0.001", "0.01", "0.1", "1", "10", "inf"};
+
+const zbx_histogram_buckets_t	zbx_latency_buckets = {latency_bounds, latency_names, ZBX_LATENCY_BUCKETS};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds value to histogram                                           *
+ *                                                                            *
+ * Parameters: buckets   - [IN] the histogram buckets                         *
+ *             histogram - [IN/OUT] the non-cumulative bucket counters        *
+ *             value     - [IN] the value to add                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_histogram_add(const zbx_histogram_buckets_t *buckets, zbx_uint64_t *histogram, double value)
+{
+	int	i;
+
+	for (i = 0; i < buckets->buckets_num - 1; i++)
+	{
+		if (value <= buckets->bounds[i])
+			break;
+	}
+
+	histogram[i]++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns histogram bucket by its upper bound name                  *
+ *                                                                            *
+ * Parameters: buckets - [IN] the histogram buckets                           *
+ *             name    - [IN] the bucket upper bound name                     *
+ *                                                                            *
+ * Return value: the bucket index or FAIL if the name is not valid            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_histogram_get_bucket(const zbx_histogram_buckets_t *buckets, const char *name)
+{
+	int	i;
+
+	for (i = 0; i < buckets->buckets_num; i++)
+	{
+		if (0 == strcmp(name, buckets->names[i]))
+			return i;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the number of values up to the specified bucket bound     *
+ *                                                                            *
+ * Parameters: histogram - [IN] the non-cumulative bucket counters            *
+ *             bucket    - [IN] the bucket index                              *
+ *                                                                            *
+ * Return value: the cumulative number of values                              *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_histogram_get_cumulative(const zbx_uint64_t *histogram, int bucket)
+{
+	zbx_uint64_t	value = 0;
+	int		i;
+
+	for (i = 0; i <= bucket; i++)
+		value += histogram[i];
+
+	return value;
+}
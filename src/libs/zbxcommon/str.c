@@ -1238,6 +1238,14 @@ const char	*get_process_type_string(unsigned char proc_type)
 			return "lld worker";
 		case ZBX_PROCESS_TYPE_ALERTSYNCER:
 			return "alert syncer";
+		case ZBX_PROCESS_TYPE_TRAPPERMAN:
+			return "trapper manager";
+		case ZBX_PROCESS_TYPE_ESCALATIONMAN:
+			return "escalation manager";
+		case ZBX_PROCESS_TYPE_HTTPAGENTPOLLER:
+			return "http agent poller";
+		case ZBX_PROCESS_TYPE_DNSRESOLVER:
+			return "dns resolver";
 	}
 
 	THIS_SHOULD_NEVER_HAPPEN;
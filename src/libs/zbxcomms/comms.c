@@ -64,6 +64,8 @@ extern int	CONFIG_TCP_MAX_BACKLOG_SIZE;
 
 static char	zbx_socket_strerror_message[ZBX_SOCKET_STRERROR_LEN];
 
+static zbx_resolve_func_t	resolve_func = NULL;
+
 const char	*zbx_socket_strerror(void)
 {
 	zbx_socket_strerror_message[ZBX_SOCKET_STRERROR_LEN - 1] = '\0';	/* force null termination */
@@ -465,6 +467,41 @@ static int	zbx_socket_connect(zbx_socket_t *s, const struct sockaddr *addr, sock
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets function used to resolve host names of outgoing connections  *
+ *                                                                            *
+ * Parameters: func - [IN] the resolver function, NULL to use getaddrinfo()   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_set_resolve_func(zbx_resolve_func_t func)
+{
+	resolve_func = func;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolves host name with the configured resolver function          *
+ *                                                                            *
+ * Parameters: host     - [IN] the host name                                  *
+ *             addr     - [OUT] the comma separated list of numeric addresses *
+ *             addr_len - [IN] the size of address buffer                     *
+ *                                                                            *
+ * Return value: SUCCEED      - the host name was resolved                    *
+ *               FAIL         - the host name cannot be resolved              *
+ *               NOTSUPPORTED - no resolver function is set or the host is    *
+ *                              already an IP address, the caller must        *
+ *                              resolve it by itself                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_resolve_host(const char *host, char *addr, size_t addr_len)
+{
+	if (NULL == resolve_func || NULL == host || '\0' == *host || SUCCEED == is_ip(host))
+		return NOTSUPPORTED;
+
+	return resolve_func(host, addr, addr_len);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: connect the socket of the specified type to external host         *
@@ -484,7 +521,8 @@ static int	zbx_socket_create(zbx_socket_t *s, int type, const char *source_ip, c
 	int		ret = FAIL;
 	struct addrinfo	*ai = NULL, hints;
 	struct addrinfo	*ai_bind = NULL;
-	char		service[8], *error = NULL;
+	char		service[8], *error = NULL, resolved[ZBX_RESOLVE_ADDRS_LEN], *next;
+	const char	*addr = ip;
 	void		(*func_socket_close)(zbx_socket_t *s);
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	const char	*server_name = NULL;
@@ -516,57 +554,89 @@ static int	zbx_socket_create(zbx_socket_t *s, int type, const char *source_ip, c
 	hints.ai_family = PF_UNSPEC;
 	hints.ai_socktype = type;
 
-	if (0 != getaddrinfo(ip, service, &hints, &ai))
-	{
-		zbx_set_socket_strerror("cannot resolve [%s]", ip);
-		goto out;
-	}
-
-	if (ZBX_SOCKET_ERROR == (s->socket = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol)))
+	switch (zbx_resolve_host(ip, resolved, sizeof(resolved)))
 	{
-		zbx_set_socket_strerror("cannot create socket [[%s]:%hu]: %s",
-				ip, port, strerror_from_system(zbx_socket_last_error()));
-		goto out;
+		case SUCCEED:
+			hints.ai_flags = AI_NUMERICHOST;
+			addr = resolved;
+			break;
+		case FAIL:
+			zbx_set_socket_strerror("cannot resolve [%s]", ip);
+			goto out;
 	}
 
-#if !defined(_WINDOWS) && !SOCK_CLOEXEC
-	if (-1 == fcntl(s->socket, F_SETFD, FD_CLOEXEC))
-	{
-		zbx_set_socket_strerror("failed to set the FD_CLOEXEC file descriptor flag on socket [[%s]:%hu]: %s",
-				ip, port, strerror_from_system(zbx_socket_last_error()));
-	}
-#endif
 	func_socket_close = (SOCK_STREAM == type ? zbx_tcp_close : zbx_udp_close);
 
 	if (NULL != source_ip)
 	{
-		memset(&hints, 0x00, sizeof(struct addrinfo));
+		struct addrinfo	hints_bind;
 
-		hints.ai_family = PF_UNSPEC;
-		hints.ai_socktype = type;
-		hints.ai_flags = AI_NUMERICHOST;
+		memset(&hints_bind, 0x00, sizeof(struct addrinfo));
 
-		if (0 != getaddrinfo(source_ip, NULL, &hints, &ai_bind))
+		hints_bind.ai_family = PF_UNSPEC;
+		hints_bind.ai_socktype = type;
+		hints_bind.ai_flags = AI_NUMERICHOST;
+
+		if (0 != getaddrinfo(source_ip, NULL, &hints_bind, &ai_bind))
 		{
 			zbx_set_socket_strerror("invalid source IP address [%s]", source_ip);
-			func_socket_close(s);
+			goto out;
+		}
+	}
+
+	/* cached host name can have several addresses, the next one is tried if connection fails */
+	for (;; addr = next)
+	{
+		if (AI_NUMERICHOST == hints.ai_flags && NULL != (next = strchr(addr, ',')))
+			*next++ = '\0';
+		else
+			next = NULL;
+
+		if (NULL != ai)
+		{
+			freeaddrinfo(ai);
+			ai = NULL;
+		}
+
+		if (0 != getaddrinfo(addr, service, &hints, &ai))
+		{
+			zbx_set_socket_strerror("cannot resolve [%s]", ip);
 			goto out;
 		}
 
-		if (ZBX_PROTO_ERROR == zbx_bind(s->socket, ai_bind->ai_addr, ai_bind->ai_addrlen))
+		if (ZBX_SOCKET_ERROR == (s->socket = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+				ai->ai_protocol)))
+		{
+			zbx_set_socket_strerror("cannot create socket [[%s]:%hu]: %s",
+					ip, port, strerror_from_system(zbx_socket_last_error()));
+			goto out;
+		}
+
+#if !defined(_WINDOWS) && !SOCK_CLOEXEC
+		if (-1 == fcntl(s->socket, F_SETFD, FD_CLOEXEC))
+		{
+			zbx_set_socket_strerror("failed to set the FD_CLOEXEC file descriptor flag on socket"
+					" [[%s]:%hu]: %s", ip, port, strerror_from_system(zbx_socket_last_error()));
+		}
+#endif
+		if (NULL != ai_bind && ZBX_PROTO_ERROR == zbx_bind(s->socket, ai_bind->ai_addr, ai_bind->ai_addrlen))
 		{
 			zbx_set_socket_strerror("bind() failed: %s", strerror_from_system(zbx_socket_last_error()));
 			func_socket_close(s);
 			goto out;
 		}
-	}
 
-	if (SUCCEED != zbx_socket_connect(s, ai->ai_addr, (socklen_t)ai->ai_addrlen, timeout, &error))
-	{
+		if (SUCCEED == zbx_socket_connect(s, ai->ai_addr, (socklen_t)ai->ai_addrlen, timeout, &error))
+			break;
+
 		func_socket_close(s);
 		zbx_set_socket_strerror("cannot connect to [[%s]:%hu]: %s", ip, port, error);
 		zbx_free(error);
-		goto out;
+
+		if (NULL == next || SUCCEED == zbx_alarm_timed_out())
+			goto out;
+
+		zbx_socket_clean(s);
 	}
 
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
@@ -605,7 +675,8 @@ static int	zbx_socket_create(zbx_socket_t *s, int type, const char *source_ip, c
 {
 	ZBX_SOCKADDR	servaddr_in;
 	struct addrinfo	hints, *ai;
-	char		*error = NULL;
+	char		*error = NULL, resolved[ZBX_RESOLVE_ADDRS_LEN], *next;
+	const char	*addr = ip;
 	void		(*func_socket_close)(zbx_socket_t *s);
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	const char	*server_name = NULL;
@@ -635,69 +706,97 @@ static int	zbx_socket_create(zbx_socket_t *s, int type, const char *source_ip, c
 	hints.ai_family = AF_INET;
 	hints.ai_socktype = type;
 
-	if (0 != getaddrinfo(ip, NULL, &hints, &ai))
+	switch (zbx_resolve_host(ip, resolved, sizeof(resolved)))
 	{
+		case SUCCEED:
+			hints.ai_flags = AI_NUMERICHOST;
+			addr = resolved;
+			break;
+		case FAIL:
+			zbx_set_socket_strerror("cannot resolve [%s]", ip);
+			return FAIL;
+	}
+
+	func_socket_close = (SOCK_STREAM == type ? zbx_tcp_close : zbx_udp_close);
+
+	/* cached host name can have several addresses, the next one is tried if connection fails */
+	for (;; addr = next)
+	{
+		if (AI_NUMERICHOST == hints.ai_flags && NULL != (next = strchr(addr, ',')))
+			*next++ = '\0';
+		else
+			next = NULL;
+
+		if (0 != getaddrinfo(addr, NULL, &hints, &ai))
+		{
 #ifdef _WINDOWS
-		zbx_set_socket_strerror("getaddrinfo() failed for '%s': %s",
-				ip, strerror_from_system(WSAGetLastError()));
+			zbx_set_socket_strerror("getaddrinfo() failed for '%s': %s",
+					ip, strerror_from_system(WSAGetLastError()));
 #else
 #ifdef HAVE_HSTRERROR
-		zbx_set_socket_strerror("getaddrinfo() failed for '%s': [%d] %s",
-				ip, h_errno, hstrerror(h_errno));
+			zbx_set_socket_strerror("getaddrinfo() failed for '%s': [%d] %s",
+					ip, h_errno, hstrerror(h_errno));
 #else
-		zbx_set_socket_strerror("getaddrinfo() failed for '%s': [%d]",
-				ip, h_errno);
+			zbx_set_socket_strerror("getaddrinfo() failed for '%s': [%d]",
+					ip, h_errno);
 #endif
 #endif
-		return FAIL;
-	}
+			return FAIL;
+		}
 
-	servaddr_in.sin_family = AF_INET;
-	servaddr_in.sin_addr = ((struct sockaddr_in *)ai->ai_addr)->sin_addr;
-	servaddr_in.sin_port = htons(port);
+		servaddr_in.sin_family = AF_INET;
+		servaddr_in.sin_addr = ((struct sockaddr_in *)ai->ai_addr)->sin_addr;
+		servaddr_in.sin_port = htons(port);
 
-	freeaddrinfo(ai);
+		freeaddrinfo(ai);
 
-	if (ZBX_SOCKET_ERROR == (s->socket = socket(AF_INET, type | SOCK_CLOEXEC, 0)))
-	{
-		zbx_set_socket_strerror("cannot create socket [[%s]:%hu]: %s",
-				ip, port, strerror_from_system(zbx_socket_last_error()));
-		return FAIL;
-	}
+		if (ZBX_SOCKET_ERROR == (s->socket = socket(AF_INET, type | SOCK_CLOEXEC, 0)))
+		{
+			zbx_set_socket_strerror("cannot create socket [[%s]:%hu]: %s",
+					ip, port, strerror_from_system(zbx_socket_last_error()));
+			return FAIL;
+		}
 
 #if !defined(_WINDOWS) && !SOCK_CLOEXEC
-	if (-1 == fcntl(s->socket, F_SETFD, FD_CLOEXEC))
-	{
-		zbx_set_socket_strerror("failed to set the FD_CLOEXEC file descriptor flag on socket [[%s]:%hu]: %s",
-				ip, port, strerror_from_system(zbx_socket_last_error()));
-	}
+		if (-1 == fcntl(s->socket, F_SETFD, FD_CLOEXEC))
+		{
+			zbx_set_socket_strerror("failed to set the FD_CLOEXEC file descriptor flag on socket"
+					" [[%s]:%hu]: %s", ip, port, strerror_from_system(zbx_socket_last_error()));
+		}
 #endif
-	func_socket_close = (SOCK_STREAM == type ? zbx_tcp_close : zbx_udp_close);
+		if (NULL != source_ip)
+		{
+			ZBX_SOCKADDR	source_addr;
 
-	if (NULL != source_ip)
-	{
-		ZBX_SOCKADDR	source_addr;
+			memset(&source_addr, 0, sizeof(source_addr));
 
-		memset(&source_addr, 0, sizeof(source_addr));
+			source_addr.sin_family = AF_INET;
+			source_addr.sin_addr.s_addr = inet_addr(source_ip);
+			source_addr.sin_port = 0;
 
-		source_addr.sin_family = AF_INET;
-		source_addr.sin_addr.s_addr = inet_addr(source_ip);
-		source_addr.sin_port = 0;
+			if (ZBX_PROTO_ERROR == bind(s->socket, (struct sockaddr *)&source_addr, sizeof(source_addr)))
+			{
+				zbx_set_socket_strerror("bind() failed: %s",
+						strerror_from_system(zbx_socket_last_error()));
+				func_socket_close(s);
+				return FAIL;
+			}
+		}
 
-		if (ZBX_PROTO_ERROR == bind(s->socket, (struct sockaddr *)&source_addr, sizeof(source_addr)))
+		if (SUCCEED == zbx_socket_connect(s, (struct sockaddr *)&servaddr_in, sizeof(servaddr_in), timeout,
+				&error))
 		{
-			zbx_set_socket_strerror("bind() failed: %s", strerror_from_system(zbx_socket_last_error()));
-			func_socket_close(s);
-			return FAIL;
+			break;
 		}
-	}
 
-	if (SUCCEED != zbx_socket_connect(s, (struct sockaddr *)&servaddr_in, sizeof(servaddr_in), timeout, &error))
-	{
 		func_socket_close(s);
 		zbx_set_socket_strerror("cannot connect to [[%s]:%hu]: %s", ip, port, error);
 		zbx_free(error);
-		return FAIL;
+
+		if (NULL == next || SUCCEED == zbx_alarm_timed_out())
+			return FAIL;
+
+		zbx_socket_clean(s);
 	}
 
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
@@ -1360,8 +1459,6 @@ int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept)
 	ZBX_SOCKET	accepted_socket;
 	ZBX_SOCKLEN_T	nlen;
 	int		i, n = 0, ret = FAIL;
-	ssize_t		res;
-	unsigned char	buf;	/* 1 byte buffer */
 
 	zbx_tcp_unaccept(s);
 
@@ -1398,6 +1495,34 @@ int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept)
 		return ret;
 	}
 
+	return zbx_tcp_accept_connection(s, accepted_socket, tls_accept);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: attaches already accepted connection to a listening socket and    *
+ *          performs peer address, encryption and TLS handshake checks        *
+ *                                                                            *
+ * Parameters: s               - [IN/OUT] the listening socket                *
+ *             accepted_socket - [IN] the accepted connection                 *
+ *             tls_accept      - [IN] allowed connection types                *
+ *                                                                            *
+ * Return value: SUCCEED - success                                            *
+ *               FAIL - an error occurred, the connection is closed           *
+ *                                                                            *
+ * Comments: used directly when connections are accepted by another process  *
+ *           and passed to a worker over a unix domain socket                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_accept_connection(zbx_socket_t *s, ZBX_SOCKET accepted_socket, unsigned int tls_accept)
+{
+	int		ret = FAIL;
+	ssize_t		res;
+	unsigned char	buf;	/* 1 byte buffer */
+
+	if (0 != s->accepted)
+		zbx_tcp_unaccept(s);
+
 	s->socket_orig = s->socket;	/* remember main socket */
 	s->socket = accepted_socket;	/* replace socket to accepted */
 	s->accepted = 1;
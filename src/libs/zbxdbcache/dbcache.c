@@ -123,6 +123,8 @@ typedef struct
 	int			history_progress_ts;
 
 	zbx_hc_proxyqueue_t     proxyqueue;
+
+	zbx_uint64_t		preprocessing_queue;	/* values queued in preprocessing manager */
 }
 ZBX_DC_CACHE;
 
@@ -313,6 +315,14 @@ void	*DCget_stats(int request)
 			value_double = 100 * (double)hc_index_mem->free_size / hc_index_mem->total_size;
 			ret = (void *)&value_double;
 			break;
+		case ZBX_STATS_FUNCTIONS_EVALUATED:
+			value_uint = cache->stats.functions_evaluated;
+			ret = (void *)&value_uint;
+			break;
+		case ZBX_STATS_FUNCTIONS_CACHED:
+			value_uint = cache->stats.functions_cached;
+			ret = (void *)&value_uint;
+			break;
 		default:
 			ret = NULL;
 	}
@@ -322,6 +332,62 @@ void	*DCget_stats(int request)
 	return ret;
 }
 
+/* web scenario scheduling lag histogram bucket upper bounds in seconds, the last bucket is unbounded */
+static const double		httptest_lag_bounds[ZBX_HTTPTEST_LAG_BUCKETS - 1] = {1, 5, 10, 30, 60};
+static const char		*const httptest_lag_names[ZBX_HTTPTEST_LAG_BUCKETS] = {"1", "5", "10", "30", "60", "inf"};
+static const zbx_histogram_buckets_t	httptest_lag_buckets = {httptest_lag_bounds, httptest_lag_names,
+		ZBX_HTTPTEST_LAG_BUCKETS};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add web scenario scheduling lags to the lag histogram             *
+ *                                                                            *
+ * Parameters: lags     - [IN] the delays between scheduled and actual web    *
+ *                             scenario start times in seconds                *
+ *             lags_num - [IN] the number of lags                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_add_httptest_lag(const double *lags, int lags_num)
+{
+	int	i;
+
+	if (0 == lags_num)
+		return;
+
+	LOCK_CACHE;
+
+	for (i = 0; i < lags_num; i++)
+		zbx_histogram_add(&httptest_lag_buckets, cache->stats.httptest_lag, lags[i]);
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the number of web scenarios started with scheduling lag up    *
+ *          to the specified histogram bucket bound                           *
+ *                                                                            *
+ * Parameters: bucket - [IN] the bucket name (1, 5, 10, 30, 60 or inf)        *
+ *             value  - [OUT] the cumulative number of started web scenarios  *
+ *                                                                            *
+ * Return value: SUCCEED - the value was returned successfully                *
+ *               FAIL    - unknown bucket name                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_get_httptest_lag(const char *bucket, zbx_uint64_t *value)
+{
+	int	index;
+
+	if (FAIL == (index = zbx_histogram_get_bucket(&httptest_lag_buckets, bucket)))
+		return FAIL;
+
+	LOCK_CACHE;
+	*value = zbx_histogram_get_cumulative(cache->stats.httptest_lag, index);
+	UNLOCK_CACHE;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: find existing or add new structure and return pointer             *
@@ -1520,6 +1586,7 @@ static void	recalculate_triggers(const ZBX_DC_HISTORY *history, int history_num,
 	zbx_hashset_t		trigger_info;
 	zbx_vector_ptr_t	trigger_order;
 	zbx_vector_ptr_t	trigger_items;
+	zbx_trigger_eval_stats_t	stats = {0, 0};
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1562,9 +1629,14 @@ static void	recalculate_triggers(const ZBX_DC_HISTORY *history, int history_num,
 		zbx_dc_get_timer_triggers_by_triggerids(&trigger_info, &trigger_order, timer_triggerids, ts);
 
 	zbx_vector_ptr_sort(&trigger_order, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
-	evaluate_expressions(&trigger_order);
+	evaluate_expressions(&trigger_order, &stats);
 	zbx_process_triggers(&trigger_order, trigger_diff);
 
+	LOCK_CACHE;
+	cache->stats.functions_evaluated += (zbx_uint64_t)stats.evaluated;
+	cache->stats.functions_cached += (zbx_uint64_t)stats.cached;
+	UNLOCK_CACHE;
+
 	DCfree_triggers(&trigger_order);
 
 	zbx_vector_ptr_destroy(&trigger_items);
@@ -1911,9 +1983,13 @@ static zbx_item_diff_t	*calculate_item_update(DC_ITEM *item, const ZBX_DC_HISTOR
 	if (NULL != item_error)
 		flags |= ZBX_FLAGS_ITEM_DIFF_UPDATE_ERROR;
 
+	if (0 == (ZBX_DC_FLAGS_NOT_FOR_HISTORY & h->flags))
+		flags |= ZBX_FLAGS_ITEM_DIFF_UPDATE_VALUE;
+
 	diff = (zbx_item_diff_t *)zbx_malloc(NULL, sizeof(zbx_item_diff_t));
 	diff->itemid = item->itemid;
 	diff->lastclock = h->ts.sec;
+	diff->lastns = h->ts.ns;
 	diff->flags = flags;
 
 	if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTLOGSIZE & flags))
@@ -2013,6 +2089,7 @@ static void	DCmass_proxy_update_items(ZBX_DC_HISTORY *history, int history_num)
 		diff->itemid = history[i].itemid;
 		diff->state = history[i].state;
 		diff->lastclock = history[i].ts.sec;
+		diff->lastns = history[i].ts.ns;
 		diff->flags = ZBX_FLAGS_ITEM_DIFF_UPDATE_STATE | ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTCLOCK;
 
 		if (0 != (ZBX_DC_FLAG_META & history[i].flags))
@@ -4523,3 +4600,43 @@ out:
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: publish the number of values queued in preprocessing manager      *
+ *                                                                            *
+ * Parameters: queued_num - [IN] the number of queued values                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hc_set_preprocessing_queue(zbx_uint64_t queued_num)
+{
+	LOCK_CACHE;
+
+	cache->preprocessing_queue = queued_num;
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the number of values queued in preprocessing manager as last  *
+ *          published by it                                                   *
+ *                                                                            *
+ * Return value: the number of queued values                                  *
+ *                                                                            *
+ * Comments: Unlike zbx_preprocessor_get_queue_size() does not communicate    *
+ *           with preprocessing manager, the value can be up to a second old. *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_hc_get_preprocessing_queue(void)
+{
+	zbx_uint64_t	queued_num;
+
+	LOCK_CACHE;
+
+	queued_num = cache->preprocessing_queue;
+
+	UNLOCK_CACHE;
+
+	return queued_num;
+}
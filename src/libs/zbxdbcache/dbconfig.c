@@ -89,6 +89,7 @@ static zbx_mem_info_t	*config_mem;
 
 extern unsigned char	program_type;
 extern int		CONFIG_TIMER_FORKS;
+extern int		CONFIG_POLLER_SMOOTHING;
 
 ZBX_MEM_FUNC_IMPL(__config, config_mem)
 
@@ -207,8 +208,11 @@ static unsigned char	poller_by_item(unsigned char type, const char *key)
 		case ITEM_TYPE_DB_MONITOR:
 		case ITEM_TYPE_SSH:
 		case ITEM_TYPE_TELNET:
-		case ITEM_TYPE_CALCULATED:
 		case ITEM_TYPE_HTTPAGENT:
+			if (0 != CONFIG_HTTPAGENT_POLLER_FORKS)
+				return ZBX_POLLER_TYPE_HTTPAGENT;
+			ZBX_FALLTHROUGH;
+		case ITEM_TYPE_CALCULATED:
 			if (0 == CONFIG_POLLER_FORKS)
 				break;
 
@@ -324,7 +328,9 @@ static int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_HOST *host, u
 		return SUCCEED;	/* avoid unnecessary nextcheck updates when syncing items in cache */
 	}
 
-	seed = get_item_nextcheck_seed(item->itemid, item->interfaceid, item->type, item->key);
+	/* items polled individually keep the time slot assigned by poller smoothing */
+	if (item->itemid == (seed = get_item_nextcheck_seed(item->itemid, item->interfaceid, item->type, item->key)))
+		seed += item->nextcheck_shift;
 
 	/* for new items, supported items and items that are notsupported due to invalid update interval try to parse */
 	/* interval first and then decide whether it should become/remain supported/notsupported */
@@ -474,6 +480,159 @@ static void	DCincrease_disable_until(const ZBX_DC_ITEM *item, ZBX_DC_HOST *host,
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get interface with circuit breaker used by the item               *
+ *                                                                            *
+ * Return value: the interface or NULL if checks of the item type do not      *
+ *               affect host availability                                     *
+ *                                                                            *
+ ******************************************************************************/
+static ZBX_DC_INTERFACE	*dc_item_breaker_interface(const ZBX_DC_ITEM *item)
+{
+	switch (item->type)
+	{
+		case ITEM_TYPE_ZABBIX:
+		case ITEM_TYPE_SNMPv1:
+		case ITEM_TYPE_SNMPv2c:
+		case ITEM_TYPE_SNMPv3:
+		case ITEM_TYPE_IPMI:
+		case ITEM_TYPE_JMX:
+			return (ZBX_DC_INTERFACE *)zbx_hashset_search(&config->interfaces, &item->interfaceid);
+		default:
+			return NULL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if the item can be checked by poller according to its      *
+ *          interface circuit breaker                                         *
+ *                                                                            *
+ * Parameters: item - [IN] the item taken from poller queue                   *
+ *             now  - [IN] the current time                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the item can be checked                            *
+ *               FAIL    - the item check must be postponed                   *
+ *                                                                            *
+ * Comments: After a network error checks of the interface are held, only one *
+ *           item at a time is let through to probe the interface. The delay  *
+ *           between probes doubles with every failed probe up to unavailable *
+ *           delay, successful check of any item closes the breaker. A probe  *
+ *           is given the check timeout to complete, then another item can    *
+ *           probe the interface.                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_interface_breaker_allow(const ZBX_DC_ITEM *item, int now)
+{
+	ZBX_DC_INTERFACE	*interface;
+
+	if (NULL == (interface = dc_item_breaker_interface(item)) || 0 == interface->breaker_failures)
+		return SUCCEED;
+
+	if (interface->breaker_until > now)
+		return FAIL;
+
+	interface->breaker_probeid = item->itemid;
+	interface->breaker_until = now + CONFIG_TIMEOUT;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates interface circuit breaker with item check result          *
+ *                                                                            *
+ * Parameters: item    - [IN] the checked item                                *
+ *             errcode - [IN] the item check result                           *
+ *             now     - [IN] the current time                                *
+ *                                                                            *
+ * Comments: Failures of items that were already being checked when breaker   *
+ *           opened are not counted, so concurrent timeouts of a host going   *
+ *           down increase probing delay only once.                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_interface_breaker_update(const ZBX_DC_ITEM *item, int errcode, int now)
+{
+	ZBX_DC_INTERFACE	*interface;
+	int			delay;
+	unsigned char		i;
+
+	if (NULL == (interface = dc_item_breaker_interface(item)))
+		return;
+
+	switch (errcode)
+	{
+		case SUCCEED:
+		case NOTSUPPORTED:
+		case AGENT_ERROR:
+			interface->breaker_probeid = 0;
+			interface->breaker_until = 0;
+			interface->breaker_failures = 0;
+			break;
+		case NETWORK_ERROR:
+		case GATEWAY_ERROR:
+		case TIMEOUT_ERROR:
+			if (0 != interface->breaker_failures && item->itemid != interface->breaker_probeid)
+				break;
+
+			if (UCHAR_MAX != interface->breaker_failures)
+				interface->breaker_failures++;
+
+			for (delay = CONFIG_TIMEOUT, i = 1; i < interface->breaker_failures &&
+					delay < CONFIG_UNAVAILABLE_DELAY; i++)
+			{
+				delay *= 2;
+			}
+
+			interface->breaker_probeid = 0;
+			interface->breaker_until = now + MIN(delay, CONFIG_UNAVAILABLE_DELAY);
+			break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: mark active check list of the host as changed                     *
+ *                                                                            *
+ * Parameters: host - [IN] the host                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_host_update_active_checks_revision(ZBX_DC_HOST *host)
+{
+	host->active_checks_revision = ++config->revision;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: mark active check lists of all hosts as changed                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_update_active_checks_revision(void)
+{
+	config->active_checks_revision = ++config->revision;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: mark active check list as changed after host macro update         *
+ *                                                                            *
+ * Parameters: hostid - [IN] the host or template identifier                  *
+ *                                                                            *
+ * Comments: Templates are not cached as hosts, so template macro changes     *
+ *           invalidate active check lists of all hosts.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_hostid_update_active_checks_revision(zbx_uint64_t hostid)
+{
+	ZBX_DC_HOST	*host;
+
+	if (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &hostid)))
+		dc_host_update_active_checks_revision(host);
+	else
+		dc_update_active_checks_revision();
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Find an element in a hashset by its 'id' or create the element if *
@@ -1103,6 +1262,8 @@ static void	DCsync_hosts(zbx_dbsync_t *sync)
 
 		host = (ZBX_DC_HOST *)DCfind_id(&config->hosts, hostid, sizeof(ZBX_DC_HOST), &found);
 
+		dc_host_update_active_checks_revision(host);
+
 		/* see whether we should and can update 'hosts_h' and 'hosts_p' indexes at this point */
 
 		update_index_h = 0;
@@ -1926,6 +2087,11 @@ static void	DCsync_hmacros(zbx_dbsync_t *sync)
 			update_index = 1;
 		}
 
+		if (1 == found && hmacro->hostid != hostid)
+			dc_hostid_update_active_checks_revision(hmacro->hostid);
+
+		dc_hostid_update_active_checks_revision(hostid);
+
 		/* store new information in macro structure */
 		hmacro->hostid = hostid;
 		hmacro->context_op = context_op;
@@ -1962,6 +2128,8 @@ static void	DCsync_hmacros(zbx_dbsync_t *sync)
 		if (NULL == (hmacro = (ZBX_DC_HMACRO *)zbx_hashset_search(&config->hmacros, &rowid)))
 			continue;
 
+		dc_hostid_update_active_checks_revision(hmacro->hostid);
+
 		hmacro_hm = config_hmacro_remove_index(&config->hmacros_hm, hmacro);
 		zbx_vector_ptr_append(&indexes, hmacro_hm);
 
@@ -2165,6 +2333,14 @@ static void	DCsync_interfaces(zbx_dbsync_t *sync)
 		reset_snmp_stats |= (SUCCEED == DCstrpool_replace(found, &interface->dns, row[6]));
 		reset_snmp_stats |= (SUCCEED == DCstrpool_replace(found, &interface->port, row[7]));
 
+		/* new address must be probed from scratch */
+		if (1 == reset_snmp_stats)
+		{
+			interface->breaker_probeid = 0;
+			interface->breaker_until = 0;
+			interface->breaker_failures = 0;
+		}
+
 		/* update interfaces_ht index using new data, if not done already */
 
 		if (1 == update_index)
@@ -2521,6 +2697,9 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 			item->update_triggers = 0;
 			item->nextcheck = 0;
 			item->lastclock = 0;
+			item->value_revision = 0;
+			item->value_ts.sec = 0;
+			item->value_ts.ns = 0;
 			item->state = (unsigned char)atoi(row[18]);
 			ZBX_STR2UINT64(item->lastlogsize, row[29]);
 			item->mtime = atoi(row[30]);
@@ -2530,6 +2709,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 			item->poller_type = ZBX_NO_POLLER;
 			item->queue_priority = ZBX_QUEUE_PRIORITY_NORMAL;
 			item->schedulable = 1;
+			item->nextcheck_shift = 0;
 		}
 		else
 		{
@@ -2546,6 +2726,9 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		if (ITEM_STATUS_ACTIVE == status)
 			dc_host_update_agent_stats(host, type, 1);
 
+		if (ITEM_TYPE_ZABBIX_ACTIVE == type || (1 == found && ITEM_TYPE_ZABBIX_ACTIVE == item->type))
+			dc_host_update_active_checks_revision(host);
+
 		item->type = type;
 		item->status = status;
 		item->value_type = value_type;
@@ -2968,10 +3151,13 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &rowid)))
 			continue;
 
-		if (ITEM_STATUS_ACTIVE == item->status &&
-				NULL != (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)))
+		if (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)))
 		{
-			dc_host_update_agent_stats(host, item->type, -1);
+			if (ITEM_STATUS_ACTIVE == item->status)
+				dc_host_update_agent_stats(host, item->type, -1);
+
+			if (ITEM_TYPE_ZABBIX_ACTIVE == item->type)
+				dc_host_update_active_checks_revision(host);
 		}
 
 		itemid = item->itemid;
@@ -4783,6 +4969,93 @@ static int	dc_timer_calculate_nextcheck(time_t now, zbx_uint64_t seed)
 	return nextcheck;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates the time when trigger with nodata() functions could    *
+ *          change its value                                                  *
+ *                                                                            *
+ * Parameters: expression - [IN] the trigger expression                       *
+ *             now        - [IN] the current time                             *
+ *             nextcheck  - [IN/OUT] the earliest time nodata() function in   *
+ *                                   the expression can change its result     *
+ *                                                                            *
+ * Return value: SUCCEED - all time functions in the expression are nodata()  *
+ *                         functions that currently evaluate to 0             *
+ *               FAIL    - the trigger must be checked with timer delay       *
+ *                                                                            *
+ * Comments: nodata(period) evaluates to 0 while the item has value newer     *
+ *           than period seconds, so it cannot change before the newest value *
+ *           timestamp + period. After that it can change only with new       *
+ *           values, which recalculate the trigger in history syncers, or     *
+ *           with data collection status changes (proxy availability,         *
+ *           maintenance), which are checked with the regular timer delay.    *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_timer_nodata_nextcheck(const char *expression, int now, int *nextcheck)
+{
+	zbx_uint64_t		functionid;
+	const ZBX_DC_FUNCTION	*dc_function;
+	const ZBX_DC_ITEM	*dc_item;
+	int			period;
+
+	while (SUCCEED == get_N_functionid(expression, 1, &functionid, &expression))
+	{
+		if (NULL == (dc_function = (ZBX_DC_FUNCTION *)zbx_hashset_search(&config->functions, &functionid)))
+			continue;
+
+		if (0 == dc_function->timer)
+			continue;
+
+		if (0 != strcmp(dc_function->function, "nodata") ||
+				SUCCEED != is_time_suffix(dc_function->parameter, &period, ZBX_LENGTH_UNLIMITED))
+		{
+			return FAIL;
+		}
+
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &dc_function->itemid)))
+			return FAIL;
+
+		/* values from future are not returned by nodata() */
+		if (0 == dc_item->value_ts.sec || now < dc_item->value_ts.sec ||
+				dc_item->value_ts.sec + period <= now)
+		{
+			return FAIL;
+		}
+
+		if (dc_item->value_ts.sec + period < *nextcheck)
+			*nextcheck = dc_item->value_ts.sec + period;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates the time when nodata() trigger could change its value  *
+ *                                                                            *
+ * Parameters: trigger - [IN] the timer trigger                               *
+ *             now     - [IN] the current time                                *
+ *                                                                            *
+ * Return value: The earliest time the trigger value could change or FAIL if  *
+ *               the trigger must be checked with timer delay.                *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_timer_trigger_nextcheck(const ZBX_DC_TRIGGER *trigger, int now)
+{
+	int	nextcheck = ZBX_JAN_2038;
+
+	if (SUCCEED != dc_timer_nodata_nextcheck(trigger->expression, now, &nextcheck))
+		return FAIL;
+
+	if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == trigger->recovery_mode &&
+			SUCCEED != dc_timer_nodata_nextcheck(trigger->recovery_expression, now, &nextcheck))
+	{
+		return FAIL;
+	}
+
+	return ZBX_JAN_2038 == nextcheck ? FAIL : nextcheck;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: updates trigger related cache data;                               *
@@ -4889,7 +5162,9 @@ static void	dc_trigger_update_cache(void)
 		if (ZBX_TRIGGER_TIMER_QUEUE != trigger->timer)
 			continue;
 
-		trigger->nextcheck = dc_timer_calculate_nextcheck(now, trigger->triggerid);
+		if (FAIL == (trigger->nextcheck = dc_timer_trigger_nextcheck(trigger, now)))
+			trigger->nextcheck = dc_timer_calculate_nextcheck(now, trigger->triggerid);
+
 		elem.key = trigger->triggerid;
 		elem.data = (void *)trigger;
 		zbx_binary_heap_insert(&config->timer_queue, &elem);
@@ -5007,6 +5282,10 @@ void	DCsync_configuration(unsigned char mode)
 	DCsync_config(&config_sync, &flags);
 	csec2 = zbx_time() - sec;
 
+	/* refresh_unsupported is sent to agents together with active check list */
+	if (0 != (flags & ZBX_REFRESH_UNSUPPORTED_CHANGED))
+		dc_update_active_checks_revision();
+
 	sec = zbx_time();
 	DCsync_autoreg_config(&autoreg_config_sync);	/* must be done in the same cache locking with config sync */
 	autoreg_csec2 = zbx_time() - sec;
@@ -5050,6 +5329,12 @@ void	DCsync_configuration(unsigned char mode)
 	sec = zbx_time();
 	DCsync_host_tags(&host_tag_sync);
 	host_tag_sec2 = zbx_time() - sec;
+
+	if (0 != htmpl_sync.add_num + htmpl_sync.update_num + htmpl_sync.remove_num ||
+			0 != gmacro_sync.add_num + gmacro_sync.update_num + gmacro_sync.remove_num)
+	{
+		dc_update_active_checks_revision();
+	}
 	FINISH_SYNC;
 
 	/* sync host data to support host lookups when resolving macros during configuration sync */
@@ -5164,6 +5449,16 @@ void	DCsync_configuration(unsigned char mode)
 	DCsync_item_preproc(&itempp_sync, sec);
 	itempp_sec2 = zbx_time() - sec;
 
+	if (0 != htmpl_sync.add_num + htmpl_sync.update_num + htmpl_sync.remove_num ||
+			0 != gmacro_sync.add_num + gmacro_sync.update_num + gmacro_sync.remove_num ||
+			0 != hmacro_sync.add_num + hmacro_sync.update_num + hmacro_sync.remove_num ||
+			0 != hosts_sync.add_num + hosts_sync.update_num + hosts_sync.remove_num ||
+			0 != if_sync.add_num + if_sync.update_num + if_sync.remove_num ||
+			0 != items_sync.add_num + items_sync.update_num + items_sync.remove_num)
+	{
+		config->poller_revision = ++config->revision;
+	}
+
 	config->item_sync_ts = time(NULL);
 	FINISH_SYNC;
 
@@ -5248,6 +5543,9 @@ void	DCsync_configuration(unsigned char mode)
 	DCsync_expressions(&expr_sync);
 	expr_sec2 = zbx_time() - sec;
 
+	if (0 != expr_sync.add_num + expr_sync.update_num + expr_sync.remove_num)
+		dc_update_active_checks_revision();
+
 	sec = zbx_time();
 	DCsync_actions(&action_sync);
 	action_sec2 = zbx_time() - sec;
@@ -6080,6 +6378,15 @@ int	init_configuration_cache(char **error)
 
 	config->internal_actions = 0;
 
+	/* start revisions from the current time to keep them increasing across restarts, */
+	/* so revisions known by agents cannot match the revisions of restarted server     */
+	config->revision = (zbx_uint64_t)time(NULL) << 32;
+	config->active_checks_revision = config->revision;
+	config->poller_revision = config->revision;
+
+	memset(config->poller_lateness, 0, sizeof(config->poller_lateness));
+	memset(config->poller_lock_wait, 0, sizeof(config->poller_lock_wait));
+
 	/* maintenance data are used only when timers are defined (server) */
 	if (0 != CONFIG_TIMER_FORKS)
 	{
@@ -6540,6 +6847,8 @@ static void	DCget_item(DC_ITEM *dst_item, const ZBX_DC_ITEM *src_item)
 	dst_item->nextcheck = src_item->nextcheck;
 	dst_item->state = src_item->state;
 	dst_item->lastclock = src_item->lastclock;
+	dst_item->value_revision = src_item->value_revision;
+	dst_item->value_ts = src_item->value_ts;
 	dst_item->flags = src_item->flags;
 	dst_item->lastlogsize = src_item->lastlogsize;
 	dst_item->mtime = src_item->mtime;
@@ -7607,6 +7916,8 @@ void	zbx_dc_get_timer_triggers_by_triggerids(zbx_hashset_t *trigger_info, zbx_ve
  ******************************************************************************/
 void	zbx_dc_get_timer_triggerids(zbx_vector_uint64_t *triggerids, int now, int limit)
 {
+	int	nextcheck;
+
 	WRLOCK_CACHE;
 
 	while (SUCCEED != zbx_binary_heap_empty(&config->timer_queue) && 0 != limit)
@@ -7620,6 +7931,15 @@ void	zbx_dc_get_timer_triggerids(zbx_vector_uint64_t *triggerids, int now, int l
 		if (dc_trigger->nextcheck > now)
 			break;
 
+		/* nodata() functions received new values since the trigger was scheduled, */
+		/* so the trigger value cannot have changed - reschedule without checking  */
+		if (FAIL != (nextcheck = dc_timer_trigger_nextcheck(dc_trigger, now)))
+		{
+			dc_trigger->nextcheck = nextcheck;
+			zbx_binary_heap_update_direct(&config->timer_queue, elem);
+			continue;
+		}
+
 		/* locked triggers are already being processed by other processes, we can skip them */
 		if (0 == dc_trigger->locked)
 		{
@@ -7921,6 +8241,99 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
 	DCupdate_item_queue(dc_item, old_poller_type, old_nextcheck);
 }
 
+/* item check lateness histogram bucket upper bounds in seconds, the last bucket is unbounded */
+static const double		poller_lateness_bounds[ZBX_POLLER_LATENESS_BUCKETS - 1] = {1, 5, 10, 30, 60};
+static const char		*const poller_lateness_names[ZBX_POLLER_LATENESS_BUCKETS] = {"1", "5", "10", "30", "60",
+		"inf"};
+static const zbx_histogram_buckets_t	poller_lateness_buckets = {poller_lateness_bounds, poller_lateness_names,
+		ZBX_POLLER_LATENESS_BUCKETS};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: registers lateness of an item taken by poller and shifts its      *
+ *          schedule when poller smoothing is enabled                         *
+ *                                                                            *
+ * Parameters: dc_item     - [IN] the item taken from poller queue            *
+ *             poller_type - [IN] the poller queue the item was taken from    *
+ *             now         - [IN] the current time                            *
+ *                                                                            *
+ * Comments: Items checked late are moved to the time slot they were actually *
+ *           checked in. Items that become due at the same time are taken     *
+ *           from the queue at the rate pollers manage to check them, so with *
+ *           every check they spread further over their update interval until *
+ *           pollers keep up. Lateness up to a second is expected because of  *
+ *           poller sleep granularity and does not shift the schedule.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_poller_item_taken(ZBX_DC_ITEM *dc_item, unsigned char poller_type, int now)
+{
+	int	lateness;
+
+	lateness = now - dc_item->nextcheck;
+
+	zbx_histogram_add(&poller_lateness_buckets, config->poller_lateness[poller_type], lateness);
+
+	if (0 == CONFIG_POLLER_SMOOTHING || 1 >= lateness || ZBX_POLLER_TYPE_UNREACHABLE == poller_type)
+		return;
+
+	/* items sharing nextcheck seed are polled in batches and must stay together */
+	if (dc_item->itemid != get_item_nextcheck_seed(dc_item->itemid, dc_item->interfaceid, dc_item->type,
+			dc_item->key))
+	{
+		return;
+	}
+
+	dc_item->nextcheck_shift += (unsigned int)lateness;
+}
+
+/* the time spent by this process waiting for configuration cache lock when getting poller items */
+static double		poller_lock_wait = 0;
+
+/* the lock wait time not yet added to configuration cache poller statistics */
+static double		poller_lock_wait_unsynced = 0;
+
+/* the poller revision of configuration cache when poller items were last retrieved by this process */
+static zbx_uint64_t	poller_revision = 0;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if item can be polled in the same batch as the previous    *
+ *          item                                                              *
+ *                                                                            *
+ * Parameters: dc_item_prev - [IN] the previous item of the batch             *
+ *             dc_item      - [IN] the item to check                          *
+ *                                                                            *
+ * Return value: SUCCEED - the item can be added to the batch                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_poller_item_batchable(const ZBX_DC_ITEM *dc_item_prev, const ZBX_DC_ITEM *dc_item)
+{
+	if (SUCCEED == is_snmp_type(dc_item_prev->type))
+	{
+		if (0 != __config_snmp_item_compare(dc_item_prev, dc_item))
+			return FAIL;
+	}
+	else if (ITEM_TYPE_JMX == dc_item_prev->type)
+	{
+		/* JMX items of different endpoints are requested concurrently by Java gateway */
+		if (ITEM_TYPE_JMX != dc_item->type)
+			return FAIL;
+	}
+	else if (ITEM_TYPE_CALCULATED == dc_item_prev->type)
+	{
+		if (ITEM_TYPE_CALCULATED != dc_item->type)
+			return FAIL;
+	}
+	else if (ITEM_TYPE_EXTERNAL == dc_item_prev->type)
+	{
+		if (ITEM_TYPE_EXTERNAL != dc_item->type)
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Get array of items for selected poller                            *
@@ -7936,18 +8349,27 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
  *           always return the items they have taken using DCrequeue_items()  *
  *           or DCpoller_requeue_items().                                     *
  *                                                                            *
- *           Currently batch polling is supported only for JMX, SNMP and      *
- *           icmpping* simple checks. In other cases only single item is      *
- *           retrieved.                                                       *
+ *           Currently batch polling is supported only for JMX, SNMP,         *
+ *           calculated items, external checks, icmpping* simple checks and   *
+ *           HTTP agent items taken by HTTP agent pollers. In other cases     *
+ *           only single item is retrieved.                                   *
  *                                                                            *
  *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
  *           function.                                                        *
  *                                                                            *
+ *           Write lock is held only while taking items from the queue, the   *
+ *           items are copied under read lock. Time spent waiting for the     *
+ *           locks is returned by DCconfig_get_poller_lock_wait() and summed  *
+ *           by poller type for zabbix[process,<type>,lock_wait] items.       *
+ *                                                                            *
  ******************************************************************************/
 int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 {
-	int			now, num = 0, max_items;
+	int			now, num = 0, max_items, i, taken_num, requeue_num = 0;
 	zbx_binary_heap_t	*queue;
+	zbx_uint64_t		*itemids = NULL;
+	const ZBX_DC_ITEM	*dc_item_first = NULL;
+	double			sec;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
 
@@ -7963,11 +8385,19 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 		case ZBX_POLLER_TYPE_PINGER:
 			max_items = MAX_PINGER_ITEMS;
 			break;
+		case ZBX_POLLER_TYPE_HTTPAGENT:
+			max_items = MAX_HTTPAGENT_ITEMS;
+			break;
 		default:
 			max_items = 1;
 	}
 
+	sec = zbx_time();
 	WRLOCK_CACHE;
+	sec = zbx_time() - sec;
+	poller_lock_wait += sec;
+	config->poller_lock_wait[poller_type] += poller_lock_wait_unsynced + sec;
+	poller_lock_wait_unsynced = 0;
 
 	while (num < max_items && FAIL == zbx_binary_heap_empty(queue))
 	{
@@ -7983,19 +8413,8 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 		if (dc_item->nextcheck > now)
 			break;
 
-		if (0 != num)
-		{
-			if (SUCCEED == is_snmp_type(dc_item_prev->type))
-			{
-				if (0 != __config_snmp_item_compare(dc_item_prev, dc_item))
-					break;
-			}
-			else if (ITEM_TYPE_JMX == dc_item_prev->type)
-			{
-				if (0 != __config_java_item_compare(dc_item_prev, dc_item))
-					break;
-			}
-		}
+		if (0 != num && SUCCEED != dc_poller_item_batchable(dc_item_prev, dc_item))
+			break;
 
 		zbx_binary_heap_remove_min(queue);
 		dc_item->location = ZBX_LOC_NOWHERE;
@@ -8037,9 +8456,19 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 							ZBX_ITEM_COLLECTED | ZBX_HOST_UNREACHABLE, now);
 					continue;
 				}
+			}
 
-				DCincrease_disable_until(dc_item, dc_host, now);
+			/* breaker is checked only for items this poller is going to check, otherwise */
+			/* the probe would be held by item that was moved to other poller             */
+			if (SUCCEED != dc_interface_breaker_allow(dc_item, now))
+			{
+				dc_requeue_item(dc_item, dc_host, dc_item->state,
+						ZBX_ITEM_COLLECTED | ZBX_HOST_UNREACHABLE, now);
+				continue;
 			}
+
+			if (0 != disable_until)
+				DCincrease_disable_until(dc_item, dc_host, now);
 		}
 
 		if (0 == num)
@@ -8057,13 +8486,61 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 					max_items = DCconfig_get_suggested_snmp_vars_nolock(dc_item->interfaceid, NULL);
 				}
 			}
+			else if (ZBX_POLLER_TYPE_NORMAL == poller_type && ITEM_TYPE_CALCULATED == dc_item->type)
+				max_items = MAX_CALCULATED_ITEMS;
+			else if (ZBX_POLLER_TYPE_NORMAL == poller_type && ITEM_TYPE_EXTERNAL == dc_item->type)
+				max_items = MAX_EXTERNAL_ITEMS;
 
-			if (1 < max_items)
-				*items = zbx_malloc(NULL, sizeof(DC_ITEM) * max_items);
+			itemids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * max_items);
 		}
 
+		dc_poller_item_taken(dc_item, poller_type, now);
+
 		dc_item_prev = dc_item;
 		dc_item->location = ZBX_LOC_POLLER;
+		itemids[num++] = dc_item->itemid;
+	}
+
+	UNLOCK_CACHE;
+
+	if (0 == num)
+		goto out;
+
+	if (1 < max_items)
+		*items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * num);
+
+	/* Items are copied under read lock, so pollers copying their batches do not block each other. */
+	/* Configuration sync could have changed the items meanwhile, items that do not fit into the   */
+	/* batch anymore are returned to the queue.                                                    */
+	sec = zbx_time();
+	RDLOCK_CACHE;
+	sec = zbx_time() - sec;
+	poller_lock_wait += sec;
+	poller_lock_wait_unsynced += sec;
+
+	poller_revision = config->poller_revision;
+
+	for (taken_num = num, num = 0, i = 0; i < taken_num; i++)
+	{
+		const ZBX_DC_ITEM	*dc_item;
+		const ZBX_DC_HOST	*dc_host;
+
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+			continue;
+
+		if (ZBX_LOC_POLLER != dc_item->location)
+			continue;
+
+		if (NULL == (dc_host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
+			continue;
+
+		if (NULL != dc_item_first && SUCCEED != dc_poller_item_batchable(dc_item_first, dc_item))
+		{
+			itemids[requeue_num++] = itemids[i];
+			continue;
+		}
+
+		dc_item_first = dc_item;
 		DCget_host(&(*items)[num].host, dc_host);
 		DCget_item(&(*items)[num], dc_item);
 		num++;
@@ -8071,11 +8548,124 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 
 	UNLOCK_CACHE;
 
+	if (0 != requeue_num)
+	{
+		sec = zbx_time();
+		WRLOCK_CACHE;
+		sec = zbx_time() - sec;
+		poller_lock_wait += sec;
+		config->poller_lock_wait[poller_type] += poller_lock_wait_unsynced + sec;
+		poller_lock_wait_unsynced = 0;
+
+		for (i = 0; i < requeue_num; i++)
+		{
+			ZBX_DC_ITEM	*dc_item;
+			ZBX_DC_HOST	*dc_host;
+
+			if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+				continue;
+
+			if (ZBX_LOC_POLLER != dc_item->location)
+				continue;
+
+			dc_item->location = ZBX_LOC_NOWHERE;
+
+			if (NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
+				continue;
+
+			dc_requeue_item_at(dc_item, dc_host, now);
+		}
+
+		UNLOCK_CACHE;
+	}
+out:
+	zbx_free(itemids);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, num);
 
 	return num;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the time this process has been waiting for configuration  *
+ *          cache lock in DCconfig_get_poller_items() since the last call     *
+ *                                                                            *
+ ******************************************************************************/
+double	DCconfig_get_poller_lock_wait(void)
+{
+	double	lock_wait = poller_lock_wait;
+
+	poller_lock_wait = 0;
+
+	return lock_wait;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the revision of configuration affecting macros in item    *
+ *          fields at the time of the last DCconfig_get_poller_items() call   *
+ *                                                                            *
+ * Comments: Item fields expanded by pollers can be reused for as long as     *
+ *           this revision does not change.                                   *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	DCconfig_get_poller_revision(void)
+{
+	return poller_revision;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the number of items checked with lateness up to the           *
+ *          specified histogram bucket bound                                  *
+ *                                                                            *
+ * Parameters: poller_type - [IN] the poller type (ZBX_POLLER_TYPE_...)       *
+ *             bucket      - [IN] the bucket name (1, 5, 10, 30, 60 or inf)   *
+ *             value       - [OUT] the cumulative number of checked items     *
+ *                                                                            *
+ * Return value: SUCCEED - the value was returned successfully                *
+ *               FAIL    - unknown bucket name                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_get_poller_lateness(unsigned char poller_type, const char *bucket, zbx_uint64_t *value)
+{
+	int	index;
+
+	if (FAIL == (index = zbx_histogram_get_bucket(&poller_lateness_buckets, bucket)))
+		return FAIL;
+
+	RDLOCK_CACHE;
+	*value = zbx_histogram_get_cumulative(config->poller_lateness[poller_type], index);
+	UNLOCK_CACHE;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the time pollers of the specified type have spent waiting for *
+ *          configuration cache lock when getting items                       *
+ *                                                                            *
+ * Parameters: poller_type - [IN] the poller type (ZBX_POLLER_TYPE_...)       *
+ *                                                                            *
+ * Return value: the cumulative lock wait time in seconds                     *
+ *                                                                            *
+ * Comments: Wait for the read lock is added on the next write lock, so the   *
+ *           value lags by one DCconfig_get_poller_items() call per poller.   *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_dc_get_poller_lock_wait(unsigned char poller_type)
+{
+	double	value;
+
+	RDLOCK_CACHE;
+	value = config->poller_lock_wait[poller_type];
+	UNLOCK_CACHE;
+
+	return value;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Get array of items for IPMI poller                                *
@@ -8134,19 +8724,26 @@ int	DCconfig_get_ipmi_poller_items(int now, DC_ITEM *items, int items_num, int *
 		/* don't apply unreachable item/host throttling for prioritized items */
 		if (ZBX_QUEUE_PRIORITY_HIGH != dc_item->queue_priority)
 		{
-			if (0 != (disable_until = DCget_disable_until(dc_item, dc_host)))
+			if (0 != (disable_until = DCget_disable_until(dc_item, dc_host)) && disable_until > now)
 			{
-				if (disable_until > now)
-				{
-					dc_requeue_item(dc_item, dc_host, dc_item->state,
-							ZBX_ITEM_COLLECTED | ZBX_HOST_UNREACHABLE, now);
-					continue;
-				}
+				dc_requeue_item(dc_item, dc_host, dc_item->state,
+						ZBX_ITEM_COLLECTED | ZBX_HOST_UNREACHABLE, now);
+				continue;
+			}
 
-				DCincrease_disable_until(dc_item, dc_host, now);
+			if (SUCCEED != dc_interface_breaker_allow(dc_item, now))
+			{
+				dc_requeue_item(dc_item, dc_host, dc_item->state,
+						ZBX_ITEM_COLLECTED | ZBX_HOST_UNREACHABLE, now);
+				continue;
 			}
+
+			if (0 != disable_until)
+				DCincrease_disable_until(dc_item, dc_host, now);
 		}
 
+		dc_poller_item_taken(dc_item, ZBX_POLLER_TYPE_IPMI, now);
+
 		dc_item->location = ZBX_LOC_POLLER;
 		DCget_host(&items[num].host, dc_host);
 		DCget_item(&items[num], dc_item);
@@ -8272,9 +8869,12 @@ static void	dc_requeue_items(const zbx_uint64_t *itemids, const unsigned char *s
 		const int *errcodes, size_t num)
 {
 	size_t		i;
+	int		now;
 	ZBX_DC_ITEM	*dc_item;
 	ZBX_DC_HOST	*dc_host;
 
+	now = time(NULL);
+
 	for (i = 0; i < num; i++)
 	{
 		if (FAIL == errcodes[i])
@@ -8295,6 +8895,8 @@ static void	dc_requeue_items(const zbx_uint64_t *itemids, const unsigned char *s
 		if (HOST_STATUS_MONITORED != dc_host->status)
 			continue;
 
+		dc_interface_breaker_update(dc_item, errcodes[i], now);
+
 		if (SUCCEED != zbx_is_counted_in_item_queue(dc_item->type, dc_item->key))
 			continue;
 
@@ -8313,7 +8915,7 @@ static void	dc_requeue_items(const zbx_uint64_t *itemids, const unsigned char *s
 			case TIMEOUT_ERROR:
 				dc_item->queue_priority = ZBX_QUEUE_PRIORITY_LOW;
 				dc_requeue_item(dc_item, dc_host, states[i], ZBX_ITEM_COLLECTED | ZBX_HOST_UNREACHABLE,
-						time(NULL));
+						now);
 				break;
 			default:
 				THIS_SHOULD_NEVER_HAPPEN;
@@ -10337,6 +10939,40 @@ void	DCget_status(zbx_vector_ptr_t *hosts_monitored, zbx_vector_ptr_t *hosts_not
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get revision of the host active check list                        *
+ *                                                                            *
+ * Parameters: hostid   - [IN] the host identifier                            *
+ *             revision - [OUT] the active check list revision                *
+ *                                                                            *
+ * Return value: SUCCEED - the revision was returned                          *
+ *               FAIL    - the host was not found in configuration cache      *
+ *                                                                            *
+ * Comments: The revision changes whenever host active agent items, host,     *
+ *           template or global macros, template linkage or global regular    *
+ *           expressions are changed, so equal revisions guarantee the same   *
+ *           active check list (except item lastlogsize and mtime values).    *
+ *                                                                            *
+ ******************************************************************************/
+int	DCget_active_checks_revision(zbx_uint64_t hostid, zbx_uint64_t *revision)
+{
+	const ZBX_DC_HOST	*host;
+	int			ret = FAIL;
+
+	RDLOCK_CACHE;
+
+	if (NULL != (host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &hostid)))
+	{
+		*revision = MAX(host->active_checks_revision, config->active_checks_revision);
+		ret = SUCCEED;
+	}
+
+	UNLOCK_CACHE;
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieves global expression data from cache                       *
@@ -11382,7 +12018,7 @@ void	zbx_dc_get_nested_hostgroupids(zbx_uint64_t *groupids, int groupids_num, zb
  *            nested_groupids - [OUT] the nested + parent group ids           *
  *                                                                            *
  ******************************************************************************/
-void	zbx_dc_get_nested_hostgroupids_by_names(zbx_vector_str_t *groups, zbx_vector_uint64_t *nested_groupids)
+void	zbx_dc_get_nested_hostgroupids_by_names(const zbx_vector_str_t *groups, zbx_vector_uint64_t *nested_groupids)
 {
 	int	i, index;
 
@@ -11408,6 +12044,87 @@ void	zbx_dc_get_nested_hostgroupids_by_names(zbx_vector_str_t *groups, zbx_vecto
 	zbx_vector_uint64_uniq(nested_groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets numeric items with the specified key on monitored hosts of   *
+ *          the specified host groups (including nested groups)               *
+ *                                                                            *
+ * Parameter: groups  - [IN] the host group names                             *
+ *            itemkey - [IN] the item key                                     *
+ *            items   - [OUT] the item identifier (first) and value type      *
+ *                      (second) pairs sorted by item identifier              *
+ *                                                                            *
+ * Return value: SUCCEED - at least one of the host groups was found          *
+ *               FAIL    - none of the host groups were found                 *
+ *                                                                            *
+ * Comments: Group membership is resolved with host group host index and      *
+ *           host/key item index of configuration cache, only active items    *
+ *           in normal state are returned.                                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_get_aggregate_items(const zbx_vector_str_t *groups, const char *itemkey,
+		zbx_vector_uint64_pair_t *items)
+{
+	int			i, ret;
+	zbx_vector_uint64_t	groupids;
+	zbx_dc_hostgroup_t	*group;
+	zbx_hashset_iter_t	iter;
+	zbx_uint64_t		*phostid;
+	const ZBX_DC_HOST	*dc_host;
+	const ZBX_DC_ITEM	*dc_item;
+	zbx_uint64_pair_t	pair;
+
+	zbx_vector_uint64_create(&groupids);
+	zbx_dc_get_nested_hostgroupids_by_names(groups, &groupids);
+
+	/* nested group resolving updates cached group data, the members can be scanned with read lock */
+	RDLOCK_CACHE;
+
+	for (i = 0; i < groupids.values_num; i++)
+	{
+		if (NULL == (group = (zbx_dc_hostgroup_t *)zbx_hashset_search(&config->hostgroups,
+				&groupids.values[i])))
+		{
+			continue;
+		}
+
+		zbx_hashset_iter_reset(&group->hostids, &iter);
+
+		while (NULL != (phostid = (zbx_uint64_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == (dc_host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, phostid)) ||
+					HOST_STATUS_MONITORED != dc_host->status)
+			{
+				continue;
+			}
+
+			if (NULL == (dc_item = DCfind_item(*phostid, itemkey)) ||
+					ITEM_STATUS_ACTIVE != dc_item->status || ITEM_STATE_NORMAL != dc_item->state)
+			{
+				continue;
+			}
+
+			if (ITEM_VALUE_TYPE_FLOAT != dc_item->value_type && ITEM_VALUE_TYPE_UINT64 != dc_item->value_type)
+				continue;
+
+			pair.first = dc_item->itemid;
+			pair.second = dc_item->value_type;
+			zbx_vector_uint64_pair_append(items, pair);
+		}
+	}
+
+	UNLOCK_CACHE;
+
+	/* hosts can be members of several groups */
+	zbx_vector_uint64_pair_sort(items, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_pair_uniq(items, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	ret = (0 == groupids.values_num ? FAIL : SUCCEED);
+	zbx_vector_uint64_destroy(&groupids);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: gets active proxy data by its name from configuration cache       *
@@ -11606,6 +12323,16 @@ void	DCconfig_items_apply_changes(const zbx_vector_ptr_t *item_diff)
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTCLOCK & diff->flags))
 			dc_item->lastclock = diff->lastclock;
+
+		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_VALUE & diff->flags))
+		{
+			zbx_timespec_t	ts = {diff->lastclock, diff->lastns};
+
+			/* allow history syncers to detect new values for cached trigger function results */
+			dc_item->value_revision++;
+			if (0 < zbx_timespec_compare(&ts, &dc_item->value_ts))
+				dc_item->value_ts = ts;
+		}
 	}
 
 	UNLOCK_CACHE;
@@ -12268,4 +12995,7 @@ int	zbx_dc_maintenance_has_tags(void)
 
 #ifdef HAVE_TESTS
 #	include "../../../tests/libs/zbxdbcache/dc_item_poller_type_update_test.c"
+#	include "../../../tests/libs/zbxdbcache/dc_interface_breaker_test.c"
+#	include "../../../tests/libs/zbxdbcache/dc_item_nextcheck_test.c"
+#	include "../../../tests/libs/zbxdbcache/dc_timer_trigger_test.c"
 #endif
@@ -79,6 +79,8 @@ typedef struct
 	zbx_uint64_t		interfaceid;
 	zbx_uint64_t		lastlogsize;
 	zbx_uint64_t		valuemapid;
+	zbx_uint64_t		value_revision;	/* incremented with every value processed by history syncers */
+	zbx_timespec_t		value_ts;	/* timestamp of the newest value processed by history syncers */
 	const char		*key;
 	const char		*port;
 	const char		*error;
@@ -89,6 +91,7 @@ typedef struct
 	int			mtime;
 	int			data_expected_from;
 	int			history_sec;
+	unsigned int		nextcheck_shift;	/* nextcheck seed shift applied by poller smoothing */
 	unsigned char		history;
 	unsigned char		type;
 	unsigned char		value_type;
@@ -305,6 +308,9 @@ typedef struct
 							/* NOTE: On disabled hosts all items are counted as disabled. */
 	zbx_uint64_t	maintenanceid;
 
+	/* revision of the host active check list, see DCget_active_checks_revision() */
+	zbx_uint64_t	active_checks_revision;
+
 	const char	*host;
 	const char	*name;
 	int		maintenance_from;
@@ -461,6 +467,11 @@ typedef struct
 	unsigned char	bulk;
 	unsigned char	max_snmp_succeed;
 	unsigned char	min_snmp_fail;
+
+	/* circuit breaker holding checks of interface after network errors, see dc_interface_breaker_allow() */
+	zbx_uint64_t	breaker_probeid;	/* the item probing interface availability */
+	int		breaker_until;		/* checks are held until this time */
+	unsigned char	breaker_failures;	/* the number of consecutive failed probes */
 }
 ZBX_DC_INTERFACE;
 
@@ -737,6 +748,17 @@ typedef struct
 
 	unsigned int		internal_actions;		/* number of enabled internal actions */
 
+	/* configuration change counter, used to assign revisions to changed objects */
+	zbx_uint64_t		revision;
+
+	/* revision of the configuration shared by active check lists of all hosts */
+	/* (global macros, template macros and linkage, global regular expressions) */
+	zbx_uint64_t		active_checks_revision;
+
+	/* revision of the configuration used to expand macros in item fields by pollers */
+	/* (hosts, interfaces, items, host and global macros, template linkage)          */
+	zbx_uint64_t		poller_revision;
+
 	/* maintenance processing management */
 	unsigned char		maintenance_update;		/* flag to trigger maintenance update by timers  */
 	zbx_uint64_t		*maintenance_update_flags;	/* Array of flags to manage timer maintenance updates.*/
@@ -808,6 +830,10 @@ typedef struct
 #endif
 	zbx_hashset_t		data_sessions;
 	zbx_binary_heap_t	queues[ZBX_POLLER_TYPE_COUNT];
+	/* non-cumulative histograms of item check lateness by poller type */
+	zbx_uint64_t		poller_lateness[ZBX_POLLER_TYPE_COUNT][ZBX_POLLER_LATENESS_BUCKETS];
+	/* seconds spent by pollers waiting for configuration cache lock when getting items, by poller type */
+	double			poller_lock_wait[ZBX_POLLER_TYPE_COUNT];
 	zbx_binary_heap_t	pqueue;
 	zbx_binary_heap_t	timer_queue;
 	ZBX_DC_CONFIG_TABLE	*config;
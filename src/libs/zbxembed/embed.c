@@ -36,6 +36,9 @@
 /* maximum number of consequent runtime errors after which it's treated as fatal error */
 #define ZBX_ES_MAX_CONSEQUENT_RT_ERROR	3
 
+/* global stash property holding the last loaded function */
+#define ZBX_ES_STASH_FUNCTION	"\xff""\xff""zbx_func"
+
 #define ZBX_ES_SCRIPT_HEADER	"function(value){"
 #define ZBX_ES_SCRIPT_FOOTER	"\n}"
 
@@ -256,6 +259,7 @@ int	zbx_es_destroy_env(zbx_es_t *es, char **error)
 	}
 
 	duk_destroy_heap(es->env->ctx);
+	zbx_free(es->env->code);
 	zbx_free(es->env->error);
 	zbx_free(es->env);
 
@@ -387,6 +391,44 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pushes function compiled into bytecode on the stack               *
+ *                                                                            *
+ * Parameters: env  - [IN] the scripting engine environment                   *
+ *             code - [IN] the precompiled bytecode                           *
+ *             size - [IN] the size of precompiled bytecode                   *
+ *                                                                            *
+ * Comments: The last loaded function is kept in global stash, so repeated    *
+ *           executions of the same script do not load bytecode again.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	es_push_function(zbx_es_env_t *env, const char *code, int size)
+{
+	void	*buffer;
+
+	if (NULL != env->code && size == env->code_size && 0 == memcmp(code, env->code, size))
+	{
+		duk_push_global_stash(env->ctx);
+		duk_get_prop_string(env->ctx, -1, ZBX_ES_STASH_FUNCTION);
+		duk_remove(env->ctx, -2);
+		return;
+	}
+
+	buffer = duk_push_fixed_buffer(env->ctx, size);
+	memcpy(buffer, code, size);
+	duk_load_function(env->ctx);
+
+	duk_push_global_stash(env->ctx);
+	duk_dup(env->ctx, -2);
+	duk_put_prop_string(env->ctx, -2, ZBX_ES_STASH_FUNCTION);
+	duk_pop(env->ctx);
+
+	env->code = (char *)zbx_realloc(env->code, size);
+	memcpy(env->code, code, size);
+	env->code_size = size;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: executes script                                                   *
@@ -411,7 +453,6 @@ out:
 int	zbx_es_execute(zbx_es_t *es, const char *script, const char *code, int size, const char *param, char **output,
 	char **error)
 {
-	void		*buffer;
 	volatile int	ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() param:%s", __func__, param);
@@ -430,12 +471,11 @@ int	zbx_es_execute(zbx_es_t *es, const char *script, const char *code, int size,
 		goto out;
 	}
 
-	buffer = duk_push_fixed_buffer(es->env->ctx, size);
-	memcpy(buffer, code, size);
-	duk_load_function(es->env->ctx);
+	es_push_function(es->env, code, size);
 	duk_push_string(es->env->ctx, param);
 
 	es->env->start_time = time(NULL);
+	es->env->exec_num++;
 
 	if (DUK_EXEC_SUCCESS != duk_pcall(es->env->ctx, 1))
 	{
@@ -501,3 +541,37 @@ void	zbx_es_set_timeout(zbx_es_t *es, int timeout)
 {
 	es->env->timeout = timeout;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if scripting engine environment should be recycled         *
+ *                                                                            *
+ * Parameters: es           - [IN] the embedded scripting engine              *
+ *             max_exec_num - [IN] the maximum number of script executions    *
+ *                                 in one environment                         *
+ *                                                                            *
+ * Return value: SUCCEED - the environment must be destroyed                  *
+ *               FAIL    - the environment can be reused                      *
+ *                                                                            *
+ * Comments: Besides fatal errors the environment is recycled after too many  *
+ *           executions or when scripts left more than half of the memory     *
+ *           limit allocated, for example in global variables.                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_es_recycle_required(zbx_es_t *es, int max_exec_num)
+{
+	if (SUCCEED == zbx_es_fatal_error(es))
+		return SUCCEED;
+
+	if (max_exec_num <= es->env->exec_num)
+		return SUCCEED;
+
+	if (ZBX_ES_MEMORY_LIMIT / 2 < es->env->total_alloc)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "embedded scripting engine memory usage " ZBX_FS_SIZE_T
+				" exceeds limits, resetting scripting environment", (zbx_fs_size_t)es->env->total_alloc);
+		return SUCCEED;
+	}
+
+	return FAIL;
+}
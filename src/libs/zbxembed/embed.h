@@ -34,6 +34,11 @@ struct zbx_es_env
 	int		fatal_error;
 	int		timeout;
 
+	/* bytecode of the last executed function, kept loaded in heap stash */
+	char		*code;
+	int		code_size;
+	int		exec_num;
+
 	jmp_buf		loc;
 };
 
@@ -219,4 +219,101 @@ char	*zbx_http_get_header(char **headers)
 	return NULL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create cURL multi interface for concurrent requests               *
+ *                                                                            *
+ * Parameters: multi           - [OUT] the multi handle                       *
+ *             share           - [OUT] the share handle                       *
+ *             max_connections - [IN] the number of connections kept open     *
+ *             error           - [OUT] the error message                      *
+ *                                                                            *
+ * Return value: SUCCEED - the multi interface was created                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Requests added to the multi handle reuse its connection cache.   *
+ *           Requests using the share handle share resolved host names and    *
+ *           TLS sessions.                                                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_http_multi_create(CURLM **multi, CURLSH **share, int max_connections, char **error)
+{
+	CURLSHcode	sh_err;
+	CURLMcode	m_err;
+
+	if (NULL == (*share = curl_share_init()))
+	{
+		*error = zbx_strdup(*error, "Cannot initialize cURL share interface");
+		return FAIL;
+	}
+
+	if (CURLSHE_OK != (sh_err = curl_share_setopt(*share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS)))
+	{
+		*error = zbx_dsprintf(*error, "Cannot share DNS cache: %s", curl_share_strerror(sh_err));
+		return FAIL;
+	}
+
+#if LIBCURL_VERSION_NUM >= 0x071700
+	/* sharing of SSL session is supported starting with version 7.23.0 (0x071700) */
+	if (CURLSHE_OK != (sh_err = curl_share_setopt(*share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION)))
+	{
+		*error = zbx_dsprintf(*error, "Cannot share SSL sessions: %s", curl_share_strerror(sh_err));
+		return FAIL;
+	}
+#endif
+
+	if (NULL == (*multi = curl_multi_init()))
+	{
+		*error = zbx_strdup(*error, "Cannot initialize cURL multi interface");
+		return FAIL;
+	}
+
+	if (CURLM_OK != (m_err = curl_multi_setopt(*multi, CURLMOPT_MAXCONNECTS, (long)max_connections)))
+	{
+		*error = zbx_dsprintf(*error, "Cannot set connection cache size: %s", curl_multi_strerror(m_err));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for activity on connections of multi interface requests      *
+ *                                                                            *
+ * Parameters: multi      - [IN] the multi handle                             *
+ *             timeout_ms - [IN] the maximum time to wait in milliseconds     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_http_multi_wait(CURLM *multi, int timeout_ms)
+{
+#if LIBCURL_VERSION_NUM >= 0x071c00
+	/* curl_multi_wait() is supported starting with version 7.28.0 (0x071c00) */
+	curl_multi_wait(multi, NULL, 0, timeout_ms, NULL);
+#else
+	fd_set		fdread, fdwrite, fdexcep;
+	int		maxfd = -1;
+	long		curl_timeout = -1;
+	struct timeval	tv;
+
+	FD_ZERO(&fdread);
+	FD_ZERO(&fdwrite);
+	FD_ZERO(&fdexcep);
+
+	if (CURLM_OK == curl_multi_timeout(multi, &curl_timeout) && 0 <= curl_timeout && curl_timeout < timeout_ms)
+		timeout_ms = (int)curl_timeout;
+
+	if (CURLM_OK != curl_multi_fdset(multi, &fdread, &fdwrite, &fdexcep, &maxfd) || -1 == maxfd)
+	{
+		/* libcurl does not have sockets to wait on yet, retry shortly */
+		timeout_ms = MIN(timeout_ms, 100);
+	}
+
+	tv.tv_sec = timeout_ms / 1000;
+	tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+	select(maxfd + 1, &fdread, &fdwrite, &fdexcep, &tv);
+#endif
+}
+
 #endif
@@ -22,6 +22,7 @@
 #include "comms.h"
 #include "base64.h"
 #include "zbxalgo.h"
+#include "sha256crypt.h"
 
 #include "zbxmedia.h"
 
@@ -406,33 +407,184 @@ out:
 }
 #endif
 
-static int	send_email_plain(const char *smtp_server, unsigned short smtp_port, const char *smtp_helo,
-		zbx_vector_ptr_t *from_mails, zbx_vector_ptr_t *to_mails, const char *mailsubject,
-		const char *mailbody, unsigned char content_type, int timeout, char *error, size_t max_error_len)
+#define ZBX_SMTP_SESSION_PLAIN	0
+#define ZBX_SMTP_SESSION_CURL	1
+
+/* the maximum number of idle SMTP sessions kept open */
+#define ZBX_SMTP_POOL_SIZE			8
+
+/* the maximum number of mail transactions sent in one SMTP session */
+#define ZBX_SMTP_SESSION_MAX_TRANSACTIONS	100
+
+typedef struct
 {
+	/* hash of SMTP server and connection parameters the session was opened with, */
+	/* the parameters include password so they are not kept in memory            */
+	char		key[ZBX_SHA256_DIGEST_SIZE];
+	unsigned char	type;
+	int		lastaccess;
+	int		transactions;
 	zbx_socket_t	s;
-	int		err, ret = FAIL, i;
-	char		cmd[MAX_STRING_LEN], *cmdp = NULL;
+#ifdef HAVE_SMTP_AUTHENTICATION
+	CURL		*easyhandle;
+#endif
+}
+zbx_smtp_session_t;
+
+static zbx_vector_ptr_t	smtp_sessions;
+
+/* idle SMTP session timeout, 0 - sessions are not pooled */
+static int	smtp_idle_timeout = 0;
+
+static int	smtp_connected_num = 0, smtp_reused_num = 0;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: closes SMTP session connection                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	smtp_session_close(zbx_smtp_session_t *session)
+{
+	if (ZBX_SMTP_SESSION_PLAIN == session->type)
+	{
+		if (0 != session->transactions)
+		{
+			/* QUIT response is not checked, the same as when pooling is disabled */
+			if (-1 == write(session->s.socket, "QUIT\r\n", ZBX_CONST_STRLEN("QUIT\r\n")))
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "error sending QUIT to mailserver: %s",
+						zbx_strerror(errno));
+			}
+
+			zbx_tcp_close(&session->s);
+		}
+	}
+#ifdef HAVE_SMTP_AUTHENTICATION
+	else if (NULL != session->easyhandle)
+	{
+		curl_easy_cleanup(session->easyhandle);
+		session->easyhandle = NULL;
+	}
+#endif
+	session->transactions = 0;
+}
+
+static void	smtp_session_free(zbx_smtp_session_t *session)
+{
+	smtp_session_close(session);
+	zbx_free(session);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets SMTP session for the specified server                        *
+ *                                                                            *
+ * Parameters: type - [IN] the session type (ZBX_SMTP_SESSION_*)              *
+ *             key  - [IN] the server and connection parameters, sessions are *
+ *                         matched by hash of the parameters                  *
+ *             now  - [IN] the current time                                   *
+ *                                                                            *
+ * Return value: the idle pooled session or a new unconnected session         *
+ *                                                                            *
+ * Comments: The returned session is removed from pool until released with    *
+ *           smtp_session_release().                                          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_smtp_session_t	*smtp_session_get(unsigned char type, const char *key, int now)
+{
+	zbx_smtp_session_t	*session = NULL, *pooled;
+	char			hash[ZBX_SHA256_DIGEST_SIZE];
+	int			i;
+
+	zbx_sha256_hash(key, hash);
+
+	for (i = 0; 0 != smtp_idle_timeout && i < smtp_sessions.values_num; i++)
+	{
+		pooled = (zbx_smtp_session_t *)smtp_sessions.values[i];
+
+		if (pooled->lastaccess + smtp_idle_timeout <= now)
+		{
+			zbx_vector_ptr_remove_noorder(&smtp_sessions, i--);
+			smtp_session_free(pooled);
+			continue;
+		}
+
+		if (NULL == session && type == pooled->type && 0 == memcmp(hash, pooled->key, sizeof(hash)))
+		{
+			zbx_vector_ptr_remove_noorder(&smtp_sessions, i--);
+			session = pooled;
+		}
+	}
+
+	if (NULL == session)
+	{
+		session = (zbx_smtp_session_t *)zbx_malloc(NULL, sizeof(zbx_smtp_session_t));
+		memset(session, 0, sizeof(zbx_smtp_session_t));
+		session->type = type;
+		memcpy(session->key, hash, sizeof(hash));
+	}
+
+	return session;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns SMTP session to pool or destroys it                       *
+ *                                                                            *
+ * Parameters: session - [IN] the session                                     *
+ *             result  - [IN] the result of the last mail transaction         *
+ *             now     - [IN] the current time                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	smtp_session_release(zbx_smtp_session_t *session, int result, int now)
+{
+	int	i, lru = 0;
+
+	if (0 == smtp_idle_timeout || SUCCEED != result || ZBX_SMTP_SESSION_MAX_TRANSACTIONS <= session->transactions)
+	{
+		smtp_session_free(session);
+		return;
+	}
+
+	session->lastaccess = now;
+
+	if (ZBX_SMTP_POOL_SIZE <= smtp_sessions.values_num)
+	{
+		for (i = 1; i < smtp_sessions.values_num; i++)
+		{
+			if (((zbx_smtp_session_t *)smtp_sessions.values[i])->lastaccess <
+					((zbx_smtp_session_t *)smtp_sessions.values[lru])->lastaccess)
+			{
+				lru = i;
+			}
+		}
 
+		smtp_session_free((zbx_smtp_session_t *)smtp_sessions.values[lru]);
+		zbx_vector_ptr_remove_noorder(&smtp_sessions, lru);
+	}
+
+	zbx_vector_ptr_append(&smtp_sessions, session);
+}
+
+static int	smtp_plain_connect(zbx_socket_t *s, const char *smtp_server, unsigned short smtp_port,
+		const char *smtp_helo, char *error, size_t max_error_len)
+{
+	char		cmd[MAX_STRING_LEN];
 	const char	*OK_220 = "220";
 	const char	*OK_250 = "250";
-	const char	*OK_251 = "251";
-	const char	*OK_354 = "354";
 	const char	*response;
 
-	zbx_alarm_on(timeout);
-
 	/* connect to and receive an initial greeting from SMTP server */
 
-	if (FAIL == zbx_tcp_connect(&s, CONFIG_SOURCE_IP, smtp_server, smtp_port, 0, ZBX_TCP_SEC_UNENCRYPTED, NULL,
+	if (FAIL == zbx_tcp_connect(s, CONFIG_SOURCE_IP, smtp_server, smtp_port, 0, ZBX_TCP_SEC_UNENCRYPTED, NULL,
 			NULL))
 	{
 		zbx_snprintf(error, max_error_len, "cannot connect to SMTP server \"%s\": %s",
 				smtp_server, zbx_socket_strerror());
-		goto out;
+		return FAIL;
 	}
 
-	if (FAIL == smtp_readln(&s, &response))
+	if (FAIL == smtp_readln(s, &response))
 	{
 		zbx_snprintf(error, max_error_len, "error receiving initial string from SMTP server: %s",
 				zbx_strerror(errno));
@@ -451,14 +603,14 @@ static int	send_email_plain(const char *smtp_server, unsigned short smtp_port, c
 	{
 		zbx_snprintf(cmd, sizeof(cmd), "HELO %s\r\n", smtp_helo);
 
-		if (-1 == write(s.socket, cmd, strlen(cmd)))
+		if (-1 == write(s->socket, cmd, strlen(cmd)))
 		{
 			zbx_snprintf(error, max_error_len, "error sending HELO to mailserver: %s",
 					zbx_strerror(errno));
 			goto close;
 		}
 
-		if (FAIL == smtp_readln(&s, &response))
+		if (FAIL == smtp_readln(s, &response))
 		{
 			zbx_snprintf(error, max_error_len, "error receiving answer on HELO request: %s",
 					zbx_strerror(errno));
@@ -472,28 +624,66 @@ static int	send_email_plain(const char *smtp_server, unsigned short smtp_port, c
 		}
 	}
 
+	return SUCCEED;
+close:
+	zbx_tcp_close(s);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if pooled SMTP connection is still usable and resets its   *
+ *          mail transaction state                                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	smtp_plain_reset(zbx_socket_t *s)
+{
+	const char	*response;
+
+	if (-1 == write(s->socket, "RSET\r\n", ZBX_CONST_STRLEN("RSET\r\n")))
+		return FAIL;
+
+	if (FAIL == smtp_readln(s, &response) || 0 != strncmp(response, "250", ZBX_CONST_STRLEN("250")))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+static int	smtp_plain_send(zbx_socket_t *s, zbx_vector_ptr_t *from_mails, zbx_vector_ptr_t *to_mails,
+		const char *mailsubject, const char *mailbody, unsigned char content_type, char *error,
+		size_t max_error_len)
+{
+	int		err, i;
+	char		cmd[MAX_STRING_LEN], *cmdp = NULL;
+
+	const char	*OK_250 = "250";
+	const char	*OK_251 = "251";
+	const char	*OK_354 = "354";
+	const char	*response;
+
 	/* send MAIL FROM */
 
 	for (i = 0; i < from_mails->values_num; i++)
 	{
 		zbx_snprintf(cmd, sizeof(cmd), "MAIL FROM:%s\r\n", ((zbx_mailaddr_t *)from_mails->values[i])->addr);
 
-		if (-1 == write(s.socket, cmd, strlen(cmd)))
+		if (-1 == write(s->socket, cmd, strlen(cmd)))
 		{
 			zbx_snprintf(error, max_error_len, "error sending MAIL FROM to mailserver: %s", zbx_strerror(errno));
-			goto close;
+			return FAIL;
 		}
 
-		if (FAIL == smtp_readln(&s, &response))
+		if (FAIL == smtp_readln(s, &response))
 		{
 			zbx_snprintf(error, max_error_len, "error receiving answer on MAIL FROM request: %s", zbx_strerror(errno));
-			goto close;
+			return FAIL;
 		}
 
 		if (0 != strncmp(response, OK_250, strlen(OK_250)))
 		{
 			zbx_snprintf(error, max_error_len, "wrong answer on MAIL FROM \"%s\"", response);
-			goto close;
+			return FAIL;
 		}
 	}
 
@@ -503,23 +693,23 @@ static int	send_email_plain(const char *smtp_server, unsigned short smtp_port, c
 	{
 		zbx_snprintf(cmd, sizeof(cmd), "RCPT TO:%s\r\n", ((zbx_mailaddr_t *)to_mails->values[i])->addr);
 
-		if (-1 == write(s.socket, cmd, strlen(cmd)))
+		if (-1 == write(s->socket, cmd, strlen(cmd)))
 		{
 			zbx_snprintf(error, max_error_len, "error sending RCPT TO to mailserver: %s", zbx_strerror(errno));
-			goto close;
+			return FAIL;
 		}
 
-		if (FAIL == smtp_readln(&s, &response))
+		if (FAIL == smtp_readln(s, &response))
 		{
 			zbx_snprintf(error, max_error_len, "error receiving answer on RCPT TO request: %s", zbx_strerror(errno));
-			goto close;
+			return FAIL;
 		}
 
 		/* May return 251 as well: User not local; will forward to <forward-path>. See RFC825. */
 		if (0 != strncmp(response, OK_250, strlen(OK_250)) && 0 != strncmp(response, OK_251, strlen(OK_251)))
 		{
 			zbx_snprintf(error, max_error_len, "wrong answer on RCPT TO \"%s\"", response);
-			goto close;
+			return FAIL;
 		}
 	}
 
@@ -527,98 +717,127 @@ static int	send_email_plain(const char *smtp_server, unsigned short smtp_port, c
 
 	zbx_snprintf(cmd, sizeof(cmd), "DATA\r\n");
 
-	if (-1 == write(s.socket, cmd, strlen(cmd)))
+	if (-1 == write(s->socket, cmd, strlen(cmd)))
 	{
 		zbx_snprintf(error, max_error_len, "error sending DATA to mailserver: %s", zbx_strerror(errno));
-		goto close;
+		return FAIL;
 	}
 
-	if (FAIL == smtp_readln(&s, &response))
+	if (FAIL == smtp_readln(s, &response))
 	{
 		zbx_snprintf(error, max_error_len, "error receiving answer on DATA request: %s", zbx_strerror(errno));
-		goto close;
+		return FAIL;
 	}
 
 	if (0 != strncmp(response, OK_354, strlen(OK_354)))
 	{
 		zbx_snprintf(error, max_error_len, "wrong answer on DATA \"%s\"", response);
-		goto close;
+		return FAIL;
 	}
 
 	cmdp = smtp_prepare_payload(from_mails, to_mails, mailsubject, mailbody, content_type);
-	err = write(s.socket, cmdp, strlen(cmdp));
+	err = write(s->socket, cmdp, strlen(cmdp));
 	zbx_free(cmdp);
 
 	if (-1 == err)
 	{
 		zbx_snprintf(error, max_error_len, "error sending headers and mail body to mailserver: %s",
 				zbx_strerror(errno));
-		goto close;
+		return FAIL;
 	}
 
 	/* send . */
 
 	zbx_snprintf(cmd, sizeof(cmd), "\r\n.\r\n");
 
-	if (-1 == write(s.socket, cmd, strlen(cmd)))
+	if (-1 == write(s->socket, cmd, strlen(cmd)))
 	{
 		zbx_snprintf(error, max_error_len, "error sending . to mailserver: %s", zbx_strerror(errno));
-		goto close;
+		return FAIL;
 	}
 
-	if (FAIL == smtp_readln(&s, &response))
+	if (FAIL == smtp_readln(s, &response))
 	{
 		zbx_snprintf(error, max_error_len, "error receiving answer on . request: %s", zbx_strerror(errno));
-		goto close;
+		return FAIL;
 	}
 
 	if (0 != strncmp(response, OK_250, strlen(OK_250)))
 	{
 		zbx_snprintf(error, max_error_len, "wrong answer on end of data \"%s\"", response);
-		goto close;
+		return FAIL;
 	}
 
-	/* send QUIT */
+	return SUCCEED;
+}
+
+static int	send_email_plain(const char *smtp_server, unsigned short smtp_port, const char *smtp_helo,
+		zbx_vector_ptr_t *from_mails, zbx_vector_ptr_t *to_mails, const char *mailsubject,
+		const char *mailbody, unsigned char content_type, int timeout, char *error, size_t max_error_len)
+{
+	zbx_smtp_session_t	*session;
+	char			*key;
+	int			ret = FAIL, now;
+
+	now = (int)time(NULL);
+	key = zbx_dsprintf(NULL, "%s:%hu/%s", smtp_server, smtp_port, smtp_helo);
+	session = smtp_session_get(ZBX_SMTP_SESSION_PLAIN, key, now);
+	zbx_free(key);
 
-	zbx_snprintf(cmd, sizeof(cmd), "QUIT\r\n");
+	zbx_alarm_on(timeout);
 
-	if (-1 == write(s.socket, cmd, strlen(cmd)))
+	if (0 != session->transactions)
 	{
-		zbx_snprintf(error, max_error_len, "error sending QUIT to mailserver: %s", zbx_strerror(errno));
-		goto close;
+		if (SUCCEED == smtp_plain_reset(&session->s))
+		{
+			smtp_reused_num++;
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() pooled SMTP session to \"%s\" is not usable, reconnecting",
+					__func__, smtp_server);
+			zbx_tcp_close(&session->s);
+			session->transactions = 0;
+		}
 	}
 
-	ret = SUCCEED;
-close:
-	zbx_tcp_close(&s);
+	if (0 == session->transactions)
+	{
+		if (SUCCEED != smtp_plain_connect(&session->s, smtp_server, smtp_port, smtp_helo, error,
+				max_error_len))
+		{
+			goto out;
+		}
+
+		smtp_connected_num++;
+	}
+
+	session->transactions++;
+
+	ret = smtp_plain_send(&session->s, from_mails, to_mails, mailsubject, mailbody, content_type, error,
+			max_error_len);
 out:
 	zbx_alarm_off();
 
+	smtp_session_release(session, ret, now);
+
 	return ret;
 }
 
-static int	send_email_curl(const char *smtp_server, unsigned short smtp_port, const char *smtp_helo,
-		zbx_vector_ptr_t *from_mails, zbx_vector_ptr_t *to_mails, const char *mailsubject,
-		const char *mailbody, unsigned char smtp_security, unsigned char smtp_verify_peer,
+#ifdef HAVE_SMTP_AUTHENTICATION
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets cURL options that are kept while SMTP session is reused      *
+ *                                                                            *
+ ******************************************************************************/
+static CURLcode	smtp_curl_setopt_session(CURL *easyhandle, const char *smtp_server, unsigned short smtp_port,
+		const char *smtp_helo, unsigned char smtp_security, unsigned char smtp_verify_peer,
 		unsigned char smtp_verify_host, unsigned char smtp_authentication, const char *username,
-		const char *password, unsigned char content_type, int timeout, char *error, size_t max_error_len)
+		const char *password)
 {
-#ifdef HAVE_SMTP_AUTHENTICATION
-	int			ret = FAIL, i;
-	CURL			*easyhandle;
-	CURLcode		err;
-	char			url[MAX_STRING_LEN], errbuf[CURL_ERROR_SIZE] = "";
-	size_t			url_offset= 0;
-	struct curl_slist	*recipients = NULL;
-	smtp_payload_status_t	payload_status;
-
-	if (NULL == (easyhandle = curl_easy_init()))
-	{
-		zbx_strlcpy(error, "cannot initialize cURL library", max_error_len);
-		goto out;
-	}
-
-	memset(&payload_status, 0, sizeof(payload_status));
+	CURLcode	err;
+	char		url[MAX_STRING_LEN];
+	size_t		url_offset= 0;
 
 	if (SMTP_SECURITY_SSL == smtp_security)
 		url_offset += zbx_snprintf(url + url_offset, sizeof(url) - url_offset, "smtps://");
@@ -633,11 +852,11 @@ static int	send_email_curl(const char *smtp_server, unsigned short smtp_port, co
 #if LIBCURL_VERSION_NUM >= 0x071304
 	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROTOCOLS, CURLPROTO_SMTPS | CURLPROTO_SMTP)))
-		goto error;
+		return err;
 #endif
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, url)))
-		goto error;
+		return err;
 
 	if (SMTP_SECURITY_NONE != smtp_security)
 	{
@@ -648,19 +867,19 @@ static int	send_email_curl(const char *smtp_server, unsigned short smtp_port, co
 				CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_SSL_VERIFYHOST,
 						0 == smtp_verify_host ? 0L : 2L)))
 		{
-			goto error;
+			return err;
 		}
 
 		if (0 != smtp_verify_peer && NULL != CONFIG_SSL_CA_LOCATION)
 		{
 			if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_CAPATH, CONFIG_SSL_CA_LOCATION)))
-				goto error;
+				return err;
 		}
 
 		if (SMTP_SECURITY_STARTTLS == smtp_security)
 		{
 			if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_USE_SSL, (long)CURLUSESSL_ALL)))
-				goto error;
+				return err;
 		}
 	}
 
@@ -669,7 +888,7 @@ static int	send_email_curl(const char *smtp_server, unsigned short smtp_port, co
 		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_USERNAME, username)) ||
 				CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PASSWORD, password)))
 		{
-			goto error;
+			return err;
 		}
 
 		/* Don't specify preferred authentication mechanism implying AUTH=* and let libcurl choose the best */
@@ -680,59 +899,118 @@ static int	send_email_curl(const char *smtp_server, unsigned short smtp_port, co
 		/*   - versions 7.34.0 and above support explicit CURLOPT_LOGIN_OPTIONS                             */
 	}
 
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")))
+		return err;
+
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_UPLOAD, 1L)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_READFUNCTION, smtp_provide_payload)))
+	{
+		return err;
+	}
+
+	if (NULL != CONFIG_SOURCE_IP)
+	{
+		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_INTERFACE, CONFIG_SOURCE_IP)))
+			return err;
+	}
+
+	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE))
+	{
+		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_VERBOSE, 1L)))
+			return err;
+
+		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_DEBUGFUNCTION, smtp_debug_function)))
+			return err;
+	}
+
+	return CURLE_OK;
+}
+#endif
+
+static int	send_email_curl(const char *smtp_server, unsigned short smtp_port, const char *smtp_helo,
+		zbx_vector_ptr_t *from_mails, zbx_vector_ptr_t *to_mails, const char *mailsubject,
+		const char *mailbody, unsigned char smtp_security, unsigned char smtp_verify_peer,
+		unsigned char smtp_verify_host, unsigned char smtp_authentication, const char *username,
+		const char *password, unsigned char content_type, int timeout, char *error, size_t max_error_len)
+{
+#ifdef HAVE_SMTP_AUTHENTICATION
+	int			ret = FAIL, i, now;
+	CURLcode		err;
+	char			errbuf[CURL_ERROR_SIZE] = "", *key;
+	long			connects;
+	struct curl_slist	*recipients = NULL;
+	smtp_payload_status_t	payload_status;
+	zbx_smtp_session_t	*session;
+
+	now = (int)time(NULL);
+	key = zbx_dsprintf(NULL, "%s:%hu/%s %d %d %d %d %s %s", smtp_server, smtp_port, smtp_helo, (int)smtp_security,
+			(int)smtp_verify_peer, (int)smtp_verify_host, (int)smtp_authentication, username, password);
+	session = smtp_session_get(ZBX_SMTP_SESSION_CURL, key, now);
+	zbx_free(key);
+
+	memset(&payload_status, 0, sizeof(payload_status));
+
+	/* the connection options are set only once, the handle keeps the connection open between transfers */
+	if (NULL == session->easyhandle)
+	{
+		if (NULL == (session->easyhandle = curl_easy_init()))
+		{
+			zbx_strlcpy(error, "cannot initialize cURL library", max_error_len);
+			goto out;
+		}
+
+		if (CURLE_OK != (err = smtp_curl_setopt_session(session->easyhandle, smtp_server, smtp_port, smtp_helo,
+				smtp_security, smtp_verify_peer, smtp_verify_host, smtp_authentication, username,
+				password)))
+		{
+			goto error;
+		}
+	}
+
 	if (0 >= from_mails->values_num)
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() sender's address is not specified", __func__);
+
+		if (CURLE_OK != (err = curl_easy_setopt(session->easyhandle, CURLOPT_MAIL_FROM, NULL)))
+			goto error;
 	}
-	else if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_MAIL_FROM,
+	else if (CURLE_OK != (err = curl_easy_setopt(session->easyhandle, CURLOPT_MAIL_FROM,
 			((zbx_mailaddr_t *)from_mails->values[0])->addr)))
 	{
 		goto error;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")))
-		goto error;
-
 	for (i = 0; i < to_mails->values_num; i++)
 		recipients = curl_slist_append(recipients, ((zbx_mailaddr_t *)to_mails->values[i])->addr);
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_MAIL_RCPT, recipients)))
+	if (CURLE_OK != (err = curl_easy_setopt(session->easyhandle, CURLOPT_MAIL_RCPT, recipients)))
 		goto error;
 
 	payload_status.payload = smtp_prepare_payload(from_mails, to_mails, mailsubject, mailbody, content_type);
 	payload_status.payload_len = strlen(payload_status.payload);
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_UPLOAD, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_READFUNCTION, smtp_provide_payload)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_READDATA, &payload_status)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, (long)timeout)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ERRORBUFFER, errbuf)))
+	if (CURLE_OK != (err = curl_easy_setopt(session->easyhandle, CURLOPT_READDATA, &payload_status)) ||
+			CURLE_OK != (err = curl_easy_setopt(session->easyhandle, CURLOPT_TIMEOUT, (long)timeout)) ||
+			CURLE_OK != (err = curl_easy_setopt(session->easyhandle, CURLOPT_ERRORBUFFER, errbuf)))
 	{
 		goto error;
 	}
 
-	if (NULL != CONFIG_SOURCE_IP)
-	{
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_INTERFACE, CONFIG_SOURCE_IP)))
-			goto error;
-	}
-
-	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE))
-	{
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_VERBOSE, 1L)))
-			goto error;
-
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_DEBUGFUNCTION, smtp_debug_function)))
-			goto error;
-	}
+	session->transactions++;
 
-	if (CURLE_OK != (err = curl_easy_perform(easyhandle)))
+	if (CURLE_OK != (err = curl_easy_perform(session->easyhandle)))
 	{
 		zbx_snprintf(error, max_error_len, "%s%s%s", curl_easy_strerror(err), ('\0' != *errbuf ? ": " : ""),
 				errbuf);
 		goto clean;
 	}
 
+	/* no new connections were made if the pooled connection was reused */
+	if (CURLE_OK == curl_easy_getinfo(session->easyhandle, CURLINFO_NUM_CONNECTS, &connects) && 0 == connects)
+		smtp_reused_num++;
+	else
+		smtp_connected_num++;
+
 	ret = SUCCEED;
 	goto clean;
 error:
@@ -740,9 +1018,18 @@ error:
 clean:
 	zbx_free(payload_status.payload);
 
+	/* do not leave references to local data in the pooled handle */
+	if (NULL != session->easyhandle)
+	{
+		curl_easy_setopt(session->easyhandle, CURLOPT_MAIL_RCPT, NULL);
+		curl_easy_setopt(session->easyhandle, CURLOPT_READDATA, NULL);
+		curl_easy_setopt(session->easyhandle, CURLOPT_ERRORBUFFER, NULL);
+	}
+
 	curl_slist_free_all(recipients);
-	curl_easy_cleanup(easyhandle);
 out:
+	smtp_session_release(session, ret, now);
+
 	return ret;
 #else
 	ZBX_UNUSED(smtp_server);
@@ -766,6 +1053,52 @@ out:
 #endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enables reuse of SMTP sessions between sent emails                *
+ *                                                                            *
+ * Parameters: idle_timeout - [IN] the time idle sessions are kept open       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_smtp_pool_init(int idle_timeout)
+{
+	zbx_vector_ptr_create(&smtp_sessions);
+	smtp_idle_timeout = idle_timeout;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: closes pooled SMTP sessions                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_smtp_pool_destroy(void)
+{
+	if (0 == smtp_idle_timeout)
+		return;
+
+	zbx_vector_ptr_clear_ext(&smtp_sessions, (zbx_clean_func_t)smtp_session_free);
+	zbx_vector_ptr_destroy(&smtp_sessions);
+	smtp_idle_timeout = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets and resets SMTP session statistics                           *
+ *                                                                            *
+ * Parameters: connected_num - [OUT] the number of new SMTP connections       *
+ *             reused_num    - [OUT] the number of emails sent over pooled    *
+ *                                   connections                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_smtp_pool_get_stats(int *connected_num, int *reused_num)
+{
+	*connected_num = smtp_connected_num;
+	*reused_num = smtp_reused_num;
+
+	smtp_connected_num = 0;
+	smtp_reused_num = 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: frees the mail address object                                     *
@@ -118,6 +118,10 @@ extern int	CONFIG_PREPROCESSOR_FORKS;
 extern int	CONFIG_LLDMANAGER_FORKS;
 extern int	CONFIG_LLDWORKER_FORKS;
 extern int	CONFIG_ALERTDB_FORKS;
+extern int	CONFIG_TRAPPERMAN_FORKS;
+extern int	CONFIG_ESCALATIONMAN_FORKS;
+extern int	CONFIG_HTTPAGENT_POLLER_FORKS;
+extern int	CONFIG_DNSRESOLVER_FORKS;
 
 extern unsigned char	process_type;
 extern int		process_num;
@@ -199,6 +203,14 @@ int	get_process_type_forks(unsigned char proc_type)
 			return CONFIG_LLDWORKER_FORKS;
 		case ZBX_PROCESS_TYPE_ALERTSYNCER:
 			return CONFIG_ALERTDB_FORKS;
+		case ZBX_PROCESS_TYPE_TRAPPERMAN:
+			return CONFIG_TRAPPERMAN_FORKS;
+		case ZBX_PROCESS_TYPE_ESCALATIONMAN:
+			return CONFIG_ESCALATIONMAN_FORKS;
+		case ZBX_PROCESS_TYPE_HTTPAGENTPOLLER:
+			return CONFIG_HTTPAGENT_POLLER_FORKS;
+		case ZBX_PROCESS_TYPE_DNSRESOLVER:
+			return CONFIG_DNSRESOLVER_FORKS;
 	}
 
 	THIS_SHOULD_NEVER_HAPPEN;
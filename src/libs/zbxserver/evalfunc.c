@@ -3180,3 +3180,70 @@ int	evaluatable_for_notsupported(const char *fn)
 
 	return FAIL;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if function result depends only on the latest item values   *
+ *                                                                            *
+ * Parameters: fn         - [IN] function name                                *
+ *             parameters - [IN] function parameters                          *
+ *                                                                            *
+ * Return value: SUCCEED - the function result can change only when the       *
+ *                         item receives new values                           *
+ *               FAIL    - the function result can change with time or        *
+ *                         configuration                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	evaluatable_by_last_values(const char *fn, const char *parameters)
+{
+	/* the sec|#num parameter and time_shift parameter numbers, 0 if function does not have them */
+	static const struct
+	{
+		const char	*name;
+		int		period_param;
+		int		time_shift_param;
+	}
+	functions[] = {
+		{"last", 1, 2}, {"prev", 0, 0}, {"diff", 0, 0}, {"change", 0, 0}, {"abschange", 0, 0},
+		{"avg", 1, 2}, {"min", 1, 2}, {"max", 1, 2}, {"sum", 1, 2}, {"delta", 1, 2},
+		{"count", 1, 4}, {"band", 1, 3}, {"strlen", 1, 2}, {"percentile", 1, 2},
+		{"str", 2, 0}, {"regexp", 2, 0}, {"iregexp", 2, 0},
+		{"logeventid", 0, 0}, {"logseverity", 0, 0}, {"logsource", 0, 0},
+		{NULL, 0, 0}
+	};
+	int	i, ret = SUCCEED;
+	char	*param;
+
+	/* user macros and global regular expressions can be changed without new item values */
+	if (NULL != strchr(parameters, '{') || NULL != strchr(parameters, '@'))
+		return FAIL;
+
+	for (i = 0; NULL != functions[i].name; i++)
+	{
+		if (0 == strcmp(functions[i].name, fn))
+			break;
+	}
+
+	if (NULL == functions[i].name)
+		return FAIL;
+
+	if (0 != functions[i].period_param &&
+			NULL != (param = zbx_function_get_param_dyn(parameters, functions[i].period_param)))
+	{
+		if ('\0' != *param && '#' != *param)
+			ret = FAIL;
+
+		zbx_free(param);
+	}
+
+	if (SUCCEED == ret && 0 != functions[i].time_shift_param &&
+			NULL != (param = zbx_function_get_param_dyn(parameters, functions[i].time_shift_param)))
+	{
+		if ('\0' != *param)
+			ret = FAIL;
+
+		zbx_free(param);
+	}
+
+	return ret;
+}
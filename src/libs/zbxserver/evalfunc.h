@@ -23,5 +23,6 @@
 int	evaluate_macro_function(char **result, const char *host, const char *key, const char *function,
 		const char *parameter);
 int	evaluatable_for_notsupported(const char *fn);
+int	evaluatable_by_last_values(const char *fn, const char *parameters);
 
 #endif
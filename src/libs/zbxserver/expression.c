@@ -4892,6 +4892,180 @@ static void	func_clean(void *ptr)
 	zbx_free(func->error);
 }
 
+/* cached result of a function that depends only on the latest item values */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	char		*function;
+	char		*parameter;
+	char		*value;
+	zbx_uint64_t	value_revision;
+	zbx_timespec_t	timespec;
+	int		lastaccess;
+	unsigned char	value_type;
+}
+zbx_func_result_t;
+
+static zbx_hashset_t	func_results;
+static int		func_results_cleanup;
+
+#define ZBX_FUNC_RESULTS_CLEANUP_PERIOD	SEC_PER_HOUR
+
+static zbx_hash_t	func_result_hash_func(const void *data)
+{
+	const zbx_func_result_t	*result = (const zbx_func_result_t *)data;
+	zbx_hash_t		hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&result->itemid);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(result->function, strlen(result->function), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(result->parameter, strlen(result->parameter), hash);
+
+	return hash;
+}
+
+static int	func_result_compare_func(const void *d1, const void *d2)
+{
+	const zbx_func_result_t	*result1 = (const zbx_func_result_t *)d1;
+	const zbx_func_result_t	*result2 = (const zbx_func_result_t *)d2;
+	int			ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(result1->itemid, result2->itemid);
+
+	if (0 != (ret = strcmp(result1->function, result2->function)))
+		return ret;
+
+	return strcmp(result1->parameter, result2->parameter);
+}
+
+static void	func_result_clean(void *ptr)
+{
+	zbx_func_result_t	*result = (zbx_func_result_t *)ptr;
+
+	zbx_free(result->function);
+	zbx_free(result->parameter);
+	zbx_free(result->value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get cached function result                                        *
+ *                                                                            *
+ * Parameters: func  - [IN] the function to evaluate                          *
+ *             item  - [IN] the function item                                 *
+ *             value - [OUT] the cached function result                       *
+ *                                                                            *
+ * Return value: SUCCEED - the item did not receive new values since the      *
+ *                         result was cached, cached value is returned        *
+ *               FAIL    - the function must be evaluated                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	func_result_get(const zbx_func_t *func, const DC_ITEM *item, char *value)
+{
+	zbx_func_result_t	*result, result_local;
+
+	if (0 == func_results.num_slots)
+		return FAIL;
+
+	result_local.itemid = func->itemid;
+	result_local.function = func->function;
+	result_local.parameter = func->parameter;
+
+	if (NULL == (result = (zbx_func_result_t *)zbx_hashset_search(&func_results, &result_local)))
+		return FAIL;
+
+	if (result->value_revision != item->value_revision || result->value_type != item->value_type ||
+			0 > zbx_timespec_compare(&func->timespec, &result->timespec))
+	{
+		return FAIL;
+	}
+
+	result->lastaccess = (int)time(NULL);
+	zbx_strlcpy(value, result->value, MAX_BUFFER_LEN);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache function result if it can be reused until the item receives *
+ *          new values                                                        *
+ *                                                                            *
+ * Parameters: func  - [IN] the evaluated function                            *
+ *             item  - [IN] the function item                                 *
+ *             value - [IN] the function result                               *
+ *                                                                            *
+ * Comments: Results are cached only when the function was evaluated at or    *
+ *           after the newest item value, otherwise a value with timestamp    *
+ *           between the evaluation time and the newest value would not be    *
+ *           taken into account by later evaluations.                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	func_result_set(const zbx_func_t *func, const DC_ITEM *item, const char *value)
+{
+	zbx_func_result_t	*result, result_local;
+
+	if (ITEM_STATE_NORMAL != item->state || 0 > zbx_timespec_compare(&func->timespec, &item->value_ts))
+		return;
+
+	if (SUCCEED != evaluatable_by_last_values(func->function, func->parameter))
+		return;
+
+	if (0 == func_results.num_slots)
+	{
+		zbx_hashset_create_ext(&func_results, 100, func_result_hash_func, func_result_compare_func,
+				func_result_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+		func_results_cleanup = (int)time(NULL);
+	}
+
+	result_local.itemid = func->itemid;
+	result_local.function = func->function;
+	result_local.parameter = func->parameter;
+
+	if (NULL == (result = (zbx_func_result_t *)zbx_hashset_search(&func_results, &result_local)))
+	{
+		result = (zbx_func_result_t *)zbx_hashset_insert(&func_results, &result_local, sizeof(result_local));
+		result->function = zbx_strdup(NULL, func->function);
+		result->parameter = zbx_strdup(NULL, func->parameter);
+		result->value = NULL;
+	}
+
+	result->value = zbx_strdup(result->value, value);
+	result->value_revision = item->value_revision;
+	result->value_type = item->value_type;
+	result->timespec = func->timespec;
+	result->lastaccess = (int)time(NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove cached function results that were not used for a while     *
+ *                                                                            *
+ ******************************************************************************/
+static void	func_results_remove_unused(void)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_func_result_t	*result;
+	int			now;
+
+	if (0 == func_results.num_slots)
+		return;
+
+	now = (int)time(NULL);
+
+	if (func_results_cleanup + ZBX_FUNC_RESULTS_CLEANUP_PERIOD > now)
+		return;
+
+	zbx_hashset_iter_reset(&func_results, &iter);
+	while (NULL != (result = (zbx_func_result_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (result->lastaccess + ZBX_FUNC_RESULTS_CLEANUP_PERIOD <= now)
+			zbx_hashset_iter_remove(&iter);
+	}
+
+	func_results_cleanup = now;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: prepare hashset of functions to evaluate                          *
@@ -4965,7 +5139,18 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ifuncs_num:%d", __func__, ifuncs->num_data);
 }
 
-static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *unknown_msgs)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: evaluate trigger functions                                        *
+ *                                                                            *
+ * Parameters: funcs        - [IN/OUT] functions to evaluate                  *
+ *             unknown_msgs - [OUT] messages for NOTSUPPORTED items and       *
+ *                                  failed functions                          *
+ *             stats        - [OUT] number of evaluated and cached functions  *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *unknown_msgs,
+		zbx_trigger_eval_stats_t *stats)
 {
 	DC_ITEM			*items = NULL;
 	char			value[MAX_BUFFER_LEN], *error = NULL;
@@ -5043,6 +5228,13 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 			ret_unknown = 1;
 		}
 
+		if (0 == ret_unknown && SUCCEED == func_result_get(func, &items[i], value))
+		{
+			func->value = zbx_strdup(func->value, value);
+			stats->cached++;
+			continue;
+		}
+
 		if (0 == ret_unknown && SUCCEED != evaluate_function(value, &items[i], func->function,
 				func->parameter, &func->timespec, &error))
 		{
@@ -5074,6 +5266,8 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 		if (0 == ret_unknown)
 		{
 			func->value = zbx_strdup(func->value, value);
+			func_result_set(func, &items[i], value);
+			stats->evaluated++;
 		}
 		else
 		{
@@ -5090,7 +5284,10 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 	zbx_free(errcodes);
 	zbx_free(items);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	func_results_remove_unused();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() evaluated:%d cached:%d", __func__, stats->evaluated,
+			stats->cached);
 }
 
 static int	substitute_expression_functions_results(zbx_hashset_t *ifuncs, char *expression, char **out,
@@ -5157,12 +5354,256 @@ static int	substitute_expression_functions_results(zbx_hashset_t *ifuncs, char *
 	return SUCCEED;
 }
 
+/* trigger expression compiled for evaluation without substituting function values into the text */
+typedef struct
+{
+	char		*expression;
+	zbx_eval_code_t	code;
+	int		compiled;	/* SUCCEED if expression was compiled, FAIL otherwise */
+	int		lastaccess;
+}
+zbx_expression_code_t;
+
+static zbx_hashset_t	expression_codes;
+static int		expression_codes_cleanup;
+
+#define ZBX_EXPRESSION_CODES_CLEANUP_PERIOD	SEC_PER_HOUR
+
+static zbx_hash_t	expression_code_hash_func(const void *data)
+{
+	const zbx_expression_code_t	*ec = (const zbx_expression_code_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(ec->expression);
+}
+
+static int	expression_code_compare_func(const void *d1, const void *d2)
+{
+	const zbx_expression_code_t	*ec1 = (const zbx_expression_code_t *)d1;
+	const zbx_expression_code_t	*ec2 = (const zbx_expression_code_t *)d2;
+
+	return strcmp(ec1->expression, ec2->expression);
+}
+
+static void	expression_code_clean(void *ptr)
+{
+	zbx_expression_code_t	*ec = (zbx_expression_code_t *)ptr;
+
+	zbx_free(ec->expression);
+	zbx_eval_code_clear(&ec->code);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get compiled trigger expression, compile it if necessary          *
+ *                                                                            *
+ * Parameters: expression - [IN] the trigger expression with expanded macros  *
+ *                                                                            *
+ * Return value: the compiled expression or NULL if the expression cannot be  *
+ *               compiled                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_eval_code_t	*expression_code_get(const char *expression)
+{
+	zbx_expression_code_t	*ec, ec_local;
+	char			error[MAX_STRING_LEN];
+
+	if (0 == expression_codes.num_slots)
+	{
+		zbx_hashset_create_ext(&expression_codes, 100, expression_code_hash_func, expression_code_compare_func,
+				expression_code_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+		expression_codes_cleanup = (int)time(NULL);
+	}
+
+	ec_local.expression = (char *)expression;
+
+	if (NULL == (ec = (zbx_expression_code_t *)zbx_hashset_search(&expression_codes, &ec_local)))
+	{
+		ec = (zbx_expression_code_t *)zbx_hashset_insert(&expression_codes, &ec_local, sizeof(ec_local));
+		ec->expression = zbx_strdup(NULL, expression);
+
+		if (FAIL == (ec->compiled = zbx_eval_compile(expression, &ec->code, error, sizeof(error))))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot compile trigger expression \"%s\": %s", expression,
+					error);
+		}
+	}
+
+	ec->lastaccess = (int)time(NULL);
+
+	return SUCCEED == ec->compiled ? &ec->code : NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove compiled expressions that were not used for a while        *
+ *                                                                            *
+ ******************************************************************************/
+static void	expression_codes_remove_unused(void)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_expression_code_t	*ec;
+	int			now;
+
+	if (0 == expression_codes.num_slots)
+		return;
+
+	now = (int)time(NULL);
+
+	if (expression_codes_cleanup + ZBX_EXPRESSION_CODES_CLEANUP_PERIOD > now)
+		return;
+
+	zbx_hashset_iter_reset(&expression_codes, &iter);
+	while (NULL != (ec = (zbx_expression_code_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (ec->lastaccess + ZBX_EXPRESSION_CODES_CLEANUP_PERIOD <= now)
+			zbx_hashset_iter_remove(&iter);
+	}
+
+	expression_codes_cleanup = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: convert function value to compiled expression operand             *
+ *                                                                            *
+ * Return value: SUCCEED - the value was converted                            *
+ *               FAIL    - the value is not a plain number, the expression    *
+ *                         must be evaluated in its textual form              *
+ *                                                                            *
+ * Comments: Accepts the same values as evaluate() would accept when the      *
+ *           function value is substituted into the expression.               *
+ *                                                                            *
+ ******************************************************************************/
+static int	expression_code_value(const char *value, zbx_eval_value_t *eval_value)
+{
+	const char	*ptr = value;
+	int		len;
+
+	if (0 == strncmp(ZBX_UNKNOWN_STR, value, ZBX_UNKNOWN_STR_LEN))
+	{
+		for (ptr += ZBX_UNKNOWN_STR_LEN; 0 != isdigit((unsigned char)*ptr); ptr++)
+			;
+
+		if (ptr == value + ZBX_UNKNOWN_STR_LEN || '\0' != *ptr)
+			return FAIL;
+
+		eval_value->value = ZBX_UNKNOWN;
+		eval_value->unknown_idx = atoi(value + ZBX_UNKNOWN_STR_LEN);
+
+		return SUCCEED;
+	}
+
+	/* negative values are substituted in parentheses and parsed as unary minus */
+	if ('-' == *ptr)
+		ptr++;
+
+	if (SUCCEED != zbx_suffixed_number_parse(ptr, &len) || '\0' != ptr[len])
+		return FAIL;
+
+	eval_value->value = atof(ptr) * suffix2factor(ptr[len - 1]);
+
+	if (ZBX_INFINITY == eval_value->value)
+		return FAIL;
+
+	if (ptr != value)
+		eval_value->value = -eval_value->value;
+
+	eval_value->unknown_idx = -1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: evaluate trigger expression with compiled code                    *
+ *                                                                            *
+ * Parameters: ifuncs     - [IN] function index by functionid                 *
+ *             expression - [IN] the trigger expression                       *
+ *             out        - [OUT] the evaluation result in the form accepted  *
+ *                                by evaluate(): "1", "0" or "ZBX_UNKNOWN<N>" *
+ *             out_alloc  - [IN/OUT] the output buffer size                   *
+ *             error      - [OUT] the error message                           *
+ *                                                                            *
+ * Return value: SUCCEED      - the expression was evaluated                  *
+ *               FAIL         - the expression evaluation failed              *
+ *               NOTSUPPORTED - the expression must be evaluated after        *
+ *                              substituting function values                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	evaluate_expression_code(zbx_hashset_t *ifuncs, const char *expression, char **out,
+		size_t *out_alloc, char **error)
+{
+	const zbx_eval_code_t	*code;
+	zbx_eval_value_t	*values, result;
+	zbx_ifunc_t		*ifunc;
+	zbx_func_t		*func;
+	char			err[MAX_STRING_LEN];
+	int			i, ret = NOTSUPPORTED;
+
+	if (NULL == (code = expression_code_get(expression)))
+		return NOTSUPPORTED;
+
+	values = (zbx_eval_value_t *)zbx_malloc(NULL, sizeof(zbx_eval_value_t) *
+			(size_t)MAX(1, code->functionids.values_num));
+
+	/* report function errors in the same order as substitute_expression_functions_results() */
+	for (i = 0; i < code->functionids.values_num; i++)
+	{
+		if (NULL == (ifunc = (zbx_ifunc_t *)zbx_hashset_search(ifuncs, &code->functionids.values[i])))
+		{
+			*error = zbx_dsprintf(*error, "Cannot obtain function"
+					" and item for functionid: " ZBX_FS_UI64, code->functionids.values[i]);
+			ret = FAIL;
+			goto out;
+		}
+
+		func = ifunc->func;
+
+		if (NULL != func->error)
+		{
+			*error = zbx_strdup(*error, func->error);
+			ret = FAIL;
+			goto out;
+		}
+
+		if (NULL == func->value)
+		{
+			*error = zbx_strdup(*error, "Unexpected error while processing a trigger expression");
+			ret = FAIL;
+			goto out;
+		}
+
+		if (SUCCEED != expression_code_value(func->value, &values[i]))
+			goto out;
+	}
+
+	if (SUCCEED != (ret = zbx_eval_execute(code, values, &result, err, sizeof(err))))
+	{
+		if (FAIL == ret)
+			*error = zbx_strdup(*error, err);
+
+		goto out;
+	}
+
+	if (ZBX_UNKNOWN == result.value)
+		zbx_snprintf(*out, *out_alloc, ZBX_UNKNOWN_STR "%d", result.unknown_idx);
+	else
+		zbx_strlcpy(*out, SUCCEED != zbx_double_compare(result.value, 0.0) ? "1" : "0", *out_alloc);
+
+	ret = SUCCEED;
+out:
+	zbx_free(values);
+
+	return ret;
+}
+
 static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_ptr_t *triggers)
 {
 	DC_TRIGGER	*tr;
 	char		*out = NULL;
 	size_t		out_alloc = TRIGGER_EXPRESSION_LEN_MAX;
-	int		i;
+	int		i, ret;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() ifuncs_num:%d tr_num:%d",
 			__func__, ifuncs->num_data, triggers->values_num);
@@ -5176,8 +5617,14 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
 		if (NULL != tr->new_error)
 			continue;
 
-		if( SUCCEED != substitute_expression_functions_results(ifuncs, tr->expression, &out, &out_alloc,
-				&tr->new_error))
+		if (NOTSUPPORTED == (ret = evaluate_expression_code(ifuncs, tr->expression, &out, &out_alloc,
+				&tr->new_error)))
+		{
+			ret = substitute_expression_functions_results(ifuncs, tr->expression, &out, &out_alloc,
+					&tr->new_error);
+		}
+
+		if (SUCCEED != ret)
 		{
 			tr->new_value = TRIGGER_VALUE_UNKNOWN;
 			continue;
@@ -5189,8 +5636,14 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
 
 		if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == tr->recovery_mode)
 		{
-			if (SUCCEED != substitute_expression_functions_results(ifuncs,
-					tr->recovery_expression, &out, &out_alloc, &tr->new_error))
+			if (NOTSUPPORTED == (ret = evaluate_expression_code(ifuncs, tr->recovery_expression, &out,
+					&out_alloc, &tr->new_error)))
+			{
+				ret = substitute_expression_functions_results(ifuncs, tr->recovery_expression, &out,
+						&out_alloc, &tr->new_error);
+			}
+
+			if (SUCCEED != ret)
 			{
 				tr->new_value = TRIGGER_VALUE_UNKNOWN;
 				continue;
@@ -5205,6 +5658,8 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
 
 	zbx_free(out);
 
+	expression_codes_remove_unused();
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -5216,13 +5671,15 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
  *                             triggerids                                     *
  *             unknown_msgs - vector for storing messages for NOTSUPPORTED    *
  *                            items and failed functions                      *
+ *             stats        - [OUT] number of evaluated and cached functions  *
  *                                                                            *
  * Author: Alexei Vladishev, Alexander Vladishev, Aleksandrs Saveljevs        *
  *                                                                            *
  * Comments: example: "({15}>10) or ({123}=1)" => "(26.416>10) or (0=1)"      *
  *                                                                            *
  ******************************************************************************/
-static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_vector_ptr_t *unknown_msgs)
+static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_vector_ptr_t *unknown_msgs,
+		zbx_trigger_eval_stats_t *stats)
 {
 	zbx_vector_uint64_t	functionids;
 	zbx_hashset_t		ifuncs, funcs;
@@ -5245,7 +5702,7 @@ static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_vector_ptr_t *u
 
 	if (0 != ifuncs.num_data)
 	{
-		zbx_evaluate_item_functions(&funcs, unknown_msgs);
+		zbx_evaluate_item_functions(&funcs, unknown_msgs, stats);
 		zbx_substitute_functions_results(&ifuncs, triggers);
 	}
 
@@ -5263,11 +5720,13 @@ empty:
  *                                                                            *
  * Parameters: triggers - [IN] vector of DC_TRIGGGER pointers, sorted by      *
  *                             triggerids                                     *
+ *             stats    - [OUT] number of evaluated and cached functions,     *
+ *                              can be NULL                                   *
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
  ******************************************************************************/
-void	evaluate_expressions(zbx_vector_ptr_t *triggers)
+void	evaluate_expressions(zbx_vector_ptr_t *triggers, zbx_trigger_eval_stats_t *stats)
 {
 	DB_EVENT		event;
 	DC_TRIGGER		*tr;
@@ -5275,9 +5734,13 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 	double			expr_result;
 	zbx_vector_ptr_t	unknown_msgs;	    /* pointers to messages about origins of 'unknown' values */
 	char			err[MAX_STRING_LEN];
+	zbx_trigger_eval_stats_t	stats_local = {0, 0};
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() tr_num:%d", __func__, triggers->values_num);
 
+	if (NULL == stats)
+		stats = &stats_local;
+
 	event.object = EVENT_OBJECT_TRIGGER;
 
 	for (i = 0; i < triggers->values_num; i++)
@@ -5297,7 +5760,7 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 	/* Therefore initialize error messages vector but do not reserve any space. */
 	zbx_vector_ptr_create(&unknown_msgs);
 
-	substitute_functions(triggers, &unknown_msgs);
+	substitute_functions(triggers, &unknown_msgs, stats);
 
 	/* calculate new trigger values based on their recovery modes and expression evaluations */
 	for (i = 0; i < triggers->values_num; i++)
@@ -6278,3 +6741,7 @@ int	xml_xpath_check(const char *xpath, char *error, size_t errlen)
 	return SUCCEED;
 #endif
 }
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/libs/zbxserver/expression_test.c"
+#endif
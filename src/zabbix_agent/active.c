@@ -30,6 +30,9 @@
 #include "zbxjson.h"
 #include "alias.h"
 #include "metrics.h"
+#ifndef _WINDOWS
+#	include "active_spool.h"
+#endif
 
 extern unsigned char			program_type;
 extern ZBX_THREAD_LOCAL unsigned char	process_type;
@@ -48,6 +51,10 @@ static ZBX_THREAD_LOCAL zbx_vector_ptr_t	active_metrics;
 static ZBX_THREAD_LOCAL zbx_vector_ptr_t	regexps;
 static ZBX_THREAD_LOCAL char			*session_token;
 static ZBX_THREAD_LOCAL zbx_uint64_t		last_valueid = 0;
+static ZBX_THREAD_LOCAL zbx_uint64_t		config_revision = 0;
+#ifndef _WINDOWS
+static ZBX_THREAD_LOCAL zbx_active_spool_t	spool;
+#endif
 
 static void	init_active_metrics(void)
 {
@@ -66,7 +73,24 @@ static void	init_active_metrics(void)
 		buffer.lastsent = (int)time(NULL);
 		buffer.first_error = 0;
 	}
+#ifndef _WINDOWS
+	if (NULL != CONFIG_BUFFER_SPOOL_FILE && NULL == spool.data)
+	{
+		char	*path, *error = NULL;
+
+		/* each active checks process has its own spool file */
+		path = zbx_dsprintf(NULL, "%s.%d", CONFIG_BUFFER_SPOOL_FILE, process_num);
+
+		if (SUCCEED != zbx_active_spool_open(&spool, path, CONFIG_BUFFER_SPOOL_SIZE, &last_valueid, &error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot open buffer spool, values will be kept in memory only: %s",
+					error);
+			zbx_free(error);
+		}
 
+		zbx_free(path);
+	}
+#endif
 	zbx_vector_ptr_create(&active_metrics);
 	zbx_vector_ptr_create(&regexps);
 
@@ -291,7 +315,7 @@ static int	parse_list_of_checks(char *str, const char *host, unsigned short port
 	const char		*p;
 	char			name[MAX_STRING_LEN], key_orig[MAX_STRING_LEN], expression[MAX_STRING_LEN],
 				tmp[MAX_STRING_LEN], exp_delimiter;
-	zbx_uint64_t		lastlogsize;
+	zbx_uint64_t		lastlogsize, revision = 0;
 	struct zbx_json_parse	jp;
 	struct zbx_json_parse	jp_data, jp_row;
 	ZBX_ACTIVE_METRIC	*metric;
@@ -324,8 +348,24 @@ static int	parse_list_of_checks(char *str, const char *host, unsigned short port
 		goto out;
 	}
 
+	if (SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_CONFIG_REVISION, tmp, sizeof(tmp), NULL) &&
+			SUCCEED != is_uint64(tmp, &revision))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot parse list of active checks: invalid value of tag \"%s\"",
+				ZBX_PROTO_TAG_CONFIG_REVISION);
+		goto out;
+	}
+
 	if (SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data))
 	{
+		/* the list was not sent because it has not changed since the last refresh */
+		if (0 != revision && revision == config_revision)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "active check list has not changed");
+			ret = SUCCEED;
+			goto out;
+		}
+
 		zabbix_log(LOG_LEVEL_ERR, "cannot parse list of active checks: %s", zbx_json_strerror());
 		goto out;
 	}
@@ -477,8 +517,12 @@ static int	parse_list_of_checks(char *str, const char *host, unsigned short port
 		}
 	}
 
+	config_revision = revision;
 	ret = SUCCEED;
 out:
+	if (SUCCEED != ret)
+		config_revision = 0;
+
 	zbx_vector_str_clear_ext(&received_metrics, zbx_str_free);
 	zbx_vector_str_destroy(&received_metrics);
 
@@ -613,6 +657,9 @@ static int	refresh_active_checks(const char *host, unsigned short port)
 	if (ZBX_DEFAULT_AGENT_PORT != CONFIG_LISTEN_PORT)
 		zbx_json_adduint64(&json, ZBX_PROTO_TAG_PORT, CONFIG_LISTEN_PORT);
 
+	if (0 != config_revision)
+		zbx_json_adduint64(&json, ZBX_PROTO_TAG_CONFIG_REVISION, config_revision);
+
 	switch (configured_tls_connect_mode)
 	{
 		case ZBX_TCP_SEC_UNENCRYPTED:
@@ -717,51 +764,90 @@ static int	check_response(char *response)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: Send value stored in the buffer to Zabbix server                  *
+ * Purpose: fills buffer element with a new value                             *
  *                                                                            *
- * Parameters: host - IP or Hostname of Zabbix server                         *
- *             port - port number                                             *
+ ******************************************************************************/
+static void	init_buffer_element(ZBX_ACTIVE_BUFFER_ELEMENT *el, const char *host, const char *key, const char *value,
+		unsigned char state, const zbx_uint64_t *lastlogsize, const int *mtime, const unsigned long *timestamp,
+		const char *source, const unsigned short *severity, const unsigned long *logeventid, unsigned char flags)
+{
+	memset(el, 0, sizeof(ZBX_ACTIVE_BUFFER_ELEMENT));
+	el->host = zbx_strdup(NULL, host);
+	el->key = zbx_strdup(NULL, key);
+	if (NULL != value)
+		el->value = zbx_strdup(NULL, value);
+	el->state = state;
+
+	if (NULL != source)
+		el->source = strdup(source);
+	if (NULL != severity)
+		el->severity = *severity;
+	if (NULL != lastlogsize)
+		el->lastlogsize = *lastlogsize;
+	if (NULL != mtime)
+		el->mtime = *mtime;
+	if (NULL != timestamp)
+		el->timestamp = *timestamp;
+	if (NULL != logeventid)
+		el->logeventid = (int)*logeventid;
+
+	zbx_timespec(&el->ts);
+	el->flags = flags;
+	el->id = ++last_valueid;
+}
+
+/******************************************************************************
  *                                                                            *
- * Return value: returns SUCCEED on successful sending,                       *
- *               FAIL on other cases                                          *
+ * Purpose: frees data of buffer elements                                     *
  *                                                                            *
- * Author: Alexei Vladishev                                                   *
+ ******************************************************************************/
+static void	free_buffer_elements(ZBX_ACTIVE_BUFFER_ELEMENT *elements, int count)
+{
+	int	i;
+
+	for (i = 0; i < count; i++)
+	{
+		ZBX_ACTIVE_BUFFER_ELEMENT	*el = &elements[i];
+
+		zbx_free(el->host);
+		zbx_free(el->key);
+		zbx_free(el->value);
+		zbx_free(el->source);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: Send buffer elements to Zabbix server                             *
+ *                                                                            *
+ * Parameters: host          - IP or Hostname of Zabbix server                *
+ *             port          - port number                                    *
+ *             elements      - the elements to send                           *
+ *             count         - the number of elements                         *
+ *             err_send_step - the failed step, for error messages            *
+ *                                                                            *
+ * Return value: returns SUCCEED if server accepted the data,                 *
+ *               FAIL on other cases                                          *
  *                                                                            *
  ******************************************************************************/
-static int	send_buffer(const char *host, unsigned short port)
+static int	send_elements(const char *host, unsigned short port, const ZBX_ACTIVE_BUFFER_ELEMENT *elements,
+		int count, const char **err_send_step)
 {
-	ZBX_ACTIVE_BUFFER_ELEMENT	*el;
-	int				ret = SUCCEED, i, now;
+	const ZBX_ACTIVE_BUFFER_ELEMENT	*el;
+	int				ret = SUCCEED, i;
 	char				*tls_arg1, *tls_arg2;
 	zbx_timespec_t			ts;
-	const char			*err_send_step = "";
 	zbx_socket_t			s;
 	struct zbx_json 		json;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' port:%d entries:%d/%d",
-			__func__, host, port, buffer.count, CONFIG_BUFFER_SIZE);
-
-	if (0 == buffer.count)
-		goto ret;
-
-	now = (int)time(NULL);
-
-	if (CONFIG_BUFFER_SIZE / 2 > buffer.pcount && CONFIG_BUFFER_SIZE > buffer.count &&
-			CONFIG_BUFFER_SEND > now - buffer.lastsent)
-	{
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() now:%d lastsent:%d now-lastsent:%d BufferSend:%d; will not send now",
-				__func__, now, buffer.lastsent, now - buffer.lastsent, CONFIG_BUFFER_SEND);
-		goto ret;
-	}
-
 	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_AGENT_DATA, ZBX_JSON_TYPE_STRING);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_SESSION, session_token, ZBX_JSON_TYPE_STRING);
 	zbx_json_addarray(&json, ZBX_PROTO_TAG_DATA);
 
-	for (i = 0; i < buffer.count; i++)
+	for (i = 0; i < count; i++)
 	{
-		el = &buffer.data[i];
+		el = &elements[i];
 
 		zbx_json_addobject(&json, NULL);
 		zbx_json_addstring(&json, ZBX_PROTO_TAG_HOST, el->host, ZBX_JSON_TYPE_STRING);
@@ -826,7 +912,7 @@ static int	send_buffer(const char *host, unsigned short port)
 			goto out;
 	}
 
-	if (SUCCEED == (ret = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, host, port, MIN(buffer.count * CONFIG_TIMEOUT, 60),
+	if (SUCCEED == (ret = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, host, port, MIN(count * CONFIG_TIMEOUT, 60),
 			configured_tls_connect_mode, tls_arg1, tls_arg2)))
 	{
 		zbx_timespec(&ts);
@@ -850,32 +936,30 @@ static int	send_buffer(const char *host, unsigned short port)
 					zabbix_log(LOG_LEVEL_DEBUG, "OK");
 			}
 			else
-				err_send_step = "[recv] ";
+				*err_send_step = "[recv] ";
 		}
 		else
-			err_send_step = "[send] ";
+			*err_send_step = "[send] ";
 
 		zbx_tcp_close(&s);
 	}
 	else
-		err_send_step = "[connect] ";
+		*err_send_step = "[connect] ";
 out:
 	zbx_json_free(&json);
 
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: update upload state after sending data to Zabbix server           *
+ *                                                                            *
+ ******************************************************************************/
+static void	update_send_state(const char *host, unsigned short port, int ret, int now, const char *err_send_step)
+{
 	if (SUCCEED == ret)
 	{
-		/* free buffer */
-		for (i = 0; i < buffer.count; i++)
-		{
-			el = &buffer.data[i];
-
-			zbx_free(el->host);
-			zbx_free(el->key);
-			zbx_free(el->value);
-			zbx_free(el->source);
-		}
-		buffer.count = 0;
-		buffer.pcount = 0;
 		buffer.lastsent = now;
 		if (0 != buffer.first_error)
 		{
@@ -894,12 +978,169 @@ out:
 		}
 		zabbix_log(LOG_LEVEL_DEBUG, "send value error: %s%s", err_send_step, zbx_socket_strerror());
 	}
+}
+
+#ifndef _WINDOWS
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send values stored in the spool file to Zabbix server             *
+ *                                                                            *
+ * Parameters: host - IP or Hostname of Zabbix server                         *
+ *             port - port number                                             *
+ *                                                                            *
+ * Return value: returns SUCCEED if there were no sending errors,             *
+ *               FAIL on other cases                                          *
+ *                                                                            *
+ * Comments: Values are sent in batches of BufferSize elements. While server  *
+ *           is unreachable the sending is retried once per BufferSend        *
+ *           seconds instead of on every new value.                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	send_spool(const char *host, unsigned short port)
+{
+#define ZBX_SPOOL_SEND_TIME	1	/* maximum time to spend draining spool in one call */
+
+	ZBX_ACTIVE_BUFFER_ELEMENT	*elements;
+	int				ret = SUCCEED, count, now;
+	const char			*err_send_step = "";
+	double				time_start;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' port:%d spooled:%d", __func__, host, port,
+			spool.records_num);
+
+	now = (int)time(NULL);
+
+	if (CONFIG_BUFFER_SIZE > spool.records_num && CONFIG_BUFFER_SEND > now - buffer.lastsent)
+		goto ret;
+
+	elements = (ZBX_ACTIVE_BUFFER_ELEMENT *)zbx_malloc(NULL, CONFIG_BUFFER_SIZE * sizeof(ZBX_ACTIVE_BUFFER_ELEMENT));
+	time_start = zbx_time();
+
+	do
+	{
+		count = zbx_active_spool_read(&spool, elements, CONFIG_BUFFER_SIZE);
+
+		if (SUCCEED == (ret = send_elements(host, port, elements, count, &err_send_step)))
+			zbx_active_spool_ack(&spool, count);
+
+		free_buffer_elements(elements, count);
+	}
+	while (SUCCEED == ret && 0 != spool.records_num && ZBX_SPOOL_SEND_TIME > zbx_time() - time_start);
+
+	zbx_free(elements);
+
+	update_send_state(host, port, ret, now, err_send_step);
+
+	/* postpone the next attempt by BufferSend seconds */
+	if (SUCCEED != ret)
+		buffer.lastsent = now;
+	else if (0 == spool.records_num)
+		zabbix_log(LOG_LEVEL_WARNING, "all values from buffer spool file \"%s\" have been sent", spool.path);
+ret:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s spooled:%d", __func__, zbx_result_string(ret),
+			spool.records_num);
+
+	return ret;
+
+#undef ZBX_SPOOL_SEND_TIME
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: Send value stored in the buffer to Zabbix server                  *
+ *                                                                            *
+ * Parameters: host - IP or Hostname of Zabbix server                         *
+ *             port - port number                                             *
+ *                                                                            *
+ * Return value: returns SUCCEED on successful sending,                       *
+ *               FAIL on other cases                                          *
+ *                                                                            *
+ * Author: Alexei Vladishev                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	send_buffer(const char *host, unsigned short port)
+{
+	int		ret = SUCCEED, now;
+	const char	*err_send_step = "";
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' port:%d entries:%d/%d",
+			__func__, host, port, buffer.count, CONFIG_BUFFER_SIZE);
+
+#ifndef _WINDOWS
+	/* spooled values are older than values in memory buffer and must be sent first */
+	if (NULL != spool.data && 0 != spool.records_num)
+	{
+		if (SUCCEED != (ret = send_spool(host, port)) || 0 != spool.records_num)
+			goto ret;
+	}
+#endif
+	if (0 == buffer.count)
+		goto ret;
+
+	now = (int)time(NULL);
+
+	if (CONFIG_BUFFER_SIZE / 2 > buffer.pcount && CONFIG_BUFFER_SIZE > buffer.count &&
+			CONFIG_BUFFER_SEND > now - buffer.lastsent)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() now:%d lastsent:%d now-lastsent:%d BufferSend:%d; will not send now",
+				__func__, now, buffer.lastsent, now - buffer.lastsent, CONFIG_BUFFER_SEND);
+		goto ret;
+	}
+
+	if (SUCCEED == (ret = send_elements(host, port, buffer.data, buffer.count, &err_send_step)))
+	{
+		/* free buffer */
+		free_buffer_elements(buffer.data, buffer.count);
+		buffer.count = 0;
+		buffer.pcount = 0;
+	}
+
+	update_send_state(host, port, ret, now, err_send_step);
 ret:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
 
+#ifndef _WINDOWS
+/******************************************************************************
+ *                                                                            *
+ * Purpose: move all values from memory buffer to the spool file              *
+ *                                                                            *
+ * Return value: SUCCEED - memory buffer is empty                             *
+ *               FAIL    - spool is full, remaining values are kept in memory *
+ *                                                                            *
+ ******************************************************************************/
+static int	spool_buffer(void)
+{
+	int	i, ret = SUCCEED;
+
+	for (i = 0; i < buffer.count; i++)
+	{
+		if (SUCCEED != (ret = zbx_active_spool_append(&spool, &buffer.data[i])))
+			break;
+	}
+
+	if (0 == i)
+		return ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "moved %d values from buffer to spool file", i);
+
+	free_buffer_elements(buffer.data, i);
+	memmove(buffer.data, buffer.data + i, (buffer.count - i) * sizeof(ZBX_ACTIVE_BUFFER_ELEMENT));
+	buffer.count -= i;
+
+	for (buffer.pcount = 0, i = 0; i < buffer.count; i++)
+	{
+		if (0 != (ZBX_METRIC_FLAG_PERSISTENT & buffer.data[i].flags))
+			buffer.pcount++;
+	}
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Buffer new value or send the whole buffer to the server           *
@@ -971,7 +1212,30 @@ static int	process_value(const char *server, unsigned short port, const char *ho
 			send_buffer(server, port);
 		}
 	}
+#ifndef _WINDOWS
+	else if (NULL != spool.data && 0 != spool.records_num)
+		send_buffer(server, port);
+
+	/* spool the value if it cannot be kept in memory buffer without dropping other values */
+	if (NULL != spool.data && (0 != spool.records_num || CONFIG_BUFFER_SIZE <= buffer.count ||
+			(0 != (ZBX_METRIC_FLAG_PERSISTENT & flags) && CONFIG_BUFFER_SIZE / 2 <= buffer.pcount)))
+	{
+		if (SUCCEED == spool_buffer())
+		{
+			ZBX_ACTIVE_BUFFER_ELEMENT	spooled;
 
+			init_buffer_element(&spooled, host, key, value, state, lastlogsize, mtime, timestamp, source,
+					severity, logeventid, flags);
+			ret = zbx_active_spool_append(&spool, &spooled);
+			free_buffer_elements(&spooled, 1);
+
+			if (SUCCEED == ret)
+				goto out;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "buffer spool file is full");
+	}
+#endif
 	if (0 != (ZBX_METRIC_FLAG_PERSISTENT & flags) && CONFIG_BUFFER_SIZE / 2 <= buffer.pcount)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "buffer is full, cannot store persistent value");
@@ -1024,29 +1288,8 @@ static int	process_value(const char *server, unsigned short port, const char *ho
 		el = &buffer.data[CONFIG_BUFFER_SIZE - 1];
 	}
 
-	memset(el, 0, sizeof(ZBX_ACTIVE_BUFFER_ELEMENT));
-	el->host = zbx_strdup(NULL, host);
-	el->key = zbx_strdup(NULL, key);
-	if (NULL != value)
-		el->value = zbx_strdup(NULL, value);
-	el->state = state;
-
-	if (NULL != source)
-		el->source = strdup(source);
-	if (NULL != severity)
-		el->severity = *severity;
-	if (NULL != lastlogsize)
-		el->lastlogsize = *lastlogsize;
-	if (NULL != mtime)
-		el->mtime = *mtime;
-	if (NULL != timestamp)
-		el->timestamp = *timestamp;
-	if (NULL != logeventid)
-		el->logeventid = (int)*logeventid;
-
-	zbx_timespec(&el->ts);
-	el->flags = flags;
-	el->id = ++last_valueid;
+	init_buffer_element(el, host, key, value, state, lastlogsize, mtime, timestamp, source, severity, logeventid,
+			flags);
 
 	if (0 != (ZBX_METRIC_FLAG_PERSISTENT & flags))
 		buffer.pcount++;
@@ -1355,6 +1598,9 @@ ZBX_THREAD_ENTRY(active_checks_thread, args)
 
 	zbx_thread_exit(EXIT_SUCCESS);
 #else
+	if (NULL != spool.data)
+		zbx_active_spool_close(&spool);
+
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
 
 	while (1)
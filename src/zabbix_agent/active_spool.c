@@ -0,0 +1,542 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "log.h"
+#include "zbxalgo.h"
+#include "zbxserialize.h"
+#include "active_spool.h"
+
+#include <sys/mman.h>
+
+/*
+ * Spool file layout:
+ *
+ *   header | record | record | ... | 0
+ *
+ * Each record is 8 byte aligned and consists of payload size (uint32), payload hash (uint32) and the serialized
+ * buffer element. The payload size is written last, so a record interrupted by a crash either has zero size and
+ * terminates the record list, or fails hash check and is discarded during recovery. The area after the last
+ * record is always kept zeroed.
+ */
+
+#define ZBX_SPOOL_MAGIC		"ZBXSPOOL"
+#define ZBX_SPOOL_VERSION	1
+
+#define ZBX_SPOOL_ALIGN(size)	(((size) + 7) & ~(size_t)7)
+
+#define ZBX_SPOOL_RECORD_HEADER_SIZE	(sizeof(zbx_uint32_t) * 2)
+
+typedef struct
+{
+	char		magic[8];
+	zbx_uint32_t	version;
+	zbx_uint32_t	reserved;
+	zbx_uint64_t	read_offset;
+}
+zbx_spool_header_t;
+
+#define ZBX_SPOOL_DATA_OFFSET	ZBX_SPOOL_ALIGN(sizeof(zbx_spool_header_t))
+
+static zbx_spool_header_t	*spool_header(const zbx_active_spool_t *spool)
+{
+	return (zbx_spool_header_t *)spool->data;
+}
+
+static zbx_uint32_t	spool_record_size(const zbx_active_spool_t *spool, size_t offset)
+{
+	zbx_uint32_t	size;
+
+	memcpy(&size, spool->data + offset, sizeof(size));
+
+	return size;
+}
+
+static size_t	spool_record_next(const zbx_active_spool_t *spool, size_t offset)
+{
+	return offset + ZBX_SPOOL_ALIGN(ZBX_SPOOL_RECORD_HEADER_SIZE + spool_record_size(spool, offset));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes buffer element into spool record payload               *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	spool_serialize_element(unsigned char **data, const ZBX_ACTIVE_BUFFER_ELEMENT *el)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0, host_len, key_len, value_len, source_len;
+
+	zbx_serialize_prepare_str_len(data_len, el->host, host_len);
+	zbx_serialize_prepare_str_len(data_len, el->key, key_len);
+	zbx_serialize_prepare_str_len(data_len, el->value, value_len);
+	zbx_serialize_prepare_str_len(data_len, el->source, source_len);
+	zbx_serialize_prepare_value(data_len, el->state);
+	zbx_serialize_prepare_value(data_len, el->flags);
+	zbx_serialize_prepare_value(data_len, el->lastlogsize);
+	zbx_serialize_prepare_value(data_len, el->id);
+	zbx_serialize_prepare_value(data_len, el->timestamp);
+	zbx_serialize_prepare_value(data_len, el->severity);
+	zbx_serialize_prepare_value(data_len, el->logeventid);
+	zbx_serialize_prepare_value(data_len, el->mtime);
+	zbx_serialize_prepare_value(data_len, el->ts.sec);
+	zbx_serialize_prepare_value(data_len, el->ts.ns);
+
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+	ptr = *data;
+
+	ptr += zbx_serialize_str(ptr, el->host, host_len);
+	ptr += zbx_serialize_str(ptr, el->key, key_len);
+	ptr += zbx_serialize_str(ptr, el->value, value_len);
+	ptr += zbx_serialize_str(ptr, el->source, source_len);
+	ptr += zbx_serialize_char(ptr, el->state);
+	ptr += zbx_serialize_char(ptr, el->flags);
+	ptr += zbx_serialize_uint64(ptr, el->lastlogsize);
+	ptr += zbx_serialize_uint64(ptr, el->id);
+	ptr += zbx_serialize_int(ptr, el->timestamp);
+	ptr += zbx_serialize_int(ptr, el->severity);
+	ptr += zbx_serialize_int(ptr, el->logeventid);
+	ptr += zbx_serialize_int(ptr, el->mtime);
+	ptr += zbx_serialize_int(ptr, el->ts.sec);
+	(void)zbx_serialize_int(ptr, el->ts.ns);
+
+	return data_len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: deserializes buffer element from spool record payload             *
+ *                                                                            *
+ ******************************************************************************/
+static void	spool_deserialize_element(const unsigned char *data, ZBX_ACTIVE_BUFFER_ELEMENT *el)
+{
+	zbx_uint32_t	len;
+
+	memset(el, 0, sizeof(ZBX_ACTIVE_BUFFER_ELEMENT));
+
+	data += zbx_deserialize_str(data, &el->host, len);
+	data += zbx_deserialize_str(data, &el->key, len);
+	data += zbx_deserialize_str(data, &el->value, len);
+	data += zbx_deserialize_str(data, &el->source, len);
+	data += zbx_deserialize_char(data, &el->state);
+	data += zbx_deserialize_char(data, &el->flags);
+	data += zbx_deserialize_uint64(data, &el->lastlogsize);
+	data += zbx_deserialize_uint64(data, &el->id);
+	data += zbx_deserialize_int(data, &el->timestamp);
+	data += zbx_deserialize_int(data, &el->severity);
+	data += zbx_deserialize_int(data, &el->logeventid);
+	data += zbx_deserialize_int(data, &el->mtime);
+	data += zbx_deserialize_int(data, &el->ts.sec);
+	(void)zbx_deserialize_int(data, &el->ts.ns);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: validates records after the last acknowledged one and finds the   *
+ *          spool write position                                              *
+ *                                                                            *
+ * Parameters: spool        - [IN/OUT] the spool                              *
+ *             last_valueid - [OUT] the largest value identifier in spool     *
+ *                                                                            *
+ ******************************************************************************/
+static void	spool_recover(zbx_active_spool_t *spool, zbx_uint64_t *last_valueid)
+{
+	size_t			offset, end;
+	zbx_uint32_t		size, hash;
+	ZBX_ACTIVE_BUFFER_ELEMENT	el;
+
+	spool->records_num = 0;
+
+	for (offset = spool->read_offset; offset + ZBX_SPOOL_RECORD_HEADER_SIZE <= spool->size;
+			offset = spool_record_next(spool, offset))
+	{
+		if (0 == (size = spool_record_size(spool, offset)))
+			break;
+
+		end = offset + ZBX_SPOOL_ALIGN(ZBX_SPOOL_RECORD_HEADER_SIZE + size);
+
+		if (end > spool->size)
+		{
+			end = spool->size;
+			goto corrupted;
+		}
+
+		memcpy(&hash, spool->data + offset + sizeof(zbx_uint32_t), sizeof(hash));
+
+		if (hash != zbx_hash_modfnv(spool->data + offset + ZBX_SPOOL_RECORD_HEADER_SIZE, size,
+				ZBX_DEFAULT_HASH_SEED))
+		{
+			goto corrupted;
+		}
+
+		spool_deserialize_element(spool->data + offset + ZBX_SPOOL_RECORD_HEADER_SIZE, &el);
+
+		if (el.id > *last_valueid)
+			*last_valueid = el.id;
+
+		zbx_free(el.host);
+		zbx_free(el.key);
+		zbx_free(el.value);
+		zbx_free(el.source);
+
+		spool->records_num++;
+	}
+
+	spool->write_offset = offset;
+
+	return;
+corrupted:
+	zabbix_log(LOG_LEVEL_WARNING, "discarding corrupted record at offset " ZBX_FS_SIZE_T " in buffer spool"
+			" file \"%s\"", (zbx_fs_size_t)offset, spool->path);
+
+	memset(spool->data + offset, 0, end - offset);
+	spool->write_offset = offset;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: opens or creates spool file and recovers unsent values            *
+ *                                                                            *
+ * Parameters: spool        - [OUT] the spool                                 *
+ *             path         - [IN] the spool file path                        *
+ *             size         - [IN] the spool file size                        *
+ *             last_valueid - [IN/OUT] the last used value identifier,        *
+ *                                     updated to the largest identifier in   *
+ *                                     spool so new values are sent after the *
+ *                                     spooled ones                           *
+ *             error        - [OUT] the error message                         *
+ *                                                                            *
+ * Return value: SUCCEED - the spool was opened                               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_active_spool_open(zbx_active_spool_t *spool, const char *path, zbx_uint64_t size,
+		zbx_uint64_t *last_valueid, char **error)
+{
+	zbx_stat_t		st;
+	zbx_spool_header_t	*header;
+	int			ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() path:'%s' size:" ZBX_FS_UI64, __func__, path, size);
+
+	memset(spool, 0, sizeof(zbx_active_spool_t));
+	spool->fd = -1;
+
+	if (-1 == (spool->fd = open(path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR)))
+	{
+		*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", path, zbx_strerror(errno));
+		goto out;
+	}
+
+	if (0 != zbx_fstat(spool->fd, &st))
+	{
+		*error = zbx_dsprintf(*error, "cannot obtain information for file \"%s\": %s", path,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	/* never shrink existing spool file to avoid losing unsent values */
+	if ((zbx_uint64_t)st.st_size < size && 0 != ftruncate(spool->fd, (off_t)size))
+	{
+		*error = zbx_dsprintf(*error, "cannot resize file \"%s\": %s", path, zbx_strerror(errno));
+		goto out;
+	}
+
+	spool->size = (size_t)MAX((zbx_uint64_t)st.st_size, size);
+
+	if (MAP_FAILED == (spool->data = (unsigned char *)mmap(NULL, spool->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			spool->fd, 0)))
+	{
+		spool->data = NULL;
+		*error = zbx_dsprintf(*error, "cannot map file \"%s\": %s", path, zbx_strerror(errno));
+		goto out;
+	}
+
+	spool->path = zbx_strdup(NULL, path);
+	header = spool_header(spool);
+
+	if (0 != memcmp(header->magic, ZBX_SPOOL_MAGIC, sizeof(header->magic)) ||
+			ZBX_SPOOL_VERSION != header->version || ZBX_SPOOL_DATA_OFFSET > header->read_offset ||
+			spool->size < header->read_offset || 0 != (header->read_offset & 7))
+	{
+		if (0 != st.st_size)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "buffer spool file \"%s\" has invalid format, reinitializing",
+					path);
+			memset(spool->data, 0, spool->size);
+		}
+
+		memcpy(header->magic, ZBX_SPOOL_MAGIC, sizeof(header->magic));
+		header->version = ZBX_SPOOL_VERSION;
+		header->read_offset = ZBX_SPOOL_DATA_OFFSET;
+	}
+
+	spool->read_offset = (size_t)header->read_offset;
+	spool_recover(spool, last_valueid);
+
+	if (0 != spool->records_num)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "recovered %d unsent values from buffer spool file \"%s\"",
+				spool->records_num, path);
+	}
+
+	ret = SUCCEED;
+out:
+	if (SUCCEED != ret)
+		zbx_active_spool_close(spool);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s records:%d", __func__, zbx_result_string(ret),
+			spool->records_num);
+
+	return ret;
+}
+
+void	zbx_active_spool_close(zbx_active_spool_t *spool)
+{
+	if (NULL != spool->data)
+	{
+		msync(spool->data, spool->size, MS_SYNC);
+		munmap(spool->data, spool->size);
+		spool->data = NULL;
+	}
+
+	if (-1 != spool->fd)
+	{
+		close(spool->fd);
+		spool->fd = -1;
+	}
+
+	zbx_free(spool->path);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes data to file, retrying interrupted and partial writes      *
+ *                                                                            *
+ ******************************************************************************/
+static int	spool_write(int fd, const unsigned char *data, size_t len)
+{
+	ssize_t	nbytes;
+
+	while (0 != len)
+	{
+		if (-1 == (nbytes = write(fd, data, len)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			return FAIL;
+		}
+
+		data += nbytes;
+		len -= (size_t)nbytes;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves unsent records to the beginning of spool                    *
+ *                                                                            *
+ * Comments: Records cannot be moved in place without risking to lose them if *
+ *           agent or system crashes in the middle. Compacted spool is        *
+ *           written to temporary file and synced to disk, then it replaces   *
+ *           the spool file with rename(), so after a crash either the old or *
+ *           the new spool file is found. If compacting fails the spool is    *
+ *           left unchanged.                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	spool_compact(zbx_active_spool_t *spool)
+{
+	size_t		used;
+	char		*tmp_path;
+	int		fd, ret = FAIL;
+	unsigned char	*data = NULL, header[ZBX_SPOOL_DATA_OFFSET];
+	zbx_uint64_t	read_offset = ZBX_SPOOL_DATA_OFFSET;
+
+	if (ZBX_SPOOL_DATA_OFFSET == spool->read_offset)
+		return;
+
+	used = spool->write_offset - spool->read_offset;
+	tmp_path = zbx_dsprintf(NULL, "%s.tmp", spool->path);
+
+	if (-1 == (fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot compact buffer spool: cannot open file \"%s\": %s", tmp_path,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	memcpy(header, spool->data, sizeof(header));
+	memcpy(header + offsetof(zbx_spool_header_t, read_offset), &read_offset, sizeof(read_offset));
+
+	/* the area after records is zeroed by extending the file after writing them */
+	if (SUCCEED != spool_write(fd, header, sizeof(header)) ||
+			SUCCEED != spool_write(fd, spool->data + spool->read_offset, used) ||
+			0 != ftruncate(fd, (off_t)spool->size) || 0 != fsync(fd))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot compact buffer spool: cannot write file \"%s\": %s", tmp_path,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	if (MAP_FAILED == (data = (unsigned char *)mmap(NULL, spool->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+			0)))
+	{
+		data = NULL;
+		zabbix_log(LOG_LEVEL_WARNING, "cannot compact buffer spool: cannot map file \"%s\": %s", tmp_path,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	if (0 != rename(tmp_path, spool->path))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot compact buffer spool: cannot rename file \"%s\" to \"%s\": %s",
+				tmp_path, spool->path, zbx_strerror(errno));
+		goto out;
+	}
+
+	munmap(spool->data, spool->size);
+	close(spool->fd);
+
+	spool->data = data;
+	spool->fd = fd;
+	spool->read_offset = ZBX_SPOOL_DATA_OFFSET;
+	spool->write_offset = ZBX_SPOOL_DATA_OFFSET + used;
+
+	ret = SUCCEED;
+out:
+	if (SUCCEED != ret && -1 != fd)
+	{
+		if (NULL != data)
+			munmap(data, spool->size);
+
+		close(fd);
+		unlink(tmp_path);
+	}
+
+	zbx_free(tmp_path);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s():%s records:%d used:" ZBX_FS_SIZE_T, __func__, zbx_result_string(ret),
+			spool->records_num, (zbx_fs_size_t)used);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends buffer element to spool                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the element was stored                             *
+ *               FAIL    - spool is full                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_active_spool_append(zbx_active_spool_t *spool, const ZBX_ACTIVE_BUFFER_ELEMENT *el)
+{
+	unsigned char	*data;
+	zbx_uint32_t	data_len, hash;
+	size_t		record_len;
+	int		ret = FAIL;
+
+	data_len = spool_serialize_element(&data, el);
+	record_len = ZBX_SPOOL_ALIGN(ZBX_SPOOL_RECORD_HEADER_SIZE + data_len);
+
+	/* keep space for the terminating zero record size */
+	if (spool->write_offset + record_len + sizeof(zbx_uint32_t) > spool->size)
+	{
+		spool_compact(spool);
+
+		if (spool->write_offset + record_len + sizeof(zbx_uint32_t) > spool->size)
+			goto out;
+	}
+
+	hash = zbx_hash_modfnv(data, data_len, ZBX_DEFAULT_HASH_SEED);
+
+	memcpy(spool->data + spool->write_offset + ZBX_SPOOL_RECORD_HEADER_SIZE, data, data_len);
+	memcpy(spool->data + spool->write_offset + sizeof(zbx_uint32_t), &hash, sizeof(hash));
+	memcpy(spool->data + spool->write_offset, &data_len, sizeof(data_len));
+
+	spool->write_offset += record_len;
+	spool->records_num++;
+
+	ret = SUCCEED;
+out:
+	zbx_free(data);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads the oldest unsent elements from spool without removing them *
+ *                                                                            *
+ * Parameters: spool    - [IN] the spool                                      *
+ *             elements - [OUT] the elements, must be freed by caller         *
+ *             max_num  - [IN] the maximum number of elements to read         *
+ *                                                                            *
+ * Return value: the number of elements read                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_active_spool_read(zbx_active_spool_t *spool, ZBX_ACTIVE_BUFFER_ELEMENT *elements, int max_num)
+{
+	size_t	offset;
+	int	num;
+
+	for (num = 0, offset = spool->read_offset; num < max_num && num < spool->records_num; num++)
+	{
+		spool_deserialize_element(spool->data + offset + ZBX_SPOOL_RECORD_HEADER_SIZE, &elements[num]);
+		offset = spool_record_next(spool, offset);
+	}
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes the oldest elements from spool after they were accepted   *
+ *          by server                                                         *
+ *                                                                            *
+ * Parameters: spool - [IN/OUT] the spool                                     *
+ *             num   - [IN] the number of elements to remove                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_active_spool_ack(zbx_active_spool_t *spool, int num)
+{
+	for (; 0 < num && 0 < spool->records_num; num--)
+	{
+		spool->read_offset = spool_record_next(spool, spool->read_offset);
+		spool->records_num--;
+	}
+
+	if (0 == spool->records_num)
+	{
+		memset(spool->data + ZBX_SPOOL_DATA_OFFSET, 0, spool->write_offset - ZBX_SPOOL_DATA_OFFSET);
+		spool->read_offset = spool->write_offset = ZBX_SPOOL_DATA_OFFSET;
+		spool_header(spool)->read_offset = spool->read_offset;
+	}
+	else
+	{
+		spool_header(spool)->read_offset = spool->read_offset;
+
+		/* compact when more than half of spool is occupied by acknowledged records */
+		if (spool->read_offset - ZBX_SPOOL_DATA_OFFSET > (spool->size - ZBX_SPOOL_DATA_OFFSET) / 2)
+			spool_compact(spool);
+	}
+
+	msync(spool->data, spool->size, MS_ASYNC);
+}
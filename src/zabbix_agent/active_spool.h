@@ -0,0 +1,53 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_ACTIVE_SPOOL_H
+#define ZABBIX_ACTIVE_SPOOL_H
+
+#include "active.h"
+
+extern char		*CONFIG_BUFFER_SPOOL_FILE;
+extern zbx_uint64_t	CONFIG_BUFFER_SPOOL_SIZE;
+
+/* memory mapped append-only spool file of active check values */
+typedef struct
+{
+	char		*path;
+	int		fd;
+	unsigned char	*data;
+	size_t		size;
+
+	/* offset of the oldest unsent record */
+	size_t		read_offset;
+
+	/* offset where the next record will be written */
+	size_t		write_offset;
+
+	int		records_num;
+}
+zbx_active_spool_t;
+
+int	zbx_active_spool_open(zbx_active_spool_t *spool, const char *path, zbx_uint64_t size,
+		zbx_uint64_t *last_valueid, char **error);
+void	zbx_active_spool_close(zbx_active_spool_t *spool);
+int	zbx_active_spool_append(zbx_active_spool_t *spool, const ZBX_ACTIVE_BUFFER_ELEMENT *el);
+int	zbx_active_spool_read(zbx_active_spool_t *spool, ZBX_ACTIVE_BUFFER_ELEMENT *elements, int max_num);
+void	zbx_active_spool_ack(zbx_active_spool_t *spool, int num);
+
+#endif
@@ -0,0 +1,540 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "logdir_watch.h"
+
+#if defined(ZBX_LOGDIR_WATCH)
+
+#include "log.h"
+
+#define ZBX_LOGDIR_WATCH_MASK	(IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB |	\
+		IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+/* period after which the cached directory contents are discarded and read again, protects against */
+/* changes inotify cannot report, for example, writes through memory mappings                       */
+#define ZBX_LOGDIR_WATCH_RESCAN	(5 * SEC_PER_MIN)
+
+/* watches of directories not used by any log item for this period are removed */
+#define ZBX_LOGDIR_WATCH_EXPIRE	SEC_PER_HOUR
+
+/* file systems where inotify does not see changes made by other hosts */
+#define ZBX_FS_MAGIC_NFS	0x6969
+#define ZBX_FS_MAGIC_SMB	0x517b
+#define ZBX_FS_MAGIC_CIFS	0xff534d42
+#define ZBX_FS_MAGIC_SMB2	0xfe534d42
+#define ZBX_FS_MAGIC_FUSE	0x65735546
+#define ZBX_FS_MAGIC_CEPH	0x00c36400
+#define ZBX_FS_MAGIC_GFS2	0x01161970
+#define ZBX_FS_MAGIC_OCFS2	0x7461636f
+#define ZBX_FS_MAGIC_AFS	0x5346414f
+
+static int		inotify_fd = -1;
+static int		inotify_disabled = 0;
+static zbx_hashset_t	watches;
+
+static zbx_hash_t	logdir_watch_hash_func(const void *d)
+{
+	const zbx_logdir_watch_t	*watch = (const zbx_logdir_watch_t *)d;
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(watch->directory, strlen(watch->directory), ZBX_DEFAULT_HASH_SEED);
+}
+
+static int	logdir_watch_compare_func(const void *d1, const void *d2)
+{
+	const zbx_logdir_watch_t	*w1 = (const zbx_logdir_watch_t *)d1;
+	const zbx_logdir_watch_t	*w2 = (const zbx_logdir_watch_t *)d2;
+
+	return strcmp(w1->directory, w2->directory);
+}
+
+static zbx_hash_t	logdir_entry_hash_func(const void *d)
+{
+	const zbx_logdir_entry_t	*entry = (const zbx_logdir_entry_t *)d;
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(entry->name, strlen(entry->name), ZBX_DEFAULT_HASH_SEED);
+}
+
+static int	logdir_entry_compare_func(const void *d1, const void *d2)
+{
+	const zbx_logdir_entry_t	*e1 = (const zbx_logdir_entry_t *)d1;
+	const zbx_logdir_entry_t	*e2 = (const zbx_logdir_entry_t *)d2;
+
+	return strcmp(e1->name, e2->name);
+}
+
+static void	logdir_entry_clean_func(void *d)
+{
+	zbx_logdir_entry_t	*entry = (zbx_logdir_entry_t *)d;
+
+	zbx_free(entry->name);
+}
+
+static void	logdir_watch_clean_func(void *d)
+{
+	zbx_logdir_watch_t	*watch = (zbx_logdir_watch_t *)d;
+
+	if (-1 != watch->wd)
+		inotify_rm_watch(inotify_fd, watch->wd);
+
+	zbx_hashset_destroy(&watch->entries);
+	zbx_free(watch->directory);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if directory resides on a file system where inotify cannot *
+ *          report all changes                                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	logdir_is_remote(const char *directory)
+{
+	struct statfs	fs;
+
+	if (0 != statfs(directory, &fs))
+		return FAIL;
+
+	switch ((unsigned int)fs.f_type)
+	{
+		case ZBX_FS_MAGIC_NFS:
+		case ZBX_FS_MAGIC_SMB:
+		case ZBX_FS_MAGIC_CIFS:
+		case ZBX_FS_MAGIC_SMB2:
+		case ZBX_FS_MAGIC_FUSE:
+		case ZBX_FS_MAGIC_CEPH:
+		case ZBX_FS_MAGIC_GFS2:
+		case ZBX_FS_MAGIC_OCFS2:
+		case ZBX_FS_MAGIC_AFS:
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: discards cached directory contents                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	logdir_watch_reset(zbx_logdir_watch_t *watch)
+{
+	zbx_hashset_clear(&watch->entries);
+	watch->scanned = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stops watching directory, the cached contents are discarded       *
+ *                                                                            *
+ ******************************************************************************/
+static void	logdir_watch_stop(zbx_logdir_watch_t *watch)
+{
+	if (-1 != watch->wd)
+	{
+		inotify_rm_watch(inotify_fd, watch->wd);
+		watch->wd = -1;
+	}
+
+	logdir_watch_reset(watch);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads directory contents into the cache                           *
+ *                                                                            *
+ * Return value: SUCCEED - the directory was read successfully                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The directory must be watched before it is read so that changes  *
+ *           made during the scan are not lost.                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	logdir_watch_scan(zbx_logdir_watch_t *watch, time_t now)
+{
+	DIR			*dir;
+	struct dirent		*d_ent;
+	zbx_logdir_entry_t	entry_local;
+
+	if (NULL == (dir = opendir(watch->directory)))
+		return FAIL;
+
+	memset(&entry_local, 0, sizeof(entry_local));
+
+	while (NULL != (d_ent = readdir(dir)))
+	{
+		if (0 == strcmp(d_ent->d_name, ".") || 0 == strcmp(d_ent->d_name, ".."))
+			continue;
+
+		entry_local.name = d_ent->d_name;
+
+		if (NULL == zbx_hashset_search(&watch->entries, &entry_local))
+		{
+			zbx_logdir_entry_t	*entry;
+
+			entry = (zbx_logdir_entry_t *)zbx_hashset_insert(&watch->entries, &entry_local,
+					sizeof(entry_local));
+			entry->name = zbx_strdup(NULL, d_ent->d_name);
+		}
+	}
+
+	closedir(dir);
+
+	watch->scanned = 1;
+	watch->scan_time = now;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() directory:'%s' entries:%d", __func__, watch->directory,
+			watch->entries.num_data);
+
+	return SUCCEED;
+}
+
+static zbx_logdir_watch_t	*logdir_watch_get_by_wd(int wd)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_logdir_watch_t	*watch;
+
+	zbx_hashset_iter_reset(&watches, &iter);
+	while (NULL != (watch = (zbx_logdir_watch_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (wd == watch->wd)
+			return watch;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates cached directory contents according to inotify event      *
+ *                                                                            *
+ ******************************************************************************/
+static void	logdir_process_event(const struct inotify_event *ev)
+{
+	zbx_logdir_watch_t	*watch;
+	zbx_logdir_entry_t	*entry, entry_local;
+
+	if (0 != (ev->mask & IN_Q_OVERFLOW))
+	{
+		zbx_hashset_iter_t	iter;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "inotify event queue overflow, log directories will be read again");
+
+		zbx_hashset_iter_reset(&watches, &iter);
+		while (NULL != (watch = (zbx_logdir_watch_t *)zbx_hashset_iter_next(&iter)))
+			logdir_watch_reset(watch);
+
+		return;
+	}
+
+	if (NULL == (watch = logdir_watch_get_by_wd(ev->wd)))
+		return;
+
+	if (0 != (ev->mask & IN_IGNORED))
+	{
+		/* the watch was removed by kernel, the directory was deleted or file system unmounted */
+		watch->wd = -1;
+		logdir_watch_reset(watch);
+		return;
+	}
+
+	if (0 != (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF)))
+	{
+		logdir_watch_stop(watch);
+		return;
+	}
+
+	if (0 == ev->len || 0 == watch->scanned)
+		return;
+
+	entry_local.name = (char *)ev->name;
+
+	if (0 != (ev->mask & (IN_DELETE | IN_MOVED_FROM)))
+	{
+		zbx_hashset_remove(&watch->entries, &entry_local);
+		return;
+	}
+
+	if (NULL == (entry = (zbx_logdir_entry_t *)zbx_hashset_search(&watch->entries, &entry_local)))
+	{
+		if (0 == (ev->mask & (IN_CREATE | IN_MOVED_TO)))
+			return;
+
+		memset(&entry_local, 0, sizeof(entry_local));
+		entry_local.name = (char *)ev->name;
+		entry = (zbx_logdir_entry_t *)zbx_hashset_insert(&watch->entries, &entry_local, sizeof(entry_local));
+		entry->name = zbx_strdup(NULL, ev->name);
+	}
+
+	entry->stat_valid = 0;
+	entry->md5_valid = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads pending inotify events                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	logdir_read_events(void)
+{
+	union
+	{
+		struct inotify_event	ev;
+		char			buf[ZBX_KIBIBYTE * 16];
+	}
+	events;
+	ssize_t	n;
+
+	for (;;)
+	{
+		const char	*p;
+
+		if (-1 == (n = read(inotify_fd, events.buf, sizeof(events.buf))))
+		{
+			zbx_hashset_iter_t	iter;
+			zbx_logdir_watch_t	*watch;
+
+			if (EINTR == errno)
+				continue;
+
+			if (EAGAIN == errno)
+				break;
+
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot read inotify events: %s", zbx_strerror(errno));
+
+			zbx_hashset_iter_reset(&watches, &iter);
+			while (NULL != (watch = (zbx_logdir_watch_t *)zbx_hashset_iter_next(&iter)))
+				logdir_watch_reset(watch);
+
+			break;
+		}
+
+		for (p = events.buf; p < events.buf + n;)
+		{
+			const struct inotify_event	*ev = (const struct inotify_event *)p;
+
+			logdir_process_event(ev);
+			p += sizeof(struct inotify_event) + ev->len;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes watches of directories not used by log items anymore      *
+ *                                                                            *
+ ******************************************************************************/
+static void	logdir_remove_expired(time_t now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_logdir_watch_t	*watch;
+
+	zbx_hashset_iter_reset(&watches, &iter);
+	while (NULL != (watch = (zbx_logdir_watch_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (watch->lastaccess + ZBX_LOGDIR_WATCH_EXPIRE < now)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() directory:'%s'", __func__, watch->directory);
+			zbx_hashset_iter_remove(&iter);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns watched directory with up to date list of entries         *
+ *                                                                            *
+ * Parameters: directory - [IN] the directory path with trailing '/'          *
+ *                                                                            *
+ * Return value: the watched directory or NULL if the directory cannot be     *
+ *               watched and must be read by the caller                       *
+ *                                                                            *
+ * Comments: Pending inotify events are applied to all watched directories,   *
+ *           the directory is read again after event queue overflow or when   *
+ *           the cached contents become older than ZBX_LOGDIR_WATCH_RESCAN.   *
+ *                                                                            *
+ ******************************************************************************/
+zbx_logdir_watch_t	*zbx_logdir_watch_get(const char *directory)
+{
+	zbx_logdir_watch_t	*watch, watch_local;
+	time_t			now;
+
+	if (0 != inotify_disabled)
+		return NULL;
+
+	if (-1 == inotify_fd)
+	{
+		if (-1 == (inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot initialize inotify, log directories will be read on"
+					" every check: %s", zbx_strerror(errno));
+			inotify_disabled = 1;
+			return NULL;
+		}
+
+		zbx_hashset_create_ext(&watches, 10, logdir_watch_hash_func, logdir_watch_compare_func,
+				logdir_watch_clean_func, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+	}
+
+	logdir_read_events();
+
+	now = time(NULL);
+	logdir_remove_expired(now);
+
+	watch_local.directory = (char *)directory;
+
+	if (NULL == (watch = (zbx_logdir_watch_t *)zbx_hashset_search(&watches, &watch_local)))
+	{
+		memset(&watch_local, 0, sizeof(watch_local));
+		watch_local.directory = zbx_strdup(NULL, directory);
+		watch_local.wd = -1;
+		watch_local.remote = (SUCCEED == logdir_is_remote(directory) ? 1 : 0);
+		zbx_hashset_create_ext(&watch_local.entries, 100, logdir_entry_hash_func, logdir_entry_compare_func,
+				logdir_entry_clean_func, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+		watch = (zbx_logdir_watch_t *)zbx_hashset_insert(&watches, &watch_local, sizeof(watch_local));
+
+		if (0 != watch->remote)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "directory \"%s\" is on a network file system and will be read on"
+					" every check", directory);
+		}
+	}
+
+	watch->lastaccess = now;
+
+	if (0 != watch->remote)
+		return NULL;
+
+	if (-1 == watch->wd)
+	{
+		if (-1 == (watch->wd = inotify_add_watch(inotify_fd, directory, ZBX_LOGDIR_WATCH_MASK)))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot watch directory \"%s\": %s", directory,
+					zbx_strerror(errno));
+			return NULL;
+		}
+
+		logdir_watch_reset(watch);
+	}
+
+	if (0 != watch->scanned && watch->scan_time + ZBX_LOGDIR_WATCH_RESCAN <= now)
+		logdir_watch_reset(watch);
+
+	if (0 == watch->scanned && SUCCEED != logdir_watch_scan(watch, now))
+	{
+		logdir_watch_stop(watch);
+		return NULL;
+	}
+
+	return watch;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes sure the cached file details of directory entry are valid   *
+ *                                                                            *
+ * Parameters: watch - [IN] the watched directory                             *
+ *             entry - [IN/OUT] the directory entry                           *
+ *                                                                            *
+ * Return value: SUCCEED - the file details are available in entry->st        *
+ *               FAIL    - stat() failed, errno is set                        *
+ *                                                                            *
+ * Comments: Changes of files through symbolic links or through hard links in *
+ *           other directories are not reported by watch of this directory,   *
+ *           so details of such files are not cached and they are stat()-ed   *
+ *           on every check.                                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_logdir_entry_stat(const zbx_logdir_watch_t *watch, zbx_logdir_entry_t *entry)
+{
+	char		*path;
+	int		ret = SUCCEED;
+	struct stat	lst;
+
+	if (0 != entry->stat_valid)
+		return SUCCEED;
+
+	path = zbx_dsprintf(NULL, "%s%s", watch->directory, entry->name);
+
+	if (0 == zbx_stat(path, &entry->st))
+	{
+		if (1 < entry->st.st_nlink || 0 != lstat(path, &lst) || S_ISLNK(lst.st_mode))
+			entry->stat_valid = 0;
+		else
+			entry->stat_valid = 1;
+
+		entry->md5_valid = 0;
+	}
+	else
+		ret = FAIL;
+
+	zbx_free(path);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds cached details of a file in watched directory               *
+ *                                                                            *
+ * Parameters: filename - [IN] the file name with full path                   *
+ *                                                                            *
+ * Return value: the directory entry with valid stat() information or NULL if *
+ *               the file is not in a watched directory or it has changed     *
+ *               since the information was cached                             *
+ *                                                                            *
+ ******************************************************************************/
+zbx_logdir_entry_t	*zbx_logdir_watch_find_file(const char *filename)
+{
+	const char		*name;
+	char			*directory;
+	zbx_logdir_watch_t	*watch, watch_local;
+	zbx_logdir_entry_t	*entry = NULL, entry_local;
+
+	if (-1 == inotify_fd || NULL == (name = strrchr(filename, '/')))
+		return NULL;
+
+	/* apply changes made since the directory contents were read */
+	logdir_read_events();
+
+	name++;
+	directory = zbx_malloc(NULL, (size_t)(name - filename) + 1);
+	memcpy(directory, filename, (size_t)(name - filename));
+	directory[name - filename] = '\0';
+
+	watch_local.directory = directory;
+
+	if (NULL != (watch = (zbx_logdir_watch_t *)zbx_hashset_search(&watches, &watch_local)) &&
+			-1 != watch->wd && 0 != watch->scanned)
+	{
+		entry_local.name = (char *)name;
+
+		if (NULL != (entry = (zbx_logdir_entry_t *)zbx_hashset_search(&watch->entries, &entry_local)) &&
+				0 == entry->stat_valid)
+		{
+			entry = NULL;
+		}
+	}
+
+	zbx_free(directory);
+
+	return entry;
+}
+
+#endif	/* ZBX_LOGDIR_WATCH */
@@ -0,0 +1,63 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_LOGDIR_WATCH_H
+#define ZABBIX_LOGDIR_WATCH_H
+
+#include "common.h"
+
+#if defined(HAVE_SYS_INOTIFY_H)
+
+#include "zbxalgo.h"
+#include "md5.h"
+
+#define ZBX_LOGDIR_WATCH
+
+/* directory entry with cached file details, valid until inotify reports a change, */
+/* details of symbolic links and files with several hard links are never cached   */
+typedef struct
+{
+	char		*name;
+	int		stat_valid;
+	int		md5_valid;
+	int		md5size;
+	zbx_stat_t	st;
+	md5_byte_t	md5buf[MD5_DIGEST_SIZE];
+}
+zbx_logdir_entry_t;
+
+typedef struct
+{
+	char		*directory;
+	int		wd;		/* inotify watch descriptor, -1 if the directory is not watched */
+	int		scanned;	/* 1 if 'entries' reflect the directory contents */
+	int		remote;		/* 1 if the directory is on a network file system and is not watched */
+	time_t		scan_time;
+	time_t		lastaccess;
+	zbx_hashset_t	entries;
+}
+zbx_logdir_watch_t;
+
+zbx_logdir_watch_t	*zbx_logdir_watch_get(const char *directory);
+int			zbx_logdir_entry_stat(const zbx_logdir_watch_t *watch, zbx_logdir_entry_t *entry);
+zbx_logdir_entry_t	*zbx_logdir_watch_find_file(const char *filename);
+
+#endif	/* HAVE_SYS_INOTIFY_H */
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "common.h"
 #include "logfiles.h"
+#include "logdir_watch.h"
 #include "log.h"
 #include "sysinfo.h"
 
@@ -27,6 +28,14 @@
 #	include "zbxtypes.h"	/* ssize_t */
 #endif /* _WINDOWS */
 
+#if defined(__GNUC__) && defined(__AVX2__)
+#	include <immintrin.h>
+#	define ZBX_LOG_SCAN_AVX2
+#elif defined(__GNUC__) && defined(__SSE2__)
+#	include <emmintrin.h>
+#	define ZBX_LOG_SCAN_SSE2
+#endif
+
 #define MAX_LEN_MD5	512	/* maximum size of the initial part of the file to calculate MD5 sum for */
 
 #define ZBX_SAME_FILE_ERROR	-1
@@ -1431,13 +1440,15 @@ static void	pick_logfile(const char *directory, const char *filename, int mtime,
 	char		*logfile_candidate;
 	zbx_stat_t	file_buf;
 
+	/* match the name first to avoid stat() of files which are not log file candidates */
+	if (0 != zbx_regexp_match_precompiled(filename, re))
+		return;
+
 	logfile_candidate = zbx_dsprintf(NULL, "%s%s", directory, filename);
 
 	if (0 == zbx_stat(logfile_candidate, &file_buf))
 	{
-		if (S_ISREG(file_buf.st_mode) &&
-				mtime <= file_buf.st_mtime &&
-				0 == zbx_regexp_match_precompiled(filename, re))
+		if (S_ISREG(file_buf.st_mode) && mtime <= file_buf.st_mtime)
 		{
 			add_logfile(logfiles, logfiles_alloc, logfiles_num, logfile_candidate, &file_buf);
 		}
@@ -1448,6 +1459,55 @@ static void	pick_logfile(const char *directory, const char *filename, int mtime,
 	zbx_free(logfile_candidate);
 }
 
+#if defined(ZBX_LOGDIR_WATCH)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: selects logfiles from the cached contents of watched directory    *
+ *                                                                            *
+ * Parameters:                                                                *
+ *     watch          - [IN] the watched directory                            *
+ *     mtime          - [IN] selection criterion "logfile modification time"  *
+ *     re             - [IN] selection criterion "regexp describing filename  *
+ *                      pattern"                                              *
+ *     logfiles       - [IN/OUT] pointer to the list of logfiles              *
+ *     logfiles_alloc - [IN/OUT] number of logfiles memory was allocated for  *
+ *     logfiles_num   - [IN/OUT] number of already inserted logfiles          *
+ *                                                                            *
+ * Comments: This is a helper function for pick_logfiles(). Only the files    *
+ *           changed since the previous check are stat()-ed.                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	pick_watched_logfiles(zbx_logdir_watch_t *watch, int mtime, const zbx_regexp_t *re,
+		struct st_logfile **logfiles, int *logfiles_alloc, int *logfiles_num)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_logdir_entry_t	*entry;
+
+	zbx_hashset_iter_reset(&watch->entries, &iter);
+	while (NULL != (entry = (zbx_logdir_entry_t *)zbx_hashset_iter_next(&iter)))
+	{
+		char	*logfile_candidate;
+
+		if (0 != zbx_regexp_match_precompiled(entry->name, re))
+			continue;
+
+		if (SUCCEED != zbx_logdir_entry_stat(watch, entry))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot process entry '%s%s': %s", watch->directory, entry->name,
+					zbx_strerror(errno));
+			continue;
+		}
+
+		if (!S_ISREG(entry->st.st_mode) || mtime > entry->st.st_mtime)
+			continue;
+
+		logfile_candidate = zbx_dsprintf(NULL, "%s%s", watch->directory, entry->name);
+		add_logfile(logfiles, logfiles_alloc, logfiles_num, logfile_candidate, &entry->st);
+		zbx_free(logfile_candidate);
+	}
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: find logfiles in a directory and put them into a list             *
@@ -1522,9 +1582,19 @@ clean:
 
 	return ret;
 #else
-	DIR		*dir = NULL;
-	struct dirent	*d_ent = NULL;
+	DIR			*dir = NULL;
+	struct dirent		*d_ent = NULL;
+#if defined(ZBX_LOGDIR_WATCH)
+	zbx_logdir_watch_t	*watch;
+
+	if (NULL != (watch = zbx_logdir_watch_get(directory)))
+	{
+		*use_ino = 1;
+		pick_watched_logfiles(watch, mtime, re, logfiles, logfiles_alloc, logfiles_num);
 
+		return SUCCEED;
+	}
+#endif
 	if (NULL == (dir = opendir(directory)))
 	{
 		*err_msg = zbx_dsprintf(*err_msg, "Cannot open directory \"%s\" for reading: %s", directory,
@@ -1589,7 +1659,8 @@ static int	compile_filename_regexp(const char *filename_regexp, zbx_regexp_t **r
  *                                                                            *
  * Return value: SUCCEED or FAIL                                              *
  *                                                                            *
- * Comments: Thread-safe                                                      *
+ * Comments: Thread-safe. MD5 sums of files in watched directories are reused *
+ *           if the files have not changed since the previous check.          *
  *                                                                            *
  ******************************************************************************/
 #if defined(_WINDOWS) || defined(__MINGW32__)
@@ -1607,14 +1678,31 @@ static int	fill_file_details(struct st_logfile **logfiles, int logfiles_num, cha
 	{
 		int			f;
 		struct st_logfile	*p = *logfiles + i;
-
+#if defined(ZBX_LOGDIR_WATCH)
+		zbx_logdir_entry_t	*entry;
+#endif
+		p->md5size = (zbx_uint64_t)MAX_LEN_MD5 > p->size ? (int)p->size : MAX_LEN_MD5;
+#if defined(ZBX_LOGDIR_WATCH)
+		if (NULL != (entry = zbx_logdir_watch_find_file(p->filename)) && 0 != entry->md5_valid &&
+				entry->md5size == p->md5size)
+		{
+			memcpy(p->md5buf, entry->md5buf, sizeof(p->md5buf));
+			continue;
+		}
+#endif
 		if (-1 == (f = open_file_helper(p->filename, err_msg)))
 			return FAIL;
 
-		p->md5size = (zbx_uint64_t)MAX_LEN_MD5 > p->size ? (int)p->size : MAX_LEN_MD5;
-
 		if (SUCCEED != (ret = file_start_md5(f, p->md5size, p->md5buf, p->filename, err_msg)))
 			goto clean;
+#if defined(ZBX_LOGDIR_WATCH)
+		if (NULL != entry)
+		{
+			memcpy(entry->md5buf, p->md5buf, sizeof(entry->md5buf));
+			entry->md5size = p->md5size;
+			entry->md5_valid = 1;
+		}
+#endif
 #if defined(_WINDOWS) || defined(__MINGW32__)
 		ret = file_id(f, use_ino, &p->dev, &p->ino_lo, &p->ino_hi, p->filename, err_msg);
 #endif	/*_WINDOWS*/
@@ -1751,6 +1839,127 @@ clean:
 	return	ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: skips bytes which cannot start a line ending or contain a NULL    *
+ *          character in single-byte character set                            *
+ *                                                                            *
+ * Parameters: p     - [IN] the current position                              *
+ *             p_end - [IN] the end of data                                   *
+ *                                                                            *
+ * Return value: position of the first CR, LF or NULL byte or position from   *
+ *               which the remaining data must be checked byte by byte        *
+ *                                                                            *
+ * Comments: scans 32 or 16 bytes at a time when compiled with AVX2 or SSE2   *
+ *           support, otherwise returns the current position                  *
+ *                                                                            *
+ ******************************************************************************/
+static char	*buf_skip_plain_sb(char *p, const char *p_end)
+{
+#if defined(ZBX_LOG_SCAN_AVX2)
+	const __m256i	v_lf = _mm256_set1_epi8(0xa), v_cr = _mm256_set1_epi8(0xd), v_nul = _mm256_setzero_si256();
+
+	for (; p + sizeof(__m256i) <= p_end; p += sizeof(__m256i))
+	{
+		__m256i		chunk = _mm256_loadu_si256((const __m256i *)p);
+		unsigned int	mask;
+
+		mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(
+				_mm256_cmpeq_epi8(chunk, v_lf), _mm256_cmpeq_epi8(chunk, v_cr)),
+				_mm256_cmpeq_epi8(chunk, v_nul)));
+
+		if (0 != mask)
+			return p + __builtin_ctz(mask);
+	}
+#elif defined(ZBX_LOG_SCAN_SSE2)
+	const __m128i	v_lf = _mm_set1_epi8(0xa), v_cr = _mm_set1_epi8(0xd), v_nul = _mm_setzero_si128();
+
+	for (; p + sizeof(__m128i) <= p_end; p += sizeof(__m128i))
+	{
+		__m128i		chunk = _mm_loadu_si128((const __m128i *)p);
+		unsigned int	mask;
+
+		mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, v_lf),
+				_mm_cmpeq_epi8(chunk, v_cr)), _mm_cmpeq_epi8(chunk, v_nul)));
+
+		if (0 != mask)
+			return p + __builtin_ctz(mask);
+	}
+#else
+	ZBX_UNUSED(p_end);
+#endif
+	return p;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: skips UTF-16 characters which are not CR, LF or NULL              *
+ *                                                                            *
+ * Parameters: p     - [IN] the current position                              *
+ *             p_end - [IN] the end of data                                   *
+ *             cr    - [IN] the CR character in the file encoding             *
+ *             lf    - [IN] the LF character in the file encoding             *
+ *                                                                            *
+ * Return value: position of the first CR, LF or NULL character or position   *
+ *               from which the remaining data must be checked one character  *
+ *               at a time                                                    *
+ *                                                                            *
+ * Comments: Characters are compared in their file byte order, so the same    *
+ *           code handles both little-endian and big-endian files.            *
+ *                                                                            *
+ ******************************************************************************/
+static char	*buf_skip_plain_utf16(char *p, const char *p_end, const char *cr, const char *lf)
+{
+#if defined(ZBX_LOG_SCAN_AVX2) || defined(ZBX_LOG_SCAN_SSE2)
+	unsigned short	cr16, lf16;
+
+	memcpy(&cr16, cr, sizeof(cr16));
+	memcpy(&lf16, lf, sizeof(lf16));
+#endif
+#if defined(ZBX_LOG_SCAN_AVX2)
+	{
+		const __m256i	v_lf = _mm256_set1_epi16((short)lf16), v_cr = _mm256_set1_epi16((short)cr16),
+				v_nul = _mm256_setzero_si256();
+
+		for (; p + sizeof(__m256i) <= p_end; p += sizeof(__m256i))
+		{
+			__m256i		chunk = _mm256_loadu_si256((const __m256i *)p);
+			unsigned int	mask;
+
+			mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(
+					_mm256_cmpeq_epi16(chunk, v_lf), _mm256_cmpeq_epi16(chunk, v_cr)),
+					_mm256_cmpeq_epi16(chunk, v_nul)));
+
+			if (0 != mask)
+				return p + __builtin_ctz(mask);
+		}
+	}
+#elif defined(ZBX_LOG_SCAN_SSE2)
+	{
+		const __m128i	v_lf = _mm_set1_epi16((short)lf16), v_cr = _mm_set1_epi16((short)cr16),
+				v_nul = _mm_setzero_si128();
+
+		for (; p + sizeof(__m128i) <= p_end; p += sizeof(__m128i))
+		{
+			__m128i		chunk = _mm_loadu_si128((const __m128i *)p);
+			unsigned int	mask;
+
+			mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(
+					_mm_cmpeq_epi16(chunk, v_lf), _mm_cmpeq_epi16(chunk, v_cr)),
+					_mm_cmpeq_epi16(chunk, v_nul)));
+
+			if (0 != mask)
+				return p + __builtin_ctz(mask);
+		}
+	}
+#else
+	ZBX_UNUSED(p_end);
+	ZBX_UNUSED(cr);
+	ZBX_UNUSED(lf);
+#endif
+	return p;
+}
+
 static char	*buf_find_newline(char *p, char **p_next, const char *p_end, const char *cr, const char *lf,
 		size_t szbyte)
 {
@@ -1758,6 +1967,9 @@ static char	*buf_find_newline(char *p, char **p_next, const char *p_end, const c
 	{
 		for (; p < p_end; p++)
 		{
+			if (p_end == (p = buf_skip_plain_sb(p, p_end)))
+				break;
+
 			/* detect NULL byte and replace it with '?' character */
 			if (0x0 == *p)
 			{
@@ -1792,6 +2004,9 @@ static char	*buf_find_newline(char *p, char **p_next, const char *p_end, const c
 	{
 		while (p <= p_end - szbyte)
 		{
+			if (2 == szbyte && p_end - szbyte < (p = buf_skip_plain_utf16(p, p_end, cr, lf)))
+				break;
+
 			/* detect NULL byte in UTF-16 encoding and replace it with '?' character */
 			if (2 == szbyte && 0x0 == *p && 0x0 == *(p + 1))
 			{
@@ -1826,6 +2041,89 @@ static char	*buf_find_newline(char *p, char **p_next, const char *p_end, const c
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: extracts the literal text every match of a regular expression     *
+ *          must start with                                                   *
+ *                                                                            *
+ * Parameters: pattern - [IN] the regular expression                          *
+ *                                                                            *
+ * Return value: the allocated literal prefix or NULL if the pattern does not *
+ *               start with a literal or it cannot be safely determined       *
+ *                                                                            *
+ * Comments: Patterns with alternation and global regular expressions are not *
+ *           analyzed. A character followed by a quantifier allowing zero     *
+ *           repetitions is not included in the prefix.                       *
+ *                                                                            *
+ ******************************************************************************/
+static char	*regexp_literal_prefix(const char *pattern)
+{
+	const char	*start, *end;
+	char		*literal;
+
+	if (NULL == pattern || '\0' == *pattern || '@' == *pattern || NULL != strchr(pattern, '|'))
+		return NULL;
+
+	start = ('^' == *pattern ? pattern + 1 : pattern);
+
+	for (end = start; '\0' != *end && NULL == strchr("\\^$.|?*+()[]{}", *end); end++)
+		;
+
+	if ('?' == *end || '*' == *end || '{' == *end)
+	{
+		/* the quantifier applies to the last character, skip it together with UTF-8 continuation bytes */
+		while (end > start && 0x80 == (*(end - 1) & 0xc0))
+			end--;
+
+		if (end > start)
+			end--;
+	}
+
+	if (end == start)
+		return NULL;
+
+	literal = (char *)zbx_malloc(NULL, (size_t)(end - start) + 1);
+	memcpy(literal, start, (size_t)(end - start));
+	literal[end - start] = '\0';
+
+	return literal;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: matches log line against regular expression, rejecting lines     *
+ *          without the literal prefix of regular expression before running   *
+ *          the regular expression engine                                     *
+ *                                                                            *
+ * Parameters: regexps         - [IN] the global regular expressions          *
+ *             value           - [IN] the log line                            *
+ *             pattern         - [IN] the regular expression                  *
+ *             literal         - [IN] the literal prefix of pattern, optional *
+ *             pattern_checked - [IN/OUT] SUCCEED if the pattern was already  *
+ *                                        compiled successfully               *
+ *             output_template - [IN] the output template, optional           *
+ *             output          - [OUT] the output value, optional             *
+ *                                                                            *
+ * Return value: see regexp_sub_ex()                                          *
+ *                                                                            *
+ * Comments: The first line is always passed to regexp_sub_ex() so that       *
+ *           invalid regular expressions are still reported.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	regexp_sub_prefiltered(const zbx_vector_ptr_t *regexps, const char *value, const char *pattern,
+		const char *literal, int *pattern_checked, const char *output_template, char **output)
+{
+	int	ret;
+
+	if (NULL != literal && SUCCEED == *pattern_checked && NULL == strstr(value, literal))
+		return ZBX_REGEXP_NO_MATCH;
+
+	if (FAIL != (ret = regexp_sub_ex(regexps, value, pattern, ZBX_CASE_SENSITIVE, output_template, output)))
+		*pattern_checked = SUCCEED;
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Comments: Thread-safe                                                      *
@@ -1839,13 +2137,14 @@ static int	zbx_read2(int fd, unsigned char flags, zbx_uint64_t *lastlogsize, int
 {
 	static ZBX_THREAD_LOCAL char	*buf = NULL;
 
-	int				ret, nbytes, regexp_ret;
+	int				ret, nbytes, regexp_ret, pattern_checked = FAIL, p_count_start = *p_count;
 	const char			*cr, *lf, *p_end;
-	char				*p_start, *p, *p_nl, *p_next, *item_value = NULL;
+	char				*p_start, *p, *p_nl, *p_next, *item_value = NULL, *literal;
 	size_t				szbyte;
 	zbx_offset_t			offset;
 	int				send_err;
 	zbx_uint64_t			lastlogsize1;
+	double				time_start;
 
 #define BUF_SIZE	(256 * ZBX_KIBIBYTE)	/* The longest encodings use 4 bytes for every character. To send */
 						/* up to 64 k characters to Zabbix server a 256 kB buffer might be */
@@ -1856,6 +2155,9 @@ static int	zbx_read2(int fd, unsigned char flags, zbx_uint64_t *lastlogsize, int
 
 	find_cr_lf_szbyte(encoding, &cr, &lf, &szbyte);
 
+	literal = regexp_literal_prefix(pattern);
+	time_start = zbx_time();
+
 	for (;;)
 	{
 		if (0 >= *p_count || 0 >= *s_count)
@@ -1939,9 +2241,9 @@ static int	zbx_read2(int fd, unsigned char flags, zbx_uint64_t *lastlogsize, int
 
 					if (0 == (ZBX_METRIC_FLAG_LOG_COUNT & flags))	/* log[] or logrt[] */
 					{
-						if (ZBX_REGEXP_MATCH == (regexp_ret = regexp_sub_ex(regexps, value,
-								pattern, ZBX_CASE_SENSITIVE, output_template,
-								&item_value)))
+						if (ZBX_REGEXP_MATCH == (regexp_ret = regexp_sub_prefiltered(regexps,
+								value, pattern, literal, &pattern_checked,
+								output_template, &item_value)))
 						{
 							if (SUCCEED == (send_err = process_value(server, port,
 									hostname, key, item_value, ITEM_STATE_NORMAL,
@@ -1968,8 +2270,9 @@ static int	zbx_read2(int fd, unsigned char flags, zbx_uint64_t *lastlogsize, int
 					}
 					else	/* log.count[] or logrt.count[] */
 					{
-						if (ZBX_REGEXP_MATCH == (regexp_ret = regexp_sub_ex(regexps, value,
-								pattern, ZBX_CASE_SENSITIVE, NULL, NULL)))
+						if (ZBX_REGEXP_MATCH == (regexp_ret = regexp_sub_prefiltered(regexps,
+								value, pattern, literal, &pattern_checked, NULL,
+								NULL)))
 						{
 							(*s_count)--;
 						}
@@ -2033,9 +2336,9 @@ static int	zbx_read2(int fd, unsigned char flags, zbx_uint64_t *lastlogsize, int
 
 					if (0 == (ZBX_METRIC_FLAG_LOG_COUNT & flags))   /* log[] or logrt[] */
 					{
-						if (ZBX_REGEXP_MATCH == (regexp_ret = regexp_sub_ex(regexps, value,
-								pattern, ZBX_CASE_SENSITIVE, output_template,
-								&item_value)))
+						if (ZBX_REGEXP_MATCH == (regexp_ret = regexp_sub_prefiltered(regexps,
+								value, pattern, literal, &pattern_checked,
+								output_template, &item_value)))
 						{
 							if (SUCCEED == (send_err = process_value(server, port,
 									hostname, key, item_value, ITEM_STATE_NORMAL,
@@ -2062,8 +2365,9 @@ static int	zbx_read2(int fd, unsigned char flags, zbx_uint64_t *lastlogsize, int
 					}
 					else	/* log.count[] or logrt.count[] */
 					{
-						if (ZBX_REGEXP_MATCH == (regexp_ret = regexp_sub_ex(regexps, value,
-								pattern, ZBX_CASE_SENSITIVE, NULL, NULL)))
+						if (ZBX_REGEXP_MATCH == (regexp_ret = regexp_sub_prefiltered(regexps,
+								value, pattern, literal, &pattern_checked, NULL,
+								NULL)))
 						{
 							(*s_count)--;
 						}
@@ -2121,6 +2425,17 @@ static int	zbx_read2(int fd, unsigned char flags, zbx_uint64_t *lastlogsize, int
 		}
 	}
 out:
+	zbx_free(literal);
+
+	if (p_count_start > *p_count && SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+	{
+		double	time_spent = zbx_time() - time_start;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() processed %d lines in " ZBX_FS_DBL " sec (" ZBX_FS_DBL
+				" lines/sec)", __func__, p_count_start - *p_count, time_spent,
+				0 < time_spent ? (p_count_start - *p_count) / time_spent : 0.0);
+	}
+
 	return ret;
 
 #undef BUF_SIZE
@@ -3667,3 +3982,7 @@ out:
 
 	return ret;
 }
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/zabbix_agent/logfiles/logfiles_test.c"
+#endif
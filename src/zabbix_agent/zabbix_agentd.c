@@ -45,6 +45,10 @@ int	CONFIG_LOG_LEVEL		= LOG_LEVEL_WARNING;
 
 int	CONFIG_BUFFER_SIZE		= 100;
 int	CONFIG_BUFFER_SEND		= 5;
+#ifndef _WINDOWS
+char		*CONFIG_BUFFER_SPOOL_FILE	= NULL;
+zbx_uint64_t	CONFIG_BUFFER_SPOOL_SIZE	= 64 * ZBX_MEBIBYTE;
+#endif
 
 int	CONFIG_MAX_LINES_PER_SECOND		= 20;
 int	CONFIG_EVENTLOG_MAX_LINES_PER_SECOND	= 20;
@@ -291,6 +295,10 @@ int	CONFIG_PREPROCESSOR_FORKS	= 0;
 int	CONFIG_LLDMANAGER_FORKS		= 0;
 int	CONFIG_LLDWORKER_FORKS		= 0;
 int	CONFIG_ALERTDB_FORKS		= 0;
+int	CONFIG_TRAPPERMAN_FORKS		= 0;
+int	CONFIG_ESCALATIONMAN_FORKS	= 0;
+int	CONFIG_HTTPAGENT_POLLER_FORKS	= 0;
+int	CONFIG_DNSRESOLVER_FORKS	= 0;
 
 char	*opt = NULL;
 
@@ -758,6 +766,12 @@ static void	zbx_load_config(int requirement, ZBX_TASK_EX *task)
 			PARM_OPT,	2,			65535},
 		{"BufferSend",			&CONFIG_BUFFER_SEND,			TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
+#ifndef _WINDOWS
+		{"BufferSpoolFile",		&CONFIG_BUFFER_SPOOL_FILE,		TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"BufferSpoolSize",		&CONFIG_BUFFER_SPOOL_SIZE,		TYPE_UINT64,
+			PARM_OPT,	ZBX_MEBIBYTE,		__UINT64_C(64) * ZBX_GIBIBYTE},
+#endif
 #ifndef _WINDOWS
 		{"PidFile",			&CONFIG_PID_FILE,			TYPE_STRING,
 			PARM_OPT,	0,			0},
@@ -28,6 +28,8 @@ PID_FILE="/tmp/zabbix_java.pid"
 
 ### Option: zabbix.startPollers
 #	Number of worker threads to start.
+#	Also the number of connections kept open for Zabbix server and proxy Java pollers, should not be less
+#	than the total number of their Java pollers. Further connections are closed after one request.
 #
 # Mandatory: no
 # Range: 1-1000
@@ -40,20 +40,30 @@ class BinaryProtocolSpeaker
 	private DataInputStream dis = null;
 	private BufferedOutputStream bos = null;
 
-	BinaryProtocolSpeaker(Socket socket)
+	BinaryProtocolSpeaker(Socket socket) throws IOException
 	{
 		this.socket = socket;
+
+		dis = new DataInputStream(new BufferedInputStream(socket.getInputStream()));
+		bos = new BufferedOutputStream(socket.getOutputStream());
 	}
 
+	/*
+	 * Returns the next request or null if the connection was closed by the client between requests.
+	 */
 	String getRequest() throws IOException, ZabbixException
 	{
-		dis = new DataInputStream(socket.getInputStream());
-
 		byte[] data;
+		int first;
 
 		logger.debug("reading Zabbix protocol header");
+
+		if (-1 == (first = dis.read()))
+			return null;
+
 		data = new byte[5];
-		dis.readFully(data);
+		data[0] = (byte)first;
+		dis.readFully(data, 1, data.length - 1);
 
 		if (!Arrays.equals(data, PROTOCOL_HEADER))
 			throw new ZabbixException("bad protocol header: %02X %02X %02X %02X %02X", data[0], data[1], data[2], data[3], data[4]);
@@ -78,10 +88,8 @@ class BinaryProtocolSpeaker
 		return request;
 	}
 
-	void sendResponse(String response) throws IOException, ZabbixException
+	synchronized void sendResponse(String response) throws IOException, ZabbixException
 	{
-		bos = new BufferedOutputStream(socket.getOutputStream());
-
 		logger.debug("sending the following data in response: {}", response);
 
 		byte[] data, responseBytes;
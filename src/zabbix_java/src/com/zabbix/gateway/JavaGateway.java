@@ -21,6 +21,7 @@ package com.zabbix.gateway;
 
 import java.net.InetAddress;
 import java.net.ServerSocket;
+import java.net.Socket;
 import java.util.concurrent.*;
 import java.util.Map;
 import java.util.HashMap;
@@ -80,8 +81,31 @@ public class JavaGateway
 					new ThreadPoolExecutor.CallerRunsPolicy());
 			logger.debug("created a thread pool of {} pollers", startPollers);
 
+			// connections are kept open by the server between requests, each is served by its own thread,
+			// at most one per expected Java poller; when all are busy the connection is served with a single
+			// request in the poller thread pool like by older gateways
+			ThreadPoolExecutor connectionPool = new ThreadPoolExecutor(
+					startPollers,
+					startPollers,
+					30L, TimeUnit.SECONDS,
+					new SynchronousQueue<Runnable>());
+			connectionPool.allowCoreThreadTimeOut(true);
+			logger.debug("created a connection pool of {} threads", startPollers);
+
 			while (true)
-				threadPool.execute(new SocketProcessor(socket.accept()));
+			{
+				Socket connection = socket.accept();
+
+				try
+				{
+					connectionPool.execute(new SocketProcessor(connection, threadPool, true));
+				}
+				catch (RejectedExecutionException e)
+				{
+					logger.debug("all connection threads are busy, serving a single request");
+					threadPool.execute(new SocketProcessor(connection, threadPool, false));
+				}
+			}
 		}
 		catch (Exception e)
 		{
@@ -0,0 +1,146 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+package com.zabbix.gateway;
+
+import java.util.Map;
+import java.util.Iterator;
+
+import org.json.*;
+
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+
+class RequestProcessor implements Runnable
+{
+	private static final Logger logger = LoggerFactory.getLogger(RequestProcessor.class);
+
+	private static long cleanupTime = System.currentTimeMillis();
+
+	private SocketProcessor connection;
+	private String request;
+	private String response = null;
+
+	RequestProcessor(SocketProcessor connection, String request)
+	{
+		this.connection = connection;
+		this.request = request;
+	}
+
+	@Override
+	public void run()
+	{
+		logger.debug("starting to process request");
+
+		ItemChecker checker = null;
+
+		try
+		{
+			JSONObject request = new JSONObject(this.request);
+
+			if (request.getString(ItemChecker.JSON_TAG_REQUEST).equals(ItemChecker.JSON_REQUEST_INTERNAL))
+			{
+				checker = new InternalItemChecker(request);
+			}
+			else if (request.getString(ItemChecker.JSON_TAG_REQUEST).equals(ItemChecker.JSON_REQUEST_JMX))
+			{
+				checker = new JMXItemChecker(request);
+
+				cleanDiscoveredObjects(System.currentTimeMillis());
+			}
+			else
+				throw new ZabbixException("bad request tag value: '%s'", request.getString(ItemChecker.JSON_TAG_REQUEST));
+
+			logger.debug("dispatched request to class {}", checker.getClass().getName());
+			JSONArray values = checker.getValues();
+
+			JSONObject response = new JSONObject();
+			response.put(ItemChecker.JSON_TAG_RESPONSE, ItemChecker.JSON_RESPONSE_SUCCESS);
+			response.put(ItemChecker.JSON_TAG_DATA, values);
+
+			setResponse(response.toString());
+		}
+		catch (Exception e1)
+		{
+			String error = ZabbixException.getRootCauseMessage(e1);
+
+			// Display first item key to identify items with incorrect configuration, all items in batch have same configuration.
+			if (null == checker || null == checker.getFirstKey())
+				logger.warn("error processing request: {}", error);
+			else
+				logger.warn("error processing request, item \"{}\" failed: {}", checker.getFirstKey(), error);
+
+			logger.debug("error caused by", e1);
+
+			try
+			{
+				JSONObject response = new JSONObject();
+				response.put(ItemChecker.JSON_TAG_RESPONSE, ItemChecker.JSON_RESPONSE_FAILED);
+				response.put(ItemChecker.JSON_TAG_ERROR, error);
+
+				setResponse(response.toString());
+			}
+			catch (Exception e2)
+			{
+				logger.warn("error preparing failure notification: {}", ZabbixException.getRootCauseMessage(e1));
+				logger.debug("error caused by", e2);
+
+				setResponse(null);
+			}
+		}
+
+		connection.complete();
+
+		logger.debug("finished processing request");
+	}
+
+	synchronized boolean isDone()
+	{
+		return null != response || null == request;
+	}
+
+	synchronized String getResponse()
+	{
+		return response;
+	}
+
+	private synchronized void setResponse(String response)
+	{
+		this.response = response;
+		this.request = null;
+	}
+
+	private static synchronized void cleanDiscoveredObjects(long now)
+	{
+		if (now < cleanupTime)
+			return;
+
+		for (Iterator<Map.Entry<String, Long>> it = JavaGateway.iterativeObjects.entrySet().iterator();
+			it.hasNext(); )
+		{
+			Map.Entry<String, Long> entry = it.next();
+			long expirationTime = entry.getValue();
+
+			if (now >= expirationTime)
+				it.remove();
+		}
+
+		cleanupTime = now + SocketProcessor.MILLISECONDS_IN_HOUR;
+	}
+}
@@ -20,26 +20,40 @@
 package com.zabbix.gateway;
 
 import java.net.Socket;
-import java.util.Map;
-import java.util.Iterator;
-
-import org.json.*;
+import java.net.SocketTimeoutException;
+import java.util.LinkedList;
+import java.util.concurrent.Executor;
 
 import org.slf4j.Logger;
 import org.slf4j.LoggerFactory;
 
+/*
+ * Reads requests from a connection until the client closes it. Requests are processed concurrently by
+ * the pollers, responses are sent back in the order the requests were received, so that the client can
+ * pipeline several requests without waiting for each response. Connections that are not persistent are
+ * closed after the first request is processed in the calling thread.
+ */
 class SocketProcessor implements Runnable
 {
 	private static final Logger logger = LoggerFactory.getLogger(SocketProcessor.class);
 
-	private static long cleanupTime = System.currentTimeMillis();
 	private Socket socket;
+	private Executor pollers;
+	private boolean persistent;
+	private BinaryProtocolSpeaker speaker = null;
+	private LinkedList<RequestProcessor> pending = new LinkedList<RequestProcessor>();
+	private boolean failed = false;
 
 	public static final long MILLISECONDS_IN_HOUR = 1000 * 60 * 60;
 
-	SocketProcessor(Socket socket)
+	// persistent connections idle for longer are closed, so that threads of dead clients are released
+	private static final int IDLE_TIMEOUT = 1000 * 60 * 5;
+
+	SocketProcessor(Socket socket, Executor pollers, boolean persistent)
 	{
 		this.socket = socket;
+		this.pollers = pollers;
+		this.persistent = persistent;
 	}
 
 	@Override
@@ -47,71 +61,63 @@ class SocketProcessor implements Runnable
 	{
 		logger.debug("starting to process incoming connection");
 
-		BinaryProtocolSpeaker speaker = null;
-		ItemChecker checker = null;
-
 		try
 		{
-			speaker = new BinaryProtocolSpeaker(socket);
-
-			JSONObject request = new JSONObject(speaker.getRequest());
-
-			if (request.getString(ItemChecker.JSON_TAG_REQUEST).equals(ItemChecker.JSON_REQUEST_INTERNAL))
+			if (persistent)
 			{
-				checker = new InternalItemChecker(request);
-			}
-			else if (request.getString(ItemChecker.JSON_TAG_REQUEST).equals(ItemChecker.JSON_REQUEST_JMX))
-			{
-				checker = new JMXItemChecker(request);
-
-				long now = System.currentTimeMillis();
-
-				if (now >= cleanupTime)
-				{
-					cleanDiscoveredObjects(now);
-					cleanupTime = now + MILLISECONDS_IN_HOUR;
-				}
+				socket.setSoTimeout(IDLE_TIMEOUT);
+				socket.setKeepAlive(true);
 			}
 			else
-				throw new ZabbixException("bad request tag value: '%s'", request.getString(ItemChecker.JSON_TAG_REQUEST));
+				socket.setSoTimeout(1000 * ConfigurationManager.getIntegerParameterValue(ConfigurationManager.TIMEOUT));
 
-			logger.debug("dispatched request to class {}", checker.getClass().getName());
-			JSONArray values = checker.getValues();
+			speaker = new BinaryProtocolSpeaker(socket);
 
-			JSONObject response = new JSONObject();
-			response.put(ItemChecker.JSON_TAG_RESPONSE, ItemChecker.JSON_RESPONSE_SUCCESS);
-			response.put(ItemChecker.JSON_TAG_DATA, values);
+			String request;
 
-			speaker.sendResponse(response.toString());
-		}
-		catch (Exception e1)
-		{
-			String error = ZabbixException.getRootCauseMessage(e1);
+			while (null != (request = speaker.getRequest()))
+			{
+				RequestProcessor processor = new RequestProcessor(this, request);
 
-			// Display first item key to identify items with incorrect configuration, all items in batch have same configuration.
-			if (null == checker || null == checker.getFirstKey())
-				logger.warn("error processing request: {}", error);
-			else
-				logger.warn("error processing request, item \"{}\" failed: {}", checker.getFirstKey(), error);
+				synchronized (this)
+				{
+					if (failed)
+						break;
 
-			logger.debug("error caused by", e1);
+					pending.addLast(processor);
+				}
 
-			try
-			{
-				JSONObject response = new JSONObject();
-				response.put(ItemChecker.JSON_TAG_RESPONSE, ItemChecker.JSON_RESPONSE_FAILED);
-				response.put(ItemChecker.JSON_TAG_ERROR, error);
+				if (!persistent)
+				{
+					processor.run();
+					break;
+				}
 
-				speaker.sendResponse(response.toString());
+				pollers.execute(processor);
 			}
-			catch (Exception e2)
+
+			synchronized (this)
 			{
-				logger.warn("error sending failure notification: {}", ZabbixException.getRootCauseMessage(e1));
-				logger.debug("error caused by", e2);
+				while (!failed && !pending.isEmpty())
+					wait();
 			}
 		}
+		catch (SocketTimeoutException e)
+		{
+			logger.debug("closing connection: {}", ZabbixException.getRootCauseMessage(e));
+		}
+		catch (Exception e)
+		{
+			logger.warn("error processing connection: {}", ZabbixException.getRootCauseMessage(e));
+			logger.debug("error caused by", e);
+		}
 		finally
 		{
+			synchronized (this)
+			{
+				failed = true;
+			}
+
 			try { if (null != speaker) speaker.close(); } catch (Exception e) { }
 			try { if (null != socket) socket.close(); } catch (Exception e) { }
 		}
@@ -119,16 +125,31 @@ class SocketProcessor implements Runnable
 		logger.debug("finished processing incoming connection");
 	}
 
-	private void cleanDiscoveredObjects(long now)
+	synchronized void complete()
 	{
-		for (Iterator<Map.Entry<String, Long>> it = JavaGateway.iterativeObjects.entrySet().iterator();
-			it.hasNext(); )
+		while (!failed && !pending.isEmpty() && pending.getFirst().isDone())
 		{
-			Map.Entry<String, Long> entry = it.next();
-			long expirationTime = entry.getValue();
+			String response = pending.removeFirst().getResponse();
+
+			try
+			{
+				if (null == response)
+					throw new ZabbixException("cannot prepare response");
+
+				speaker.sendResponse(response);
+			}
+			catch (Exception e)
+			{
+				logger.warn("error sending response: {}", ZabbixException.getRootCauseMessage(e));
+				logger.debug("error caused by", e);
+
+				failed = true;
 
-			if (now >= expirationTime)
-				it.remove();
+				// unblock the reading thread, the connection cannot be used anymore
+				try { socket.shutdownInput(); } catch (Exception e2) { }
+			}
 		}
+
+		notifyAll();
 	}
 }
@@ -45,6 +45,7 @@
 #include "../zabbix_server/pinger/pinger.h"
 #include "../zabbix_server/poller/poller.h"
 #include "../zabbix_server/trapper/trapper.h"
+#include "../zabbix_server/trapper/trapper_manager.h"
 #include "../zabbix_server/trapper/proxydata.h"
 #include "../zabbix_server/snmptrapper/snmptrapper.h"
 #include "proxyconfig/proxyconfig.h"
@@ -58,6 +59,8 @@
 #include "zbxipcservice.h"
 #include "../zabbix_server/preprocessor/preproc_manager.h"
 #include "../zabbix_server/preprocessor/preproc_worker.h"
+#include "../zabbix_server/forkserver/forkserver.h"
+#include "../zabbix_server/dnsresolver/dnsresolver.h"
 
 
 #ifdef HAVE_OPENIPMI
@@ -98,11 +101,13 @@ const char	*help_message[] = {
 	"      Log level control targets:",
 	"        process-type             All processes of specified type",
 	"                                 (configuration syncer, data sender, discoverer,",
-	"                                 heartbeat sender, history syncer, housekeeper,",
-	"                                 http poller, icmp pinger, ipmi manager,",
-	"                                 ipmi poller, java poller, poller,",
+	"                                 dns resolver, heartbeat sender, history syncer,",
+	"                                 housekeeper,",
+	"                                 http agent poller, http poller, icmp pinger,",
+	"                                 ipmi manager, ipmi poller, java poller, poller,",
 	"                                 self-monitoring, snmp trapper, task manager,",
-	"                                 trapper, unreachable poller, vmware collector)",
+	"                                 trapper, trapper manager, unreachable poller,",
+	"                                 vmware collector)",
 	"        process-type,N           Process type and number (e.g., poller,3)",
 	"        pid                      Process identifier, up to 65535. For larger",
 	"                                 values specify target as \"process-type,N\"",
@@ -160,6 +165,10 @@ int	CONFIG_IPMIPOLLER_FORKS		= 0;
 int	CONFIG_TRAPPER_FORKS		= 5;
 int	CONFIG_SNMPTRAPPER_FORKS	= 0;
 int	CONFIG_JAVAPOLLER_FORKS		= 0;
+int	CONFIG_HTTPAGENT_POLLER_FORKS	= 0;
+int	CONFIG_POLLER_SMOOTHING		= 0;
+int	CONFIG_POLLER_SMOOTHING_QUEUE	= 100000;
+int	CONFIG_DNSRESOLVER_FORKS	= 0;
 int	CONFIG_SELFMON_FORKS		= 1;
 int	CONFIG_PROXYPOLLER_FORKS	= 0;
 int	CONFIG_ESCALATOR_FORKS		= 0;
@@ -177,6 +186,8 @@ int	CONFIG_PREPROCESSOR_FORKS	= 3;
 int	CONFIG_LLDMANAGER_FORKS		= 0;
 int	CONFIG_LLDWORKER_FORKS		= 0;
 int	CONFIG_ALERTDB_FORKS		= 0;
+int	CONFIG_TRAPPERMAN_FORKS		= 0;
+int	CONFIG_ESCALATIONMAN_FORKS	= 0;
 
 int	CONFIG_LISTEN_PORT		= ZBX_DEFAULT_SERVER_PORT;
 char	*CONFIG_LISTEN_IP		= NULL;
@@ -200,6 +211,7 @@ int	CONFIG_VMWARE_FORKS		= 0;
 int	CONFIG_VMWARE_FREQUENCY		= 60;
 int	CONFIG_VMWARE_PERF_FREQUENCY	= 60;
 int	CONFIG_VMWARE_TIMEOUT		= 10;
+int	CONFIG_DNSCACHE_TTL		= 60;
 
 zbx_uint64_t	CONFIG_CONF_CACHE_SIZE		= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * ZBX_MEBIBYTE;
@@ -207,6 +219,7 @@ zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 0;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
+zbx_uint64_t	CONFIG_DNSCACHE_SIZE		= 0;
 zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE;
 
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
@@ -307,6 +320,12 @@ int	get_process_info_by_thread(int local_server_num, unsigned char *local_proces
 		*local_process_type = ZBX_PROCESS_TYPE_CONFSYNCER;
 		*local_process_num = local_server_num - server_count + CONFIG_CONFSYNCER_FORKS;
 	}
+	else if (local_server_num <= (server_count += CONFIG_TRAPPERMAN_FORKS))
+	{
+		/* trapper manager must be running before trappers register with it */
+		*local_process_type = ZBX_PROCESS_TYPE_TRAPPERMAN;
+		*local_process_num = local_server_num - server_count + CONFIG_TRAPPERMAN_FORKS;
+	}
 	else if (local_server_num <= (server_count += CONFIG_TRAPPER_FORKS))
 	{
 		/* make initial configuration sync before worker processes are forked on passive Zabbix proxy */
@@ -369,6 +388,16 @@ int	get_process_info_by_thread(int local_server_num, unsigned char *local_proces
 		*local_process_type = ZBX_PROCESS_TYPE_JAVAPOLLER;
 		*local_process_num = local_server_num - server_count + CONFIG_JAVAPOLLER_FORKS;
 	}
+	else if (local_server_num <= (server_count += CONFIG_HTTPAGENT_POLLER_FORKS))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_HTTPAGENTPOLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_HTTPAGENT_POLLER_FORKS;
+	}
+	else if (local_server_num <= (server_count += CONFIG_DNSRESOLVER_FORKS))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_DNSRESOLVER;
+		*local_process_num = local_server_num - server_count + CONFIG_DNSRESOLVER_FORKS;
+	}
 	else if (local_server_num <= (server_count += CONFIG_SNMPTRAPPER_FORKS))
 	{
 		*local_process_type = ZBX_PROCESS_TYPE_SNMPTRAPPER;
@@ -501,6 +530,12 @@ static void	zbx_set_defaults(void)
 
 	if (0 != CONFIG_IPMIPOLLER_FORKS)
 		CONFIG_IPMIMANAGER_FORKS = 1;
+
+	if (0 == CONFIG_TRAPPER_FORKS)
+		CONFIG_TRAPPERMAN_FORKS = 0;
+
+	if (0 != CONFIG_DNSCACHE_SIZE)
+		CONFIG_DNSRESOLVER_FORKS = 1;
 }
 
 /******************************************************************************
@@ -554,6 +589,13 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (0 != CONFIG_DNSCACHE_SIZE && 128 * ZBX_KIBIBYTE > CONFIG_DNSCACHE_SIZE)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"DNSCacheSize\" configuration parameter must be either 0"
+				" or greater than 128KB");
+		err = 1;
+	}
+
 	if (NULL != CONFIG_SOURCE_IP && SUCCEED != is_supported_ip(CONFIG_SOURCE_IP))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "invalid \"SourceIP\" configuration parameter: '%s'", CONFIG_SOURCE_IP);
@@ -573,6 +615,8 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 	err |= (FAIL == check_cfg_feature_str("SSLCALocation", CONFIG_SSL_CA_LOCATION, "cURL library"));
 	err |= (FAIL == check_cfg_feature_str("SSLCertLocation", CONFIG_SSL_CERT_LOCATION, "cURL library"));
 	err |= (FAIL == check_cfg_feature_str("SSLKeyLocation", CONFIG_SSL_KEY_LOCATION, "cURL library"));
+	err |= (FAIL == check_cfg_feature_int("StartHTTPAgentPollers", CONFIG_HTTPAGENT_POLLER_FORKS,
+			"cURL library"));
 #endif
 #if !defined(HAVE_LIBXML2) || !defined(HAVE_LIBCURL)
 	err |= (FAIL == check_cfg_feature_int("StartVMwareCollectors", CONFIG_VMWARE_FORKS, "VMware support"));
@@ -652,12 +696,20 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			1000},
 		{"StartPollersUnreachable",	&CONFIG_UNREACHABLE_POLLER_FORKS,	TYPE_INT,
 			PARM_OPT,	0,			1000},
+		{"PollerSmoothing",		&CONFIG_POLLER_SMOOTHING,		TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"PollerSmoothingQueue",	&CONFIG_POLLER_SMOOTHING_QUEUE,		TYPE_INT,
+			PARM_OPT,	1000,			10000000},
 		{"StartIPMIPollers",		&CONFIG_IPMIPOLLER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			1000},
 		{"StartTrappers",		&CONFIG_TRAPPER_FORKS,			TYPE_INT,
 			PARM_OPT,	0,			1000},
+		{"StartTrapperManager",		&CONFIG_TRAPPERMAN_FORKS,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"StartJavaPollers",		&CONFIG_JAVAPOLLER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			1000},
+		{"StartHTTPAgentPollers",	&CONFIG_HTTPAGENT_POLLER_FORKS,		TYPE_INT,
+			PARM_OPT,	0,			1000},
 		{"JavaGateway",			&CONFIG_JAVA_GATEWAY,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"JavaGatewayPort",		&CONFIG_JAVA_GATEWAY_PORT,		TYPE_INT,
@@ -750,6 +802,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	256 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"VMwareTimeout",		&CONFIG_VMWARE_TIMEOUT,			TYPE_INT,
 			PARM_OPT,	1,			300},
+		{"DNSCacheSize",		&CONFIG_DNSCACHE_SIZE,			TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"DNSCacheTTL",			&CONFIG_DNSCACHE_TTL,			TYPE_INT,
+			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"AllowRoot",			&CONFIG_ALLOW_ROOT,			TYPE_INT,
 			PARM_OPT,	0,			1},
 		{"User",			&CONFIG_USER,				TYPE_STRING,
@@ -1021,6 +1077,14 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 #endif
+	/* the fork server must be started before allocating shared memory, so it stays small */
+	if (SUCCEED != zbx_forkserver_start(&error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot start fork server: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	if (FAIL == zbx_load_modules(CONFIG_LOAD_MODULE_PATH, CONFIG_LOAD_MODULE, CONFIG_TIMEOUT, 1))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "loading modules failed, exiting...");
@@ -1064,6 +1128,18 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 
+	if (0 != CONFIG_DNSCACHE_SIZE)
+	{
+		if (SUCCEED != zbx_dns_cache_init(&error))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot initialize DNS cache: %s", error);
+			zbx_free(error);
+			exit(EXIT_FAILURE);
+		}
+
+		zbx_set_resolve_func(zbx_dns_cache_resolve);
+	}
+
 	if (SUCCEED != DBinit(&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database: %s", error);
@@ -1096,7 +1172,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 			+ CONFIG_DISCOVERER_FORKS + CONFIG_HISTSYNCER_FORKS + CONFIG_IPMIPOLLER_FORKS
 			+ CONFIG_JAVAPOLLER_FORKS + CONFIG_SNMPTRAPPER_FORKS + CONFIG_SELFMON_FORKS
 			+ CONFIG_VMWARE_FORKS + CONFIG_IPMIMANAGER_FORKS + CONFIG_TASKMANAGER_FORKS
-			+ CONFIG_PREPROCMAN_FORKS + CONFIG_PREPROCESSOR_FORKS;
+			+ CONFIG_PREPROCMAN_FORKS + CONFIG_PREPROCESSOR_FORKS + CONFIG_TRAPPERMAN_FORKS
+			+ CONFIG_HTTPAGENT_POLLER_FORKS + CONFIG_DNSRESOLVER_FORKS;
 
 	threads = (pid_t *)zbx_calloc(threads, threads_num, sizeof(pid_t));
 	threads_flags = (int *)zbx_calloc(threads_flags, threads_num, sizeof(int));
@@ -1108,6 +1185,13 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 			zabbix_log(LOG_LEVEL_CRIT, "listener failed: %s", zbx_socket_strerror());
 			exit(EXIT_FAILURE);
 		}
+
+		if (0 != CONFIG_TRAPPERMAN_FORKS && SUCCEED != zbx_trapper_manager_init(&error))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot initialize trapper manager: %s", error);
+			zbx_free(error);
+			exit(EXIT_FAILURE);
+		}
 	}
 
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
@@ -1135,6 +1219,10 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 				zbx_thread_start(proxyconfig_thread, &thread_args, &threads[i]);
 				DCconfig_wait_sync();
 				break;
+			case ZBX_PROCESS_TYPE_TRAPPERMAN:
+				thread_args.args = &listen_sock;
+				zbx_thread_start(trapper_manager_thread, &thread_args, &threads[i]);
+				break;
 			case ZBX_PROCESS_TYPE_TRAPPER:
 				thread_args.args = &listen_sock;
 				zbx_thread_start(trapper_thread, &thread_args, &threads[i]);
@@ -1176,6 +1264,14 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 				thread_args.args = &poller_type;
 				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
 				break;
+			case ZBX_PROCESS_TYPE_HTTPAGENTPOLLER:
+				poller_type = ZBX_POLLER_TYPE_HTTPAGENT;
+				thread_args.args = &poller_type;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
+			case ZBX_PROCESS_TYPE_DNSRESOLVER:
+				zbx_thread_start(dnsresolver_thread, &thread_args, &threads[i]);
+				break;
 			case ZBX_PROCESS_TYPE_SNMPTRAPPER:
 				zbx_thread_start(snmptrapper_thread, &thread_args, &threads[i]);
 				break;
@@ -1232,6 +1328,9 @@ void	zbx_on_exit(int ret)
 		zbx_free(threads);
 		zbx_free(threads_flags);
 	}
+
+	zbx_forkserver_stop();
+
 #ifdef HAVE_PTHREAD_PROCESS_SHARED
 	zbx_locks_disable();
 #endif
@@ -1249,6 +1348,9 @@ void	zbx_on_exit(int ret)
 	if (0 != CONFIG_VMWARE_FORKS)
 		zbx_vmware_destroy();
 
+	if (0 != CONFIG_DNSCACHE_SIZE)
+		zbx_dns_cache_destroy();
+
 	free_selfmon_collector();
 	free_proxy_history_lock();
 
@@ -25,6 +25,7 @@
 #include "actions.h"
 #include "operations.h"
 #include "events.h"
+#include "escalations.h"
 #include "zbxregexp.h"
 
 /******************************************************************************
@@ -3297,11 +3298,14 @@ void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pai
 	zbx_vector_ptr_t		esc_events[EVENT_SOURCE_COUNT];
 	zbx_hashset_iter_t		iter;
 	zbx_condition_t			*condition;
+	zbx_vector_escalation_ref_t	escalation_refs;
+	zbx_escalation_ref_t		ref;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() events_num:" ZBX_FS_SIZE_T, __func__, (zbx_fs_size_t)events->values_num);
 
 	zbx_vector_ptr_create(&new_escalations);
 	zbx_vector_uint64_pair_create(&rec_escalations);
+	zbx_vector_escalation_ref_create(&escalation_refs);
 
 	for (i = 0; i < EVENT_SOURCE_COUNT; i++)
 	{
@@ -3394,7 +3398,7 @@ void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pai
 		/* 3.2. Select escalations that must be recovered. */
 		zbx_vector_uint64_sort(&eventids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
-				"select eventid,escalationid"
+				"select eventid,escalationid,triggerid,itemid"
 				" from escalations"
 				" where");
 
@@ -3420,6 +3424,13 @@ void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pai
 			pair.second = closed_events->values[index].second;
 			ZBX_DBROW2UINT64(pair.first, row[1]);
 			zbx_vector_uint64_pair_append(&rec_escalations, pair);
+
+			ref.escalationid = pair.first;
+			ZBX_DBROW2UINT64(ref.triggerid, row[2]);
+			ZBX_DBROW2UINT64(ref.itemid, row[3]);
+			ref.nextcheck = 0;
+			ref.state = ZBX_ESCALATION_REF_SCHEDULED;
+			zbx_vector_escalation_ref_append(&escalation_refs, ref);
 		}
 
 		DBfree_result(result);
@@ -3432,6 +3443,9 @@ void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pai
 	{
 		zbx_db_insert_t	db_insert;
 		int		j;
+		zbx_uint64_t	escalationid;
+
+		escalationid = DBget_maxid_num("escalations", new_escalations.values_num);
 
 		zbx_db_insert_prepare(&db_insert, "escalations", "escalationid", "actionid", "status", "triggerid",
 					"itemid", "eventid", "r_eventid", "acknowledgeid", NULL);
@@ -3454,14 +3468,20 @@ void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pai
 					break;
 			}
 
-			zbx_db_insert_add_values(&db_insert, __UINT64_C(0), new_escalation->actionid,
+			zbx_db_insert_add_values(&db_insert, escalationid, new_escalation->actionid,
 					(int)ESCALATION_STATUS_ACTIVE, triggerid, itemid,
 					new_escalation->event->eventid, __UINT64_C(0), __UINT64_C(0));
 
+			ref.escalationid = escalationid++;
+			ref.triggerid = triggerid;
+			ref.itemid = itemid;
+			ref.nextcheck = 0;
+			ref.state = ZBX_ESCALATION_REF_SCHEDULED;
+			zbx_vector_escalation_ref_append(&escalation_refs, ref);
+
 			zbx_free(new_escalation);
 		}
 
-		zbx_db_insert_autoincrement(&db_insert, "escalationid");
 		zbx_db_insert_execute(&db_insert);
 		zbx_db_insert_clean(&db_insert);
 	}
@@ -3495,6 +3515,9 @@ void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pai
 		zbx_free(sql);
 	}
 
+	zbx_escalations_notify(&escalation_refs);
+	zbx_vector_escalation_ref_destroy(&escalation_refs);
+
 	zbx_vector_uint64_pair_destroy(&rec_escalations);
 	zbx_vector_ptr_destroy(&new_escalations);
 
@@ -3616,7 +3639,13 @@ int	process_actions_by_acknowledgements(const zbx_vector_ptr_t *ack_tasks)
 
 	if (0 != ack_escalations.values_num)
 	{
-		zbx_db_insert_t	db_insert;
+		zbx_db_insert_t			db_insert;
+		zbx_uint64_t			escalationid;
+		zbx_vector_escalation_ref_t	escalation_refs;
+		zbx_escalation_ref_t		ref;
+
+		zbx_vector_escalation_ref_create(&escalation_refs);
+		escalationid = DBget_maxid_num("escalations", ack_escalations.values_num);
 
 		zbx_db_insert_prepare(&db_insert, "escalations", "escalationid", "actionid", "status", "triggerid",
 						"itemid", "eventid", "r_eventid", "acknowledgeid", NULL);
@@ -3627,15 +3656,24 @@ int	process_actions_by_acknowledgements(const zbx_vector_ptr_t *ack_tasks)
 		{
 			ack_escalation = (zbx_ack_escalation_t *)ack_escalations.values[i];
 
-			zbx_db_insert_add_values(&db_insert, __UINT64_C(0), ack_escalation->actionid,
+			zbx_db_insert_add_values(&db_insert, escalationid, ack_escalation->actionid,
 				(int)ESCALATION_STATUS_ACTIVE, ack_escalation->triggerid, __UINT64_C(0),
 				ack_escalation->eventid, __UINT64_C(0), ack_escalation->acknowledgeid);
+
+			ref.escalationid = escalationid++;
+			ref.triggerid = ack_escalation->triggerid;
+			ref.itemid = 0;
+			ref.nextcheck = 0;
+			ref.state = ZBX_ESCALATION_REF_SCHEDULED;
+			zbx_vector_escalation_ref_append(&escalation_refs, ref);
 		}
 
-		zbx_db_insert_autoincrement(&db_insert, "escalationid");
 		zbx_db_insert_execute(&db_insert);
 		zbx_db_insert_clean(&db_insert);
 
+		zbx_escalations_notify(&escalation_refs);
+		zbx_vector_escalation_ref_destroy(&escalation_refs);
+
 		processed_num = ack_escalations.values_num;
 	}
 
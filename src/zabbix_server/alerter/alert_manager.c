@@ -111,6 +111,9 @@ typedef struct
 	char		*params;
 	int		status;
 	int		retries;
+
+	/* the time alert was queued or became due for resending, used for queue latency statistics */
+	double		queued;
 }
 zbx_am_alert_t;
 
@@ -174,6 +177,9 @@ typedef struct
 	int			script_bin_sz;
 	unsigned char		content_type;
 	unsigned char		flags;
+
+	/* non-cumulative histogram of time alerts spent in queue before being sent to alerters */
+	zbx_uint64_t		latency[ZBX_ALERTER_LATENCY_BUCKETS];
 }
 zbx_am_mediatype_t;
 
@@ -719,6 +725,7 @@ static zbx_am_alert_t	*am_create_alert(zbx_uint64_t alertid, zbx_uint64_t mediat
 	alert->status = status;
 	alert->retries = retries;
 	alert->nextsend = nextsend;
+	alert->queued = 0;
 
 	return alert;
 }
@@ -754,6 +761,7 @@ static zbx_am_alert_t	*am_copy_db_alert(zbx_am_db_alert_t *db_alert)
 	alert->status = db_alert->status;
 	alert->retries = db_alert->retries;
 	alert->nextsend = 0;
+	alert->queued = 0;
 
 	zbx_free(db_alert);
 
@@ -884,6 +892,7 @@ static int	am_retry_alert(zbx_am_t *manager, zbx_am_alert_t *alert)
 		goto out;
 
 	alert->nextsend = time(NULL) + mediatype->attempt_interval;
+	alert->queued = alert->nextsend;
 
 	alertpool = am_get_alertpool(manager, alert->mediatypeid, alert->alertpoolid);
 
@@ -1481,6 +1490,9 @@ static int	am_process_alert(zbx_am_t *manager, zbx_am_alerter_t *alerter, zbx_am
 	zbx_ipc_client_send(alerter->client, command, data, data_len);
 	zbx_free(data);
 
+	if (0 != alert->queued)
+		zbx_histogram_add(&zbx_latency_buckets, mediatype->latency, zbx_time() - alert->queued);
+
 	ret = SUCCEED;
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -1649,6 +1661,7 @@ static int	am_queue_alert(zbx_am_t *manager, zbx_am_alert_t *alert, int now)
 	zbx_am_alertpool_t	*alertpool;
 
 	alert->nextsend = now;
+	alert->queued = zbx_time();
 
 	if (NULL == (mediatype = am_get_mediatype(manager, alert->mediatypeid)))
 		return FAIL;
@@ -1788,6 +1801,30 @@ out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns alert queue latency histogram of the requested media type *
+ *                                                                            *
+ * Comments: Empty histogram is returned for media types not cached by alert  *
+ *           manager.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	am_send_latency(zbx_am_t *manager, zbx_ipc_client_t *client, zbx_ipc_message_t *message)
+{
+	zbx_uint64_t		mediatypeid, latency[ZBX_ALERTER_LATENCY_BUCKETS] = {0};
+	zbx_am_mediatype_t	*mediatype;
+
+	if (sizeof(mediatypeid) == message->size)
+	{
+		memcpy(&mediatypeid, message->data, sizeof(mediatypeid));
+
+		if (NULL != (mediatype = am_get_mediatype(manager, mediatypeid)))
+			memcpy(latency, mediatype->latency, sizeof(latency));
+	}
+
+	zbx_ipc_client_send(client, ZBX_IPC_ALERTER_LATENCY, (unsigned char *)latency, sizeof(latency));
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: process external alert request                                    *
@@ -1879,7 +1916,7 @@ ZBX_THREAD_ENTRY(alert_manager_thread, args)
 	zbx_ipc_message_t	*message;
 	zbx_am_alerter_t	*alerter;
 	int			ret, sent_num = 0, failed_num = 0, now, time_watchdog = 0, time_ping = 0,
-				time_mediatype = 0;
+				time_mediatype = 0, smtp_stats[2], smtp_connected_num = 0, smtp_reused_num = 0;
 	double			time_stat, time_idle = 0, time_now, sec;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
@@ -1937,14 +1974,17 @@ ZBX_THREAD_ENTRY(alert_manager_thread, args)
 
 		if (STAT_INTERVAL < time_now - time_stat)
 		{
-			zbx_setproctitle("%s #%d [sent %d, failed %d alerts, idle " ZBX_FS_DBL " sec during "
-					ZBX_FS_DBL " sec]", get_process_type_string(process_type), process_num,
-					sent_num, failed_num, time_idle, time_now - time_stat);
+			zbx_setproctitle("%s #%d [sent %d, failed %d alerts, SMTP connections %d new, %d reused, idle "
+					ZBX_FS_DBL " sec during " ZBX_FS_DBL " sec]", get_process_type_string(process_type),
+					process_num, sent_num, failed_num, smtp_connected_num, smtp_reused_num, time_idle,
+					time_now - time_stat);
 
 			time_stat = time_now;
 			time_idle = 0;
 			sent_num = 0;
 			failed_num = 0;
+			smtp_connected_num = 0;
+			smtp_reused_num = 0;
 		}
 
 		now = time(NULL);
@@ -2006,6 +2046,17 @@ ZBX_THREAD_ENTRY(alert_manager_thread, args)
 				case ZBX_IPC_ALERTER_DROP_MEDIATYPES:
 					am_drop_mediatypes(&manager, message);
 					break;
+				case ZBX_IPC_ALERTER_SMTP_STATS:
+					if (sizeof(smtp_stats) == message->size)
+					{
+						memcpy(smtp_stats, message->data, sizeof(smtp_stats));
+						smtp_connected_num += smtp_stats[0];
+						smtp_reused_num += smtp_stats[1];
+					}
+					break;
+				case ZBX_IPC_ALERTER_LATENCY:
+					am_send_latency(&manager, client, message);
+					break;
 			}
 
 			zbx_ipc_message_free(message);
@@ -649,6 +649,25 @@ static void	am_db_validate_tags_for_update(zbx_vector_events_tags_t *update_even
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compares alert results by the updated alert fields                *
+ *                                                                            *
+ * Comments: Results with equal status, retries and error are written to      *
+ *           database with a single update statement.                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	am_db_result_update_compare(const void *d1, const void *d2)
+{
+	const zbx_am_result_t	*r1 = *(const zbx_am_result_t * const *)d1;
+	const zbx_am_result_t	*r2 = *(const zbx_am_result_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(r1->status, r2->status);
+	ZBX_RETURN_IF_NOT_EQUAL(r1->retries, r2->retries);
+
+	return strcmp(ZBX_NULL2EMPTY_STR(r1->error), ZBX_NULL2EMPTY_STR(r2->error));
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieves alert updates from alert manager and flushes them into  *
@@ -656,10 +675,14 @@ static void	am_db_validate_tags_for_update(zbx_vector_events_tags_t *update_even
  *                                                                            *
  * Parameters: amdb            - [IN] the alert manager cache                 *
  *                                                                            *
+ * Comments: Alert updates are coalesced into multi-row update statements by  *
+ *           status, retries and error, so a mass notification with the same  *
+ *           outcome is flushed with few statements instead of one per alert. *
+ *                                                                            *
  ******************************************************************************/
 static int	am_db_flush_results(zbx_am_db_t *amdb)
 {
-	int				results_num;
+	int				results_num, updates_num = 0;
 	zbx_vector_events_tags_t	update_events_tags;
 	zbx_ipc_message_t		message;
 	zbx_am_result_t			**results;
@@ -677,15 +700,20 @@ static int	am_db_flush_results(zbx_am_db_t *amdb)
 
 	if (0 != results_num)
 	{
-		int 		i;
-		char		*sql;
-		size_t		sql_alloc = results_num * 128, sql_offset;
-		zbx_db_insert_t	db_event, db_problem;
+		int 			i, j;
+		char			*sql;
+		size_t			sql_alloc = results_num * 32 + ZBX_KIBIBYTE, sql_offset;
+		zbx_db_insert_t		db_event, db_problem;
+		zbx_vector_uint64_t	alertids;
 
 		sql = (char *)zbx_malloc(NULL, sql_alloc);
+		zbx_vector_uint64_create(&alertids);
+
+		qsort(results, results_num, sizeof(zbx_am_result_t *), am_db_result_update_compare);
 
 		do {
 			sql_offset = 0;
+			updates_num = 0;
 
 			DBbegin();
 			DBbegin_multiple_update(&sql, &sql_alloc, &sql_offset);
@@ -695,10 +723,29 @@ static int	am_db_flush_results(zbx_am_db_t *amdb)
 
 			zbx_vector_events_tags_create(&update_events_tags);
 
-			for (i = 0; i < results_num; i++)
+			for (i = 0; i < results_num; i = j)
 			{
-				zbx_am_db_mediatype_t	*mediatype;
-				zbx_am_result_t		*result = results[i];
+				zbx_am_result_t	*result = results[i];
+
+				zbx_vector_uint64_clear(&alertids);
+
+				for (j = i; j < results_num && 0 == am_db_result_update_compare(&result, &results[j]);
+						j++)
+				{
+					zbx_am_db_mediatype_t	*mediatype;
+
+					zbx_vector_uint64_append(&alertids, results[j]->alertid);
+
+					if (EVENT_SOURCE_TRIGGERS != results[j]->source || NULL == results[j]->value)
+						continue;
+
+					mediatype = zbx_hashset_search(&amdb->mediatypes, &results[j]->mediatypeid);
+					if (NULL != mediatype && 0 != mediatype->process_tags)
+					{
+						am_db_update_event_tags(results[j]->eventid, results[j]->value,
+								&update_events_tags);
+					}
+				}
 
 				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 						"update alerts set status=%d,retries=%d",
@@ -714,18 +761,15 @@ static int	am_db_flush_results(zbx_am_db_t *amdb)
 				else
 					zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ",error=''");
 
-				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " where alertid=" ZBX_FS_UI64 ";\n",
-						result->alertid);
+				zbx_vector_uint64_sort(&alertids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+				zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " where");
+				DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "alertid", alertids.values,
+						alertids.values_num);
+				zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ";\n");
+
+				updates_num++;
 
-				if (EVENT_SOURCE_TRIGGERS == result->source && NULL != result->value)
-				{
-					mediatype = zbx_hashset_search(&amdb->mediatypes, &result->mediatypeid);
-					if (NULL != mediatype && 0 != mediatype->process_tags)
-					{
-						am_db_update_event_tags(result->eventid, result->value,
-								&update_events_tags);
-					}
-				}
 				DBexecute_overflowed_sql(&sql, &sql_alloc, &sql_offset);
 			}
 
@@ -757,13 +801,14 @@ static int	am_db_flush_results(zbx_am_db_t *amdb)
 			zbx_free(result);
 		}
 
+		zbx_vector_uint64_destroy(&alertids);
 		zbx_free(sql);
 	}
 
 	zbx_free(results);
 	zbx_ipc_message_clean(&message);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() flushed:%d", __func__, results_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() flushed:%d updates:%d", __func__, results_num, updates_num);
 
 	return results_num;
 }
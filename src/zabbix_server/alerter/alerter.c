@@ -32,14 +32,119 @@
 #include "alerter.h"
 #include "alerter_protocol.h"
 #include "alert_manager.h"
+#include "../forkserver/forkserver.h"
 #include "zbxembed.h"
+#include "md5.h"
 
 #define	ALARM_ACTION_TIMEOUT	40
 
+/* idle SMTP sessions are closed after this period */
+#define ZBX_SMTP_IDLE_TIMEOUT	SEC_PER_MIN
+
+/* the maximum number of webhook scripting environments kept by alerter */
+#define ZBX_WEBHOOK_ES_MAX		16
+/* the number of executions after which webhook scripting environment is recreated */
+#define ZBX_WEBHOOK_ES_MAX_EXEC		1000
+/* webhook scripting environments not used for this period are destroyed */
+#define ZBX_WEBHOOK_ES_IDLE_PERIOD	SEC_PER_HOUR
+
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
-static zbx_es_t	es_engine;
+/* scripting environment kept for webhook script, identified by bytecode hash */
+typedef struct
+{
+	md5_byte_t	hash[MD5_DIGEST_SIZE];
+	zbx_es_t	es;
+	int		lastaccess;
+}
+zbx_webhook_es_t;
+
+static zbx_hashset_t	webhook_es;
+
+static zbx_hash_t	webhook_es_hash(const void *data)
+{
+	const zbx_webhook_es_t	*wes = (const zbx_webhook_es_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(wes->hash, sizeof(wes->hash), ZBX_DEFAULT_HASH_SEED);
+}
+
+static int	webhook_es_compare(const void *d1, const void *d2)
+{
+	return memcmp(((const zbx_webhook_es_t *)d1)->hash, ((const zbx_webhook_es_t *)d2)->hash, MD5_DIGEST_SIZE);
+}
+
+static void	webhook_es_destroy(zbx_webhook_es_t *wes)
+{
+	char	*error = NULL;
+
+	if (SUCCEED != zbx_es_is_env_initialized(&wes->es))
+		return;
+
+	if (SUCCEED != zbx_es_destroy_env(&wes->es, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "Cannot destroy embedded scripting engine environment: %s", error);
+		zbx_free(error);
+	}
+}
+
+static void	webhook_es_clean(void *data)
+{
+	webhook_es_destroy((zbx_webhook_es_t *)data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets scripting environment for webhook script                     *
+ *                                                                            *
+ * Parameters: script_bin    - [IN] the webhook script bytecode               *
+ *             script_bin_sz - [IN] the bytecode size                         *
+ *             now           - [IN] the current time                          *
+ *                                                                            *
+ * Return value: the webhook scripting environment                            *
+ *                                                                            *
+ * Comments: Each webhook script gets own scripting environment, so scripts   *
+ *           do not share global state and stay loaded between executions.    *
+ *           The least recently used environment is destroyed when too many   *
+ *           different scripts are being executed.                            *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_webhook_es_t	*webhook_es_get(const char *script_bin, int script_bin_sz, int now)
+{
+	zbx_webhook_es_t	wes_local, *wes, *wes_lru = NULL;
+	md5_state_t		state;
+	zbx_hashset_iter_t	iter;
+
+	zbx_md5_init(&state);
+	zbx_md5_append(&state, (const md5_byte_t *)script_bin, script_bin_sz);
+	zbx_md5_finish(&state, wes_local.hash);
+
+	if (NULL == (wes = (zbx_webhook_es_t *)zbx_hashset_search(&webhook_es, &wes_local)))
+	{
+		zbx_hashset_iter_reset(&webhook_es, &iter);
+		while (NULL != (wes = (zbx_webhook_es_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (now - wes->lastaccess >= ZBX_WEBHOOK_ES_IDLE_PERIOD)
+			{
+				zbx_hashset_iter_remove(&iter);
+				continue;
+			}
+
+			if (NULL == wes_lru || wes->lastaccess < wes_lru->lastaccess)
+				wes_lru = wes;
+		}
+
+		if (ZBX_WEBHOOK_ES_MAX <= webhook_es.num_data && NULL != wes_lru)
+			zbx_hashset_remove_direct(&webhook_es, wes_lru);
+
+		zbx_es_init(&wes_local.es);
+		wes = (zbx_webhook_es_t *)zbx_hashset_insert(&webhook_es, &wes_local, sizeof(wes_local));
+	}
+
+	wes->lastaccess = now;
+
+	return wes;
+}
 
 /******************************************************************************
  *                                                                            *
@@ -51,8 +156,8 @@ static int	execute_script_alert(const char *command, char *error, size_t max_err
 	char	*output = NULL;
 	int	ret = FAIL;
 
-	if (SUCCEED == (ret = zbx_execute(command, &output, error, max_error_len, ALARM_ACTION_TIMEOUT,
-			ZBX_EXIT_CODE_CHECKS_ENABLED, NULL)))
+	if (SUCCEED == (ret = zbx_forkserver_execute(command, &output, error, max_error_len, ALARM_ACTION_TIMEOUT,
+			ZBX_EXIT_CODE_CHECKS_ENABLED)))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "%s output:\n%s", command, output);
 		zbx_free(output);
@@ -97,6 +202,23 @@ static void	alerter_send_result(zbx_ipc_socket_t *socket, const char *value, int
 	zbx_free(data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends SMTP session statistics to alert manager                    *
+ *                                                                            *
+ * Parameters: socket - [IN] the connections socket                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	alerter_send_smtp_stats(zbx_ipc_socket_t *socket)
+{
+	int	stats[2];
+
+	zbx_smtp_pool_get_stats(&stats[0], &stats[1]);
+
+	if (0 != stats[0] || 0 != stats[1])
+		zbx_ipc_socket_write(socket, ZBX_IPC_ALERTER_SMTP_STATS, (unsigned char *)stats, sizeof(stats));
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes email alert                                             *
@@ -123,6 +245,8 @@ static void	alerter_process_email(zbx_ipc_socket_t *socket, zbx_ipc_message_t *i
 			smtp_verify_peer, smtp_verify_host, smtp_authentication, username, password, content_type,
 			ALARM_ACTION_TIMEOUT, error, sizeof(error));
 
+	/* statistics must reach manager before the result frees the alerter */
+	alerter_send_smtp_stats(socket);
 	alerter_send_result(socket, NULL, ret, (SUCCEED == ret ? NULL : error));
 
 	zbx_free(sendto);
@@ -197,29 +321,24 @@ static void	alerter_process_exec(zbx_ipc_socket_t *socket, zbx_ipc_message_t *ip
  ******************************************************************************/
 static void	alerter_process_webhook(zbx_ipc_socket_t *socket, zbx_ipc_message_t *ipc_message)
 {
-	char	*script_bin = NULL, *params = NULL, *error = NULL, *output = NULL;
-	int	script_bin_sz, ret, timeout;
+	char			*script_bin = NULL, *params = NULL, *error = NULL, *output = NULL;
+	int			script_bin_sz, ret, timeout;
+	zbx_webhook_es_t	*wes;
 
 	zbx_alerter_deserialize_webhook(ipc_message->data, &script_bin, &script_bin_sz, &timeout, &params);
 
-		if (SUCCEED != (ret = zbx_es_is_env_initialized(&es_engine)))
-		ret = zbx_es_init_env(&es_engine, &error);
+	wes = webhook_es_get(script_bin, script_bin_sz, (int)time(NULL));
+
+	if (SUCCEED != (ret = zbx_es_is_env_initialized(&wes->es)))
+		ret = zbx_es_init_env(&wes->es, &error);
 
 	if (SUCCEED == ret)
 	{
-		zbx_es_set_timeout(&es_engine, timeout);
-		ret = zbx_es_execute(&es_engine, NULL, script_bin, script_bin_sz, params, &output, &error);
-	}
+		zbx_es_set_timeout(&wes->es, timeout);
+		ret = zbx_es_execute(&wes->es, NULL, script_bin, script_bin_sz, params, &output, &error);
 
-	if (SUCCEED == zbx_es_fatal_error(&es_engine))
-	{
-		char	*errmsg = NULL;
-		if (SUCCEED != zbx_es_destroy_env(&es_engine, &errmsg))
-		{
-			zabbix_log(LOG_LEVEL_WARNING,
-					"Cannot destroy embedded scripting engine environment: %s", errmsg);
-			zbx_free(errmsg);
-		}
+		if (SUCCEED == zbx_es_recycle_required(&wes->es, ZBX_WEBHOOK_ES_MAX_EXEC))
+			webhook_es_destroy(wes);
 	}
 
 	alerter_send_result(socket, output, ret, error);
@@ -259,7 +378,10 @@ ZBX_THREAD_ENTRY(alerter_thread, args)
 
 	zbx_setproctitle("%s [connecting to the database]", get_process_type_string(process_type));
 
-	zbx_es_init(&es_engine);
+	zbx_hashset_create_ext(&webhook_es, 0, webhook_es_hash, webhook_es_compare, webhook_es_clean,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	zbx_smtp_pool_init(ZBX_SMTP_IDLE_TIMEOUT);
 
 	zbx_ipc_message_init(&message);
 
@@ -332,5 +454,7 @@ ZBX_THREAD_ENTRY(alerter_thread, args)
 	while (1)
 		zbx_sleep(SEC_PER_MIN);
 
+	zbx_hashset_destroy(&webhook_es);
+	zbx_smtp_pool_destroy();
 	zbx_ipc_socket_close(&alerter_socket);
 }
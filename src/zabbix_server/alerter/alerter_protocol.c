@@ -21,6 +21,7 @@
 
 #include "log.h"
 #include "zbxserialize.h"
+#include "zbxipcservice.h"
 
 #include "alerter_protocol.h"
 
@@ -709,3 +710,51 @@ void	zbx_alerter_deserialize_ids(const unsigned char *data, zbx_uint64_t **ids,
 	for (i = 0; i < *ids_num; i++)
 		data += zbx_deserialize_value(data, &(*ids)[i]);
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets alert queue latency histogram of the specified media type    *
+ *          from alert manager                                                *
+ *                                                                            *
+ * Parameters: mediatypeid - [IN] the media type identifier                   *
+ *             latency     - [OUT] the non-cumulative latency histogram with  *
+ *                                 ZBX_ALERTER_LATENCY_BUCKETS buckets        *
+ *             error       - [OUT] the error message                          *
+ *                                                                            *
+ * Return value: SUCCEED - the histogram was returned successfully            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_alerter_get_latency(zbx_uint64_t mediatypeid, zbx_uint64_t *latency, char **error)
+{
+	zbx_ipc_message_t	message;
+	zbx_ipc_socket_t	alerter_socket;
+	int			ret = FAIL;
+
+	if (FAIL == zbx_ipc_socket_open(&alerter_socket, ZBX_IPC_SERVICE_ALERTER, SEC_PER_MIN, error))
+		return FAIL;
+
+	zbx_ipc_message_init(&message);
+
+	if (FAIL == zbx_ipc_socket_write(&alerter_socket, ZBX_IPC_ALERTER_LATENCY, (unsigned char *)&mediatypeid,
+			sizeof(mediatypeid)))
+	{
+		*error = zbx_strdup(NULL, "cannot send latency request to alert manager service");
+		goto out;
+	}
+
+	if (FAIL == zbx_ipc_socket_read(&alerter_socket, &message) ||
+			sizeof(zbx_uint64_t) * ZBX_ALERTER_LATENCY_BUCKETS != message.size)
+	{
+		*error = zbx_strdup(NULL, "cannot read latency response from alert manager service");
+		goto out;
+	}
+
+	memcpy(latency, message.data, sizeof(zbx_uint64_t) * ZBX_ALERTER_LATENCY_BUCKETS);
+	ret = SUCCEED;
+out:
+	zbx_ipc_socket_close(&alerter_socket);
+	zbx_ipc_message_clean(&message);
+
+	return ret;
+}
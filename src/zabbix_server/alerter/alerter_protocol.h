@@ -21,6 +21,7 @@
 #define ZABBIX_ALERTER_PROTOCOL_H
 
 #include "common.h"
+#include "zbxalgo.h"
 
 #define ZBX_IPC_SERVICE_ALERTER	"alerter"
 
@@ -33,6 +34,7 @@
 #define ZBX_IPC_ALERTER_WATCHDOG	1005
 #define ZBX_IPC_ALERTER_RESULTS		1006
 #define ZBX_IPC_ALERTER_DROP_MEDIATYPES	1007
+#define ZBX_IPC_ALERTER_SMTP_STATS	1008
 
 /* manager -> alerter */
 #define ZBX_IPC_ALERTER_EMAIL		1100
@@ -40,8 +42,13 @@
 #define ZBX_IPC_ALERTER_EXEC		1104
 #define ZBX_IPC_ALERTER_WEBHOOK		1105
 
+/* internal checks -> manager */
+#define ZBX_IPC_ALERTER_LATENCY		1200
+
 #define ZBX_WATCHDOG_ALERT_FREQUENCY	(15 * SEC_PER_MIN)
 
+#define ZBX_ALERTER_LATENCY_BUCKETS	ZBX_LATENCY_BUCKETS
+
 typedef struct
 {
 	zbx_uint64_t	mediaid;
@@ -188,4 +195,6 @@ zbx_uint32_t	zbx_alerter_serialize_ids(unsigned char **data, zbx_uint64_t *ids,
 
 void	zbx_alerter_deserialize_ids(const unsigned char *data, zbx_uint64_t **ids, int *ids_num);
 
+int	zbx_alerter_get_latency(zbx_uint64_t mediatypeid, zbx_uint64_t *latency, char **error);
+
 #endif
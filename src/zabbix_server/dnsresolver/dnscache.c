@@ -0,0 +1,624 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+
+#include "log.h"
+#include "memalloc.h"
+#include "mutexs.h"
+#include "zbxalgo.h"
+#include "comms.h"
+
+#include "dnsresolver.h"
+
+/* names that are not looked up for this long are removed from the cache */
+#define ZBX_DNS_CACHE_IDLE_TIMEOUT	SEC_PER_HOUR
+
+/* the maximum time a resolution failure is cached */
+#define ZBX_DNS_CACHE_NEGATIVE_TTL	10
+
+extern zbx_uint64_t	CONFIG_DNSCACHE_SIZE;
+extern int		CONFIG_DNSCACHE_TTL;
+
+typedef struct
+{
+	const char	*host;
+
+	/* the comma separated resolved addresses, empty if the name cannot be resolved */
+	char		addr[ZBX_RESOLVE_ADDRS_LEN];
+
+	/* the time when dns resolver must resolve the name again */
+	int		nextcheck;
+
+	/* the time after which the cached result is no longer used */
+	int		expires;
+
+	int		lastaccess;
+}
+zbx_dns_entry_t;
+
+typedef struct
+{
+	zbx_hashset_t	entries;
+	zbx_uint64_t	hits;
+	zbx_uint64_t	misses;
+	zbx_uint64_t	negative;
+	zbx_uint64_t	refreshes;
+}
+zbx_dns_cache_t;
+
+static zbx_dns_cache_t	*dns_cache = NULL;
+
+static zbx_mutex_t	dns_cache_lock = ZBX_MUTEX_NULL;
+static zbx_mem_info_t	*dns_mem = NULL;
+
+ZBX_MEM_FUNC_IMPL(__dns, dns_mem)
+
+#define LOCK_CACHE	zbx_mutex_lock(dns_cache_lock)
+#define UNLOCK_CACHE	zbx_mutex_unlock(dns_cache_lock)
+
+static zbx_hash_t	dns_entry_hash_func(const void *data)
+{
+	const zbx_dns_entry_t	*entry = (const zbx_dns_entry_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(entry->host);
+}
+
+static int	dns_entry_compare_func(const void *d1, const void *d2)
+{
+	const zbx_dns_entry_t	*e1 = (const zbx_dns_entry_t *)d1;
+	const zbx_dns_entry_t	*e2 = (const zbx_dns_entry_t *)d2;
+
+	return strcmp(e1->host, e2->host);
+}
+
+static int	dns_negative_ttl(void)
+{
+	return MIN(CONFIG_DNSCACHE_TTL, ZBX_DNS_CACHE_NEGATIVE_TTL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates DNS cache in shared memory                                *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the cache was created                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dns_cache_init(char **error)
+{
+	int		ret = FAIL;
+	zbx_uint64_t	size_reserved;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (SUCCEED != zbx_mutex_create(&dns_cache_lock, ZBX_MUTEX_DNSCACHE, error))
+		goto out;
+
+	size_reserved = zbx_mem_required_size(1, "dns cache size", "DNSCacheSize");
+
+	if (CONFIG_DNSCACHE_SIZE <= size_reserved)
+	{
+		*error = zbx_dsprintf(*error, "DNS cache size must be greater than " ZBX_FS_UI64 " bytes",
+				size_reserved);
+		goto out;
+	}
+
+	CONFIG_DNSCACHE_SIZE -= size_reserved;
+
+	/* running out of memory only stops caching of new names */
+	if (SUCCEED != zbx_mem_create(&dns_mem, CONFIG_DNSCACHE_SIZE, "dns cache size", "DNSCacheSize", 1, error))
+		goto out;
+
+	if (NULL == (dns_cache = (zbx_dns_cache_t *)__dns_mem_malloc_func(NULL, sizeof(zbx_dns_cache_t))))
+	{
+		*error = zbx_strdup(*error, "cannot allocate DNS cache header");
+		goto out;
+	}
+
+	memset(dns_cache, 0, sizeof(zbx_dns_cache_t));
+
+	zbx_hashset_create_ext(&dns_cache->entries, 100, dns_entry_hash_func, dns_entry_compare_func, NULL,
+			__dns_mem_malloc_func, __dns_mem_realloc_func, __dns_mem_free_func);
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: destroys DNS cache                                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dns_cache_destroy(void)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != dns_cache)
+	{
+		zbx_hashset_destroy(&dns_cache->entries);
+		dns_cache = NULL;
+	}
+
+	zbx_mutex_destroy(&dns_cache_lock);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolves host name with the system resolver                       *
+ *                                                                            *
+ * Parameters: host     - [IN] the host name                                  *
+ *             addr     - [OUT] the comma separated list of numeric addresses *
+ *             addr_len - [IN] the size of address buffer                     *
+ *                                                                            *
+ * Return value: SUCCEED - the host name was resolved                         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Up to ZBX_RESOLVE_ADDR_MAX addresses are kept in the order       *
+ *           returned by the system resolver, so connections can fail over to *
+ *           the next address. Socket type is not specified because the same  *
+ *           address is used for TCP and UDP connections.                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	dns_resolve(const char *host, char *addr, size_t addr_len)
+{
+	struct addrinfo	hints, *ai = NULL, *ai_next;
+	const void	*src;
+	char		addrs[ZBX_RESOLVE_ADDR_MAX][ZBX_RESOLVE_ADDR_LEN];
+	size_t		offset = 0;
+	int		i, addrs_num = 0;
+
+	*addr = '\0';
+
+	memset(&hints, 0, sizeof(hints));
+#ifdef HAVE_IPV6
+	hints.ai_family = PF_UNSPEC;
+#else
+	hints.ai_family = AF_INET;
+#endif
+	if (0 != getaddrinfo(host, NULL, &hints, &ai))
+		goto out;
+
+	for (ai_next = ai; NULL != ai_next && ZBX_RESOLVE_ADDR_MAX > addrs_num; ai_next = ai_next->ai_next)
+	{
+		switch (ai_next->ai_family)
+		{
+			case AF_INET:
+				src = &((struct sockaddr_in *)ai_next->ai_addr)->sin_addr;
+				break;
+#ifdef HAVE_IPV6
+			case AF_INET6:
+				src = &((struct sockaddr_in6 *)ai_next->ai_addr)->sin6_addr;
+				break;
+#endif
+			default:
+				continue;
+		}
+
+		if (NULL == inet_ntop(ai_next->ai_family, src, addrs[addrs_num], ZBX_RESOLVE_ADDR_LEN))
+			continue;
+
+		/* the same address is returned for every socket type */
+		for (i = 0; i < addrs_num && 0 != strcmp(addrs[i], addrs[addrs_num]); i++)
+			;
+
+		if (i == addrs_num)
+			addrs_num++;
+	}
+
+	for (i = 0; i < addrs_num; i++)
+		offset += zbx_snprintf(addr + offset, addr_len - offset, 0 == i ? "%s" : ",%s", addrs[i]);
+out:
+	if (NULL != ai)
+		freeaddrinfo(ai);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() host:'%s' addr:'%s'", __func__, host, addr);
+
+	return 0 != addrs_num ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stores resolution result in the cache                             *
+ *                                                                            *
+ * Parameters: host   - [IN] the host name                                    *
+ *             addr   - [IN] the resolved addresses, NULL if the name cannot  *
+ *                           be resolved                                      *
+ *             now    - [IN] the current time                                 *
+ *             create - [IN] 1 - add the name if it is not cached             *
+ *                           0 - update only cached name                      *
+ *                                                                            *
+ * Comments: The cache must be locked. The name is not cached if the cache    *
+ *           is out of memory.                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	dns_cache_update(const char *host, const char *addr, int now, int create)
+{
+	zbx_dns_entry_t	*entry, entry_local;
+	size_t		len;
+
+	entry_local.host = host;
+
+	if (NULL == (entry = (zbx_dns_entry_t *)zbx_hashset_search(&dns_cache->entries, &entry_local)))
+	{
+		if (0 == create)
+			return;
+
+		len = strlen(host) + 1;
+
+		if (NULL == (entry_local.host = (char *)__dns_mem_malloc_func(NULL, len)))
+			return;
+
+		memcpy((char *)entry_local.host, host, len);
+		*entry_local.addr = '\0';
+		entry_local.nextcheck = 0;
+		entry_local.expires = 0;
+		entry_local.lastaccess = now;
+
+		if (NULL == (entry = (zbx_dns_entry_t *)zbx_hashset_insert(&dns_cache->entries, &entry_local,
+				sizeof(entry_local))))
+		{
+			__dns_mem_free_func((char *)entry_local.host);
+			return;
+		}
+	}
+
+	if (NULL != addr)
+	{
+		zbx_strlcpy(entry->addr, addr, sizeof(entry->addr));
+		entry->nextcheck = now + CONFIG_DNSCACHE_TTL;
+
+		/* the address is used while dns resolver is refreshing it */
+		entry->expires = entry->nextcheck + CONFIG_DNSCACHE_TTL;
+		return;
+	}
+
+	entry->nextcheck = now + dns_negative_ttl();
+
+	/* keep the last known address until it expires, the name server might be unavailable temporarily */
+	if ('\0' == *entry->addr || entry->expires <= now)
+	{
+		*entry->addr = '\0';
+		entry->expires = entry->nextcheck;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolves host name through the DNS cache                          *
+ *                                                                            *
+ * Parameters: host     - [IN] the host name                                  *
+ *             addr     - [OUT] the comma separated list of numeric addresses *
+ *             addr_len - [IN] the size of address buffer                     *
+ *                                                                            *
+ * Return value: SUCCEED      - the host name was resolved                    *
+ *               FAIL         - the host name cannot be resolved              *
+ *               NOTSUPPORTED - the cache is disabled or the host is already  *
+ *                              an IP address                                 *
+ *                                                                            *
+ * Comments: Names missing in the cache are resolved by the calling process   *
+ *           and cached for other processes. Cached names are kept up to date *
+ *           by dns resolver process.                                         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dns_cache_resolve(const char *host, char *addr, size_t addr_len)
+{
+	zbx_dns_entry_t	*entry, entry_local;
+	int		ret = NOTSUPPORTED, now;
+
+	if (NULL == dns_cache || NULL == host || '\0' == *host || SUCCEED == is_ip(host))
+		return NOTSUPPORTED;
+
+	now = (int)time(NULL);
+	entry_local.host = host;
+
+	LOCK_CACHE;
+
+	if (NULL != (entry = (zbx_dns_entry_t *)zbx_hashset_search(&dns_cache->entries, &entry_local)))
+	{
+		entry->lastaccess = now;
+
+		if (entry->expires > now)
+		{
+			if ('\0' != *entry->addr)
+			{
+				zbx_strlcpy(addr, entry->addr, addr_len);
+				dns_cache->hits++;
+				ret = SUCCEED;
+			}
+			else
+			{
+				dns_cache->negative++;
+				ret = FAIL;
+			}
+		}
+	}
+
+	if (NOTSUPPORTED == ret)
+		dns_cache->misses++;
+
+	UNLOCK_CACHE;
+
+	if (NOTSUPPORTED != ret)
+		return ret;
+
+	ret = dns_resolve(host, addr, addr_len);
+
+	LOCK_CACHE;
+	dns_cache_update(host, SUCCEED == ret ? addr : NULL, now, 1);
+	UNLOCK_CACHE;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolves again cached names that are about to expire and removes  *
+ *          names that are not used anymore                                   *
+ *                                                                            *
+ * Parameters: now - [IN] the current time                                    *
+ *                                                                            *
+ * Return value: the number of resolved names                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dns_cache_refresh(int now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_dns_entry_t		*entry;
+	zbx_vector_str_t	hosts;
+	char			addr[ZBX_RESOLVE_ADDRS_LEN];
+	int			i, ret, removed = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_vector_str_create(&hosts);
+
+	LOCK_CACHE;
+
+	zbx_hashset_iter_reset(&dns_cache->entries, &iter);
+	while (NULL != (entry = (zbx_dns_entry_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (entry->lastaccess + ZBX_DNS_CACHE_IDLE_TIMEOUT <= now)
+		{
+			__dns_mem_free_func((char *)entry->host);
+			zbx_hashset_iter_remove(&iter);
+			removed++;
+			continue;
+		}
+
+		/* resolve names one second ahead so they do not expire before the next refresh */
+		if (entry->nextcheck <= now + 1)
+			zbx_vector_str_append(&hosts, zbx_strdup(NULL, entry->host));
+	}
+
+	UNLOCK_CACHE;
+
+	for (i = 0; i < hosts.values_num; i++)
+	{
+		ret = dns_resolve(hosts.values[i], addr, sizeof(addr));
+		now = (int)time(NULL);
+
+		LOCK_CACHE;
+		dns_cache_update(hosts.values[i], SUCCEED == ret ? addr : NULL, now, 0);
+		dns_cache->refreshes++;
+		UNLOCK_CACHE;
+	}
+
+	ret = hosts.values_num;
+
+	zbx_vector_str_clear_ext(&hosts, zbx_str_free);
+	zbx_vector_str_destroy(&hosts);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() resolved:%d removed:%d", __func__, ret, removed);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets DNS cache statistics                                         *
+ *                                                                            *
+ * Parameters: stats - [OUT] the cache statistics                             *
+ *                                                                            *
+ * Return value: SUCCEED - the statistics were retrieved                      *
+ *               FAIL    - the cache is disabled                              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dns_cache_get_stats(zbx_dns_cache_stats_t *stats)
+{
+	if (NULL == dns_cache)
+		return FAIL;
+
+	LOCK_CACHE;
+
+	stats->hits = dns_cache->hits;
+	stats->misses = dns_cache->misses;
+	stats->negative = dns_cache->negative;
+	stats->refreshes = dns_cache->refreshes;
+	stats->entries = (zbx_uint64_t)dns_cache->entries.num_data;
+	stats->memory_total = dns_mem->total_size;
+	stats->memory_used = dns_mem->total_size - dns_mem->free_size;
+
+	UNLOCK_CACHE;
+
+	return SUCCEED;
+}
+
+#ifdef HAVE_LIBCURL
+#if LIBCURL_VERSION_NUM >= 0x071503
+/******************************************************************************
+ *                                                                            *
+ * Purpose: extracts host name and port from HTTP or HTTPS URL                *
+ *                                                                            *
+ * Parameters: url      - [IN] the URL                                        *
+ *             host     - [OUT] the host name                                 *
+ *             host_len - [IN] the size of host name buffer                   *
+ *             port     - [OUT] the port, default port of the scheme if the   *
+ *                              URL does not specify it                       *
+ *                                                                            *
+ * Return value: SUCCEED - the host name was extracted                        *
+ *               FAIL    - the URL has other scheme, IP literal or invalid    *
+ *                         authority, cURL must resolve it by itself          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dns_parse_url(const char *url, char *host, size_t host_len, unsigned short *port)
+{
+	const char	*ptr, *end, *at, *colon;
+	char		buf[8];
+
+	if (NULL != (ptr = strstr(url, "://")))
+	{
+		if (ZBX_CONST_STRLEN("https") == ptr - url && 0 == zbx_strncasecmp(url, "https", ptr - url))
+			*port = 443;
+		else if (ZBX_CONST_STRLEN("http") == ptr - url && 0 == zbx_strncasecmp(url, "http", ptr - url))
+			*port = 80;
+		else
+			return FAIL;
+
+		ptr += ZBX_CONST_STRLEN("://");
+	}
+	else
+	{
+		/* cURL assumes HTTP if the scheme is not specified */
+		ptr = url;
+		*port = 80;
+	}
+
+	end = ptr + strcspn(ptr, "/?#");
+
+	for (at = end; at > ptr && '@' != *(at - 1); at--)
+		;
+
+	if (at > ptr)
+		ptr = at;
+
+	if ('[' == *ptr)
+		return FAIL;
+
+	for (colon = ptr; colon < end && ':' != *colon; colon++)
+		;
+
+	if (colon == ptr || (size_t)(colon - ptr) >= host_len)
+		return FAIL;
+
+	memcpy(host, ptr, colon - ptr);
+	host[colon - ptr] = '\0';
+
+	if (colon < end - 1)
+	{
+		if ((size_t)(end - colon - 1) >= sizeof(buf))
+			return FAIL;
+
+		memcpy(buf, colon + 1, end - colon - 1);
+		buf[end - colon - 1] = '\0';
+
+		if (FAIL == is_ushort(buf, port))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes cURL connect to the address of URL host name from DNS cache *
+ *                                                                            *
+ * Parameters: easyhandle    - [IN] the cURL handle                           *
+ *             url           - [IN] the request URL                           *
+ *             proxy         - [IN] the HTTP proxy, can be NULL               *
+ *             resolve_slist - [IN/OUT] the cURL resolve list, must be freed  *
+ *                                      after the transfer                    *
+ *             error         - [OUT] the error message                        *
+ *                                                                            *
+ * Return value: SUCCEED - the address was set or cURL will resolve the host  *
+ *                         name by itself                                     *
+ *               FAIL    - the host name cannot be resolved                   *
+ *                                                                            *
+ * Comments: Host names are not resolved when the request goes through proxy, *
+ *           the proxy resolves them. Redirect targets are resolved by cURL.  *
+ *           All cached addresses are passed, so cURL can fail over to the    *
+ *           next address if connection fails.                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dns_cache_set_curl_resolve(CURL *easyhandle, const char *url, const char *proxy,
+		struct curl_slist **resolve_slist, char **error)
+{
+#if LIBCURL_VERSION_NUM >= 0x071503
+	/* CURLOPT_RESOLVE is supported starting with version 7.21.3 (0x071503) */
+	char		host[MAX_ZBX_DNSNAME_LEN + 1], addr[ZBX_RESOLVE_ADDRS_LEN], *entry;
+	unsigned short	port;
+	CURLcode	err;
+
+	if (NULL == dns_cache)
+		return SUCCEED;
+
+	if ((NULL == proxy || '\0' == *proxy) && SUCCEED == dns_parse_url(url, host, sizeof(host), &port))
+	{
+		switch (zbx_dns_cache_resolve(host, addr, sizeof(addr)))
+		{
+			case SUCCEED:
+#if LIBCURL_VERSION_NUM < 0x073b00
+				/* multiple addresses are supported starting with version 7.59.0 (0x073b00) */
+				if (NULL != (entry = strchr(addr, ',')))
+					*entry = '\0';
+#endif
+				/* drop the address cached by previous request, the name might be resolved to */
+				/* other address now */
+				entry = zbx_dsprintf(NULL, "-%s:%hu", host, port);
+				*resolve_slist = curl_slist_append(*resolve_slist, entry);
+				zbx_free(entry);
+
+				entry = zbx_dsprintf(NULL, "%s:%hu:%s", host, port, addr);
+				*resolve_slist = curl_slist_append(*resolve_slist, entry);
+				zbx_free(entry);
+				break;
+			case FAIL:
+				*error = zbx_dsprintf(*error, "Cannot resolve host name \"%s\"", host);
+				return FAIL;
+		}
+	}
+
+	/* the list of previous request might be already freed, so it must be always replaced */
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_RESOLVE, *resolve_slist)))
+	{
+		*error = zbx_dsprintf(*error, "Cannot set resolved address: %s", curl_easy_strerror(err));
+		return FAIL;
+	}
+#else
+	ZBX_UNUSED(easyhandle);
+	ZBX_UNUSED(url);
+	ZBX_UNUSED(proxy);
+	ZBX_UNUSED(resolve_slist);
+	ZBX_UNUSED(error);
+#endif
+	return SUCCEED;
+}
+#endif
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/zabbix_server/dnsresolver/dnscache_test.c"
+#endif
@@ -0,0 +1,73 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "daemon.h"
+#include "zbxself.h"
+#include "log.h"
+
+#include "dnsresolver.h"
+
+extern unsigned char	process_type, program_type;
+extern int		server_num, process_num;
+
+/* how often the cache is checked for names to resolve again */
+#define ZBX_DNSRESOLVER_DELAY	1
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: keeps DNS cache up to date by resolving cached names again before *
+ *          they expire                                                       *
+ *                                                                            *
+ ******************************************************************************/
+ZBX_THREAD_ENTRY(dnsresolver_thread, args)
+{
+	double	sec;
+	int	resolved;
+
+	process_type = ((zbx_thread_args_t *)args)->process_type;
+	server_num = ((zbx_thread_args_t *)args)->server_num;
+	process_num = ((zbx_thread_args_t *)args)->process_num;
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(program_type),
+			server_num, get_process_type_string(process_type), process_num);
+
+	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+	while (ZBX_IS_RUNNING())
+	{
+		sec = zbx_time();
+		zbx_update_env(sec);
+
+		zbx_setproctitle("%s [resolving host names]", get_process_type_string(process_type));
+
+		resolved = zbx_dns_cache_refresh((int)sec);
+		sec = zbx_time() - sec;
+
+		zbx_setproctitle("%s [resolved %d names in " ZBX_FS_DBL " sec, idle %d sec]",
+				get_process_type_string(process_type), resolved, sec, ZBX_DNSRESOLVER_DELAY);
+
+		zbx_sleep_loop(ZBX_DNSRESOLVER_DELAY);
+	}
+
+	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
+
+	while (1)
+		zbx_sleep(SEC_PER_MIN);
+}
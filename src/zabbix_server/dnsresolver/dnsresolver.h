@@ -0,0 +1,52 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_DNSRESOLVER_H
+#define ZABBIX_DNSRESOLVER_H
+
+#include "common.h"
+#include "threads.h"
+
+typedef struct
+{
+	zbx_uint64_t	hits;		/* lookups answered with cached address */
+	zbx_uint64_t	misses;		/* lookups resolved by the calling process */
+	zbx_uint64_t	negative;	/* lookups answered with cached resolution failure */
+	zbx_uint64_t	refreshes;	/* names resolved again by dns resolver */
+	zbx_uint64_t	entries;
+	zbx_uint64_t	memory_total;
+	zbx_uint64_t	memory_used;
+}
+zbx_dns_cache_stats_t;
+
+int	zbx_dns_cache_init(char **error);
+void	zbx_dns_cache_destroy(void);
+
+int	zbx_dns_cache_resolve(const char *host, char *addr, size_t addr_len);
+int	zbx_dns_cache_get_stats(zbx_dns_cache_stats_t *stats);
+int	zbx_dns_cache_refresh(int now);
+
+#ifdef HAVE_LIBCURL
+int	zbx_dns_cache_set_curl_resolve(CURL *easyhandle, const char *url, const char *proxy,
+		struct curl_slist **resolve_slist, char **error);
+#endif
+
+ZBX_THREAD_ENTRY(dnsresolver_thread, args);
+
+#endif
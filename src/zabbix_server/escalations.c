@@ -0,0 +1,135 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "log.h"
+#include "zbxipcservice.h"
+#include "zbxserialize.h"
+#include "../libs/zbxalgo/vectorimpl.h"
+
+#include "escalations.h"
+
+extern int	CONFIG_ESCALATIONMAN_FORKS;
+
+ZBX_VECTOR_IMPL(escalation_ref, zbx_escalation_ref_t)
+
+#define ZBX_ESCALATION_REF_SIZE	(sizeof(zbx_uint64_t) * 3 + sizeof(int) + sizeof(unsigned char))
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes escalation references for IPC                          *
+ *                                                                            *
+ * Parameters: data     - [OUT] the serialized data                           *
+ *             refs     - [IN] the escalation references                      *
+ *             refs_num - [IN] the number of references                       *
+ *                                                                            *
+ * Return value: the size of serialized data                                  *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_escalation_serialize_refs(unsigned char **data, const zbx_escalation_ref_t *refs, int refs_num)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len;
+	int		i;
+
+	data_len = sizeof(int) + (zbx_uint32_t)(ZBX_ESCALATION_REF_SIZE * (size_t)refs_num);
+	ptr = *data = (unsigned char *)zbx_malloc(NULL, data_len);
+
+	ptr += zbx_serialize_value(ptr, refs_num);
+
+	for (i = 0; i < refs_num; i++)
+	{
+		ptr += zbx_serialize_value(ptr, refs[i].escalationid);
+		ptr += zbx_serialize_value(ptr, refs[i].triggerid);
+		ptr += zbx_serialize_value(ptr, refs[i].itemid);
+		ptr += zbx_serialize_value(ptr, refs[i].nextcheck);
+		ptr += zbx_serialize_value(ptr, refs[i].state);
+	}
+
+	return data_len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: deserializes escalation references                                *
+ *                                                                            *
+ * Parameters: data - [IN] the serialized data                                *
+ *             refs - [OUT] the escalation references                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_escalation_deserialize_refs(const unsigned char *data, zbx_vector_escalation_ref_t *refs)
+{
+	int			i, refs_num;
+	zbx_escalation_ref_t	ref;
+
+	data += zbx_deserialize_value(data, &refs_num);
+	zbx_vector_escalation_ref_reserve(refs, (size_t)(refs->values_num + refs_num));
+
+	for (i = 0; i < refs_num; i++)
+	{
+		data += zbx_deserialize_value(data, &ref.escalationid);
+		data += zbx_deserialize_value(data, &ref.triggerid);
+		data += zbx_deserialize_value(data, &ref.itemid);
+		data += zbx_deserialize_value(data, &ref.nextcheck);
+		data += zbx_deserialize_value(data, &ref.state);
+
+		zbx_vector_escalation_ref_append(refs, ref);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: informs escalation manager about created or recovered escalations *
+ *                                                                            *
+ * Parameters: refs - [IN] the escalations to schedule                        *
+ *                                                                            *
+ * Comments: The escalations are stored in database, so failure to reach the  *
+ *           manager is not fatal - it will find them during the next         *
+ *           synchronization with the escalations table.                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_escalations_notify(const zbx_vector_escalation_ref_t *refs)
+{
+	static zbx_ipc_socket_t	esc_socket = {-1};
+	char			*error = NULL;
+	unsigned char		*data;
+	zbx_uint32_t		data_len;
+
+	if (0 == CONFIG_ESCALATIONMAN_FORKS || 0 == refs->values_num)
+		return;
+
+	/* each process keeps a permanent connection to manager */
+	if (-1 == esc_socket.fd && FAIL == zbx_ipc_socket_open(&esc_socket, ZBX_IPC_SERVICE_ESCALATOR, 0, &error))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot connect to escalation manager service: %s", error);
+		zbx_free(error);
+		esc_socket.fd = -1;
+		return;
+	}
+
+	data_len = zbx_escalation_serialize_refs(&data, refs->values, refs->values_num);
+
+	if (FAIL == zbx_ipc_socket_write(&esc_socket, ZBX_IPC_ESCALATOR_QUEUE, data, data_len))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send escalations to escalation manager service");
+		zbx_ipc_socket_close(&esc_socket);
+	}
+
+	zbx_free(data);
+}
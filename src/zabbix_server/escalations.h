@@ -0,0 +1,64 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_ESCALATIONS_H
+#define ZABBIX_ESCALATIONS_H
+
+#include "common.h"
+#include "zbxalgo.h"
+
+#define CONFIG_ESCALATOR_FREQUENCY	3
+
+#define ZBX_IPC_SERVICE_ESCALATOR	"escalator"
+
+/* escalator -> manager */
+#define ZBX_IPC_ESCALATOR_REGISTER	1000
+#define ZBX_IPC_ESCALATOR_DONE		1001
+
+/* manager -> escalator */
+#define ZBX_IPC_ESCALATOR_PROCESS	1100
+
+/* escalation sources (history syncers, task manager, ...) -> manager */
+#define ZBX_IPC_ESCALATOR_QUEUE		1200
+
+/* escalation state reported by escalators after processing */
+#define ZBX_ESCALATION_REF_SCHEDULED	0
+#define ZBX_ESCALATION_REF_DELETED	1
+#define ZBX_ESCALATION_REF_MISSING	2
+#define ZBX_ESCALATION_REF_NOT_DUE	3
+
+/* reference to escalation in escalations table used for scheduling */
+typedef struct
+{
+	zbx_uint64_t	escalationid;
+	zbx_uint64_t	triggerid;
+	zbx_uint64_t	itemid;
+	int		nextcheck;
+	unsigned char	state;
+}
+zbx_escalation_ref_t;
+
+ZBX_VECTOR_DECL(escalation_ref, zbx_escalation_ref_t)
+
+zbx_uint32_t	zbx_escalation_serialize_refs(unsigned char **data, const zbx_escalation_ref_t *refs, int refs_num);
+void		zbx_escalation_deserialize_refs(const unsigned char *data, zbx_vector_escalation_ref_t *refs);
+
+void	zbx_escalations_notify(const zbx_vector_escalation_ref_t *refs);
+
+#endif
@@ -0,0 +1,644 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "daemon.h"
+#include "db.h"
+#include "zbxself.h"
+#include "log.h"
+#include "zbxipcservice.h"
+#include "escalation_manager.h"
+#include "../escalations.h"
+
+extern unsigned char	process_type, program_type;
+extern int		server_num, process_num;
+
+extern int	CONFIG_ESCALATOR_FORKS;
+
+/*
+ * The escalation manager keeps schedule of all escalations in memory so that escalators
+ * do not have to poll escalations table. Each escalator owns its own queue (binary heap
+ * sorted by nextcheck) of escalations, partitioned in the same way as escalators did
+ * when selecting escalations from database - by trigger, item or escalation identifier.
+ *
+ * New and recovered escalations are reported to the manager by the processes creating them
+ * (history syncers, task manager, ...). Due escalations are popped from queue and sent to
+ * the owning escalator when it is free. After processing the escalator reports the new
+ * nextcheck or deletion of each escalation and the manager queues them accordingly.
+ *
+ * The escalations table is the persistent storage of escalations. The manager reads it on
+ * startup and periodically afterwards to pick up escalations it was not notified about.
+ */
+
+/* period of synchronization with escalations table */
+#define ZBX_ESCALATION_SYNC_PERIOD	(10 * SEC_PER_MIN)
+
+/* Escalations are reported to manager before the transaction creating or recovering them */
+/* is committed. Until this timeout expires escalations not found in database or not due  */
+/* yet are retried.                                                                        */
+#define ZBX_ESCALATION_PENDING_TIMEOUT	SEC_PER_MIN
+
+#define ZBX_ESCALATIONS_PER_STEP	1000
+
+#define ZBX_ESCALATION_SCHED_IDLE	0
+#define ZBX_ESCALATION_SCHED_QUEUED	1
+#define ZBX_ESCALATION_SCHED_BUSY	2
+
+typedef struct
+{
+	zbx_uint64_t	escalationid;
+	int		nextcheck;
+	int		worker;
+
+	/* time when escalation was reported by escalation source and not processed yet */
+	int		pending_since;
+
+	/* escalation was updated while being processed by escalator */
+	int		requeue_nextcheck;
+	unsigned char	requeue;
+
+	unsigned char	state;
+
+	/* synchronization revision */
+	unsigned char	sync_rev;
+}
+zbx_escalation_sched_t;
+
+typedef struct
+{
+	zbx_ipc_client_t	*client;
+
+	/* the escalations owned by escalator, sorted by nextcheck */
+	zbx_binary_heap_t	queue;
+
+	/* the number of escalations being processed by escalator */
+	int			busy_num;
+}
+zbx_escalation_worker_t;
+
+typedef struct
+{
+	zbx_hashset_t		escalations;
+	zbx_escalation_worker_t	*workers;
+	int			workers_num;
+	int			sync_time;
+	unsigned char		sync_rev;
+}
+zbx_escalation_manager_t;
+
+static int	escalation_sched_compare(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+
+	const zbx_escalation_sched_t	*s1 = (const zbx_escalation_sched_t *)e1->data;
+	const zbx_escalation_sched_t	*s2 = (const zbx_escalation_sched_t *)e2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(s1->nextcheck, s2->nextcheck);
+	ZBX_RETURN_IF_NOT_EQUAL(s1->escalationid, s2->escalationid);
+
+	return 0;
+}
+
+static void	escalation_manager_init(zbx_escalation_manager_t *manager)
+{
+	int	i;
+
+	zbx_hashset_create(&manager->escalations, 1000, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	manager->workers_num = CONFIG_ESCALATOR_FORKS;
+	manager->workers = (zbx_escalation_worker_t *)zbx_malloc(NULL,
+			sizeof(zbx_escalation_worker_t) * (size_t)manager->workers_num);
+
+	for (i = 0; i < manager->workers_num; i++)
+	{
+		manager->workers[i].client = NULL;
+		manager->workers[i].busy_num = 0;
+		zbx_binary_heap_create(&manager->workers[i].queue, escalation_sched_compare,
+				ZBX_BINARY_HEAP_OPTION_DIRECT);
+	}
+
+	manager->sync_time = 0;
+	manager->sync_rev = 0;
+}
+
+static void	escalation_manager_destroy(zbx_escalation_manager_t *manager)
+{
+	int	i;
+
+	for (i = 0; i < manager->workers_num; i++)
+		zbx_binary_heap_destroy(&manager->workers[i].queue);
+
+	zbx_free(manager->workers);
+	zbx_hashset_destroy(&manager->escalations);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns index of escalator owning the escalation                  *
+ *                                                                            *
+ * Comments: Escalations of the same trigger or item are always processed by  *
+ *           the same escalator.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	escalation_get_worker_index(const zbx_escalation_manager_t *manager, const zbx_escalation_ref_t *ref)
+{
+	zbx_uint64_t	key;
+
+	if (0 != ref->triggerid)
+		key = ref->triggerid;
+	else if (0 != ref->itemid)
+		key = ref->itemid;
+	else
+		key = ref->escalationid;
+
+	return (int)(key % (zbx_uint64_t)manager->workers_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: queues escalation to be processed at the specified time           *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_queue(zbx_escalation_manager_t *manager, zbx_escalation_sched_t *sched, int nextcheck)
+{
+	zbx_binary_heap_elem_t	elem = {sched->escalationid, (const void *)sched};
+	zbx_binary_heap_t	*queue = &manager->workers[sched->worker].queue;
+
+	switch (sched->state)
+	{
+		case ZBX_ESCALATION_SCHED_BUSY:
+			/* processed by escalator, queue when it's done */
+			if (0 == sched->requeue || nextcheck < sched->requeue_nextcheck)
+				sched->requeue_nextcheck = nextcheck;
+			sched->requeue = 1;
+			break;
+		case ZBX_ESCALATION_SCHED_QUEUED:
+			sched->nextcheck = nextcheck;
+			zbx_binary_heap_update_direct(queue, &elem);
+			break;
+		default:
+			sched->nextcheck = nextcheck;
+			sched->state = ZBX_ESCALATION_SCHED_QUEUED;
+			zbx_binary_heap_insert(queue, &elem);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes escalation from schedule                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_remove(zbx_escalation_manager_t *manager, zbx_escalation_sched_t *sched)
+{
+	if (ZBX_ESCALATION_SCHED_QUEUED == sched->state)
+		zbx_binary_heap_remove_direct(&manager->workers[sched->worker].queue, sched->escalationid);
+
+	zbx_hashset_remove_direct(&manager->escalations, sched);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds escalation to schedule or updates its nextcheck              *
+ *                                                                            *
+ * Parameters: manager - [IN] the manager                                     *
+ *             ref     - [IN] the escalation reference                        *
+ *                                                                            *
+ * Return value: the scheduled escalation                                     *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_escalation_sched_t	*escalation_schedule(zbx_escalation_manager_t *manager,
+		const zbx_escalation_ref_t *ref)
+{
+	zbx_escalation_sched_t	*sched, sched_local;
+
+	if (NULL == (sched = (zbx_escalation_sched_t *)zbx_hashset_search(&manager->escalations, &ref->escalationid)))
+	{
+		memset(&sched_local, 0, sizeof(sched_local));
+		sched_local.escalationid = ref->escalationid;
+		sched_local.worker = escalation_get_worker_index(manager, ref);
+		sched_local.state = ZBX_ESCALATION_SCHED_IDLE;
+		sched_local.sync_rev = manager->sync_rev;
+
+		sched = (zbx_escalation_sched_t *)zbx_hashset_insert(&manager->escalations, &sched_local,
+				sizeof(sched_local));
+	}
+	else if (ZBX_ESCALATION_SCHED_QUEUED == sched->state && sched->nextcheck <= ref->nextcheck)
+		return sched;
+
+	escalation_queue(manager, sched, ref->nextcheck);
+
+	return sched;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: synchronizes schedule with escalations table                      *
+ *                                                                            *
+ * Comments: Escalations not found in database are removed unless they are    *
+ *           processed by escalators or were reported recently and might be   *
+ *           not committed yet.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_manager_sync(zbx_escalation_manager_t *manager, int now)
+{
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_escalation_sched_t	*sched;
+	zbx_hashset_iter_t	iter;
+	int			added_num = 0, removed_num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	manager->sync_rev++;
+
+	result = DBselect("select escalationid,triggerid,itemid,nextcheck from escalations");
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		zbx_escalation_ref_t	ref;
+
+		ZBX_STR2UINT64(ref.escalationid, row[0]);
+		ZBX_DBROW2UINT64(ref.triggerid, row[1]);
+		ZBX_DBROW2UINT64(ref.itemid, row[2]);
+		ref.nextcheck = atoi(row[3]);
+
+		if (NULL == (sched = (zbx_escalation_sched_t *)zbx_hashset_search(&manager->escalations,
+				&ref.escalationid)))
+		{
+			added_num++;
+		}
+
+		sched = escalation_schedule(manager, &ref);
+		sched->sync_rev = manager->sync_rev;
+	}
+	DBfree_result(result);
+
+	zbx_hashset_iter_reset(&manager->escalations, &iter);
+	while (NULL != (sched = (zbx_escalation_sched_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (sched->sync_rev == manager->sync_rev || ZBX_ESCALATION_SCHED_BUSY == sched->state)
+			continue;
+
+		if (0 != sched->pending_since && now - sched->pending_since < ZBX_ESCALATION_PENDING_TIMEOUT)
+			continue;
+
+		if (ZBX_ESCALATION_SCHED_QUEUED == sched->state)
+			zbx_binary_heap_remove_direct(&manager->workers[sched->worker].queue, sched->escalationid);
+
+		zbx_hashset_iter_remove(&iter);
+		removed_num++;
+	}
+
+	manager->sync_time = now;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() escalations:%d added:%d removed:%d", __func__,
+			manager->escalations.num_data, added_num, removed_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: registers escalator                                               *
+ *                                                                            *
+ * Parameters: manager - [IN] the manager                                     *
+ *             client  - [IN] the connected escalator IPC client data         *
+ *             message - [IN] the received message                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_register_worker(zbx_escalation_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
+{
+	pid_t	ppid;
+	int	worker_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	memcpy(&ppid, message->data, sizeof(ppid));
+	memcpy(&worker_num, message->data + sizeof(ppid), sizeof(worker_num));
+
+	if (ppid != getppid())
+	{
+		zbx_ipc_client_close(client);
+		zabbix_log(LOG_LEVEL_DEBUG, "refusing connection from foreign process");
+	}
+	else if (1 > worker_num || worker_num > manager->workers_num)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		zbx_ipc_client_close(client);
+	}
+	else
+	{
+		zbx_escalation_worker_t	*worker = &manager->workers[worker_num - 1];
+
+		if (NULL != worker->client)
+			zbx_ipc_client_release(worker->client);
+
+		zbx_ipc_client_addref(client);
+		worker->client = client;
+		worker->busy_num = 0;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: queues escalations reported by processes creating them            *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_process_queue_request(zbx_escalation_manager_t *manager, const zbx_ipc_message_t *message,
+		int now)
+{
+	zbx_vector_escalation_ref_t	refs;
+	int				i;
+
+	zbx_vector_escalation_ref_create(&refs);
+	zbx_escalation_deserialize_refs(message->data, &refs);
+
+	for (i = 0; i < refs.values_num; i++)
+		escalation_schedule(manager, &refs.values[i])->pending_since = now;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() queued:%d", __func__, refs.values_num);
+
+	zbx_vector_escalation_ref_destroy(&refs);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies escalation processing results                             *
+ *                                                                            *
+ * Return value: the number of processed escalations                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	escalation_process_result(zbx_escalation_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message, int now)
+{
+	zbx_vector_escalation_ref_t	refs;
+	zbx_escalation_sched_t		*sched;
+	int				i, nextcheck;
+
+	zbx_vector_escalation_ref_create(&refs);
+	zbx_escalation_deserialize_refs(message->data, &refs);
+
+	for (i = 0; i < manager->workers_num; i++)
+	{
+		if (client == manager->workers[i].client)
+		{
+			manager->workers[i].busy_num = 0;
+			break;
+		}
+	}
+
+	for (i = 0; i < refs.values_num; i++)
+	{
+		const zbx_escalation_ref_t	*ref = &refs.values[i];
+
+		if (NULL == (sched = (zbx_escalation_sched_t *)zbx_hashset_search(&manager->escalations,
+				&ref->escalationid)))
+		{
+			continue;
+		}
+
+		sched->state = ZBX_ESCALATION_SCHED_IDLE;
+
+		switch (ref->state)
+		{
+			case ZBX_ESCALATION_REF_DELETED:
+				escalation_remove(manager, sched);
+				continue;
+			case ZBX_ESCALATION_REF_MISSING:
+				if (0 == sched->pending_since ||
+						now - sched->pending_since >= ZBX_ESCALATION_PENDING_TIMEOUT)
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "escalation " ZBX_FS_UI64 " not found in database",
+							sched->escalationid);
+					escalation_remove(manager, sched);
+					continue;
+				}
+
+				nextcheck = now + 1;
+				break;
+			case ZBX_ESCALATION_REF_NOT_DUE:
+				/* the reported change might be not committed yet */
+				if (0 != sched->pending_since &&
+						now - sched->pending_since < ZBX_ESCALATION_PENDING_TIMEOUT)
+				{
+					nextcheck = now + 1;
+					break;
+				}
+
+				sched->pending_since = 0;
+				nextcheck = ref->nextcheck;
+				break;
+			default:
+				sched->pending_since = 0;
+
+				/* skipped escalations are checked again in the next escalator cycle */
+				if ((nextcheck = ref->nextcheck) <= now)
+					nextcheck = now + CONFIG_ESCALATOR_FREQUENCY;
+		}
+
+		/* escalation was recovered while being processed, its nextcheck was reset in database */
+		if (0 != sched->requeue && sched->requeue_nextcheck < nextcheck)
+			nextcheck = sched->requeue_nextcheck;
+
+		sched->requeue = 0;
+		escalation_queue(manager, sched, nextcheck);
+	}
+
+	i = refs.values_num;
+	zbx_vector_escalation_ref_destroy(&refs);
+
+	return i;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends due escalations to free escalators                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_dispatch(zbx_escalation_manager_t *manager, int now)
+{
+	int				i;
+	zbx_vector_escalation_ref_t	refs;
+
+	zbx_vector_escalation_ref_create(&refs);
+
+	for (i = 0; i < manager->workers_num; i++)
+	{
+		zbx_escalation_worker_t	*worker = &manager->workers[i];
+		zbx_escalation_sched_t	*sched;
+		zbx_escalation_ref_t	ref = {0};
+		unsigned char		*data;
+		zbx_uint32_t		data_len;
+
+		if (NULL == worker->client || 0 != worker->busy_num)
+			continue;
+
+		while (FAIL == zbx_binary_heap_empty(&worker->queue) && ZBX_ESCALATIONS_PER_STEP > refs.values_num)
+		{
+			sched = (zbx_escalation_sched_t *)zbx_binary_heap_find_min(&worker->queue)->data;
+
+			if (sched->nextcheck > now)
+				break;
+
+			zbx_binary_heap_remove_min(&worker->queue);
+			sched->state = ZBX_ESCALATION_SCHED_BUSY;
+
+			ref.escalationid = sched->escalationid;
+			zbx_vector_escalation_ref_append(&refs, ref);
+		}
+
+		if (0 == refs.values_num)
+			continue;
+
+		data_len = zbx_escalation_serialize_refs(&data, refs.values, refs.values_num);
+		zbx_ipc_client_send(worker->client, ZBX_IPC_ESCALATOR_PROCESS, data, data_len);
+		zbx_free(data);
+
+		worker->busy_num = refs.values_num;
+		zbx_vector_escalation_ref_clear(&refs);
+	}
+
+	zbx_vector_escalation_ref_destroy(&refs);
+}
+
+static int	escalation_manager_queued_num(const zbx_escalation_manager_t *manager)
+{
+	int	i, queued_num = 0;
+
+	for (i = 0; i < manager->workers_num; i++)
+		queued_num += manager->workers[i].queue.elems_num;
+
+	return queued_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: schedules escalations and passes due escalations to escalators    *
+ *                                                                            *
+ ******************************************************************************/
+ZBX_THREAD_ENTRY(escalation_manager_thread, args)
+{
+#define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
+				/* once in STAT_INTERVAL seconds */
+
+	zbx_ipc_service_t		service;
+	char				*error = NULL;
+	zbx_ipc_client_t		*client;
+	zbx_ipc_message_t		*message;
+	double				time_stat, time_now, sec, time_idle = 0;
+	zbx_escalation_manager_t	manager;
+	int				ret, now, processed_num = 0;
+
+	process_type = ((zbx_thread_args_t *)args)->process_type;
+	server_num = ((zbx_thread_args_t *)args)->server_num;
+	process_num = ((zbx_thread_args_t *)args)->process_num;
+
+	zbx_setproctitle("%s #%d starting", get_process_type_string(process_type), process_num);
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(program_type),
+			server_num, get_process_type_string(process_type), process_num);
+
+	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+	if (FAIL == zbx_ipc_service_start(&service, ZBX_IPC_SERVICE_ESCALATOR, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot start escalation manager service: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
+	escalation_manager_init(&manager);
+
+	zbx_setproctitle("%s #%d [connecting to the database]", get_process_type_string(process_type), process_num);
+	DBconnect(ZBX_DB_CONNECT_NORMAL);
+
+	escalation_manager_sync(&manager, (int)time(NULL));
+
+	/* initialize statistics */
+	time_stat = zbx_time();
+
+	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
+
+	while (ZBX_IS_RUNNING())
+	{
+		time_now = zbx_time();
+		now = (int)time_now;
+
+		if (STAT_INTERVAL < time_now - time_stat)
+		{
+			zbx_setproctitle("%s #%d [processed %d escalations, scheduled %d, queued %d, idle "
+					ZBX_FS_DBL " sec during " ZBX_FS_DBL " sec]",
+					get_process_type_string(process_type), process_num, processed_num,
+					manager.escalations.num_data, escalation_manager_queued_num(&manager),
+					time_idle, time_now - time_stat);
+
+			time_stat = time_now;
+			time_idle = 0;
+			processed_num = 0;
+		}
+
+		if (manager.sync_time + ZBX_ESCALATION_SYNC_PERIOD <= now)
+			escalation_manager_sync(&manager, now);
+
+		escalation_dispatch(&manager, now);
+
+		update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
+		ret = zbx_ipc_service_recv(&service, 1, &client, &message);
+		update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+		sec = zbx_time();
+		zbx_update_env(sec);
+
+		if (ZBX_IPC_RECV_IMMEDIATE != ret)
+			time_idle += sec - time_now;
+
+		if (NULL != message)
+		{
+			switch (message->code)
+			{
+				case ZBX_IPC_ESCALATOR_REGISTER:
+					escalation_register_worker(&manager, client, message);
+					break;
+				case ZBX_IPC_ESCALATOR_QUEUE:
+					escalation_process_queue_request(&manager, message, (int)sec);
+					break;
+				case ZBX_IPC_ESCALATOR_DONE:
+					processed_num += escalation_process_result(&manager, client, message, (int)sec);
+					break;
+			}
+
+			zbx_ipc_message_free(message);
+		}
+
+		if (NULL != client)
+			zbx_ipc_client_release(client);
+	}
+
+	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
+
+	while (1)
+		zbx_sleep(SEC_PER_MIN);
+
+	zbx_ipc_service_close(&service);
+	escalation_manager_destroy(&manager);
+#undef STAT_INTERVAL
+}
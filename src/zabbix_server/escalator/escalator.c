@@ -32,10 +32,11 @@
 #include "../scripts/scripts.h"
 #include "zbxcrypto.h"
 #include "comms.h"
+#include "zbxipcservice.h"
+#include "../escalations.h"
 
 extern int	CONFIG_ESCALATOR_FORKS;
-
-#define CONFIG_ESCALATOR_FREQUENCY	3
+extern int	CONFIG_ESCALATIONMAN_FORKS;
 
 #define ZBX_ESCALATION_SOURCE_DEFAULT	0
 #define ZBX_ESCALATION_SOURCE_ITEM	1
@@ -2284,7 +2285,7 @@ static void	add_ack_escalation_r_eventids(zbx_vector_ptr_t *escalations, zbx_vec
 }
 
 static int	process_db_escalations(int now, int *nextcheck, zbx_vector_ptr_t *escalations,
-		zbx_vector_uint64_t *eventids, zbx_vector_uint64_t *actionids)
+		zbx_vector_uint64_t *eventids, zbx_vector_uint64_t *actionids, zbx_vector_uint64_t *deleted)
 {
 	int				i, ret;
 	zbx_vector_uint64_t		escalationids;
@@ -2551,11 +2552,51 @@ out:
 
 	ret = escalationids.values_num; /* performance metric */
 
+	if (NULL != deleted)
+		zbx_vector_uint64_append_array(deleted, escalationids.values, escalationids.values_num);
+
 	zbx_vector_uint64_destroy(&escalationids);
 
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates escalation from escalations table row and adds it to the  *
+ *          escalations being processed                                       *
+ *                                                                            *
+ * Parameters: row         - [IN] the escalations table row                   *
+ *             nextcheck   - [IN] the escalation nextcheck                    *
+ *             escalations - [OUT] the escalations                            *
+ *             actionids   - [OUT] the action identifiers                     *
+ *             eventids    - [OUT] the event identifiers                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_add_db_row(DB_ROW row, int nextcheck, zbx_vector_ptr_t *escalations,
+		zbx_vector_uint64_t *actionids, zbx_vector_uint64_t *eventids)
+{
+	DB_ESCALATION	*escalation;
+
+	escalation = (DB_ESCALATION *)zbx_malloc(NULL, sizeof(DB_ESCALATION));
+	escalation->nextcheck = nextcheck;
+	ZBX_DBROW2UINT64(escalation->r_eventid, row[4]);
+	ZBX_STR2UINT64(escalation->escalationid, row[0]);
+	ZBX_STR2UINT64(escalation->actionid, row[1]);
+	ZBX_DBROW2UINT64(escalation->triggerid, row[2]);
+	ZBX_DBROW2UINT64(escalation->eventid, row[3]);
+	escalation->esc_step = atoi(row[6]);
+	escalation->status = atoi(row[7]);
+	ZBX_DBROW2UINT64(escalation->itemid, row[8]);
+	ZBX_DBROW2UINT64(escalation->acknowledgeid, row[9]);
+
+	zbx_vector_ptr_append(escalations, escalation);
+	zbx_vector_uint64_append(actionids, escalation->actionid);
+	zbx_vector_uint64_append(eventids, escalation->eventid);
+
+	if (0 < escalation->r_eventid)
+		zbx_vector_uint64_append(eventids, escalation->r_eventid);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: execute escalation steps and recovery operations;                 *
@@ -2587,8 +2628,6 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 	zbx_vector_ptr_t	escalations;
 	zbx_vector_uint64_t	actionids, eventids;
 
-	DB_ESCALATION		*escalation;
-
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	zbx_vector_ptr_create(&escalations);
@@ -2663,28 +2702,11 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 			continue;
 		}
 
-		escalation = (DB_ESCALATION *)zbx_malloc(NULL, sizeof(DB_ESCALATION));
-		escalation->nextcheck = esc_nextcheck;
-		ZBX_DBROW2UINT64(escalation->r_eventid, row[4]);
-		ZBX_STR2UINT64(escalation->escalationid, row[0]);
-		ZBX_STR2UINT64(escalation->actionid, row[1]);
-		ZBX_DBROW2UINT64(escalation->triggerid, row[2]);
-		ZBX_DBROW2UINT64(escalation->eventid, row[3]);
-		escalation->esc_step = atoi(row[6]);
-		escalation->status = atoi(row[7]);
-		ZBX_DBROW2UINT64(escalation->itemid, row[8]);
-		ZBX_DBROW2UINT64(escalation->acknowledgeid, row[9]);
-
-		zbx_vector_ptr_append(&escalations, escalation);
-		zbx_vector_uint64_append(&actionids, escalation->actionid);
-		zbx_vector_uint64_append(&eventids, escalation->eventid);
-
-		if (0 < escalation->r_eventid)
-			zbx_vector_uint64_append(&eventids, escalation->r_eventid);
+		escalation_add_db_row(row, esc_nextcheck, &escalations, &actionids, &eventids);
 
 		if (escalations.values_num >= ZBX_ESCALATIONS_PER_STEP)
 		{
-			ret += process_db_escalations(now, nextcheck, &escalations, &eventids, &actionids);
+			ret += process_db_escalations(now, nextcheck, &escalations, &eventids, &actionids, NULL);
 			zbx_vector_ptr_clear_ext(&escalations, zbx_ptr_free);
 			zbx_vector_uint64_clear(&actionids);
 			zbx_vector_uint64_clear(&eventids);
@@ -2694,7 +2716,7 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 
 	if (0 < escalations.values_num)
 	{
-		ret += process_db_escalations(now, nextcheck, &escalations, &eventids, &actionids);
+		ret += process_db_escalations(now, nextcheck, &escalations, &eventids, &actionids, NULL);
 		zbx_vector_ptr_clear_ext(&escalations, zbx_ptr_free);
 	}
 
@@ -2707,6 +2729,266 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 	return ret; /* performance metric */
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reports processed escalations to escalation manager               *
+ *                                                                            *
+ * Parameters: escalations - [IN] the processed escalations                   *
+ *             deleted     - [IN] the deleted escalation identifiers          *
+ *             refs        - [OUT] the escalation references to report        *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_add_results(const zbx_vector_ptr_t *escalations, zbx_vector_uint64_t *deleted,
+		zbx_vector_escalation_ref_t *refs)
+{
+	int			i;
+	zbx_escalation_ref_t	ref;
+
+	zbx_vector_uint64_sort(deleted, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; i < escalations->values_num; i++)
+	{
+		const DB_ESCALATION	*escalation = (const DB_ESCALATION *)escalations->values[i];
+
+		ref.escalationid = escalation->escalationid;
+		ref.triggerid = escalation->triggerid;
+		ref.itemid = escalation->itemid;
+
+		if (FAIL != zbx_vector_uint64_bsearch(deleted, escalation->escalationid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			ref.state = ZBX_ESCALATION_REF_DELETED;
+			ref.nextcheck = 0;
+		}
+		else
+		{
+			ref.state = ZBX_ESCALATION_REF_SCHEDULED;
+			/* recovered escalations are stored with zero nextcheck, see process_db_escalations() */
+			ref.nextcheck = (0 == escalation->r_eventid ? escalation->nextcheck : 0);
+		}
+
+		zbx_vector_escalation_ref_append(refs, ref);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process escalations passed by escalation manager                  *
+ *                                                                            *
+ * Parameters: now  - [IN] the current time                                   *
+ *             refs - [IN/OUT] the escalations to process, their processing   *
+ *                             results on exit                                *
+ *                                                                            *
+ * Return value: the count of deleted escalations                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_escalations_by_ids(int now, zbx_vector_escalation_ref_t *refs)
+{
+	int			i, ret = 0, nextcheck = 0;
+	DB_RESULT		result;
+	DB_ROW			row;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	zbx_vector_ptr_t	escalations;
+	zbx_vector_uint64_t	actionids, eventids, escalationids, deleted;
+	zbx_escalation_ref_t	ref;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() escalations:%d", __func__, refs->values_num);
+
+	zbx_vector_ptr_create(&escalations);
+	zbx_vector_uint64_create(&actionids);
+	zbx_vector_uint64_create(&eventids);
+	zbx_vector_uint64_create(&escalationids);
+	zbx_vector_uint64_create(&deleted);
+
+	for (i = 0; i < refs->values_num; i++)
+		zbx_vector_uint64_append(&escalationids, refs->values[i].escalationid);
+
+	zbx_vector_uint64_sort(&escalationids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_escalation_ref_clear(refs);
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+			"select escalationid,actionid,triggerid,eventid,r_eventid,nextcheck,esc_step,status,itemid,"
+				"acknowledgeid"
+			" from escalations"
+			" where");
+	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "escalationid", escalationids.values,
+			escalationids.values_num);
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+			" order by actionid,triggerid,itemid," ZBX_SQL_SORT_ASC("r_eventid") ",escalationid");
+
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		int		esc_nextcheck;
+		zbx_uint64_t	escalationid;
+
+		ZBX_STR2UINT64(escalationid, row[0]);
+
+		if (FAIL != (i = zbx_vector_uint64_bsearch(&escalationids, escalationid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+		{
+			zbx_vector_uint64_remove(&escalationids, i);
+		}
+
+		esc_nextcheck = atoi(row[5]);
+
+		/* escalation is not due yet, let manager reschedule it */
+		if (esc_nextcheck > now || !ZBX_IS_RUNNING())
+		{
+			ref.escalationid = escalationid;
+			ZBX_DBROW2UINT64(ref.triggerid, row[2]);
+			ZBX_DBROW2UINT64(ref.itemid, row[8]);
+			ref.nextcheck = esc_nextcheck;
+			ref.state = ZBX_ESCALATION_REF_NOT_DUE;
+			zbx_vector_escalation_ref_append(refs, ref);
+			continue;
+		}
+
+		escalation_add_db_row(row, esc_nextcheck, &escalations, &actionids, &eventids);
+	}
+	DBfree_result(result);
+
+	if (0 < escalations.values_num)
+	{
+		ret = process_db_escalations(now, &nextcheck, &escalations, &eventids, &actionids, &deleted);
+		escalation_add_results(&escalations, &deleted, refs);
+		zbx_vector_ptr_clear_ext(&escalations, zbx_ptr_free);
+	}
+
+	/* escalations not committed yet or already deleted */
+	for (i = 0; i < escalationids.values_num; i++)
+	{
+		memset(&ref, 0, sizeof(ref));
+		ref.escalationid = escalationids.values[i];
+		ref.state = ZBX_ESCALATION_REF_MISSING;
+		zbx_vector_escalation_ref_append(refs, ref);
+	}
+
+	zbx_vector_uint64_destroy(&deleted);
+	zbx_vector_uint64_destroy(&escalationids);
+	zbx_vector_ptr_destroy(&escalations);
+	zbx_vector_uint64_destroy(&actionids);
+	zbx_vector_uint64_destroy(&eventids);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() deleted:%d", __func__, ret);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: registers escalator with escalation manager                       *
+ *                                                                            *
+ * Parameters: socket - [IN] the connection socket                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalator_register(zbx_ipc_socket_t *socket)
+{
+	pid_t		ppid;
+	unsigned char	data[sizeof(ppid) + sizeof(process_num)];
+
+	ppid = getppid();
+	memcpy(data, &ppid, sizeof(ppid));
+	memcpy(data + sizeof(ppid), &process_num, sizeof(process_num));
+
+	zbx_ipc_socket_write(socket, ZBX_IPC_ESCALATOR_REGISTER, data, sizeof(data));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes escalations scheduled by escalation manager             *
+ *                                                                            *
+ * Comments: never returns                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalator_managed_loop(void)
+{
+#define STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
+				/* once in STAT_INTERVAL seconds */
+
+	char				*error = NULL;
+	zbx_ipc_socket_t		esc_socket;
+	zbx_ipc_message_t		message;
+	zbx_vector_escalation_ref_t	refs;
+	double				time_stat, time_idle = 0, time_now, time_read;
+	int				processed_num = 0, deleted_num = 0;
+	unsigned char			*data;
+	zbx_uint32_t			data_len;
+
+	if (FAIL == zbx_ipc_socket_open(&esc_socket, ZBX_IPC_SERVICE_ESCALATOR, SEC_PER_MIN, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to escalation manager service: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
+	escalator_register(&esc_socket);
+
+	zbx_ipc_message_init(&message);
+	zbx_vector_escalation_ref_create(&refs);
+
+	time_stat = zbx_time();
+
+	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
+
+	while (ZBX_IS_RUNNING())
+	{
+		time_now = zbx_time();
+
+		if (STAT_INTERVAL < time_now - time_stat)
+		{
+			zbx_setproctitle("%s #%d [processed %d escalations, deleted %d, idle " ZBX_FS_DBL
+					" sec during " ZBX_FS_DBL " sec]", get_process_type_string(process_type),
+					process_num, processed_num, deleted_num, time_idle, time_now - time_stat);
+
+			time_stat = time_now;
+			time_idle = 0;
+			processed_num = 0;
+			deleted_num = 0;
+		}
+
+		update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
+		if (SUCCEED != zbx_ipc_socket_read(&esc_socket, &message))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot read escalation manager service request");
+			exit(EXIT_FAILURE);
+		}
+		update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+		time_read = zbx_time();
+		time_idle += time_read - time_now;
+		zbx_update_env(time_read);
+
+		switch (message.code)
+		{
+			case ZBX_IPC_ESCALATOR_PROCESS:
+				zbx_escalation_deserialize_refs(message.data, &refs);
+				processed_num += refs.values_num;
+				deleted_num += process_escalations_by_ids((int)time_read, &refs);
+
+				data_len = zbx_escalation_serialize_refs(&data, refs.values, refs.values_num);
+				zbx_ipc_socket_write(&esc_socket, ZBX_IPC_ESCALATOR_DONE, data, data_len);
+				zbx_free(data);
+				zbx_vector_escalation_ref_clear(&refs);
+				break;
+		}
+
+		zbx_ipc_message_clean(&message);
+	}
+
+	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
+
+	while (1)
+		zbx_sleep(SEC_PER_MIN);
+
+	zbx_vector_escalation_ref_destroy(&refs);
+	zbx_ipc_socket_close(&esc_socket);
+#undef STAT_INTERVAL
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: periodically check table escalations and generate alerts          *
@@ -2746,6 +3028,9 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
 
+	if (0 != CONFIG_ESCALATIONMAN_FORKS)
+		escalator_managed_loop();
+
 	while (ZBX_IS_RUNNING())
 	{
 		sec = zbx_time();
@@ -0,0 +1,657 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+
+#ifdef HAVE_LIBEVENT
+#	include <event.h>
+#endif
+
+#include <spawn.h>
+
+#include "log.h"
+#include "daemon.h"
+#include "threads.h"
+#include "zbxalgo.h"
+#include "zbxipcservice.h"
+#include "zbxexec.h"
+
+#include "forkserver.h"
+
+/* the size of temporary buffer used to read from output stream */
+#define PIPE_BUFFER_SIZE	4096
+
+/* the maximum number of concurrently running commands, the excess requests are queued */
+#define ZBX_FORKSERVER_MAX_PROCESSES	256
+
+extern char	**environ;
+
+#if !defined(LIBEVENT_VERSION_NUMBER) || LIBEVENT_VERSION_NUMBER < 0x2000000
+typedef int evutil_socket_t;
+
+static struct event	*event_new(struct event_base *ev, evutil_socket_t fd, short what,
+		void(*cb_func)(int, short, void *), void *cb_arg)
+{
+	struct event	*event;
+
+	event = zbx_malloc(NULL, sizeof(struct event));
+	event_set(event, fd, what, cb_func, cb_arg);
+	event_base_set(ev, event);
+
+	return event;
+}
+
+static void	event_free(struct event *event)
+{
+	event_del(event);
+	zbx_free(event);
+}
+
+#endif
+
+/* the fork server process id, inherited by processes forked after the fork server */
+static pid_t	forkserver_pid = 0;
+
+/* command executed by the fork server */
+typedef struct
+{
+	/* the requesting client, NULL after the result has been sent */
+	zbx_ipc_client_t	*client;
+
+	/* the request identifier, assigned by client */
+	zbx_uint64_t		id;
+
+	/* the command process id, it's also the command process group id */
+	pid_t			pid;
+
+	/* the reading end of command output pipe, -1 after it has been closed */
+	int			fd;
+
+	unsigned char		flag;
+
+	/* the command execution timeout, counted from the command start */
+	int			timeout;
+
+	/* the command exit status, valid only when reaped flag is set */
+	int			status;
+	unsigned char		reaped;
+
+	char			*command;
+	char			*buffer;
+	size_t			buffer_alloc;
+	size_t			buffer_offset;
+
+	struct event		*ev_read;
+	struct event		*ev_timer;
+}
+zbx_forkserver_job_t;
+
+static zbx_ipc_service_t	forkserver_service;
+
+/* the jobs with running or not yet reaped command processes */
+static zbx_vector_ptr_t		forkserver_jobs;
+
+/* the jobs waiting for the number of command processes to drop below limit */
+static zbx_list_t		forkserver_queue;
+
+static void	forkserver_start_queued(void);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: launches shell command with its output redirected to a pipe       *
+ *                                                                            *
+ * Parameters: command - [IN] the shell command                               *
+ *             pid     - [OUT] the command process id                         *
+ *             fd      - [OUT] the reading end of the output pipe             *
+ *                                                                            *
+ * Return value: 0 on success, otherwise the error number                     *
+ *                                                                            *
+ * Comments: The command is launched with posix_spawn() and becomes leader of *
+ *           its own process group, so the whole group can be killed on       *
+ *           timeout.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	forkserver_spawn(const char *command, pid_t *pid, int *fd)
+{
+	int				pipefd[2], err;
+	posix_spawn_file_actions_t	actions;
+	posix_spawnattr_t		attr;
+	sigset_t			mask;
+	char				*argv[] = {"sh", "-c", NULL, NULL};
+
+	if (-1 == pipe(pipefd))
+		return errno;
+
+	/* keep pipes of concurrently running commands from leaking into other commands, */
+	/* otherwise the end of output would not be detected until all of them exit      */
+	fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
+
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, pipefd[1], STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, pipefd[1], STDERR_FILENO);
+
+	sigemptyset(&mask);
+
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK);
+	posix_spawnattr_setpgroup(&attr, 0);
+	posix_spawnattr_setsigmask(&attr, &mask);
+
+	argv[2] = (char *)command;
+
+	err = posix_spawn(pid, "/bin/sh", &actions, &attr, argv, environ);
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&actions);
+
+	close(pipefd[1]);
+
+	if (0 != err)
+	{
+		close(pipefd[0]);
+		return err;
+	}
+
+	*fd = pipefd[0];
+
+	return 0;
+}
+
+static void	forkserver_job_free(zbx_forkserver_job_t *job)
+{
+	zbx_free(job->command);
+	zbx_free(job->buffer);
+	zbx_free(job);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: closes command output pipe and removes job events                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_job_close(zbx_forkserver_job_t *job)
+{
+	if (NULL != job->ev_read)
+	{
+		event_free(job->ev_read);
+		job->ev_read = NULL;
+	}
+
+	if (NULL != job->ev_timer)
+	{
+		event_free(job->ev_timer);
+		job->ev_timer = NULL;
+	}
+
+	if (-1 != job->fd)
+	{
+		close(job->fd);
+		job->fd = -1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes job after its result has been sent and command process    *
+ *          has been reaped                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_job_release(zbx_forkserver_job_t *job)
+{
+	int	index;
+
+	if (NULL != job->client || 0 == job->reaped)
+		return;
+
+	if (FAIL != (index = zbx_vector_ptr_search(&forkserver_jobs, job, ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+		zbx_vector_ptr_remove_noorder(&forkserver_jobs, index);
+
+	forkserver_job_free(job);
+	forkserver_start_queued();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends command execution result to the requesting client           *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_job_reply(zbx_forkserver_job_t *job, int ret, const char *output, const char *error)
+{
+	unsigned char	*data;
+	zbx_uint32_t	data_len;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() id:" ZBX_FS_UI64 " ret:%d", __func__, job->id, ret);
+
+	forkserver_job_close(job);
+
+	if (SUCCEED == zbx_ipc_client_connected(job->client))
+	{
+		data_len = zbx_forkserver_serialize_result(&data, job->id, ret, output, error);
+		zbx_ipc_client_send(job->client, ZBX_IPC_FORKSERVER_RESULT, data, data_len);
+		zbx_free(data);
+	}
+
+	zbx_ipc_client_release(job->client);
+	job->client = NULL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends command execution result after the command has exited and   *
+ *          all its output was read                                           *
+ *                                                                            *
+ * Comments: The exit status is interpreted the same way as in zbx_execute(). *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_job_complete(zbx_forkserver_job_t *job)
+{
+	char	*error = NULL;
+	int	ret = FAIL;
+
+	if (0 == WIFEXITED(job->status) || (ZBX_EXIT_CODE_CHECKS_ENABLED == job->flag &&
+			0 != WEXITSTATUS(job->status)))
+	{
+		if ('\0' == *job->buffer)
+		{
+			if (WIFEXITED(job->status))
+				error = zbx_dsprintf(NULL, "Process exited with code: %d.", WEXITSTATUS(job->status));
+			else if (WIFSIGNALED(job->status))
+			{
+				error = zbx_dsprintf(NULL, "Process killed by signal: %d.", WTERMSIG(job->status));
+				ret = SIG_ERROR;
+			}
+			else
+				error = zbx_strdup(NULL, "Process terminated unexpectedly.");
+
+			forkserver_job_reply(job, ret, NULL, error);
+			zbx_free(error);
+		}
+		else
+			forkserver_job_reply(job, ret, NULL, job->buffer);
+	}
+	else
+		forkserver_job_reply(job, SUCCEED, job->buffer, NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads available command output                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_job_read_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_forkserver_job_t	*job = (zbx_forkserver_job_t *)arg;
+	char			tmp_buf[PIPE_BUFFER_SIZE], *error;
+	ssize_t			rc;
+
+	ZBX_UNUSED(what);
+
+	if (-1 == (rc = read(fd, tmp_buf, sizeof(tmp_buf) - 1)))
+	{
+		if (EINTR == errno || EAGAIN == errno)
+			return;
+
+		error = zbx_dsprintf(NULL, "cannot read command output: %s", zbx_strerror(errno));
+		forkserver_job_reply(job, FAIL, NULL, error);
+		zbx_free(error);
+
+		if (0 == job->reaped && -1 == kill(-job->pid, SIGTERM))
+			zabbix_log(LOG_LEVEL_ERR, "failed to kill [%s]: %s", job->command, zbx_strerror(errno));
+
+		return;
+	}
+
+	if (0 == rc)
+	{
+		forkserver_job_close(job);
+
+		/* the result is sent when the command process is reaped */
+		if (0 != job->reaped)
+		{
+			forkserver_job_complete(job);
+			forkserver_job_release(job);
+		}
+
+		return;
+	}
+
+	if (MAX_EXECUTE_OUTPUT_LEN <= job->buffer_offset + rc)
+	{
+		zabbix_log(LOG_LEVEL_ERR, "command output exceeded limit of %d KB",
+				MAX_EXECUTE_OUTPUT_LEN / ZBX_KIBIBYTE);
+
+		/* closing the pipe terminates the command on its next write, same as zbx_execute() */
+		forkserver_job_reply(job, FAIL, NULL, NULL);
+		forkserver_job_release(job);
+		return;
+	}
+
+	tmp_buf[rc] = '\0';
+	zbx_strcpy_alloc(&job->buffer, &job->buffer_alloc, &job->buffer_offset, tmp_buf);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: terminates command process group on execution timeout             *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_job_timer_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_forkserver_job_t	*job = (zbx_forkserver_job_t *)arg;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	/* kill the whole process group, pid is the leader */
+	if (0 == job->reaped && -1 == kill(-job->pid, SIGTERM))
+		zabbix_log(LOG_LEVEL_ERR, "failed to kill [%s]: %s", job->command, zbx_strerror(errno));
+
+	forkserver_job_reply(job, TIMEOUT_ERROR, NULL, NULL);
+	forkserver_job_release(job);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reaps exited command processes                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_sigchld_cb(evutil_socket_t fd, short what, void *arg)
+{
+	int	i;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+	ZBX_UNUSED(arg);
+
+	for (i = 0; i < forkserver_jobs.values_num; i++)
+	{
+		zbx_forkserver_job_t	*job = (zbx_forkserver_job_t *)forkserver_jobs.values[i];
+
+		if (0 != job->reaped || 0 >= waitpid(job->pid, &job->status, WNOHANG))
+			continue;
+
+		job->reaped = 1;
+
+		/* wait for the rest of output if the result was not sent yet */
+		if (NULL != job->client && -1 != job->fd)
+			continue;
+
+		if (NULL != job->client)
+			forkserver_job_complete(job);
+
+		zbx_vector_ptr_remove_noorder(&forkserver_jobs, i--);
+		forkserver_job_free(job);
+	}
+
+	forkserver_start_queued();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: launches job command                                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_job_start(zbx_forkserver_job_t *job)
+{
+	int		err;
+	struct timeval	tv;
+	char		*error;
+
+	if (0 != (err = forkserver_spawn(NULL != job->command ? job->command : "", &job->pid, &job->fd)))
+	{
+		error = zbx_strdup(NULL, zbx_strerror(err));
+		forkserver_job_reply(job, FAIL, NULL, error);
+		zbx_free(error);
+		forkserver_job_free(job);
+		return;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() id:" ZBX_FS_UI64 " pid:%d", __func__, job->id, (int)job->pid);
+
+	job->ev_read = event_new(forkserver_service.ev, job->fd, EV_READ | EV_PERSIST, forkserver_job_read_cb, job);
+	event_add(job->ev_read, NULL);
+
+	tv.tv_sec = job->timeout;
+	tv.tv_usec = 0;
+	job->ev_timer = event_new(forkserver_service.ev, -1, 0, forkserver_job_timer_cb, job);
+	evtimer_add(job->ev_timer, &tv);
+
+	zbx_vector_ptr_append(&forkserver_jobs, job);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: launches queued jobs while the number of command processes is     *
+ *          below limit                                                       *
+ *                                                                            *
+ * Comments: Jobs of disconnected clients are dropped without launching.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_start_queued(void)
+{
+	zbx_forkserver_job_t	*job;
+
+	while (ZBX_FORKSERVER_MAX_PROCESSES > forkserver_jobs.values_num &&
+			SUCCEED == zbx_list_pop(&forkserver_queue, (void **)&job))
+	{
+		if (SUCCEED != zbx_ipc_client_connected(job->client))
+		{
+			zbx_ipc_client_release(job->client);
+			forkserver_job_free(job);
+			continue;
+		}
+
+		forkserver_job_start(job);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts command execution request                                  *
+ *                                                                            *
+ * Parameters: client  - [IN] the requesting client                           *
+ *             message - [IN] the execute request message                     *
+ *                                                                            *
+ * Comments: The request is queued if the maximum number of commands is       *
+ *           already running, its timeout starts when the command is          *
+ *           launched.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_execute(zbx_ipc_client_t *client, const zbx_ipc_message_t *message)
+{
+	zbx_forkserver_job_t	*job;
+
+	job = (zbx_forkserver_job_t *)zbx_malloc(NULL, sizeof(zbx_forkserver_job_t));
+	memset(job, 0, sizeof(zbx_forkserver_job_t));
+
+	zbx_forkserver_deserialize_request(message->data, &job->id, &job->timeout, &job->flag, &job->command);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() id:" ZBX_FS_UI64 " command:'%s'", __func__, job->id, job->command);
+
+	job->client = client;
+	zbx_ipc_client_addref(client);
+
+	job->fd = -1;
+	job->buffer_alloc = PIPE_BUFFER_SIZE;
+	job->buffer = (char *)zbx_malloc(NULL, job->buffer_alloc);
+	*job->buffer = '\0';
+
+	if (ZBX_FORKSERVER_MAX_PROCESSES > forkserver_jobs.values_num)
+		forkserver_job_start(job);
+	else
+		zbx_list_append(&forkserver_queue, job, NULL);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() running:%d", __func__, forkserver_jobs.values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: fork server main loop                                             *
+ *                                                                            *
+ * Parameters: parent_pid - [IN] the main process id                          *
+ *                                                                            *
+ * Comments: The fork server is forked before shared memory caches are        *
+ *           allocated and database connections are opened, so launching      *
+ *           commands from it does not pay for duplicating the address space  *
+ *           of the main process.                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_run(pid_t parent_pid)
+{
+	char			*error = NULL;
+	struct event		*ev_sigchld;
+	zbx_ipc_client_t	*client;
+	zbx_ipc_message_t	*message;
+	zbx_forkserver_job_t	*job;
+	int			i;
+
+	zbx_setproctitle("fork server");
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "fork server started [pid:%d]", (int)getpid());
+
+	if (FAIL == zbx_ipc_service_start(&forkserver_service, ZBX_IPC_SERVICE_FORKSERVER, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot start fork server service: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
+	fcntl(forkserver_service.fd, F_SETFD, FD_CLOEXEC);
+
+	zbx_vector_ptr_create(&forkserver_jobs);
+	zbx_list_create(&forkserver_queue);
+
+	ev_sigchld = event_new(forkserver_service.ev, SIGCHLD, EV_SIGNAL | EV_PERSIST, forkserver_sigchld_cb, NULL);
+	event_add(ev_sigchld, NULL);
+
+	/* the main process might exit without stopping fork server when startup fails */
+	while (ZBX_IS_RUNNING() && getppid() == parent_pid)
+	{
+		zbx_ipc_service_recv(&forkserver_service, 1, &client, &message);
+
+		if (NULL != message)
+		{
+			switch (message->code)
+			{
+				case ZBX_IPC_FORKSERVER_EXECUTE:
+					forkserver_execute(client, message);
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+			}
+
+			zbx_ipc_message_free(message);
+		}
+
+		if (NULL != client)
+			zbx_ipc_client_release(client);
+	}
+
+	for (i = 0; i < forkserver_jobs.values_num; i++)
+	{
+		job = (zbx_forkserver_job_t *)forkserver_jobs.values[i];
+
+		if (0 == job->reaped)
+			kill(-job->pid, SIGTERM);
+	}
+
+	while (SUCCEED == zbx_list_pop(&forkserver_queue, (void **)&job))
+	{
+		zbx_ipc_client_release(job->client);
+		forkserver_job_free(job);
+	}
+
+	event_free(ev_sigchld);
+	zbx_ipc_service_close(&forkserver_service);
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "fork server stopped");
+
+	exit(EXIT_SUCCESS);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: forks fork server process                                         *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the fork server was started successfully           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Must be called from the main process before forking any process  *
+ *           that executes commands through the fork server.                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_forkserver_start(char **error)
+{
+	pid_t	pid, parent_pid;
+
+	parent_pid = getpid();
+
+	zbx_child_fork(&pid);
+
+	if (-1 == pid)
+	{
+		*error = zbx_dsprintf(*error, "cannot fork: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (0 == pid)
+		forkserver_run(parent_pid);
+
+	forkserver_pid = pid;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stops fork server process                                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_forkserver_stop(void)
+{
+	sigset_t	set;
+
+	if (0 == forkserver_pid)
+		return;
+
+	/* fork server exit must not be treated as a child process failure */
+	sigemptyset(&set);
+	sigaddset(&set, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &set, NULL);
+
+	if (-1 != kill(forkserver_pid, SIGUSR2))
+		waitpid(forkserver_pid, NULL, 0);
+
+	forkserver_pid = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if commands can be executed through fork server            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_forkserver_is_started(void)
+{
+	return 0 != forkserver_pid ? SUCCEED : FAIL;
+}
@@ -0,0 +1,68 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_FORKSERVER_H
+#define ZABBIX_FORKSERVER_H
+
+#include "common.h"
+
+#define ZBX_IPC_SERVICE_FORKSERVER	"forkserver"
+
+/* process -> fork server */
+#define ZBX_IPC_FORKSERVER_EXECUTE	1000
+
+/* fork server -> process */
+#define ZBX_IPC_FORKSERVER_RESULT	1001
+
+/* a command executed by the fork server on behalf of the calling process */
+typedef struct
+{
+	/* [IN] the shell command */
+	const char	*command;
+
+	/* [OUT] the command output, set only on success */
+	char		*output;
+
+	/* [OUT] the error message, set only on failure */
+	char		*error;
+
+	/* [OUT] SUCCEED, FAIL, TIMEOUT_ERROR or SIG_ERROR (see zbx_execute()) */
+	int		ret;
+}
+zbx_forkserver_request_t;
+
+int	zbx_forkserver_start(char **error);
+void	zbx_forkserver_stop(void);
+int	zbx_forkserver_is_started(void);
+
+int	zbx_forkserver_execute(const char *command, char **output, char *error, size_t max_error_len, int timeout,
+		unsigned char flag);
+void	zbx_forkserver_execute_batch(zbx_forkserver_request_t *requests, int requests_num, int timeout,
+		unsigned char flag);
+
+zbx_uint32_t	zbx_forkserver_serialize_request(unsigned char **data, zbx_uint64_t id, int timeout,
+		unsigned char flag, const char *command);
+void	zbx_forkserver_deserialize_request(const unsigned char *data, zbx_uint64_t *id, int *timeout,
+		unsigned char *flag, char **command);
+zbx_uint32_t	zbx_forkserver_serialize_result(unsigned char **data, zbx_uint64_t id, int ret, const char *output,
+		const char *error);
+void	zbx_forkserver_deserialize_result(const unsigned char *data, zbx_uint64_t *id, int *ret, char **output,
+		char **error);
+
+#endif
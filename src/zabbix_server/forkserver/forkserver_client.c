@@ -0,0 +1,335 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+
+#include "log.h"
+#include "zbxexec.h"
+#include "zbxipcservice.h"
+
+#include "forkserver.h"
+
+#include <poll.h>
+
+/* the fork server socket is opened on first use */
+#define ZBX_FORKSERVER_SOCKET_NONE	0
+#define ZBX_FORKSERVER_SOCKET_OPEN	1
+#define ZBX_FORKSERVER_SOCKET_FAILED	2
+
+/* the time to wait for fork server service to start listening */
+#define ZBX_FORKSERVER_CONNECT_TIMEOUT	SEC_PER_MIN
+
+/* the time fork server has above command timeout to kill the command and send its result */
+#define ZBX_FORKSERVER_RESULT_MARGIN	5
+
+static zbx_ipc_socket_t	forkserver_socket;
+static unsigned char	forkserver_socket_state = ZBX_FORKSERVER_SOCKET_NONE;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: opens connection to fork server                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the connection is open                             *
+ *               FAIL    - fork server is not available, commands must be     *
+ *                         executed by the calling process                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	forkserver_connect(void)
+{
+	char	*error = NULL;
+
+	if (ZBX_FORKSERVER_SOCKET_NONE != forkserver_socket_state)
+		return ZBX_FORKSERVER_SOCKET_OPEN == forkserver_socket_state ? SUCCEED : FAIL;
+
+	if (SUCCEED != zbx_forkserver_is_started())
+	{
+		forkserver_socket_state = ZBX_FORKSERVER_SOCKET_FAILED;
+		return FAIL;
+	}
+
+	if (FAIL == zbx_ipc_socket_open(&forkserver_socket, ZBX_IPC_SERVICE_FORKSERVER, ZBX_FORKSERVER_CONNECT_TIMEOUT,
+			&error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot connect to fork server, commands will be executed directly: %s",
+				error);
+		zbx_free(error);
+		forkserver_socket_state = ZBX_FORKSERVER_SOCKET_FAILED;
+		return FAIL;
+	}
+
+	forkserver_socket_state = ZBX_FORKSERVER_SOCKET_OPEN;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: waits for the next result from fork server                        *
+ *                                                                            *
+ * Parameters: timeout - [IN] the maximum time to wait in seconds             *
+ *                                                                            *
+ * Return value: SUCCEED       - the result can be read                       *
+ *               TIMEOUT_ERROR - no result was received within timeout        *
+ *               FAIL          - an error occurred                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	forkserver_wait_result(int timeout)
+{
+	struct pollfd	pfd;
+	double		deadline;
+	int		ret;
+
+	/* a buffered message might already be there */
+	if (forkserver_socket.rx_buffer_offset < forkserver_socket.rx_buffer_bytes)
+		return SUCCEED;
+
+	pfd.fd = forkserver_socket.fd;
+	pfd.events = POLLIN;
+	deadline = zbx_time() + timeout;
+
+	while (-1 == (ret = poll(&pfd, 1, (int)(MAX(deadline - zbx_time(), 0) * 1000))))
+	{
+		if (EINTR != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for fork server result: %s", zbx_strerror(errno));
+			return FAIL;
+		}
+	}
+
+	if (0 == ret)
+		return TIMEOUT_ERROR;
+
+	/* closed or failed connection will be detected by the following read */
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes commands by the calling process                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	forkserver_execute_local(zbx_forkserver_request_t *requests, int requests_num, int timeout,
+		unsigned char flag)
+{
+	char	error[MAX_STRING_LEN];
+	int	i;
+
+	for (i = 0; i < requests_num; i++)
+	{
+		zbx_forkserver_request_t	*request = &requests[i];
+
+		if (SUCCEED != (request->ret = zbx_execute(request->command, &request->output, error, sizeof(error),
+				timeout, flag, NULL)))
+		{
+			request->error = zbx_strdup(NULL, error);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes commands concurrently through fork server                *
+ *                                                                            *
+ * Parameters: requests     - [IN/OUT] the commands to execute                *
+ *             requests_num - [IN] the number of commands                     *
+ *             timeout      - [IN] the execution timeout of each command      *
+ *             flag         - [IN] indicates if exit code must be checked     *
+ *                                                                            *
+ * Comments: The result of each request has the same meaning as zbx_execute() *
+ *           return value, output and error message. Commands are executed    *
+ *           directly if the fork server is not available, or if connection   *
+ *           to it is lost before they are answered. Fork server runs a       *
+ *           limited number of commands at once and queues the rest, so the   *
+ *           wait is bounded per result - if no result arrives within command *
+ *           timeout plus a margin the fork server is considered stuck and    *
+ *           the unanswered commands fail with timeout error.                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_forkserver_execute_batch(zbx_forkserver_request_t *requests, int requests_num, int timeout,
+		unsigned char flag)
+{
+	int			i, pending_num = 0, wait_ret;
+	unsigned char		*data;
+	zbx_uint32_t		data_len;
+	zbx_ipc_message_t	message;
+	sigset_t		mask, orig_mask;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, requests_num);
+
+	for (i = 0; i < requests_num; i++)
+	{
+		requests[i].output = NULL;
+		requests[i].error = NULL;
+		requests[i].ret = FAIL;
+	}
+
+	if (0 == requests_num)
+		goto out;
+
+	if (SUCCEED != forkserver_connect())
+	{
+		forkserver_execute_local(requests, requests_num, timeout, flag);
+		goto out;
+	}
+
+	/* block signals to prevent interruption of statements when runtime control command is issued */
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGUSR1);
+	sigaddset(&mask, SIGUSR2);
+	sigprocmask(SIG_BLOCK, &mask, &orig_mask);
+
+	for (i = 0; i < requests_num; i++)
+	{
+		zbx_uint64_t	id = (zbx_uint64_t)i;
+		int		ret;
+
+		data_len = zbx_forkserver_serialize_request(&data, id, timeout, flag, requests[i].command);
+		ret = zbx_ipc_socket_write(&forkserver_socket, ZBX_IPC_FORKSERVER_EXECUTE, data, data_len);
+		zbx_free(data);
+
+		if (FAIL == ret)
+			goto fail;
+
+		pending_num++;
+	}
+
+	zbx_ipc_message_init(&message);
+
+	while (0 < pending_num)
+	{
+		zbx_uint64_t	id;
+		int		ret;
+		char		*output = NULL, *error = NULL;
+
+		if (SUCCEED != (wait_ret = forkserver_wait_result(timeout + ZBX_FORKSERVER_RESULT_MARGIN)))
+		{
+			if (TIMEOUT_ERROR == wait_ret)
+				goto timeout;
+
+			goto fail;
+		}
+
+		if (FAIL == zbx_ipc_socket_read(&forkserver_socket, &message))
+			goto fail;
+
+		zbx_forkserver_deserialize_result(message.data, &id, &ret, &output, &error);
+		zbx_ipc_message_clean(&message);
+
+		if (id >= (zbx_uint64_t)requests_num)
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			zbx_free(output);
+			zbx_free(error);
+			continue;
+		}
+
+		/* answered requests always have either output or error set */
+		if (SUCCEED != ret && NULL == error)
+			error = zbx_strdup(NULL, "");
+
+		requests[id].ret = ret;
+		requests[id].output = output;
+		requests[id].error = error;
+		pending_num--;
+	}
+
+	goto restore;
+timeout:
+	zabbix_log(LOG_LEVEL_WARNING, "fork server did not answer within %d seconds, %d unanswered commands will"
+			" fail with timeout", timeout + ZBX_FORKSERVER_RESULT_MARGIN, pending_num);
+
+	/* executing the commands directly would at least double the caller's wait, fail them instead */
+	for (i = 0; i < requests_num; i++)
+	{
+		if (NULL == requests[i].output && NULL == requests[i].error)
+		{
+			requests[i].ret = TIMEOUT_ERROR;
+			requests[i].error = zbx_strdup(NULL, "");
+		}
+	}
+	goto close;
+fail:
+	zabbix_log(LOG_LEVEL_WARNING, "cannot communicate with fork server, unanswered commands will be executed"
+			" directly");
+close:
+	/* drop the connection so that late replies cannot be mistaken for results of the next batch */
+	zbx_ipc_socket_close(&forkserver_socket);
+	forkserver_socket_state = ZBX_FORKSERVER_SOCKET_NONE;
+restore:
+	sigprocmask(SIG_SETMASK, &orig_mask, NULL);
+
+	for (i = 0; i < requests_num; i++)
+	{
+		zbx_forkserver_request_t	*request = &requests[i];
+
+		/* answered requests always have either output or error set */
+		if (NULL == request->output && NULL == request->error)
+			forkserver_execute_local(request, 1, timeout, flag);
+
+		if (TIMEOUT_ERROR == request->ret)
+		{
+			zbx_free(request->error);
+			request->error = zbx_strdup(NULL, "Timeout while executing a shell script.");
+		}
+
+		if (NULL != request->error && '\0' != *request->error)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "Failed to execute command \"%s\": %s", request->command,
+					request->error);
+		}
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes a script through fork server and returns result from     *
+ *          stdout                                                            *
+ *                                                                            *
+ * Parameters: see zbx_execute()                                              *
+ *                                                                            *
+ * Return value: see zbx_execute()                                            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_forkserver_execute(const char *command, char **output, char *error, size_t max_error_len, int timeout,
+		unsigned char flag)
+{
+	zbx_forkserver_request_t	request;
+
+	request.command = command;
+	zbx_forkserver_execute_batch(&request, 1, timeout, flag);
+
+	if (NULL != request.error)
+		zbx_strlcpy(error, request.error, max_error_len);
+	else
+		*error = '\0';
+
+	if (NULL != output)
+	{
+		zbx_free(*output);
+		*output = request.output;
+	}
+	else
+		zbx_free(request.output);
+
+	zbx_free(request.error);
+
+	return request.ret;
+}
@@ -0,0 +1,90 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+
+#include "zbxserialize.h"
+
+#include "forkserver.h"
+
+zbx_uint32_t	zbx_forkserver_serialize_request(unsigned char **data, zbx_uint64_t id, int timeout,
+		unsigned char flag, const char *command)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0, command_len;
+
+	zbx_serialize_prepare_value(data_len, id);
+	zbx_serialize_prepare_value(data_len, timeout);
+	zbx_serialize_prepare_value(data_len, flag);
+	zbx_serialize_prepare_str(data_len, command);
+
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, id);
+	ptr += zbx_serialize_value(ptr, timeout);
+	ptr += zbx_serialize_value(ptr, flag);
+	(void)zbx_serialize_str(ptr, command, command_len);
+
+	return data_len;
+}
+
+void	zbx_forkserver_deserialize_request(const unsigned char *data, zbx_uint64_t *id, int *timeout,
+		unsigned char *flag, char **command)
+{
+	zbx_uint32_t	len;
+
+	data += zbx_deserialize_value(data, id);
+	data += zbx_deserialize_value(data, timeout);
+	data += zbx_deserialize_value(data, flag);
+	(void)zbx_deserialize_str(data, command, len);
+}
+
+zbx_uint32_t	zbx_forkserver_serialize_result(unsigned char **data, zbx_uint64_t id, int ret, const char *output,
+		const char *error)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0, output_len, error_len;
+
+	zbx_serialize_prepare_value(data_len, id);
+	zbx_serialize_prepare_value(data_len, ret);
+	zbx_serialize_prepare_str(data_len, output);
+	zbx_serialize_prepare_str(data_len, error);
+
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, id);
+	ptr += zbx_serialize_value(ptr, ret);
+	ptr += zbx_serialize_str(ptr, output, output_len);
+	(void)zbx_serialize_str(ptr, error, error_len);
+
+	return data_len;
+}
+
+void	zbx_forkserver_deserialize_result(const unsigned char *data, zbx_uint64_t *id, int *ret, char **output,
+		char **error)
+{
+	zbx_uint32_t	len;
+
+	data += zbx_deserialize_value(data, id);
+	data += zbx_deserialize_value(data, ret);
+	data += zbx_deserialize_str(data, output, len);
+	(void)zbx_deserialize_str(data, error, len);
+}
@@ -91,6 +91,7 @@ ZBX_THREAD_ENTRY(httppoller_thread, args)
 	int	now, nextcheck, sleeptime = -1, httptests_count = 0, old_httptests_count = 0;
 	double	sec, total_sec = 0.0, old_total_sec = 0.0;
 	time_t	last_stat_time;
+	char	*error = NULL;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -109,6 +110,13 @@ ZBX_THREAD_ENTRY(httppoller_thread, args)
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
 
+	if (SUCCEED != init_httptests(&error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize web scenario processing: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	while (ZBX_IS_RUNNING())
 	{
 		sec = zbx_time();
@@ -125,8 +133,16 @@ ZBX_THREAD_ENTRY(httppoller_thread, args)
 		httptests_count += process_httptests(process_num, now);
 		total_sec += zbx_time() - sec;
 
-		nextcheck = get_minnextcheck();
-		sleeptime = calculate_sleeptime(nextcheck, POLLER_DELAY);
+		/* running web scenarios are advanced without sleeping, waiting is done for their step requests */
+		if (0 != get_running_httptests_num())
+		{
+			sleeptime = 0;
+		}
+		else
+		{
+			nextcheck = get_minnextcheck();
+			sleeptime = calculate_sleeptime(nextcheck, POLLER_DELAY);
+		}
 
 		if (0 != sleeptime || STAT_INTERVAL <= time(NULL) - last_stat_time)
 		{
@@ -24,11 +24,14 @@
 #include "dbcache.h"
 #include "preproc.h"
 #include "daemon.h"
+#include "zbxself.h"
 
 #include "zbxserver.h"
 #include "zbxregexp.h"
 #include "zbxhttp.h"
 
+#include "../dnsresolver/dnsresolver.h"
+
 #include "httptest.h"
 #include "httpmacro.h"
 
@@ -52,23 +55,20 @@ typedef struct
 }
 zbx_httppage_t;
 
-static zbx_httppage_t	page;
-
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
-	size_t	r_size = size * nmemb;
-
-	ZBX_UNUSED(userdata);
+	size_t		r_size = size * nmemb;
+	zbx_httppage_t	*page = (zbx_httppage_t *)userdata;
 
 	/* first piece of data */
-	if (NULL == page.data)
+	if (NULL == page->data)
 	{
-		page.allocated = MAX(8096, r_size);
-		page.offset = 0;
-		page.data = (char *)zbx_malloc(page.data, page.allocated);
+		page->allocated = MAX(8096, r_size);
+		page->offset = 0;
+		page->data = (char *)zbx_malloc(page->data, page->allocated);
 	}
 
-	zbx_strncpy_alloc(&page.data, &page.allocated, &page.offset, (char *)ptr, r_size);
+	zbx_strncpy_alloc(&page->data, &page->allocated, &page->offset, (char *)ptr, r_size);
 
 	return r_size;
 }
@@ -83,6 +83,42 @@ static size_t	curl_ignore_cb(void *ptr, size_t size, size_t nmemb, void *userdat
 
 #endif	/* HAVE_LIBCURL */
 
+/* the maximum number of web scenarios executed concurrently by one http poller */
+#define ZBX_HTTPTEST_MAX_RUNNING	100
+
+typedef struct
+{
+	DC_HOST			host;
+	zbx_httptest_t		httptest;
+	/* web scenario steps, the next one is fetched when the previous step finishes */
+	DB_RESULT		result;
+	DB_HTTPSTEP		db_httpstep;
+	char			*err_str;
+	int			delay;
+	int			lastfailedstep;
+	double			speed_download;
+	int			speed_download_num;
+#ifdef HAVE_LIBCURL
+	zbx_httpstep_t		httpstep;
+	zbx_httpstat_t		stat;
+	zbx_httppage_t		page;
+	CURL			*easyhandle;
+	CURLcode		err;
+	struct curl_slist	*headers_slist;
+	struct curl_slist	*resolve_slist;
+	char			errbuf[CURL_ERROR_SIZE];
+#endif
+}
+zbx_httptest_job_t;
+
+/* web scenarios being executed */
+static zbx_vector_ptr_t	httptest_jobs;
+
+#ifdef HAVE_LIBCURL
+static CURLM	*curl_multi = NULL;
+static CURLSH	*curl_share = NULL;
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: remove all macro variables cached during http test execution      *
@@ -609,446 +645,810 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Purpose: process single scenario of http test                              *
+ * Purpose: checks if web scenario is being executed                          *
  *                                                                            *
- * Parameters:                                                                *
+ * Parameters: httptestid - [IN] the web scenario identifier                  *
  *                                                                            *
- * Return value:                                                              *
+ * Return value: SUCCEED - the web scenario is running                        *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
- * Author: Alexei Vladishev                                                   *
+ ******************************************************************************/
+static int	httptest_is_running(zbx_uint64_t httptestid)
+{
+	int	i;
+
+	for (i = 0; i < httptest_jobs.values_num; i++)
+	{
+		if (((zbx_httptest_job_t *)httptest_jobs.values[i])->httptest.httptest.httptestid == httptestid)
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads web scenario to be executed                                 *
  *                                                                            *
- * Comments:                                                                  *
+ * Parameters: row - [IN] the web scenario and its host data                  *
+ *                                                                            *
+ * Return value: the web scenario job or NULL if web scenario data could not  *
+ *               be loaded                                                    *
  *                                                                            *
  ******************************************************************************/
-static void	process_httptest(DC_HOST *host, zbx_httptest_t *httptest)
+static zbx_httptest_job_t	*httptest_job_create(DB_ROW row)
 {
-	DB_RESULT	result;
-	DB_HTTPSTEP	db_httpstep;
-	char		*err_str = NULL, *buffer = NULL;
-	int		lastfailedstep = 0;
+	zbx_httptest_job_t	*job;
+	DC_HOST			*host;
+	zbx_httptest_t		*httptest;
+
+	job = (zbx_httptest_job_t *)zbx_malloc(NULL, sizeof(zbx_httptest_job_t));
+	memset(job, 0, sizeof(zbx_httptest_job_t));
+
+	host = &job->host;
+	httptest = &job->httptest;
+
+	ZBX_STR2UINT64(host->hostid, row[0]);
+	strscpy(host->host, row[1]);
+	zbx_strlcpy_utf8(host->name, row[2], sizeof(host->name));
+
+	ZBX_STR2UINT64(httptest->httptest.httptestid, row[3]);
+	httptest->httptest.name = zbx_strdup(NULL, row[4]);
+
+	/* create macro cache to use in this http test */
+	zbx_vector_ptr_pair_create(&httptest->macros);
+
+	if (SUCCEED != httptest_load_pairs(host, httptest))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot process web scenario \"%s\" on host \"%s\": "
+				"cannot load web scenario data", httptest->httptest.name, host->name);
+		THIS_SHOULD_NEVER_HAPPEN;
+
+		zbx_vector_ptr_pair_destroy(&httptest->macros);
+		zbx_free(httptest->httptest.name);
+		zbx_free(job);
+
+		return NULL;
+	}
+
+	httptest->httptest.agent = zbx_strdup(NULL, row[5]);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL,
+			&httptest->httptest.agent, MACRO_TYPE_COMMON, NULL, 0);
+
+	if (HTTPTEST_AUTH_NONE != (httptest->httptest.authentication = atoi(row[6])))
+	{
+		httptest->httptest.http_user = zbx_strdup(NULL, row[7]);
+		substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL,
+				&httptest->httptest.http_user, MACRO_TYPE_COMMON, NULL, 0);
+
+		httptest->httptest.http_password = zbx_strdup(NULL, row[8]);
+		substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL,
+				&httptest->httptest.http_password, MACRO_TYPE_COMMON, NULL, 0);
+	}
+
+	if ('\0' != *row[9])
+	{
+		httptest->httptest.http_proxy = zbx_strdup(NULL, row[9]);
+		substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL,
+				&httptest->httptest.http_proxy, MACRO_TYPE_COMMON, NULL, 0);
+	}
+	else
+		httptest->httptest.http_proxy = NULL;
+
+	httptest->httptest.retries = atoi(row[10]);
+
+	httptest->httptest.ssl_cert_file = zbx_strdup(NULL, row[11]);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL,
+			&httptest->httptest.ssl_cert_file, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+
+	httptest->httptest.ssl_key_file = zbx_strdup(NULL, row[12]);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL,
+			&httptest->httptest.ssl_key_file, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+
+	httptest->httptest.ssl_key_password = zbx_strdup(NULL, row[13]);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL,
+			&httptest->httptest.ssl_key_password, MACRO_TYPE_COMMON, NULL, 0);
+
+	httptest->httptest.verify_peer = atoi(row[14]);
+	httptest->httptest.verify_host = atoi(row[15]);
+
+	httptest->httptest.delay = zbx_strdup(NULL, row[16]);
+
+	/* add httptest variables to the current test macro cache */
+	http_process_variables(httptest, &httptest->variables, NULL, NULL);
+
+#ifdef HAVE_LIBCURL
+	job->httpstep.httptest = httptest;
+	job->httpstep.httpstep = &job->db_httpstep;
+#endif
+	return job;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees web scenario job                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	httptest_job_free(zbx_httptest_job_t *job)
+{
+	zbx_httptest_t	*httptest = &job->httptest;
+
+	zbx_free(httptest->httptest.delay);
+	zbx_free(httptest->httptest.ssl_key_password);
+	zbx_free(httptest->httptest.ssl_key_file);
+	zbx_free(httptest->httptest.ssl_cert_file);
+	zbx_free(httptest->httptest.http_proxy);
+
+	if (HTTPTEST_AUTH_NONE != httptest->httptest.authentication)
+	{
+		zbx_free(httptest->httptest.http_password);
+		zbx_free(httptest->httptest.http_user);
+	}
+	zbx_free(httptest->httptest.agent);
+	zbx_free(httptest->headers);
+	httppairs_free(&httptest->variables);
+
+	/* destroy the macro cache used in this http test */
+	httptest_remove_macros(httptest);
+	zbx_vector_ptr_pair_destroy(&httptest->macros);
+
+	zbx_free(httptest->httptest.name);
+	zbx_free(job->err_str);
+	zbx_free(job);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates next check time and item values of finished web scenario  *
+ *                                                                            *
+ * Parameters: job - [IN] the web scenario job, freed by this function        *
+ *                                                                            *
+ ******************************************************************************/
+static void	httptest_finish(zbx_httptest_job_t *job)
+{
+	zbx_httptest_t	*httptest = &job->httptest;
 	zbx_timespec_t	ts;
-	int		delay;
-	double		speed_download = 0;
-	int		speed_download_num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() httptestid:" ZBX_FS_UI64, __func__, httptest->httptest.httptestid);
+
+#ifdef HAVE_LIBCURL
+	if (NULL != job->easyhandle)
+		curl_easy_cleanup(job->easyhandle);
+#endif
+	zbx_timespec(&ts);
+
+	if (0 > job->lastfailedstep)	/* update interval is invalid, delay is uninitialized */
+	{
+		zbx_config_t	cfg;
+
+		zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_REFRESH_UNSUPPORTED);
+		DBexecute("update httptest set nextcheck=%d where httptestid=" ZBX_FS_UI64,
+				(0 == cfg.refresh_unsupported || 0 > ts.sec + cfg.refresh_unsupported ?
+				ZBX_JAN_2038 : ts.sec + cfg.refresh_unsupported), httptest->httptest.httptestid);
+		zbx_config_clean(&cfg);
+	}
+	else if (0 > ts.sec + job->delay)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "nextcheck update causes overflow for web scenario \"%s\" on host \"%s\"",
+				httptest->httptest.name, job->host.name);
+		DBexecute("update httptest set nextcheck=%d where httptestid=" ZBX_FS_UI64,
+				ZBX_JAN_2038, httptest->httptest.httptestid);
+	}
+	else
+	{
+		DBexecute("update httptest set nextcheck=%d where httptestid=" ZBX_FS_UI64,
+				ts.sec + job->delay, httptest->httptest.httptestid);
+	}
+
+	if (NULL != job->err_str)
+	{
+		if (0 >= job->lastfailedstep)
+		{
+			/* we are here because web scenario update interval is invalid, */
+			/* cURL initialization failed or we have been compiled without cURL library */
+
+			job->lastfailedstep = 1;
+		}
+
+		if (NULL != job->db_httpstep.name)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot process step \"%s\" of web scenario \"%s\" on host \"%s\": "
+					"%s", job->db_httpstep.name, httptest->httptest.name, job->host.name, job->err_str);
+		}
+	}
+	DBfree_result(job->result);
+
+	if (0 != job->speed_download_num)
+		job->speed_download /= job->speed_download_num;
+
+	process_test_data(httptest->httptest.httptestid, job->lastfailedstep, job->speed_download, job->err_str, &ts);
+
+	httptest_job_free(job);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 #ifdef HAVE_LIBCURL
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees data of the current web scenario step                       *
+ *                                                                            *
+ * Parameters: job - [IN] the web scenario job                                *
+ *                                                                            *
+ * Comments: Must be called after the step request is removed from the multi  *
+ *           interface.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	httpstep_clean(zbx_httptest_job_t *job)
+{
+	zbx_httpstep_t	*httpstep = &job->httpstep;
+
+	curl_slist_free_all(job->headers_slist);
+	job->headers_slist = NULL;
+	curl_slist_free_all(job->resolve_slist);
+	job->resolve_slist = NULL;
+
+	zbx_free(job->db_httpstep.status_codes);
+	zbx_free(job->db_httpstep.required);
+	zbx_free(job->db_httpstep.posts);
+	zbx_free(job->db_httpstep.url);
+
+	httppairs_free(&httpstep->variables);
+
+	if (ZBX_POSTTYPE_FORM == httpstep->httpstep->post_type)
+		zbx_free(httpstep->posts);
+
+	zbx_free(httpstep->url);
+	zbx_free(httpstep->headers);
+
+	if (NULL != job->err_str)
+		job->lastfailedstep = job->db_httpstep.no;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts request of the next web scenario step                      *
+ *                                                                            *
+ * Parameters: job - [IN] the web scenario job                                *
+ *                                                                            *
+ * Return value: SUCCEED - the step request was added to the multi interface  *
+ *               FAIL    - there are no more steps or the step failed, error  *
+ *                         is stored in job err_str field                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	httpstep_start(zbx_httptest_job_t *job)
+{
 	DB_ROW		row;
-	zbx_httpstat_t	stat;
-	char		errbuf[CURL_ERROR_SIZE];
-	CURL		*easyhandle = NULL;
+	zbx_httptest_t	*httptest = &job->httptest;
+	zbx_httpstep_t	*httpstep = &job->httpstep;
+	DB_HTTPSTEP	*db_httpstep = &job->db_httpstep;
+	DC_HOST		*host = &job->host;
+	char		*buffer = NULL, *header_cookie = NULL;
 	CURLcode	err;
-	zbx_httpstep_t	httpstep;
-#endif
+	CURLMcode	m_err;
+	size_t		(*curl_header_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
+	size_t		(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() httptestid:" ZBX_FS_UI64 " name:'%s'",
-			__func__, httptest->httptest.httptestid, httptest->httptest.name);
+	if (!ZBX_IS_RUNNING() || NULL == (row = DBfetch(job->result)))
+		return FAIL;
 
-	result = DBselect(
-			"select httpstepid,no,name,url,timeout,posts,required,status_codes,post_type,follow_redirects,"
-				"retrieve_mode"
-			" from httpstep"
-			" where httptestid=" ZBX_FS_UI64
-			" order by no",
-			httptest->httptest.httptestid);
+	ZBX_STR2UINT64(db_httpstep->httpstepid, row[0]);
+	db_httpstep->httptestid = httptest->httptest.httptestid;
+	db_httpstep->no = atoi(row[1]);
+	db_httpstep->name = row[2];
+
+	db_httpstep->url = zbx_strdup(NULL, row[3]);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL,
+			&db_httpstep->url, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+	http_substitute_variables(httptest, &db_httpstep->url);
 
-	buffer = zbx_strdup(buffer, httptest->httptest.delay);
+	db_httpstep->required = zbx_strdup(NULL, row[6]);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL,
+			&db_httpstep->required, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+
+	db_httpstep->status_codes = zbx_strdup(NULL, row[7]);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL,
+			&db_httpstep->status_codes, MACRO_TYPE_COMMON, NULL, 0);
+
+	db_httpstep->post_type = atoi(row[8]);
+
+	if (ZBX_POSTTYPE_RAW == db_httpstep->post_type)
+	{
+		db_httpstep->posts = zbx_strdup(NULL, row[5]);
+		substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL,
+				&db_httpstep->posts, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+		http_substitute_variables(httptest, &db_httpstep->posts);
+	}
+	else
+		db_httpstep->posts = NULL;
+
+	if (SUCCEED != httpstep_load_pairs(host, httpstep))
+	{
+		job->err_str = zbx_strdup(job->err_str, "cannot load web scenario step data");
+		goto httpstep_error;
+	}
+
+	buffer = zbx_strdup(buffer, row[4]);
 	substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, &buffer,
 			MACRO_TYPE_COMMON, NULL, 0);
 
-	/* Avoid the potential usage of uninitialized values when: */
-	/* 1) compile without libCURL support */
-	/* 2) update interval is invalid */
-	db_httpstep.name = NULL;
+	if (SUCCEED != is_time_suffix(buffer, &db_httpstep->timeout, ZBX_LENGTH_UNLIMITED))
+	{
+		job->err_str = zbx_dsprintf(job->err_str, "timeout \"%s\" is invalid", buffer);
+		goto httpstep_error;
+	}
+	else if (db_httpstep->timeout < 1 || SEC_PER_HOUR < db_httpstep->timeout)
+	{
+		job->err_str = zbx_dsprintf(job->err_str, "timeout \"%s\" is out of 1-3600 seconds bounds", buffer);
+		goto httpstep_error;
+	}
+
+	db_httpstep->follow_redirects = atoi(row[9]);
+	db_httpstep->retrieve_mode = atoi(row[10]);
+
+	memset(&job->stat, 0, sizeof(job->stat));
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() use step \"%s\"", __func__, db_httpstep->name);
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() use post \"%s\"", __func__, ZBX_NULL2EMPTY_STR(httpstep->posts));
 
-	if (SUCCEED != is_time_suffix(buffer, &delay, ZBX_LENGTH_UNLIMITED))
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_POSTFIELDS, httpstep->posts)))
 	{
-		err_str = zbx_dsprintf(err_str, "update interval \"%s\" is invalid", buffer);
-		lastfailedstep = -1;
-		goto httptest_error;
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
 	}
 
-#ifdef HAVE_LIBCURL
-	if (NULL == (easyhandle = curl_easy_init()))
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_POST, (NULL != httpstep->posts &&
+			'\0' != *httpstep->posts) ? 1L : 0L)))
 	{
-		err_str = zbx_strdup(err_str, "cannot initialize cURL library");
-		goto clean;
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROXY, httptest->httptest.http_proxy)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_COOKIEFILE, "")) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_USERAGENT, httptest->httptest.agent)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ERRORBUFFER, errbuf)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")))
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_FOLLOWLOCATION,
+			0 == db_httpstep->follow_redirects ? 0L : 1L)))
 	{
-		err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-		goto clean;
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
 	}
 
-#if LIBCURL_VERSION_NUM >= 0x071304
-	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS)))
+	if (0 != db_httpstep->follow_redirects)
 	{
-		err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-		goto clean;
+		if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
+		{
+			job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+			goto httpstep_error;
+		}
 	}
-#endif
 
-	if (SUCCEED != zbx_http_prepare_ssl(easyhandle, httptest->httptest.ssl_cert_file,
-			httptest->httptest.ssl_key_file, httptest->httptest.ssl_key_password,
-			httptest->httptest.verify_peer, httptest->httptest.verify_host, &err_str))
+	/* headers defined in a step overwrite headers defined in scenario */
+	if (NULL != httpstep->headers && '\0' != *httpstep->headers)
+		add_http_headers(httpstep->headers, &job->headers_slist, &header_cookie);
+	else if (NULL != httptest->headers && '\0' != *httptest->headers)
+		add_http_headers(httptest->headers, &job->headers_slist, &header_cookie);
+
+	err = curl_easy_setopt(job->easyhandle, CURLOPT_COOKIE, header_cookie);
+	zbx_free(header_cookie);
+
+	if (CURLE_OK != err)
 	{
-		goto clean;
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
 	}
 
-	httpstep.httptest = httptest;
-	httpstep.httpstep = &db_httpstep;
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_HTTPHEADER, job->headers_slist)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-	while (NULL != (row = DBfetch(result)) && ZBX_IS_RUNNING())
+	switch (db_httpstep->retrieve_mode)
 	{
-		struct curl_slist	*headers_slist = NULL;
-		char			*header_cookie = NULL;
-		size_t			(*curl_header_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
-		size_t			(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
+		case ZBX_RETRIEVE_MODE_CONTENT:
+			curl_header_cb = curl_ignore_cb;
+			curl_body_cb = curl_write_cb;
+			break;
+		case ZBX_RETRIEVE_MODE_BOTH:
+			curl_header_cb = curl_body_cb = curl_write_cb;
+			break;
+		case ZBX_RETRIEVE_MODE_HEADERS:
+			curl_header_cb = curl_write_cb;
+			curl_body_cb = curl_ignore_cb;
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			job->err_str = zbx_strdup(job->err_str, "invalid retrieve mode");
+			goto httpstep_error;
+	}
 
-		/* NOTE: do not break or return from this block! */
-		/*       process_step_data() call is required! */
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_HEADERFUNCTION, curl_header_cb)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		ZBX_STR2UINT64(db_httpstep.httpstepid, row[0]);
-		db_httpstep.httptestid = httptest->httptest.httptestid;
-		db_httpstep.no = atoi(row[1]);
-		db_httpstep.name = row[2];
+	/* enable/disable fetching the body */
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_NOBODY,
+			ZBX_RETRIEVE_MODE_HEADERS == db_httpstep->retrieve_mode ? 1L : 0L)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		db_httpstep.url = zbx_strdup(NULL, row[3]);
-		substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL,
-				&db_httpstep.url, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
-		http_substitute_variables(httptest, &db_httpstep.url);
+	if (SUCCEED != zbx_http_prepare_auth(job->easyhandle, httptest->httptest.authentication,
+			httptest->httptest.http_user, httptest->httptest.http_password, &job->err_str))
+	{
+		goto httpstep_error;
+	}
 
-		db_httpstep.required = zbx_strdup(NULL, row[6]);
-		substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL,
-				&db_httpstep.required, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() go to URL \"%s\"", __func__, httpstep->url);
 
-		db_httpstep.status_codes = zbx_strdup(NULL, row[7]);
-		substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL,
-				&db_httpstep.status_codes, MACRO_TYPE_COMMON, NULL, 0);
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_TIMEOUT, (long)db_httpstep->timeout)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_URL, httpstep->url)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		db_httpstep.post_type = atoi(row[8]);
+	if (SUCCEED != zbx_dns_cache_set_curl_resolve(job->easyhandle, httpstep->url,
+			httptest->httptest.http_proxy, &job->resolve_slist, &job->err_str))
+	{
+		goto httpstep_error;
+	}
 
-		if (ZBX_POSTTYPE_RAW == db_httpstep.post_type)
-		{
-			db_httpstep.posts = zbx_strdup(NULL, row[5]);
-			substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL,
-					&db_httpstep.posts, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
-			http_substitute_variables(httptest, &db_httpstep.posts);
-		}
-		else
-			db_httpstep.posts = NULL;
+	memset(&job->page, 0, sizeof(job->page));
+	job->errbuf[0] = '\0';
 
-		if (SUCCEED != httpstep_load_pairs(host, &httpstep))
-		{
-			err_str = zbx_strdup(err_str, "cannot load web scenario step data");
-			goto httpstep_error;
-		}
+	if (CURLM_OK != (m_err = curl_multi_add_handle(curl_multi, job->easyhandle)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_multi_strerror(m_err));
+		goto httpstep_error;
+	}
 
-		buffer = zbx_strdup(buffer, row[4]);
-		substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, &buffer,
-				MACRO_TYPE_COMMON, NULL, 0);
+	zbx_free(buffer);
 
-		if (SUCCEED != is_time_suffix(buffer, &db_httpstep.timeout, ZBX_LENGTH_UNLIMITED))
-		{
-			err_str = zbx_dsprintf(err_str, "timeout \"%s\" is invalid", buffer);
-			goto httpstep_error;
-		}
-		else if (db_httpstep.timeout < 1 || SEC_PER_HOUR < db_httpstep.timeout)
-		{
-			err_str = zbx_dsprintf(err_str, "timeout \"%s\" is out of 1-3600 seconds bounds", buffer);
-			goto httpstep_error;
-		}
+	return SUCCEED;
+httpstep_error:
+	zbx_free(buffer);
+	httpstep_clean(job);
 
-		db_httpstep.follow_redirects = atoi(row[9]);
-		db_httpstep.retrieve_mode = atoi(row[10]);
+	return FAIL;
+}
 
-		memset(&stat, 0, sizeof(stat));
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes result of web scenario step request                     *
+ *                                                                            *
+ * Parameters: job - [IN] the web scenario job                                *
+ *             err - [IN] the step request transfer result                    *
+ *                                                                            *
+ * Return value: SUCCEED - the step request was restarted to retry the failed *
+ *                         transfer                                           *
+ *               FAIL    - the step is finished, step error is stored in job  *
+ *                         err_str field                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	httpstep_finish(zbx_httptest_job_t *job, CURLcode err)
+{
+	zbx_httptest_t	*httptest = &job->httptest;
+	zbx_httpstep_t	*httpstep = &job->httpstep;
+	DB_HTTPSTEP	*db_httpstep = &job->db_httpstep;
+	zbx_httpstat_t	*stat = &job->stat;
+	zbx_timespec_t	ts;
+	CURLMcode	m_err;
 
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() use step \"%s\"", __func__, db_httpstep.name);
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() use post \"%s\"", __func__, ZBX_NULL2EMPTY_STR(httpstep.posts));
+	if (CURLE_OK != err)
+	{
+		zbx_free(job->page.data);
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_POSTFIELDS, httpstep.posts)))
+		/* try to retrieve page several times depending on number of retries */
+		if (0 < --httptest->httptest.retries)
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
-		}
+			memset(&job->page, 0, sizeof(job->page));
+			job->errbuf[0] = '\0';
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_POST, (NULL != httpstep.posts &&
-				'\0' != *httpstep.posts) ? 1L : 0L)))
-		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
-		}
+			if (CURLM_OK == (m_err = curl_multi_add_handle(curl_multi, job->easyhandle)))
+				return SUCCEED;
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_FOLLOWLOCATION,
-				0 == db_httpstep.follow_redirects ? 0L : 1L)))
-		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			job->err_str = zbx_strdup(job->err_str, curl_multi_strerror(m_err));
 		}
-
-		if (0 != db_httpstep.follow_redirects)
+		else
 		{
-			if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-				goto httpstep_error;
-			}
+			job->err_str = zbx_dsprintf(job->err_str, "%s", 0 < strlen(job->errbuf) ? job->errbuf :
+					curl_easy_strerror(err));
 		}
+	}
+	else
+	{
+		char	*var_err_str = NULL;
 
-		/* headers defined in a step overwrite headers defined in scenario */
-		if (NULL != httpstep.headers && '\0' != *httpstep.headers)
-			add_http_headers(httpstep.headers, &headers_slist, &header_cookie);
-		else if (NULL != httptest->headers && '\0' != *httptest->headers)
-			add_http_headers(httptest->headers, &headers_slist, &header_cookie);
-
-		err = curl_easy_setopt(easyhandle, CURLOPT_COOKIE, header_cookie);
-		zbx_free(header_cookie);
+		zabbix_log(LOG_LEVEL_TRACE, "%s() page.data from %s:'%s'", __func__, httpstep->url, job->page.data);
 
-		if (CURLE_OK != err)
+		/* first get the data that is needed even if step fails */
+		if (CURLE_OK != (err = curl_easy_getinfo(job->easyhandle, CURLINFO_RESPONSE_CODE, &stat->rspcode)))
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
 		}
-
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, headers_slist)))
+		else if ('\0' != *db_httpstep->status_codes &&
+				FAIL == int_in_list(db_httpstep->status_codes, stat->rspcode))
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			job->err_str = zbx_dsprintf(job->err_str, "response code \"%ld\" did not match any of the"
+					" required status codes \"%s\"", stat->rspcode, db_httpstep->status_codes);
 		}
 
-		switch (db_httpstep.retrieve_mode)
+		if (CURLE_OK != (err = curl_easy_getinfo(job->easyhandle, CURLINFO_TOTAL_TIME, &stat->total_time)) &&
+				NULL == job->err_str)
 		{
-			case ZBX_RETRIEVE_MODE_CONTENT:
-				curl_header_cb = curl_ignore_cb;
-				curl_body_cb = curl_write_cb;
-				break;
-			case ZBX_RETRIEVE_MODE_BOTH:
-				curl_header_cb = curl_body_cb = curl_write_cb;
-				break;
-			case ZBX_RETRIEVE_MODE_HEADERS:
-				curl_header_cb = curl_write_cb;
-				curl_body_cb = curl_ignore_cb;
-				break;
-			default:
-				THIS_SHOULD_NEVER_HAPPEN;
-				err_str = zbx_strdup(err_str, "invalid retrieve mode");
-				goto httpstep_error;
+			job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
 		}
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)) ||
-				CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERFUNCTION, curl_header_cb)))
+		if (CURLE_OK != (err = curl_easy_getinfo(job->easyhandle, CURLINFO_SPEED_DOWNLOAD,
+				&stat->speed_download)) && NULL == job->err_str)
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
 		}
-
-		/* enable/disable fetching the body */
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_NOBODY,
-				ZBX_RETRIEVE_MODE_HEADERS == db_httpstep.retrieve_mode ? 1L : 0L)))
+		else
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			job->speed_download += stat->speed_download;
+			job->speed_download_num++;
 		}
 
-		if (SUCCEED != zbx_http_prepare_auth(easyhandle, httptest->httptest.authentication,
-				httptest->httptest.http_user, httptest->httptest.http_password, &err_str))
+		/* required pattern */
+		if (NULL == job->err_str && '\0' != *db_httpstep->required &&
+				NULL == zbx_regexp_match(job->page.data, db_httpstep->required, NULL))
 		{
-			goto httpstep_error;
+			job->err_str = zbx_dsprintf(job->err_str, "required pattern \"%s\" was not found on %s",
+					db_httpstep->required, httpstep->url);
 		}
 
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() go to URL \"%s\"", __func__, httpstep.url);
-
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, (long)db_httpstep.timeout)) ||
-				CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, httpstep.url)))
+		/* variables defined in scenario */
+		if (NULL == job->err_str && FAIL == http_process_variables(httptest, &httptest->variables,
+				job->page.data, &var_err_str))
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
-		}
+			char	*variables = NULL;
+			size_t	alloc_len = 0, offset;
 
-		/* try to retrieve page several times depending on number of retries */
-		do
-		{
-			memset(&page, 0, sizeof(page));
-			errbuf[0] = '\0';
+			httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httptest->variables);
 
-			if (CURLE_OK == (err = curl_easy_perform(easyhandle)))
-				break;
+			job->err_str = zbx_dsprintf(job->err_str, "error in scenario variables \"%s\": %s", variables,
+					var_err_str);
 
-			zbx_free(page.data);
+			zbx_free(variables);
 		}
-		while (0 < --httptest->httptest.retries);
 
-		curl_slist_free_all(headers_slist);	/* must be called after curl_easy_perform() */
-
-		if (CURLE_OK == err)
+		/* variables defined in a step */
+		if (NULL == job->err_str && FAIL == http_process_variables(httptest, &httpstep->variables,
+				job->page.data, &var_err_str))
 		{
-			char	*var_err_str = NULL;
+			char	*variables = NULL;
+			size_t	alloc_len = 0, offset;
 
-			zabbix_log(LOG_LEVEL_TRACE, "%s() page.data from %s:'%s'", __func__, httpstep.url, page.data);
+			httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httpstep->variables);
 
-			/* first get the data that is needed even if step fails */
-			if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &stat.rspcode)))
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			}
-			else if ('\0' != *db_httpstep.status_codes &&
-					FAIL == int_in_list(db_httpstep.status_codes, stat.rspcode))
-			{
-				err_str = zbx_dsprintf(err_str, "response code \"%ld\" did not match any of the"
-						" required status codes \"%s\"", stat.rspcode,
-						db_httpstep.status_codes);
-			}
+			job->err_str = zbx_dsprintf(job->err_str, "error in step variables \"%s\": %s", variables,
+					var_err_str);
 
-			if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_TOTAL_TIME, &stat.total_time)) &&
-					NULL == err_str)
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			}
+			zbx_free(variables);
+		}
 
-			if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_SPEED_DOWNLOAD,
-					&stat.speed_download)) && NULL == err_str)
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			}
-			else
-			{
-				speed_download += stat.speed_download;
-				speed_download_num++;
-			}
+		zbx_free(var_err_str);
 
-			/* required pattern */
-			if (NULL == err_str && '\0' != *db_httpstep.required &&
-					NULL == zbx_regexp_match(page.data, db_httpstep.required, NULL))
-			{
-				err_str = zbx_dsprintf(err_str, "required pattern \"%s\" was not found on %s",
-						db_httpstep.required, httpstep.url);
-			}
+		zbx_timespec(&ts);
+		process_step_data(db_httpstep->httpstepid, stat, &ts);
 
-			/* variables defined in scenario */
-			if (NULL == err_str && FAIL == http_process_variables(httptest, &httptest->variables, page.data,
-					&var_err_str))
-			{
-				char	*variables = NULL;
-				size_t	alloc_len = 0, offset;
+		zbx_free(job->page.data);
+	}
 
-				httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httptest->variables);
+	httpstep_clean(job);
 
-				err_str = zbx_dsprintf(err_str, "error in scenario variables \"%s\": %s", variables,
-						var_err_str);
+	return FAIL;
+}
 
-				zbx_free(variables);
-			}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: advances running web scenarios                                    *
+ *                                                                            *
+ * Parameters: timeout_ms - [IN] the maximum time to wait for step requests   *
+ *                               in milliseconds                              *
+ *                                                                            *
+ * Return value: number of finished web scenarios                             *
+ *                                                                            *
+ * Comments: Web scenario steps are executed in order, the next step request  *
+ *           is started when the previous one completes.                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	httptests_perform(int timeout_ms)
+{
+	zbx_vector_ptr_t	finished;
+	zbx_httptest_job_t	*job;
+	CURLMcode		m_err;
+	CURLMsg			*msg;
+	int			i, index, running, queued, httptests_count = 0;
 
-			/* variables defined in a step */
-			if (NULL == err_str && FAIL == http_process_variables(httptest, &httpstep.variables, page.data,
-					&var_err_str))
-			{
-				char	*variables = NULL;
-				size_t	alloc_len = 0, offset;
+	update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
+	zbx_http_multi_wait(curl_multi, timeout_ms);
+	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
 
-				httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httpstep.variables);
+	while (CURLM_CALL_MULTI_PERFORM == (m_err = curl_multi_perform(curl_multi, &running)))
+		;
 
-				err_str = zbx_dsprintf(err_str, "error in step variables \"%s\": %s", variables,
-						var_err_str);
+	if (CURLM_OK != m_err)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot perform web scenario requests: %s", curl_multi_strerror(m_err));
+		return 0;
+	}
 
-				zbx_free(variables);
-			}
+	zbx_vector_ptr_create(&finished);
 
-			zbx_free(var_err_str);
+	while (NULL != (msg = curl_multi_info_read(curl_multi, &queued)))
+	{
+		char	*ptr = NULL;
 
-			zbx_timespec(&ts);
-			process_step_data(db_httpstep.httpstepid, &stat, &ts);
+		if (CURLMSG_DONE != msg->msg)
+			continue;
 
-			zbx_free(page.data);
-		}
-		else
-			err_str = zbx_dsprintf(err_str, "%s", 0 < strlen(errbuf) ? errbuf : curl_easy_strerror(err));
+		curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &ptr);
+		job = (zbx_httptest_job_t *)ptr;
+		job->err = msg->data.result;
 
-httpstep_error:
-		zbx_free(db_httpstep.status_codes);
-		zbx_free(db_httpstep.required);
-		zbx_free(db_httpstep.posts);
-		zbx_free(db_httpstep.url);
+		curl_multi_remove_handle(curl_multi, msg->easy_handle);
+		zbx_vector_ptr_append(&finished, job);
+	}
 
-		httppairs_free(&httpstep.variables);
+	for (i = 0; i < finished.values_num; i++)
+	{
+		job = (zbx_httptest_job_t *)finished.values[i];
 
-		if (ZBX_POSTTYPE_FORM == httpstep.httpstep->post_type)
-			zbx_free(httpstep.posts);
+		if (SUCCEED == httpstep_finish(job, job->err))
+			continue;
 
-		zbx_free(httpstep.url);
-		zbx_free(httpstep.headers);
+		if (NULL == job->err_str && SUCCEED == httpstep_start(job))
+			continue;
 
-		if (NULL != err_str)
-		{
-			lastfailedstep = db_httpstep.no;
-			break;
-		}
+		if (FAIL != (index = zbx_vector_ptr_search(&httptest_jobs, job, ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+			zbx_vector_ptr_remove_noorder(&httptest_jobs, index);
+
+		httptest_finish(job);
+		httptests_count++;
 	}
-clean:
-	curl_easy_cleanup(easyhandle);
-#else
-	err_str = zbx_strdup(err_str, "cURL library is required for Web monitoring support");
+
+	zbx_vector_ptr_destroy(&finished);
+
+	return httptests_count;
+}
 #endif	/* HAVE_LIBCURL */
 
-httptest_error:
-	zbx_timespec(&ts);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts web scenario                                               *
+ *                                                                            *
+ * Parameters: job - [IN] the web scenario job                                *
+ *                                                                            *
+ * Return value: SUCCEED - the first step request was started                 *
+ *               FAIL    - the web scenario is finished, error is stored in   *
+ *                         job err_str field                                  *
+ *                                                                            *
+ * Author: Alexei Vladishev                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	httptest_start(zbx_httptest_job_t *job)
+{
+	zbx_httptest_t	*httptest = &job->httptest;
+	char		*buffer;
+	int		ret = FAIL;
+#ifdef HAVE_LIBCURL
+	CURLcode	err;
+#endif
 
-	if (0 > lastfailedstep)	/* update interval is invalid, delay is uninitialized */
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() httptestid:" ZBX_FS_UI64 " name:'%s'",
+			__func__, httptest->httptest.httptestid, httptest->httptest.name);
+
+	job->result = DBselect(
+			"select httpstepid,no,name,url,timeout,posts,required,status_codes,post_type,follow_redirects,"
+				"retrieve_mode"
+			" from httpstep"
+			" where httptestid=" ZBX_FS_UI64
+			" order by no",
+			httptest->httptest.httptestid);
+
+	buffer = zbx_strdup(NULL, httptest->httptest.delay);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, &job->host.hostid, NULL, NULL, NULL, NULL, &buffer,
+			MACRO_TYPE_COMMON, NULL, 0);
+
+	if (SUCCEED != is_time_suffix(buffer, &job->delay, ZBX_LENGTH_UNLIMITED))
 	{
-		zbx_config_t	cfg;
+		job->err_str = zbx_dsprintf(job->err_str, "update interval \"%s\" is invalid", buffer);
+		job->lastfailedstep = -1;
+		goto out;
+	}
 
-		zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_REFRESH_UNSUPPORTED);
-		DBexecute("update httptest set nextcheck=%d where httptestid=" ZBX_FS_UI64,
-				(0 == cfg.refresh_unsupported || 0 > ts.sec + cfg.refresh_unsupported ?
-				ZBX_JAN_2038 : ts.sec + cfg.refresh_unsupported), httptest->httptest.httptestid);
-		zbx_config_clean(&cfg);
+#ifdef HAVE_LIBCURL
+	if (NULL == (job->easyhandle = curl_easy_init()))
+	{
+		job->err_str = zbx_strdup(job->err_str, "cannot initialize cURL library");
+		goto out;
 	}
-	else if (0 > ts.sec + delay)
+
+	/* the easy handle is reused by all steps to keep cookies of the web scenario */
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_PROXY, httptest->httptest.http_proxy)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_COOKIEFILE, "")) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_USERAGENT,
+					httptest->httptest.agent)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_ERRORBUFFER, job->errbuf)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_WRITEDATA, &job->page)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_HEADERDATA, &job->page)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_PRIVATE, job)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_SHARE, curl_share)))
 	{
-		zabbix_log(LOG_LEVEL_WARNING, "nextcheck update causes overflow for web scenario \"%s\" on host \"%s\"",
-				httptest->httptest.name, host->name);
-		DBexecute("update httptest set nextcheck=%d where httptestid=" ZBX_FS_UI64,
-				ZBX_JAN_2038, httptest->httptest.httptestid);
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto out;
 	}
-	else
+
+#if LIBCURL_VERSION_NUM >= 0x071304
+	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_PROTOCOLS,
+			CURLPROTO_HTTP | CURLPROTO_HTTPS)))
 	{
-		DBexecute("update httptest set nextcheck=%d where httptestid=" ZBX_FS_UI64,
-				ts.sec + delay, httptest->httptest.httptestid);
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto out;
 	}
+#endif
 
-	if (NULL != err_str)
+	if (SUCCEED != zbx_http_prepare_ssl(job->easyhandle, httptest->httptest.ssl_cert_file,
+			httptest->httptest.ssl_key_file, httptest->httptest.ssl_key_password,
+			httptest->httptest.verify_peer, httptest->httptest.verify_host, &job->err_str))
 	{
-		if (0 >= lastfailedstep)
-		{
-			/* we are here because web scenario update interval is invalid, */
-			/* cURL initialization failed or we have been compiled without cURL library */
+		goto out;
+	}
 
-			lastfailedstep = 1;
-		}
+	ret = httpstep_start(job);
+#else
+	job->err_str = zbx_strdup(job->err_str, "cURL library is required for Web monitoring support");
+#endif	/* HAVE_LIBCURL */
+out:
+	zbx_free(buffer);
 
-		if (NULL != db_httpstep.name)
-		{
-			zabbix_log(LOG_LEVEL_DEBUG, "cannot process step \"%s\" of web scenario \"%s\" on host \"%s\": "
-					"%s", db_httpstep.name, httptest->httptest.name, host->name, err_str);
-		}
-	}
-	DBfree_result(result);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
-	if (0 != speed_download_num)
-		speed_download /= speed_download_num;
+	return ret;
+}
 
-	process_test_data(httptest->httptest.httptestid, lastfailedstep, speed_download, err_str, &ts);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes concurrent execution of web scenarios                 *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - initialized successfully                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Step requests of all web scenarios share connection, DNS and TLS *
+ *           session caches, see zbx_http_multi_create().                     *
+ *                                                                            *
+ ******************************************************************************/
+int	init_httptests(char **error)
+{
+	zbx_vector_ptr_create(&httptest_jobs);
+	zbx_vector_ptr_reserve(&httptest_jobs, ZBX_HTTPTEST_MAX_RUNNING);
 
-	zbx_free(buffer);
-	zbx_free(err_str);
-	zbx_preprocessor_flush();
+#ifdef HAVE_LIBCURL
+	return zbx_http_multi_create(&curl_multi, &curl_share, ZBX_HTTPTEST_MAX_RUNNING, error);
+#else
+	ZBX_UNUSED(error);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	return SUCCEED;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the number of web scenarios being executed                *
+ *                                                                            *
+ ******************************************************************************/
+int	get_running_httptests_num(void)
+{
+	return httptest_jobs.values_num;
 }
 
 /******************************************************************************
@@ -1061,130 +1461,92 @@ httptest_error:
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
- * Comments: always SUCCEED                                                   *
+ * Comments: Up to ZBX_HTTPTEST_MAX_RUNNING due web scenarios are executed    *
+ *           concurrently. While web scenarios are running new due ones are   *
+ *           looked for once per second and the running ones are advanced by  *
+ *           waiting for their step requests until the next second.           *
  *                                                                            *
  ******************************************************************************/
 int	process_httptests(int httppoller_num, int now)
 {
-	DB_RESULT	result;
-	DB_ROW		row;
-	zbx_httptest_t	httptest;
-	DC_HOST		host;
-	int		httptests_count = 0;
+	static int		last_selected = 0;
+	zbx_httptest_job_t	*job;
+	double			lags[ZBX_HTTPTEST_MAX_RUNNING];
+	int			lags_num = 0, httptests_count = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	/* create macro cache to use in http tests */
-	zbx_vector_ptr_pair_create(&httptest.macros);
-
-	result = DBselect(
-			"select h.hostid,h.host,h.name,t.httptestid,t.name,t.agent,"
-				"t.authentication,t.http_user,t.http_password,t.http_proxy,t.retries,t.ssl_cert_file,"
-				"t.ssl_key_file,t.ssl_key_password,t.verify_peer,t.verify_host,t.delay"
-			" from httptest t,hosts h"
-			" where t.hostid=h.hostid"
-				" and t.nextcheck<=%d"
-				" and " ZBX_SQL_MOD(t.httptestid,%d) "=%d"
-				" and t.status=%d"
-				" and h.proxy_hostid is null"
-				" and h.status=%d"
-				" and (h.maintenance_status=%d or h.maintenance_type=%d)",
-			now,
-			CONFIG_HTTPPOLLER_FORKS, httppoller_num - 1,
-			HTTPTEST_STATUS_MONITORED,
-			HOST_STATUS_MONITORED,
-			HOST_MAINTENANCE_STATUS_OFF, MAINTENANCE_TYPE_NORMAL);
-
-	while (NULL != (row = DBfetch(result)) && ZBX_IS_RUNNING())
+	if (ZBX_HTTPTEST_MAX_RUNNING > httptest_jobs.values_num &&
+			(0 == httptest_jobs.values_num || now != last_selected))
 	{
-		ZBX_STR2UINT64(host.hostid, row[0]);
-		strscpy(host.host, row[1]);
-		zbx_strlcpy_utf8(host.name, row[2], sizeof(host.name));
-
-		ZBX_STR2UINT64(httptest.httptest.httptestid, row[3]);
-		httptest.httptest.name = row[4];
-
-		if (SUCCEED != httptest_load_pairs(&host, &httptest))
+		DB_RESULT	result;
+		DB_ROW		row;
+		zbx_uint64_t	httptestid;
+		int		running = httptest_jobs.values_num;
+
+		last_selected = now;
+
+		result = DBselect(
+				"select h.hostid,h.host,h.name,t.httptestid,t.name,t.agent,"
+					"t.authentication,t.http_user,t.http_password,t.http_proxy,t.retries,"
+					"t.ssl_cert_file,t.ssl_key_file,t.ssl_key_password,t.verify_peer,t.verify_host,"
+					"t.delay,t.nextcheck"
+				" from httptest t,hosts h"
+				" where t.hostid=h.hostid"
+					" and t.nextcheck<=%d"
+					" and " ZBX_SQL_MOD(t.httptestid,%d) "=%d"
+					" and t.status=%d"
+					" and h.proxy_hostid is null"
+					" and h.status=%d"
+					" and (h.maintenance_status=%d or h.maintenance_type=%d)",
+				now,
+				CONFIG_HTTPPOLLER_FORKS, httppoller_num - 1,
+				HTTPTEST_STATUS_MONITORED,
+				HOST_STATUS_MONITORED,
+				HOST_MAINTENANCE_STATUS_OFF, MAINTENANCE_TYPE_NORMAL);
+
+		while (ZBX_HTTPTEST_MAX_RUNNING > running + lags_num &&
+				NULL != (row = DBfetch(result)) && ZBX_IS_RUNNING())
 		{
-			zabbix_log(LOG_LEVEL_WARNING, "cannot process web scenario \"%s\" on host \"%s\": "
-					"cannot load web scenario data", httptest.httptest.name, host.name);
-			THIS_SHOULD_NEVER_HAPPEN;
-			continue;
-		}
+			ZBX_STR2UINT64(httptestid, row[3]);
 
-		httptest.httptest.agent = zbx_strdup(NULL, row[5]);
-		substitute_simple_macros(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL, NULL,
-				&httptest.httptest.agent, MACRO_TYPE_COMMON, NULL, 0);
+			if (SUCCEED == httptest_is_running(httptestid))
+				continue;
 
-		if (HTTPTEST_AUTH_NONE != (httptest.httptest.authentication = atoi(row[6])))
-		{
-			httptest.httptest.http_user = zbx_strdup(NULL, row[7]);
-			substitute_simple_macros(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL, NULL,
-					&httptest.httptest.http_user, MACRO_TYPE_COMMON, NULL, 0);
+			/* delay between the scheduled and actual web scenario start */
+			lags[lags_num++] = zbx_time() - atoi(row[17]);
 
-			httptest.httptest.http_password = zbx_strdup(NULL, row[8]);
-			substitute_simple_macros(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL, NULL,
-					&httptest.httptest.http_password, MACRO_TYPE_COMMON, NULL, 0);
-		}
+			if (NULL == (job = httptest_job_create(row)))
+				continue;
 
-		if ('\0' != *row[9])
-		{
-			httptest.httptest.http_proxy = zbx_strdup(NULL, row[9]);
-			substitute_simple_macros(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL, NULL,
-					&httptest.httptest.http_proxy, MACRO_TYPE_COMMON, NULL, 0);
+			if (SUCCEED == httptest_start(job))
+			{
+				zbx_vector_ptr_append(&httptest_jobs, job);
+			}
+			else
+			{
+				httptest_finish(job);
+				httptests_count++;	/* performance metric */
+			}
 		}
-		else
-			httptest.httptest.http_proxy = NULL;
-
-		httptest.httptest.retries = atoi(row[10]);
-
-		httptest.httptest.ssl_cert_file = zbx_strdup(NULL, row[11]);
-		substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, &host, NULL, NULL, NULL,
-				&httptest.httptest.ssl_cert_file, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
-
-		httptest.httptest.ssl_key_file = zbx_strdup(NULL, row[12]);
-		substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, &host, NULL, NULL, NULL,
-				&httptest.httptest.ssl_key_file, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
-
-		httptest.httptest.ssl_key_password = zbx_strdup(NULL, row[13]);
-		substitute_simple_macros(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL, NULL,
-				&httptest.httptest.ssl_key_password, MACRO_TYPE_COMMON, NULL, 0);
-
-		httptest.httptest.verify_peer = atoi(row[14]);
-		httptest.httptest.verify_host = atoi(row[15]);
+		DBfree_result(result);
 
-		httptest.httptest.delay = row[16];
-
-		/* add httptest variables to the current test macro cache */
-		http_process_variables(&httptest, &httptest.variables, NULL, NULL);
-
-		process_httptest(&host, &httptest);
-
-		zbx_free(httptest.httptest.ssl_key_password);
-		zbx_free(httptest.httptest.ssl_key_file);
-		zbx_free(httptest.httptest.ssl_cert_file);
-		zbx_free(httptest.httptest.http_proxy);
-
-		if (HTTPTEST_AUTH_NONE != httptest.httptest.authentication)
-		{
-			zbx_free(httptest.httptest.http_password);
-			zbx_free(httptest.httptest.http_user);
-		}
-		zbx_free(httptest.httptest.agent);
-		zbx_free(httptest.headers);
-		httppairs_free(&httptest.variables);
+		zbx_dc_add_httptest_lag(lags, lags_num);
+	}
 
-		/* clear the macro cache used in this http test */
-		httptest_remove_macros(&httptest);
+#ifdef HAVE_LIBCURL
+	if (0 != httptest_jobs.values_num)
+	{
+		double	sec;
 
-		httptests_count++;	/* performance metric */
+		sec = zbx_time();
+		httptests_count += httptests_perform(1000 - (int)((sec - (int)sec) * 1000));
 	}
-	/* destroy the macro cache used in http tests */
-	zbx_vector_ptr_pair_destroy(&httptest.macros);
-
-	DBfree_result(result);
+#endif
+	if (0 != httptests_count)
+		zbx_preprocessor_flush();
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() running:%d", __func__, httptest_jobs.values_num);
 
 	return httptests_count;
 }
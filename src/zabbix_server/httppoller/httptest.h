@@ -20,6 +20,8 @@
 #ifndef ZABBIX_HTTPTEST_H
 #define ZABBIX_HTTPTEST_H
 
+int	init_httptests(char **error);
+int	get_running_httptests_num(void);
 int	process_httptests(int httppoller_num, int now);
 
 #endif
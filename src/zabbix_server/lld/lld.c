@@ -25,6 +25,7 @@
 #include "zbxserver.h"
 #include "zbxregexp.h"
 #include "proxy.h"
+#include "md5.h"
 
 /* lld rule filter condition (item_condition table record) */
 typedef struct
@@ -555,22 +556,253 @@ static void	lld_row_free(zbx_lld_row_t *lld_row)
 	zbx_free(lld_row);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates fingerprint of filtered discovery data                 *
+ *                                                                            *
+ * Parameters: lld_rows        - [IN] the filtered discovery rows             *
+ *             lld_macro_paths - [IN] the LLD macro paths                     *
+ *             lifetime        - [IN] the lost resource lifetime              *
+ *                                                                            *
+ * Return value: The fingerprint (never 0).                                   *
+ *                                                                            *
+ * Comments: Rows are hashed separately and the row hashes are sorted before  *
+ *           calculating the rule fingerprint, so reordering of rows in       *
+ *           discovery data does not change it.                               *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lld_rows_fingerprint(const zbx_vector_ptr_t *lld_rows, const zbx_vector_ptr_t *lld_macro_paths,
+		int lifetime)
+{
+	md5_state_t		state;
+	md5_byte_t		digest[MD5_DIGEST_SIZE];
+	zbx_vector_uint64_t	hashes;
+	zbx_uint64_t		fingerprint;
+	int			i;
+
+	zbx_vector_uint64_create(&hashes);
+	zbx_vector_uint64_reserve(&hashes, lld_rows->values_num);
+
+	for (i = 0; i < lld_rows->values_num; i++)
+	{
+		const struct zbx_json_parse	*jp_row = &((const zbx_lld_row_t *)lld_rows->values[i])->jp_row;
+
+		zbx_md5_init(&state);
+		zbx_md5_append(&state, (const md5_byte_t *)jp_row->start, jp_row->end - jp_row->start + 1);
+		zbx_md5_finish(&state, digest);
+
+		memcpy(&fingerprint, digest, sizeof(fingerprint));
+		zbx_vector_uint64_append(&hashes, fingerprint);
+	}
+
+	zbx_vector_uint64_sort(&hashes, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_md5_init(&state);
+	zbx_md5_append(&state, (const md5_byte_t *)&lifetime, sizeof(lifetime));
+
+	for (i = 0; i < lld_macro_paths->values_num; i++)
+	{
+		const zbx_lld_macro_path_t	*lld_macro_path = (const zbx_lld_macro_path_t *)lld_macro_paths->values[i];
+
+		zbx_md5_append(&state, (const md5_byte_t *)lld_macro_path->lld_macro,
+				strlen(lld_macro_path->lld_macro) + 1);
+		zbx_md5_append(&state, (const md5_byte_t *)lld_macro_path->path, strlen(lld_macro_path->path) + 1);
+	}
+
+	if (0 != hashes.values_num)
+	{
+		zbx_md5_append(&state, (const md5_byte_t *)hashes.values,
+				hashes.values_num * (int)sizeof(zbx_uint64_t));
+	}
+
+	zbx_md5_finish(&state, digest);
+	memcpy(&fingerprint, digest, sizeof(fingerprint));
+
+	zbx_vector_uint64_destroy(&hashes);
+
+	return 0 != fingerprint ? fingerprint : 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if there are lost resources with expired lifetime          *
+ *                                                                            *
+ * Parameters: table     - [IN] the discovery table                           *
+ *             field     - [IN] the parent (prototype) id field name          *
+ *             parentids - [IN] the prototype ids                             *
+ *             lastcheck - [IN] the current timestamp                         *
+ *                                                                            *
+ * Return value: SUCCEED - there are lost resources to be removed             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_lost_resources_expired(const char *table, const char *field, const zbx_vector_uint64_t *parentids,
+		int lastcheck)
+{
+	DB_RESULT	result;
+	char		*sql = NULL;
+	size_t		sql_alloc = 0, sql_offset = 0;
+	int		ret;
+
+	if (0 == parentids->values_num)
+		return FAIL;
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select null from %s where", table);
+	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, field, parentids->values, parentids->values_num);
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and ts_delete<>0 and ts_delete<%d", lastcheck);
+
+	result = DBselectN(sql, 1);
+	ret = (NULL != DBfetch(result) ? SUCCEED : FAIL);
+	DBfree_result(result);
+
+	zbx_free(sql);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates lastcheck of discovered (not lost) resources              *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_discovered_resources_touch(char **sql, size_t *sql_alloc, size_t *sql_offset, const char *table,
+		const char *field, const zbx_vector_uint64_t *parentids, int lastcheck)
+{
+	if (0 == parentids->values_num)
+		return;
+
+	zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "update %s set lastcheck=%d where ts_delete=0 and", table,
+			lastcheck);
+	DBadd_condition_alloc(sql, sql_alloc, sql_offset, field, parentids->values, parentids->values_num);
+	zbx_strcpy_alloc(sql, sql_alloc, sql_offset, ";\n");
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates lost resource bookkeeping of discovery rule which         *
+ *          received the same discovery data as during last processing        *
+ *                                                                            *
+ * Parameters: lld_ruleid - [IN] the discovery rule id                        *
+ *             lastcheck  - [IN] the current timestamp                        *
+ *                                                                            *
+ * Return value: SUCCEED - lastcheck of discovered resources was updated      *
+ *               FAIL    - there are lost resources to be removed, discovery  *
+ *                         data must be processed fully                       *
+ *                                                                            *
+ * Comments: Lost resources keep ts_delete calculated during the last full    *
+ *           processing with the same lifetime, so only discovered resources  *
+ *           (ts_delete=0) must have their lastcheck refreshed.               *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_process_unchanged_rows(zbx_uint64_t lld_ruleid, int lastcheck)
+{
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	zbx_vector_uint64_t	item_protoids, host_protoids, group_protoids, application_protoids;
+	int			ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64, __func__, lld_ruleid);
+
+	zbx_vector_uint64_create(&item_protoids);
+	zbx_vector_uint64_create(&host_protoids);
+	zbx_vector_uint64_create(&group_protoids);
+	zbx_vector_uint64_create(&application_protoids);
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"select itemid from item_discovery where parent_itemid=" ZBX_FS_UI64, lld_ruleid);
+	DBselect_uint64(sql, &item_protoids);
+
+	sql_offset = 0;
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"select hostid from host_discovery where parent_itemid=" ZBX_FS_UI64, lld_ruleid);
+	DBselect_uint64(sql, &host_protoids);
+
+	if (0 != host_protoids.values_num)
+	{
+		sql_offset = 0;
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select group_prototypeid from group_prototype where");
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "hostid", host_protoids.values,
+				host_protoids.values_num);
+		DBselect_uint64(sql, &group_protoids);
+	}
+
+	sql_offset = 0;
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"select application_prototypeid from application_prototype where itemid=" ZBX_FS_UI64,
+			lld_ruleid);
+	DBselect_uint64(sql, &application_protoids);
+
+	if (SUCCEED == lld_lost_resources_expired("item_discovery", "parent_itemid", &item_protoids, lastcheck) ||
+			SUCCEED == lld_lost_resources_expired("host_discovery", "parent_hostid", &host_protoids,
+			lastcheck) ||
+			SUCCEED == lld_lost_resources_expired("group_discovery", "parent_group_prototypeid",
+			&group_protoids, lastcheck) ||
+			SUCCEED == lld_lost_resources_expired("application_discovery", "application_prototypeid",
+			&application_protoids, lastcheck))
+	{
+		goto out;
+	}
+
+	sql_offset = 0;
+	DBbegin_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	lld_discovered_resources_touch(&sql, &sql_alloc, &sql_offset, "item_discovery", "parent_itemid",
+			&item_protoids, lastcheck);
+	lld_discovered_resources_touch(&sql, &sql_alloc, &sql_offset, "host_discovery", "parent_hostid",
+			&host_protoids, lastcheck);
+	lld_discovered_resources_touch(&sql, &sql_alloc, &sql_offset, "group_discovery", "parent_group_prototypeid",
+			&group_protoids, lastcheck);
+	lld_discovered_resources_touch(&sql, &sql_alloc, &sql_offset, "application_discovery",
+			"application_prototypeid", &application_protoids, lastcheck);
+
+	DBend_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	if (16 < sql_offset)	/* in ORACLE always present begin..end; */
+	{
+		DBbegin();
+		DBexecute("%s", sql);
+		DBcommit();
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_free(sql);
+
+	zbx_vector_uint64_destroy(&application_protoids);
+	zbx_vector_uint64_destroy(&group_protoids);
+	zbx_vector_uint64_destroy(&host_protoids);
+	zbx_vector_uint64_destroy(&item_protoids);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add or update items, triggers and graphs for discovery item       *
  *                                                                            *
- * Parameters: lld_ruleid - [IN] discovery item identifier from database      *
- *             value      - [IN] received value from agent                    *
- *             error      - [OUT] error or informational message. Will be set *
- *                               to empty string on successful discovery      *
- *                               without additional information.              *
+ * Parameters: lld_ruleid  - [IN] discovery item identifier from database     *
+ *             value       - [IN] received value from agent                   *
+ *             fingerprint - [IN/OUT] fingerprint of the discovery data       *
+ *                                 processed last time (0 if unknown), set to *
+ *                                 fingerprint of the processed data or to 0  *
+ *                                 if it must not be skipped next time        *
+ *             error       - [OUT] error or informational message. Will be    *
+ *                                 set to empty string on successful          *
+ *                                 discovery without additional information.  *
+ *                                                                            *
+ * Comments: If filtered discovery data has the same fingerprint as the data  *
+ *           processed last time, then only lost resource bookkeeping is      *
+ *           performed.                                                       *
  *                                                                            *
  ******************************************************************************/
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error)
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, zbx_uint64_t *fingerprint,
+		char **error)
 {
 	DB_RESULT		result;
 	DB_ROW			row;
-	zbx_uint64_t		hostid;
+	zbx_uint64_t		hostid, fingerprint_last, rows_fingerprint;
 	char			*discovery_key = NULL, *info = NULL;
 	int			lifetime, ret = SUCCEED;
 	zbx_vector_ptr_t	lld_rows, lld_macro_paths;
@@ -579,6 +811,9 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64, __func__, lld_ruleid);
 
+	fingerprint_last = *fingerprint;
+	*fingerprint = 0;
+
 	zbx_vector_ptr_create(&lld_rows);
 	zbx_vector_ptr_create(&lld_macro_paths);
 
@@ -642,6 +877,15 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	now = time(NULL);
 
+	rows_fingerprint = lld_rows_fingerprint(&lld_rows, &lld_macro_paths, lifetime);
+
+	if (rows_fingerprint == fingerprint_last && SUCCEED == lld_process_unchanged_rows(lld_ruleid, now))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "discovery data of rule:" ZBX_FS_UI64 " has not changed", lld_ruleid);
+		*fingerprint = rows_fingerprint;
+		goto info;
+	}
+
 	if (SUCCEED != lld_update_items(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add items because parent host was removed while"
@@ -667,6 +911,10 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	lld_update_hosts(lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now);
 
+	/* the same discovery data can be skipped only if it was processed without errors */
+	if ('\0' == **error)
+		*fingerprint = rows_fingerprint;
+info:
 	/* add informative warning to the error message about lack of data for macros used in filter */
 	if (NULL != info)
 		*error = zbx_strdcat(*error, info);
@@ -58,4 +58,13 @@ void	lld_update_hosts(zbx_uint64_t lld_ruleid, const zbx_vector_ptr_t *lld_rows,
 
 int	lld_end_of_life(int lastcheck, int lifetime);
 
+typedef void	(*zbx_lld_shard_process_func_t)(void *data, int row_from, int row_to);
+typedef void	(*zbx_lld_shard_serialize_func_t)(void *data, int row_from, int row_to, unsigned char **result,
+		zbx_uint32_t *result_len);
+typedef void	(*zbx_lld_shard_merge_func_t)(void *data, int row_from, int row_to, const unsigned char *result,
+		zbx_uint32_t result_len);
+
+void	lld_make_sharded(int rows_num, zbx_lld_shard_process_func_t process, zbx_lld_shard_serialize_func_t serialize,
+		zbx_lld_shard_merge_func_t merge, void *data);
+
 #endif
@@ -18,6 +18,22 @@
 **/
 
 #include "lld.h"
+#include "log.h"
+#include "threads.h"
+
+extern int	CONFIG_LLD_MAX_SHARDS;
+
+/* the minimum number of lld rows processed by one shard */
+#define ZBX_LLD_SHARD_ROWS_MIN	500
+
+typedef struct
+{
+	int	row_from;
+	int	row_to;
+	pid_t	pid;
+	int	fd;
+}
+zbx_lld_shard_t;
 
 /******************************************************************************
  *                                                                            *
@@ -59,3 +75,235 @@ int	lld_end_of_life(int lastcheck, int lifetime)
 {
 	return ZBX_JAN_2038 - lastcheck > lifetime ? lastcheck + lifetime : ZBX_JAN_2038;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes shard result into pipe                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_shard_write(int fd, const unsigned char *data, zbx_uint32_t data_len)
+{
+	ssize_t	n;
+
+	while (0 != data_len)
+	{
+		if (-1 == (n = write(fd, data, data_len)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			return FAIL;
+		}
+
+		data += n;
+		data_len -= (zbx_uint32_t)n;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads shard result from pipe                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_shard_read(int fd, unsigned char *data, zbx_uint32_t data_len)
+{
+	ssize_t	n;
+
+	while (0 != data_len)
+	{
+		if (-1 == (n = read(fd, data, data_len)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			return FAIL;
+		}
+
+		if (0 == n)
+			return FAIL;
+
+		data += n;
+		data_len -= (zbx_uint32_t)n;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: forks process to make objects of the specified lld row range      *
+ *                                                                            *
+ * Parameters: shard     - [IN/OUT] the shard                                 *
+ *             serialize - [IN] the callback to make and serialize objects    *
+ *             data      - [IN] the callback data                             *
+ *                                                                            *
+ * Return value: SUCCEED - the shard process was started                      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_shard_start(zbx_lld_shard_t *shard, zbx_lld_shard_serialize_func_t serialize, void *data)
+{
+	int	fds[2];
+
+	if (-1 == pipe(fds))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot create pipe for lld shard: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (-1 == (shard->pid = zbx_fork()))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot fork lld shard process: %s", zbx_strerror(errno));
+		close(fds[0]);
+		close(fds[1]);
+		return FAIL;
+	}
+
+	if (0 == shard->pid)
+	{
+		unsigned char	*result = NULL;
+		zbx_uint32_t	result_len = 0;
+		int		ret;
+
+		/* The shard process works on a copy of worker memory and must not touch database connection */
+		/* or other resources shared with the worker, so it exits without running any exit handlers. */
+		close(fds[0]);
+
+		serialize(data, shard->row_from, shard->row_to, &result, &result_len);
+
+		if (SUCCEED == (ret = lld_shard_write(fds[1], (unsigned char *)&result_len, sizeof(result_len))))
+			ret = lld_shard_write(fds[1], result, result_len);
+
+		_exit(SUCCEED == ret ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	close(fds[1]);
+	shard->fd = fds[0];
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads shard result and waits for shard process to exit            *
+ *                                                                            *
+ * Parameters: shard      - [IN] the shard                                    *
+ *             result     - [OUT] the serialized shard result                 *
+ *             result_len - [OUT] the result length                           *
+ *                                                                            *
+ * Return value: SUCCEED - the result was read successfully                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_shard_finish(zbx_lld_shard_t *shard, unsigned char **result, zbx_uint32_t *result_len)
+{
+	int	ret = FAIL, status;
+
+	*result = NULL;
+
+	if (SUCCEED == lld_shard_read(shard->fd, (unsigned char *)result_len, sizeof(*result_len)))
+	{
+		*result = (unsigned char *)zbx_malloc(NULL, 0 != *result_len ? *result_len : 1);
+		ret = lld_shard_read(shard->fd, *result, *result_len);
+	}
+
+	close(shard->fd);
+
+	while (-1 == waitpid(shard->pid, &status, 0))
+	{
+		if (EINTR != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for lld shard process: %s", zbx_strerror(errno));
+			ret = FAIL;
+			break;
+		}
+	}
+
+	if (SUCCEED == ret && (!WIFEXITED(status) || EXIT_SUCCESS != WEXITSTATUS(status)))
+		ret = FAIL;
+
+	if (SUCCEED != ret)
+		zbx_free(*result);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes lld objects of all rows, splitting large row sets into      *
+ *          shards processed in parallel                                      *
+ *                                                                            *
+ * Parameters: rows_num  - [IN] the number of lld rows or other objects that  *
+ *                              can be made independently                     *
+ *             process   - [IN] the callback to make objects of row range in  *
+ *                              the worker process                            *
+ *             serialize - [IN] the callback to make objects of row range and *
+ *                              serialize them, called in shard process       *
+ *             merge     - [IN] the callback to apply serialized shard result *
+ *                              in the worker process                         *
+ *             data      - [IN] the callback data                             *
+ *                                                                            *
+ * Comments: When the number of rows exceeds ZBX_LLD_SHARD_ROWS_MIN the rows  *
+ *           are split into up to MaxLLDShards ranges. The first range is     *
+ *           processed by the worker while the others are processed by forked *
+ *           shard processes that inherit the prepared lld data and return    *
+ *           only the made objects. If a shard fails its range is processed   *
+ *           by the worker, so the result never depends on sharding.          *
+ *           Database is accessed only by the worker.                         *
+ *                                                                            *
+ ******************************************************************************/
+void	lld_make_sharded(int rows_num, zbx_lld_shard_process_func_t process, zbx_lld_shard_serialize_func_t serialize,
+		zbx_lld_shard_merge_func_t merge, void *data)
+{
+	zbx_lld_shard_t	*shards;
+	int		shards_num, i, rows_per_shard;
+	unsigned char	*result;
+	zbx_uint32_t	result_len;
+
+	if (1 >= (shards_num = MIN(CONFIG_LLD_MAX_SHARDS, rows_num / ZBX_LLD_SHARD_ROWS_MIN)))
+	{
+		process(data, 0, rows_num);
+		return;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() rows:%d shards:%d", __func__, rows_num, shards_num);
+
+	shards = (zbx_lld_shard_t *)zbx_malloc(NULL, sizeof(zbx_lld_shard_t) * shards_num);
+	rows_per_shard = (rows_num + shards_num - 1) / shards_num;
+
+	for (i = 0; i < shards_num; i++)
+	{
+		shards[i].row_from = i * rows_per_shard;
+		shards[i].row_to = MIN(rows_num, shards[i].row_from + rows_per_shard);
+		shards[i].pid = 0;
+
+		if (0 != i && SUCCEED != lld_shard_start(&shards[i], serialize, data))
+			shards[i].pid = -1;
+	}
+
+	process(data, shards[0].row_from, shards[0].row_to);
+
+	for (i = 1; i < shards_num; i++)
+	{
+		if (-1 != shards[i].pid)
+		{
+			if (SUCCEED == lld_shard_finish(&shards[i], &result, &result_len))
+			{
+				merge(data, shards[i].row_from, shards[i].row_to, result, result_len);
+				zbx_free(result);
+				continue;
+			}
+
+			zabbix_log(LOG_LEVEL_WARNING, "lld shard process failed, processing rows %d-%d in lld worker",
+					shards[i].row_from, shards[i].row_to - 1);
+		}
+
+		process(data, shards[i].row_from, shards[i].row_to);
+	}
+
+	zbx_free(shards);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
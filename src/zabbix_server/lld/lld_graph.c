@@ -22,6 +22,7 @@
 #include "log.h"
 #include "zbxalgo.h"
 #include "zbxserver.h"
+#include "zbxserialize.h"
 
 typedef struct
 {
@@ -98,6 +99,32 @@ typedef struct
 }
 zbx_lld_item_t;
 
+/* graph make data, passed to lld shard callbacks */
+typedef struct
+{
+	const zbx_vector_ptr_t	*gitems_proto;
+	zbx_vector_ptr_t	*graphs;
+	zbx_vector_ptr_t	*items;
+	const char		*name_proto;
+	zbx_uint64_t		ymin_itemid_proto;
+	zbx_uint64_t		ymax_itemid_proto;
+	const zbx_vector_ptr_t	*lld_rows;
+	const zbx_vector_ptr_t	*lld_macro_paths;
+
+	/* the number of existing graphs, shards refer to them by index */
+	int			graphs_num;
+
+	/* Graphs that failed to be made can be matched again by the following rows, which */
+	/* shards do not see. After the first failure the remaining rows are made by the    */
+	/* worker.                                                                          */
+	int			failed;
+}
+zbx_lld_graphs_make_t;
+
+#define ZBX_LLD_GRAPH_SHARD_NONE	0
+#define ZBX_LLD_GRAPH_SHARD_NEW		1
+#define ZBX_LLD_GRAPH_SHARD_UPDATE	2
+
 static void	lld_item_free(zbx_lld_item_t *item)
 {
 	zbx_free(item);
@@ -595,10 +622,13 @@ out:
  *                                                                            *
  * Purpose: create a graph based on lld rule and add it to the list           *
  *                                                                            *
+ * Return value: the created or updated graph or NULL if y axis items could   *
+ *               not be resolved                                              *
+ *                                                                            *
  ******************************************************************************/
-static void 	lld_graph_make(const zbx_vector_ptr_t *gitems_proto, zbx_vector_ptr_t *graphs, zbx_vector_ptr_t *items,
-		const char *name_proto, zbx_uint64_t ymin_itemid_proto, zbx_uint64_t ymax_itemid_proto,
-		const zbx_lld_row_t *lld_row, const zbx_vector_ptr_t *lld_macro_paths)
+static zbx_lld_graph_t	*lld_graph_make(const zbx_vector_ptr_t *gitems_proto, zbx_vector_ptr_t *graphs,
+		zbx_vector_ptr_t *items, const char *name_proto, zbx_uint64_t ymin_itemid_proto,
+		zbx_uint64_t ymax_itemid_proto, const zbx_lld_row_t *lld_row, const zbx_vector_ptr_t *lld_macro_paths)
 {
 	zbx_lld_graph_t			*graph = NULL;
 	char				*buffer = NULL;
@@ -666,26 +696,394 @@ static void 	lld_graph_make(const zbx_vector_ptr_t *gitems_proto, zbx_vector_ptr
 	zbx_free(buffer);
 
 	if (SUCCEED != lld_gitems_make(gitems_proto, &graph->gitems, items, &lld_row->item_links))
-		return;
+		return graph;
 
 	graph->flags |= ZBX_FLAG_LLD_GRAPH_DISCOVERED;
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return graph;
 }
 
-static void	lld_graphs_make(const zbx_vector_ptr_t *gitems_proto, zbx_vector_ptr_t *graphs, zbx_vector_ptr_t *items,
-		const char *name_proto, zbx_uint64_t ymin_itemid_proto, zbx_uint64_t ymax_itemid_proto,
-		const zbx_vector_ptr_t *lld_rows, const zbx_vector_ptr_t *lld_macro_paths)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes graphs of the specified lld row range                       *
+ *                                                                            *
+ * Parameters: data     - [IN] the graph make data                            *
+ *             row_from - [IN] the first row index                            *
+ *             row_to   - [IN] the index after the last row                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_graphs_make_rows(void *data, int row_from, int row_to)
+{
+	zbx_lld_graphs_make_t	*make = (zbx_lld_graphs_make_t *)data;
+	zbx_lld_graph_t		*graph;
+	int			i;
+
+	for (i = row_from; i < row_to; i++)
+	{
+		graph = lld_graph_make(make->gitems_proto, make->graphs, make->items, make->name_proto,
+				make->ymin_itemid_proto, make->ymax_itemid_proto,
+				(const zbx_lld_row_t *)make->lld_rows->values[i], make->lld_macro_paths);
+
+		if (NULL != graph && 0 == (graph->flags & ZBX_FLAG_LLD_GRAPH_DISCOVERED))
+			make->failed = 1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes graph made from one lld row                            *
+ *                                                                            *
+ * Parameters: data        - [IN/OUT] the serialization buffer                *
+ *             data_alloc  - [IN/OUT] the buffer size                         *
+ *             data_offset - [IN/OUT] the buffer offset                       *
+ *             row         - [IN] the lld row index                           *
+ *             op          - [IN] ZBX_LLD_GRAPH_SHARD_NONE - no graph was     *
+ *                                made                                        *
+ *                                ZBX_LLD_GRAPH_SHARD_NEW - new graph         *
+ *                                ZBX_LLD_GRAPH_SHARD_UPDATE - existing graph *
+ *             index       - [IN] the existing graph index                    *
+ *             graph       - [IN] the graph, NULL if no graph was made        *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_graph_shard_serialize(unsigned char **data, zbx_uint32_t *data_alloc, zbx_uint32_t *data_offset,
+		int row, unsigned char op, int index, const zbx_lld_graph_t *graph)
+{
+	zbx_uint32_t	len = 0, name_len = 0, *colors_len = NULL;
+	unsigned char	*ptr;
+	int		i;
+
+	zbx_serialize_prepare_value(len, row);
+	zbx_serialize_prepare_value(len, op);
+
+	if (ZBX_LLD_GRAPH_SHARD_NONE != op)
+	{
+		zbx_serialize_prepare_value(len, index);
+		zbx_serialize_prepare_value(len, graph->flags);
+		zbx_serialize_prepare_str_len(len, graph->name, name_len);
+		zbx_serialize_prepare_value(len, graph->ymin_itemid);
+		zbx_serialize_prepare_value(len, graph->ymax_itemid);
+		zbx_serialize_prepare_value(len, graph->gitems.values_num);
+
+		colors_len = (zbx_uint32_t *)zbx_malloc(NULL, sizeof(zbx_uint32_t) * (graph->gitems.values_num + 1));
+
+		for (i = 0; i < graph->gitems.values_num; i++)
+		{
+			const zbx_lld_gitem_t	*gitem = (const zbx_lld_gitem_t *)graph->gitems.values[i];
+
+			zbx_serialize_prepare_value(len, gitem->itemid);
+			zbx_serialize_prepare_str_len(len, gitem->color, colors_len[i]);
+			zbx_serialize_prepare_value(len, gitem->sortorder);
+			zbx_serialize_prepare_value(len, gitem->drawtype);
+			zbx_serialize_prepare_value(len, gitem->yaxisside);
+			zbx_serialize_prepare_value(len, gitem->calc_fnc);
+			zbx_serialize_prepare_value(len, gitem->type);
+			zbx_serialize_prepare_value(len, gitem->flags);
+		}
+	}
+
+	while (len > *data_alloc - *data_offset)
+	{
+		*data_alloc *= 2;
+		*data = (unsigned char *)zbx_realloc(*data, *data_alloc);
+	}
+
+	ptr = *data + *data_offset;
+	*data_offset += len;
+
+	ptr += zbx_serialize_value(ptr, row);
+	ptr += zbx_serialize_value(ptr, op);
+
+	if (ZBX_LLD_GRAPH_SHARD_NONE == op)
+		return;
+
+	ptr += zbx_serialize_value(ptr, index);
+	ptr += zbx_serialize_value(ptr, graph->flags);
+	ptr += zbx_serialize_str(ptr, graph->name, name_len);
+	ptr += zbx_serialize_value(ptr, graph->ymin_itemid);
+	ptr += zbx_serialize_value(ptr, graph->ymax_itemid);
+	ptr += zbx_serialize_value(ptr, graph->gitems.values_num);
+
+	for (i = 0; i < graph->gitems.values_num; i++)
+	{
+		const zbx_lld_gitem_t	*gitem = (const zbx_lld_gitem_t *)graph->gitems.values[i];
+
+		ptr += zbx_serialize_value(ptr, gitem->itemid);
+		ptr += zbx_serialize_str(ptr, gitem->color, colors_len[i]);
+		ptr += zbx_serialize_value(ptr, gitem->sortorder);
+		ptr += zbx_serialize_value(ptr, gitem->drawtype);
+		ptr += zbx_serialize_value(ptr, gitem->yaxisside);
+		ptr += zbx_serialize_value(ptr, gitem->calc_fnc);
+		ptr += zbx_serialize_value(ptr, gitem->type);
+		ptr += zbx_serialize_value(ptr, gitem->flags);
+	}
+
+	zbx_free(colors_len);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes graphs of the specified lld row range and serializes them   *
+ *                                                                            *
+ * Parameters: data       - [IN] the graph make data                          *
+ *             row_from   - [IN] the first row index                          *
+ *             row_to     - [IN] the index after the last row                 *
+ *             result     - [OUT] the serialized graphs                       *
+ *             result_len - [OUT] the result length                           *
+ *                                                                            *
+ * Comments: This function is called in lld shard process. Every row is       *
+ *           serialized with the state of the graph right after it was made.  *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_graphs_make_serialize(void *data, int row_from, int row_to, unsigned char **result,
+		zbx_uint32_t *result_len)
+{
+	zbx_lld_graphs_make_t	*make = (zbx_lld_graphs_make_t *)data;
+	zbx_lld_graph_t		*graph;
+	int			i, index;
+	unsigned char		op;
+	zbx_uint32_t		result_alloc = ZBX_KIBIBYTE * 64;
+
+	*result = (unsigned char *)zbx_malloc(NULL, result_alloc);
+	*result_len = 0;
+
+	for (i = row_from; i < row_to; i++)
+	{
+		graph = lld_graph_make(make->gitems_proto, make->graphs, make->items, make->name_proto,
+				make->ymin_itemid_proto, make->ymax_itemid_proto,
+				(const zbx_lld_row_t *)make->lld_rows->values[i], make->lld_macro_paths);
+
+		index = FAIL;
+
+		if (NULL == graph)
+			op = ZBX_LLD_GRAPH_SHARD_NONE;
+		else if (0 == graph->graphid)
+			op = ZBX_LLD_GRAPH_SHARD_NEW;
+		else
+		{
+			void	**ptr;
+
+			op = ZBX_LLD_GRAPH_SHARD_UPDATE;
+
+			/* existing graphs are sorted by identifier and precede new graphs */
+			if (NULL != (ptr = (void **)bsearch(&graph, make->graphs->values, make->graphs_num,
+					sizeof(void *), ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+			{
+				index = (int)(ptr - make->graphs->values);
+			}
+		}
+
+		lld_graph_shard_serialize(result, &result_alloc, result_len, i, op, index, graph);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: deserializes graph made by lld shard process                      *
+ *                                                                            *
+ * Parameters: data  - [IN] the serialized graph                              *
+ *             index - [OUT] the existing graph index                         *
+ *             graph - [OUT] the deserialized graph                           *
+ *                                                                            *
+ * Return value: the number of bytes parsed                                   *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	lld_graph_shard_deserialize(const unsigned char *data, int *index, zbx_lld_graph_t **graph)
+{
+	const unsigned char	*ptr = data;
+	zbx_uint32_t		value_len;
+	int			i, gitems_num;
+
+	*graph = (zbx_lld_graph_t *)zbx_malloc(NULL, sizeof(zbx_lld_graph_t));
+	(*graph)->graphid = 0;
+	(*graph)->name_orig = NULL;
+	zbx_vector_ptr_create(&(*graph)->gitems);
+
+	ptr += zbx_deserialize_value(ptr, index);
+	ptr += zbx_deserialize_value(ptr, &(*graph)->flags);
+	ptr += zbx_deserialize_str(ptr, &(*graph)->name, value_len);
+	ptr += zbx_deserialize_value(ptr, &(*graph)->ymin_itemid);
+	ptr += zbx_deserialize_value(ptr, &(*graph)->ymax_itemid);
+	ptr += zbx_deserialize_value(ptr, &gitems_num);
+
+	for (i = 0; i < gitems_num; i++)
+	{
+		zbx_lld_gitem_t	*gitem;
+
+		gitem = (zbx_lld_gitem_t *)zbx_malloc(NULL, sizeof(zbx_lld_gitem_t));
+		gitem->gitemid = 0;
+
+		ptr += zbx_deserialize_value(ptr, &gitem->itemid);
+		ptr += zbx_deserialize_str(ptr, &gitem->color, value_len);
+		ptr += zbx_deserialize_value(ptr, &gitem->sortorder);
+		ptr += zbx_deserialize_value(ptr, &gitem->drawtype);
+		ptr += zbx_deserialize_value(ptr, &gitem->yaxisside);
+		ptr += zbx_deserialize_value(ptr, &gitem->calc_fnc);
+		ptr += zbx_deserialize_value(ptr, &gitem->type);
+		ptr += zbx_deserialize_value(ptr, &gitem->flags);
+
+		zbx_vector_ptr_append(&(*graph)->gitems, gitem);
+	}
+
+	return (zbx_uint32_t)(ptr - data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies graph made by lld shard process to existing graph         *
+ *                                                                            *
+ * Parameters: graph      - [IN/OUT] the existing graph                       *
+ *             graph_made - [IN/OUT] the graph made by shard, its data are    *
+ *                                   moved to the existing graph              *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_graph_shard_apply(zbx_lld_graph_t *graph, zbx_lld_graph_t *graph_made)
 {
 	int	i;
 
-	for (i = 0; i < lld_rows->values_num; i++)
+	if (0 != (graph_made->flags & ZBX_FLAG_LLD_GRAPH_UPDATE_NAME))
+	{
+		graph->name_orig = graph->name;
+		graph->name = graph_made->name;
+		graph_made->name = NULL;
+	}
+
+	graph->ymin_itemid = graph_made->ymin_itemid;
+	graph->ymax_itemid = graph_made->ymax_itemid;
+	graph->flags = graph_made->flags;
+
+	/* existing graph items are updated in place, the rest are new */
+	for (i = 0; i < graph_made->gitems.values_num; i++)
+	{
+		zbx_lld_gitem_t	*gitem, *gitem_made = (zbx_lld_gitem_t *)graph_made->gitems.values[i];
+
+		if (i >= graph->gitems.values_num)
+		{
+			zbx_vector_ptr_append(&graph->gitems, gitem_made);
+			graph_made->gitems.values[i] = NULL;
+			continue;
+		}
+
+		gitem = (zbx_lld_gitem_t *)graph->gitems.values[i];
+
+		gitem->itemid = gitem_made->itemid;
+		zbx_free(gitem->color);
+		gitem->color = gitem_made->color;
+		gitem_made->color = NULL;
+		gitem->sortorder = gitem_made->sortorder;
+		gitem->drawtype = gitem_made->drawtype;
+		gitem->yaxisside = gitem_made->yaxisside;
+		gitem->calc_fnc = gitem_made->calc_fnc;
+		gitem->type = gitem_made->type;
+		gitem->flags = gitem_made->flags;
+	}
+
+	for (i = 0; i < graph_made->gitems.values_num; i++)
+	{
+		if (NULL != graph_made->gitems.values[i])
+			lld_gitem_free((zbx_lld_gitem_t *)graph_made->gitems.values[i]);
+	}
+
+	graph_made->gitems.values_num = 0;
+	lld_graph_free(graph_made);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies graphs made by lld shard process                          *
+ *                                                                            *
+ * Parameters: data       - [IN] the graph make data                          *
+ *             row_from   - [IN] the first row index                          *
+ *             row_to     - [IN] the index after the last row                 *
+ *             result     - [IN] the serialized graphs                        *
+ *             result_len - [IN] the result length                            *
+ *                                                                            *
+ * Comments: Shard matches rows to existing graphs without seeing graphs      *
+ *           claimed by the preceding shards. A row that matched an already   *
+ *           claimed graph is made again by the worker, as are all rows after *
+ *           any graph failed to be made.                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_graphs_make_merge(void *data, int row_from, int row_to, const unsigned char *result,
+		zbx_uint32_t result_len)
+{
+	zbx_lld_graphs_make_t	*make = (zbx_lld_graphs_make_t *)data;
+	const unsigned char	*ptr = result, *end = result + result_len;
+	zbx_lld_graph_t		*graph, *graph_made;
+	int			row, index;
+	unsigned char		op;
+
+	ZBX_UNUSED(row_from);
+	ZBX_UNUSED(row_to);
+
+	while (ptr < end)
 	{
-		zbx_lld_row_t	*lld_row = (zbx_lld_row_t *)lld_rows->values[i];
+		ptr += zbx_deserialize_value(ptr, &row);
+		ptr += zbx_deserialize_value(ptr, &op);
+
+		if (ZBX_LLD_GRAPH_SHARD_NONE == op)
+		{
+			if (0 != make->failed)
+				lld_graphs_make_rows(make, row, row + 1);
+
+			continue;
+		}
+
+		ptr += lld_graph_shard_deserialize(ptr, &index, &graph_made);
+		graph = NULL;
+
+		if (ZBX_LLD_GRAPH_SHARD_UPDATE == op)
+		{
+			if (0 > index || index >= make->graphs_num)
+			{
+				THIS_SHOULD_NEVER_HAPPEN;
+				make->failed = 1;
+			}
+			else
+				graph = (zbx_lld_graph_t *)make->graphs->values[index];
+		}
+
+		if (0 != make->failed || (ZBX_LLD_GRAPH_SHARD_UPDATE == op &&
+				0 != (graph->flags & ZBX_FLAG_LLD_GRAPH_DISCOVERED)))
+		{
+			lld_graph_free(graph_made);
+			lld_graphs_make_rows(make, row, row + 1);
+			continue;
+		}
 
-		lld_graph_make(gitems_proto, graphs, items, name_proto, ymin_itemid_proto, ymax_itemid_proto, lld_row,
-				lld_macro_paths);
+		if (ZBX_LLD_GRAPH_SHARD_NEW == op)
+		{
+			graph = graph_made;
+			zbx_vector_ptr_append(make->graphs, graph);
+		}
+		else
+			lld_graph_shard_apply(graph, graph_made);
+
+		if (0 == (graph->flags & ZBX_FLAG_LLD_GRAPH_DISCOVERED))
+			make->failed = 1;
 	}
+}
+
+static void	lld_graphs_make(const zbx_vector_ptr_t *gitems_proto, zbx_vector_ptr_t *graphs, zbx_vector_ptr_t *items,
+		const char *name_proto, zbx_uint64_t ymin_itemid_proto, zbx_uint64_t ymax_itemid_proto,
+		const zbx_vector_ptr_t *lld_rows, const zbx_vector_ptr_t *lld_macro_paths)
+{
+	zbx_lld_graphs_make_t	make;
+
+	make.gitems_proto = gitems_proto;
+	make.graphs = graphs;
+	make.items = items;
+	make.name_proto = name_proto;
+	make.ymin_itemid_proto = ymin_itemid_proto;
+	make.ymax_itemid_proto = ymax_itemid_proto;
+	make.lld_rows = lld_rows;
+	make.lld_macro_paths = lld_macro_paths;
+	make.graphs_num = graphs->values_num;
+	make.failed = 0;
+
+	lld_make_sharded(lld_rows->values_num, lld_graphs_make_rows, lld_graphs_make_serialize, lld_graphs_make_merge,
+			&make);
 
 	zbx_vector_ptr_sort(graphs, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
 }
@@ -24,6 +24,7 @@
 #include "zbxserver.h"
 #include "zbxregexp.h"
 #include "zbxprometheus.h"
+#include "zbxserialize.h"
 
 typedef struct
 {
@@ -80,7 +81,6 @@ typedef struct
 	unsigned char		snmpv3_privprotocol;
 	unsigned char		authtype;
 	unsigned char		allow_traps;
-	zbx_vector_ptr_t	lld_rows;
 	zbx_vector_ptr_t	applications;
 	zbx_vector_ptr_t	preproc_ops;
 }
@@ -156,6 +156,23 @@ typedef struct
 #define ZBX_FLAG_LLD_ITEM_UPDATE_VERIFY_HOST		__UINT64_C(0x0040000000000000)
 #define ZBX_FLAG_LLD_ITEM_UPDATE_ALLOW_TRAPS		__UINT64_C(0x0080000000000000)
 #define ZBX_FLAG_LLD_ITEM_UPDATE			(~ZBX_FLAG_LLD_ITEM_DISCOVERED)
+
+/* fields updated with the item prototype values, the same for all items discovered by the prototype */
+#define ZBX_FLAG_LLD_ITEM_UPDATE_PROTOTYPE								\
+		(ZBX_FLAG_LLD_ITEM_UPDATE_TYPE | ZBX_FLAG_LLD_ITEM_UPDATE_VALUE_TYPE |			\
+		ZBX_FLAG_LLD_ITEM_UPDATE_TRAPPER_HOSTS | ZBX_FLAG_LLD_ITEM_UPDATE_FORMULA |		\
+		ZBX_FLAG_LLD_ITEM_UPDATE_LOGTIMEFMT | ZBX_FLAG_LLD_ITEM_UPDATE_VALUEMAPID |		\
+		ZBX_FLAG_LLD_ITEM_UPDATE_SNMP_COMMUNITY | ZBX_FLAG_LLD_ITEM_UPDATE_PORT |		\
+		ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_SECURITYNAME | ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_SECURITYLEVEL |	\
+		ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_AUTHPROTOCOL | ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_AUTHPASSPHRASE |	\
+		ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_PRIVPROTOCOL | ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_PRIVPASSPHRASE |	\
+		ZBX_FLAG_LLD_ITEM_UPDATE_AUTHTYPE | ZBX_FLAG_LLD_ITEM_UPDATE_PUBLICKEY |		\
+		ZBX_FLAG_LLD_ITEM_UPDATE_PRIVATEKEY | ZBX_FLAG_LLD_ITEM_UPDATE_INTERFACEID |		\
+		ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_CONTEXTNAME | ZBX_FLAG_LLD_ITEM_UPDATE_FOLLOW_REDIRECTS |	\
+		ZBX_FLAG_LLD_ITEM_UPDATE_POST_TYPE | ZBX_FLAG_LLD_ITEM_UPDATE_RETRIEVE_MODE |		\
+		ZBX_FLAG_LLD_ITEM_UPDATE_REQUEST_METHOD | ZBX_FLAG_LLD_ITEM_UPDATE_OUTPUT_FORMAT |	\
+		ZBX_FLAG_LLD_ITEM_UPDATE_VERIFY_PEER | ZBX_FLAG_LLD_ITEM_UPDATE_VERIFY_HOST |		\
+		ZBX_FLAG_LLD_ITEM_UPDATE_ALLOW_TRAPS)
 	zbx_uint64_t		flags;
 	char			*key_proto;
 	char			*name;
@@ -249,6 +266,76 @@ typedef struct
 }
 zbx_lld_item_index_t;
 
+/* lld row index by prototype (parent) id and item prototype key with substituted row macros */
+typedef struct
+{
+	zbx_uint64_t	parent_itemid;
+	char		*key;
+	zbx_lld_row_t	*lld_row;
+}
+zbx_lld_item_row_key_t;
+
+/* item string fields set from item prototype with lld macros substituted */
+typedef struct
+{
+	size_t		offset;
+	size_t		orig_offset;
+	zbx_uint64_t	flag;
+}
+zbx_lld_item_field_t;
+
+#define LLD_ITEM_FIELD_DEF(field, orig, flag)	{offsetof(zbx_lld_item_t, field), offsetof(zbx_lld_item_t, orig), flag}
+#define LLD_ITEM_FIELD(item, offset)		((char **)((char *)(item) + (offset)))
+
+static const zbx_lld_item_field_t	lld_item_fields[] = {
+	LLD_ITEM_FIELD_DEF(name, name_proto, ZBX_FLAG_LLD_ITEM_UPDATE_NAME),
+	LLD_ITEM_FIELD_DEF(key, key_orig, ZBX_FLAG_LLD_ITEM_UPDATE_KEY),
+	LLD_ITEM_FIELD_DEF(delay, delay_orig, ZBX_FLAG_LLD_ITEM_UPDATE_DELAY),
+	LLD_ITEM_FIELD_DEF(history, history_orig, ZBX_FLAG_LLD_ITEM_UPDATE_HISTORY),
+	LLD_ITEM_FIELD_DEF(trends, trends_orig, ZBX_FLAG_LLD_ITEM_UPDATE_TRENDS),
+	LLD_ITEM_FIELD_DEF(units, units_orig, ZBX_FLAG_LLD_ITEM_UPDATE_UNITS),
+	LLD_ITEM_FIELD_DEF(params, params_orig, ZBX_FLAG_LLD_ITEM_UPDATE_PARAMS),
+	LLD_ITEM_FIELD_DEF(username, username_orig, ZBX_FLAG_LLD_ITEM_UPDATE_USERNAME),
+	LLD_ITEM_FIELD_DEF(password, password_orig, ZBX_FLAG_LLD_ITEM_UPDATE_PASSWORD),
+	LLD_ITEM_FIELD_DEF(ipmi_sensor, ipmi_sensor_orig, ZBX_FLAG_LLD_ITEM_UPDATE_IPMI_SENSOR),
+	LLD_ITEM_FIELD_DEF(snmp_oid, snmp_oid_orig, ZBX_FLAG_LLD_ITEM_UPDATE_SNMP_OID),
+	LLD_ITEM_FIELD_DEF(description, description_orig, ZBX_FLAG_LLD_ITEM_UPDATE_DESCRIPTION),
+	LLD_ITEM_FIELD_DEF(jmx_endpoint, jmx_endpoint_orig, ZBX_FLAG_LLD_ITEM_UPDATE_JMX_ENDPOINT),
+	LLD_ITEM_FIELD_DEF(timeout, timeout_orig, ZBX_FLAG_LLD_ITEM_UPDATE_TIMEOUT),
+	LLD_ITEM_FIELD_DEF(url, url_orig, ZBX_FLAG_LLD_ITEM_UPDATE_URL),
+	LLD_ITEM_FIELD_DEF(query_fields, query_fields_orig, ZBX_FLAG_LLD_ITEM_UPDATE_QUERY_FIELDS),
+	LLD_ITEM_FIELD_DEF(posts, posts_orig, ZBX_FLAG_LLD_ITEM_UPDATE_POSTS),
+	LLD_ITEM_FIELD_DEF(status_codes, status_codes_orig, ZBX_FLAG_LLD_ITEM_UPDATE_STATUS_CODES),
+	LLD_ITEM_FIELD_DEF(http_proxy, http_proxy_orig, ZBX_FLAG_LLD_ITEM_UPDATE_HTTP_PROXY),
+	LLD_ITEM_FIELD_DEF(headers, headers_orig, ZBX_FLAG_LLD_ITEM_UPDATE_HEADERS),
+	LLD_ITEM_FIELD_DEF(ssl_cert_file, ssl_cert_file_orig, ZBX_FLAG_LLD_ITEM_UPDATE_SSL_CERT_FILE),
+	LLD_ITEM_FIELD_DEF(ssl_key_file, ssl_key_file_orig, ZBX_FLAG_LLD_ITEM_UPDATE_SSL_KEY_FILE),
+	LLD_ITEM_FIELD_DEF(ssl_key_password, ssl_key_password_orig, ZBX_FLAG_LLD_ITEM_UPDATE_SSL_KEY_PASSWORD)
+};
+
+/* item make data, passed to lld shard callbacks */
+typedef struct
+{
+	const zbx_vector_ptr_t	*item_prototypes;
+	zbx_vector_ptr_t	*lld_rows;
+	const zbx_vector_ptr_t	*lld_macro_paths;
+	zbx_vector_ptr_t	*items;
+	zbx_hashset_t		*items_index;
+	char			**error;
+}
+zbx_lld_items_make_t;
+
+/* item validation data, passed to lld shard callbacks */
+typedef struct
+{
+	zbx_vector_ptr_t	*items;
+	char			**error;
+}
+zbx_lld_items_validate_t;
+
+#define ZBX_LLD_ITEM_SHARD_NEW		0
+#define ZBX_LLD_ITEM_SHARD_UPDATE	1
+
 typedef struct
 {
 	zbx_uint64_t	application_prototypeid;
@@ -324,6 +411,32 @@ typedef struct
 }
 zbx_lld_application_index_t;
 
+/* item row keys index hashset support functions */
+static zbx_hash_t	lld_item_row_key_hash_func(const void *data)
+{
+	const zbx_lld_item_row_key_t	*row_key = (const zbx_lld_item_row_key_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_ALGO(&row_key->parent_itemid, sizeof(row_key->parent_itemid),
+			ZBX_DEFAULT_HASH_SEED);
+	return ZBX_DEFAULT_STRING_HASH_ALGO(row_key->key, strlen(row_key->key), hash);
+}
+
+static int	lld_item_row_key_compare_func(const void *d1, const void *d2)
+{
+	const zbx_lld_item_row_key_t	*k1 = (const zbx_lld_item_row_key_t *)d1;
+	const zbx_lld_item_row_key_t	*k2 = (const zbx_lld_item_row_key_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(k1->parent_itemid, k2->parent_itemid);
+
+	return strcmp(k1->key, k2->key);
+}
+
+static void	lld_item_row_key_clean(zbx_lld_item_row_key_t *row_key)
+{
+	zbx_free(row_key->key);
+}
+
 /* items index hashset support functions */
 static zbx_hash_t	lld_item_index_hash_func(const void *data)
 {
@@ -505,8 +618,6 @@ static void	lld_item_prototype_free(zbx_lld_item_prototype_t *item_prototype)
 	zbx_free(item_prototype->ssl_key_file);
 	zbx_free(item_prototype->ssl_key_password);
 
-	zbx_vector_ptr_destroy(&item_prototype->lld_rows);
-
 	zbx_vector_ptr_clear_ext(&item_prototype->applications, zbx_default_mem_free_func);
 	zbx_vector_ptr_destroy(&item_prototype->applications);
 
@@ -1495,6 +1606,150 @@ static int	lld_items_preproc_step_validate(const zbx_lld_item_preproc_t * pp, zb
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: validates preprocessing steps of the specified item range         *
+ *                                                                            *
+ * Parameters: data      - [IN] the item validation data                      *
+ *             item_from - [IN] the first item index                          *
+ *             item_to   - [IN] the index after the last item                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_items_preproc_validate(void *data, int item_from, int item_to)
+{
+	zbx_lld_items_validate_t	*validate = (zbx_lld_items_validate_t *)data;
+	zbx_lld_item_t			*item;
+	int				i, j;
+
+	for (i = item_from; i < item_to; i++)
+	{
+		item = (zbx_lld_item_t *)validate->items->values[i];
+
+		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED))
+			continue;
+
+		for (j = 0; j < item->preproc_ops.values_num; j++)
+		{
+			if (SUCCEED != lld_items_preproc_step_validate(item->preproc_ops.values[j], item->itemid,
+					validate->error))
+			{
+				item->flags &= ~ZBX_FLAG_LLD_ITEM_DISCOVERED;
+				break;
+			}
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: validates preprocessing steps of the specified item range and     *
+ *          serializes the failed items                                       *
+ *                                                                            *
+ * Parameters: data       - [IN] the item validation data                     *
+ *             item_from  - [IN] the first item index                         *
+ *             item_to    - [IN] the index after the last item                *
+ *             result     - [OUT] the serialized failed item indexes and      *
+ *                                validation errors                           *
+ *             result_len - [OUT] the result length                           *
+ *                                                                            *
+ * Comments: This function is called in lld shard process.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_items_preproc_validate_serialize(void *data, int item_from, int item_to, unsigned char **result,
+		zbx_uint32_t *result_len)
+{
+	zbx_lld_items_validate_t	*validate = (zbx_lld_items_validate_t *)data;
+	zbx_lld_item_t			*item;
+	int				i, j;
+	char				*error;
+	unsigned char			*ptr;
+	zbx_uint32_t			len, error_len, result_alloc = ZBX_KIBIBYTE * 64;
+
+	*result = (unsigned char *)zbx_malloc(NULL, result_alloc);
+	*result_len = 0;
+
+	for (i = item_from; i < item_to; i++)
+	{
+		item = (zbx_lld_item_t *)validate->items->values[i];
+
+		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED))
+			continue;
+
+		error = NULL;
+
+		for (j = 0; j < item->preproc_ops.values_num; j++)
+		{
+			if (SUCCEED != lld_items_preproc_step_validate(item->preproc_ops.values[j], item->itemid,
+					&error))
+			{
+				break;
+			}
+		}
+
+		if (j == item->preproc_ops.values_num)
+			continue;
+
+		len = 0;
+		zbx_serialize_prepare_value(len, i);
+		zbx_serialize_prepare_str_len(len, error, error_len);
+
+		while (len > result_alloc - *result_len)
+		{
+			result_alloc *= 2;
+			*result = (unsigned char *)zbx_realloc(*result, result_alloc);
+		}
+
+		ptr = *result + *result_len;
+		*result_len += len;
+
+		ptr += zbx_serialize_value(ptr, i);
+		(void)zbx_serialize_str(ptr, error, error_len);
+
+		zbx_free(error);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies preprocessing validation results of lld shard process     *
+ *                                                                            *
+ * Parameters: data       - [IN] the item validation data                     *
+ *             item_from  - [IN] the first item index                         *
+ *             item_to    - [IN] the index after the last item                *
+ *             result     - [IN] the serialized failed item indexes and       *
+ *                               validation errors                            *
+ *             result_len - [IN] the result length                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_items_preproc_validate_merge(void *data, int item_from, int item_to, const unsigned char *result,
+		zbx_uint32_t result_len)
+{
+	zbx_lld_items_validate_t	*validate = (zbx_lld_items_validate_t *)data;
+	const unsigned char		*ptr = result, *end = result + result_len;
+	zbx_lld_item_t			*item;
+	int				index;
+	char				*error;
+	zbx_uint32_t			value_len;
+
+	ZBX_UNUSED(item_from);
+	ZBX_UNUSED(item_to);
+
+	while (ptr < end)
+	{
+		ptr += zbx_deserialize_value(ptr, &index);
+		ptr += zbx_deserialize_str(ptr, &error, value_len);
+
+		item = (zbx_lld_item_t *)validate->items->values[index];
+		item->flags &= ~ZBX_FLAG_LLD_ITEM_DISCOVERED;
+
+		if (NULL != error)
+		{
+			*validate->error = zbx_strdcat(*validate->error, error);
+			zbx_free(error);
+		}
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Parameters: hostid            - [IN] host id                               *
@@ -1507,13 +1762,14 @@ static int	lld_items_preproc_step_validate(const zbx_lld_item_preproc_t * pp, zb
 static void	lld_items_validate(zbx_uint64_t hostid, zbx_vector_ptr_t *items, zbx_vector_ptr_t *item_prototypes,
 		zbx_vector_ptr_t *item_dependencies, char **error)
 {
-	DB_RESULT		result;
-	DB_ROW			row;
-	int			i, j;
-	zbx_lld_item_t		*item;
-	zbx_vector_uint64_t	itemids;
-	zbx_vector_str_t	keys;
-	zbx_hashset_t		items_keys;
+	DB_RESULT			result;
+	DB_ROW				row;
+	int				i, j;
+	zbx_lld_item_t			*item;
+	zbx_vector_uint64_t		itemids;
+	zbx_vector_str_t		keys;
+	zbx_hashset_t			items_keys;
+	zbx_lld_items_validate_t	validate;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1623,25 +1879,13 @@ static void	lld_items_validate(zbx_uint64_t hostid, zbx_vector_ptr_t *items, zbx
 
 	zbx_hashset_destroy(&items_keys);
 
-	/* check preprocessing steps for new and updated discovered items */
-	for (i = 0; i < items->values_num; i++)
-	{
-		item = (zbx_lld_item_t *)items->values[i];
-
-		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED))
-			continue;
-
-		for (j = 0; j < item->preproc_ops.values_num; j++)
-		{
-			if (SUCCEED != lld_items_preproc_step_validate(item->preproc_ops.values[j], item->itemid,
-					error))
-			{
-				item->flags &= ~ZBX_FLAG_LLD_ITEM_DISCOVERED;
-				break;
-			}
-		}
-	}
+	/* check preprocessing steps for new and updated discovered items, compiling */
+	/* regular expressions and paths of large item sets is split between shards  */
+	validate.items = items;
+	validate.error = error;
 
+	lld_make_sharded(items->values_num, lld_items_preproc_validate, lld_items_preproc_validate_serialize,
+			lld_items_preproc_validate_merge, &validate);
 
 	/* check duplicated keys in DB */
 	for (i = 0; i < items->values_num; i++)
@@ -2395,43 +2639,352 @@ static void	lld_item_update(const zbx_lld_item_prototype_t *item_prototype, cons
 
 /******************************************************************************
  *                                                                            *
- * Purpose: updates existing items and creates new ones based on item         *
- *          item prototypes and lld data                                      *
+ * Purpose: makes items of the specified lld row range                        *
+ *                                                                            *
+ * Parameters: data     - [IN] the item make data                             *
+ *             row_from - [IN] the first row index                            *
+ *             row_to   - [IN] the index after the last row                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_items_make_rows(void *data, int row_from, int row_to)
+{
+	zbx_lld_items_make_t		*make = (zbx_lld_items_make_t *)data;
+	int				i, j;
+	zbx_lld_item_prototype_t	*item_prototype;
+	zbx_lld_item_t			*item;
+	zbx_lld_item_index_t		*item_index, item_index_local;
+
+	for (i = 0; i < make->item_prototypes->values_num; i++)
+	{
+		item_prototype = (zbx_lld_item_prototype_t *)make->item_prototypes->values[i];
+		item_index_local.parent_itemid = item_prototype->itemid;
+
+		for (j = row_from; j < row_to; j++)
+		{
+			item_index_local.lld_row = (zbx_lld_row_t *)make->lld_rows->values[j];
+
+			if (NULL == (item_index = (zbx_lld_item_index_t *)zbx_hashset_search(make->items_index,
+					&item_index_local)))
+			{
+				if (NULL != (item = lld_item_make(item_prototype, item_index_local.lld_row,
+						make->lld_macro_paths, make->error)))
+				{
+					/* add the created item to items vector and update index */
+					zbx_vector_ptr_append(make->items, item);
+					item_index_local.item = item;
+					zbx_hashset_insert(make->items_index, &item_index_local, sizeof(item_index_local));
+				}
+			}
+			else
+			{
+				lld_item_update(item_prototype, item_index_local.lld_row, make->lld_macro_paths,
+						item_index->item, make->error);
+			}
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes made item fields                                       *
+ *                                                                            *
+ * Parameters: data        - [IN/OUT] the serialization buffer                *
+ *             data_alloc  - [IN/OUT] the buffer size                         *
+ *             data_offset - [IN/OUT] the buffer offset                       *
+ *             op          - [IN] ZBX_LLD_ITEM_SHARD_NEW - new item, all      *
+ *                                fields are serialized                       *
+ *                                ZBX_LLD_ITEM_SHARD_UPDATE - existing item,  *
+ *                                only the updated fields are serialized      *
+ *             prototype   - [IN] the item prototype index                    *
+ *             row         - [IN] the lld row index                           *
+ *             item        - [IN] the item                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_item_shard_serialize(unsigned char **data, zbx_uint32_t *data_alloc, zbx_uint32_t *data_offset,
+		unsigned char op, int prototype, int row, const zbx_lld_item_t *item)
+{
+	zbx_uint32_t	len = 0, fields_len[ARRSIZE(lld_item_fields)];
+	zbx_uint64_t	flags = item->flags & ZBX_FLAG_LLD_ITEM_UPDATE;
+	unsigned char	*ptr;
+	size_t		i;
+	char		*value;
+
+	zbx_serialize_prepare_value(len, op);
+	zbx_serialize_prepare_value(len, prototype);
+	zbx_serialize_prepare_value(len, row);
+	zbx_serialize_prepare_value(len, flags);
+
+	for (i = 0; i < ARRSIZE(lld_item_fields); i++)
+	{
+		if (ZBX_LLD_ITEM_SHARD_UPDATE == op && 0 == (flags & lld_item_fields[i].flag))
+			continue;
+
+		value = *LLD_ITEM_FIELD(item, lld_item_fields[i].offset);
+		zbx_serialize_prepare_str_len(len, value, fields_len[i]);
+	}
+
+	while (len > *data_alloc - *data_offset)
+	{
+		*data_alloc *= 2;
+		*data = (unsigned char *)zbx_realloc(*data, *data_alloc);
+	}
+
+	ptr = *data + *data_offset;
+	*data_offset += len;
+
+	ptr += zbx_serialize_value(ptr, op);
+	ptr += zbx_serialize_value(ptr, prototype);
+	ptr += zbx_serialize_value(ptr, row);
+	ptr += zbx_serialize_value(ptr, flags);
+
+	for (i = 0; i < ARRSIZE(lld_item_fields); i++)
+	{
+		if (ZBX_LLD_ITEM_SHARD_UPDATE == op && 0 == (flags & lld_item_fields[i].flag))
+			continue;
+
+		value = *LLD_ITEM_FIELD(item, lld_item_fields[i].offset);
+		ptr += zbx_serialize_str(ptr, value, fields_len[i]);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes items of the specified lld row range and serializes them    *
+ *                                                                            *
+ * Parameters: data       - [IN] the item make data                           *
+ *             row_from   - [IN] the first row index                          *
+ *             row_to     - [IN] the index after the last row                 *
+ *             result     - [OUT] the serialized items                        *
+ *             result_len - [OUT] the result length                           *
+ *                                                                            *
+ * Comments: This function is called in lld shard process. The error message  *
+ *           is serialized first, followed by new and updated items.          *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_items_make_serialize(void *data, int row_from, int row_to, unsigned char **result,
+		zbx_uint32_t *result_len)
+{
+	zbx_lld_items_make_t		*make = (zbx_lld_items_make_t *)data;
+	int				i, j;
+	zbx_lld_item_prototype_t	*item_prototype;
+	zbx_lld_item_t			*item;
+	zbx_lld_item_index_t		*item_index, item_index_local;
+	char				*error = NULL;
+	unsigned char			*items = NULL, *ptr;
+	zbx_uint32_t			items_alloc = ZBX_KIBIBYTE * 64, items_offset = 0, error_len = 0;
+
+	items = (unsigned char *)zbx_malloc(NULL, items_alloc);
+
+	for (i = 0; i < make->item_prototypes->values_num; i++)
+	{
+		item_prototype = (zbx_lld_item_prototype_t *)make->item_prototypes->values[i];
+		item_index_local.parent_itemid = item_prototype->itemid;
+
+		for (j = row_from; j < row_to; j++)
+		{
+			item_index_local.lld_row = (zbx_lld_row_t *)make->lld_rows->values[j];
+
+			if (NULL == (item_index = (zbx_lld_item_index_t *)zbx_hashset_search(make->items_index,
+					&item_index_local)))
+			{
+				if (NULL != (item = lld_item_make(item_prototype, item_index_local.lld_row,
+						make->lld_macro_paths, &error)))
+				{
+					lld_item_shard_serialize(&items, &items_alloc, &items_offset,
+							ZBX_LLD_ITEM_SHARD_NEW, i, j, item);
+					lld_item_free(item);
+				}
+			}
+			else
+			{
+				lld_item_update(item_prototype, item_index_local.lld_row, make->lld_macro_paths,
+						item_index->item, &error);
+				lld_item_shard_serialize(&items, &items_alloc, &items_offset,
+						ZBX_LLD_ITEM_SHARD_UPDATE, i, j, item_index->item);
+			}
+		}
+	}
+
+	zbx_serialize_prepare_str(*result_len, error);
+	*result_len += items_offset;
+
+	ptr = *result = (unsigned char *)zbx_malloc(NULL, *result_len);
+	ptr += zbx_serialize_str(ptr, error, error_len);
+	memcpy(ptr, items, items_offset);
+
+	zbx_free(items);
+	zbx_free(error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies items made by lld shard process                           *
+ *                                                                            *
+ * Parameters: data       - [IN] the item make data                           *
+ *             row_from   - [IN] the first row index                          *
+ *             row_to     - [IN] the index after the last row                 *
+ *             result     - [IN] the serialized items                         *
+ *             result_len - [IN] the result length                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_items_make_merge(void *data, int row_from, int row_to, const unsigned char *result,
+		zbx_uint32_t result_len)
+{
+	zbx_lld_items_make_t		*make = (zbx_lld_items_make_t *)data;
+	const unsigned char		*ptr = result, *end = result + result_len;
+	char				*error, *value, **field;
+	zbx_uint32_t			value_len;
+	unsigned char			op;
+	int				prototype, row;
+	size_t				i;
+	zbx_uint64_t			flags;
+	zbx_lld_item_prototype_t	*item_prototype;
+	zbx_lld_item_t			*item;
+	zbx_lld_item_index_t		*item_index, item_index_local;
+
+	ZBX_UNUSED(row_from);
+	ZBX_UNUSED(row_to);
+
+	ptr += zbx_deserialize_str(ptr, &error, value_len);
+
+	if (NULL != error)
+	{
+		*make->error = zbx_strdcat(*make->error, error);
+		zbx_free(error);
+	}
+
+	while (ptr < end)
+	{
+		ptr += zbx_deserialize_value(ptr, &op);
+		ptr += zbx_deserialize_value(ptr, &prototype);
+		ptr += zbx_deserialize_value(ptr, &row);
+		ptr += zbx_deserialize_value(ptr, &flags);
+
+		item_prototype = (zbx_lld_item_prototype_t *)make->item_prototypes->values[prototype];
+		item_index_local.parent_itemid = item_prototype->itemid;
+		item_index_local.lld_row = (zbx_lld_row_t *)make->lld_rows->values[row];
+
+		if (ZBX_LLD_ITEM_SHARD_NEW == op)
+		{
+			item = (zbx_lld_item_t *)zbx_malloc(NULL, sizeof(zbx_lld_item_t));
+			memset(item, 0, sizeof(zbx_lld_item_t));
+
+			item->parent_itemid = item_prototype->itemid;
+			item->type = item_prototype->type;
+			item->master_itemid = item_prototype->master_itemid;
+			item->flags = ZBX_FLAG_LLD_ITEM_DISCOVERED;
+			item->lld_row = item_index_local.lld_row;
+
+			zbx_vector_ptr_create(&item->preproc_ops);
+			zbx_vector_ptr_create(&item->dependent_items);
+
+			for (i = 0; i < ARRSIZE(lld_item_fields); i++)
+				ptr += zbx_deserialize_str(ptr, LLD_ITEM_FIELD(item, lld_item_fields[i].offset), value_len);
+
+			zbx_vector_ptr_append(make->items, item);
+			item_index_local.item = item;
+			zbx_hashset_insert(make->items_index, &item_index_local, sizeof(item_index_local));
+
+			continue;
+		}
+
+		if (NULL == (item_index = (zbx_lld_item_index_t *)zbx_hashset_search(make->items_index,
+				&item_index_local)))
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			break;
+		}
+
+		item = item_index->item;
+
+		for (i = 0; i < ARRSIZE(lld_item_fields); i++)
+		{
+			if (0 == (flags & lld_item_fields[i].flag))
+				continue;
+
+			ptr += zbx_deserialize_str(ptr, &value, value_len);
+
+			field = LLD_ITEM_FIELD(item, lld_item_fields[i].offset);
+			*LLD_ITEM_FIELD(item, lld_item_fields[i].orig_offset) = *field;
+			*field = value;
+			item->flags |= lld_item_fields[i].flag;
+		}
+
+		item->flags |= ZBX_FLAG_LLD_ITEM_DISCOVERED;
+		item->lld_row = item_index_local.lld_row;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: matches existing items to lld rows                                *
  *                                                                            *
  * Parameters: item_prototypes - [IN] the item prototypes                     *
  *             lld_rows        - [IN] the lld data rows                       *
- *             lld_macro_paths - [IN] use json path to extract from jp_row  *
- *             items           - [IN/OUT] sorted list of items                *
+ *             lld_macro_paths - [IN] use json path to extract from jp_row    *
+ *             items           - [IN] sorted list of items                    *
  *             items_index     - [OUT] index of items based on prototype ids  *
- *                                     and lld rows. Used to quckly find an   *
- *                                     item by prototype and lld_row.         *
- *             error           - [IN/OUT] the lld error message               *
+ *                                     and lld rows                           *
  *                                                                            *
  ******************************************************************************/
-static void	lld_items_make(const zbx_vector_ptr_t *item_prototypes, zbx_vector_ptr_t *lld_rows,
-		const zbx_vector_ptr_t *lld_macro_paths, zbx_vector_ptr_t *items, zbx_hashset_t *items_index,
-		char **error)
+static void	lld_items_index(const zbx_vector_ptr_t *item_prototypes, const zbx_vector_ptr_t *lld_rows,
+		const zbx_vector_ptr_t *lld_macro_paths, const zbx_vector_ptr_t *items, zbx_hashset_t *items_index)
 {
 	int				i, j, index;
 	zbx_lld_item_prototype_t	*item_prototype;
 	zbx_lld_item_t			*item;
 	zbx_lld_row_t			*lld_row;
-	zbx_lld_item_index_t		*item_index, item_index_local;
+	zbx_lld_item_index_t		item_index_local;
+	zbx_lld_item_row_key_t		*row_key, row_key_local;
+	zbx_hashset_t			row_keys;
+	zbx_vector_uint64_t		parent_itemids;
 	char				*buffer = NULL;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zbx_vector_uint64_create(&parent_itemids);
+	zbx_hashset_create_ext(&row_keys, (size_t)items->values_num, lld_item_row_key_hash_func,
+			lld_item_row_key_compare_func, (zbx_clean_func_t)lld_item_row_key_clean,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
 
-	/* create the items index */
-	for (i = 0; i < item_prototypes->values_num; i++)
+	/* index lld rows by item keys of prototypes having discovered items, so existing items */
+	/* can be matched to lld rows without substituting their keys with every row            */
+	for (i = 0; i < items->values_num; i++)
+		zbx_vector_uint64_append(&parent_itemids, ((zbx_lld_item_t *)items->values[i])->parent_itemid);
+
+	zbx_vector_uint64_sort(&parent_itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&parent_itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; i < parent_itemids.values_num; i++)
 	{
-		item_prototype = (zbx_lld_item_prototype_t *)item_prototypes->values[i];
+		if (FAIL == (index = zbx_vector_ptr_bsearch(item_prototypes, &parent_itemids.values[i],
+				ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+		{
+			continue;
+		}
 
-		for (j = 0; j < lld_rows->values_num; j++)
-			zbx_vector_ptr_append(&item_prototype->lld_rows, lld_rows->values[j]);
+		item_prototype = (zbx_lld_item_prototype_t *)item_prototypes->values[index];
+		row_key_local.parent_itemid = item_prototype->itemid;
+
+		/* with duplicate keys the last lld row is matched, so index the rows in reverse order */
+		for (j = lld_rows->values_num - 1; j >= 0; j--)
+		{
+			row_key_local.lld_row = (zbx_lld_row_t *)lld_rows->values[j];
+			row_key_local.key = zbx_strdup(NULL, item_prototype->key);
+
+			if (SUCCEED != substitute_key_macros(&row_key_local.key, NULL, NULL,
+					&row_key_local.lld_row->jp_row, lld_macro_paths, MACRO_TYPE_ITEM_KEY, NULL, 0) ||
+					NULL != zbx_hashset_search(&row_keys, &row_key_local))
+			{
+				zbx_free(row_key_local.key);
+				continue;
+			}
+
+			zbx_hashset_insert(&row_keys, &row_key_local, sizeof(row_key_local));
+		}
 	}
 
-	/* Iterate in reverse order because usually the items are created in the same order as     */
-	/* incoming lld rows. Iterating in reverse optimizes lld_row removal from item prototypes. */
+	/* Iterate in reverse order because usually the items are created in the same order as */
+	/* incoming lld rows. Iterating in reverse optimizes lld row lookup by item prototypes  */
+	/* with changed keys.                                                                   */
 	for (i = items->values_num - 1; i >= 0; i--)
 	{
 		item = (zbx_lld_item_t *)items->values[i];
@@ -2444,59 +2997,90 @@ static void	lld_items_make(const zbx_vector_ptr_t *item_prototypes, zbx_vector_p
 		}
 
 		item_prototype = (zbx_lld_item_prototype_t *)item_prototypes->values[index];
+		item_index_local.parent_itemid = item->parent_itemid;
+		item_index_local.lld_row = NULL;
 
-		for (j = item_prototype->lld_rows.values_num - 1; j >= 0; j--)
+		if (0 == strcmp(item->key_proto, item_prototype->key))
 		{
-			lld_row = (zbx_lld_row_t *)item_prototype->lld_rows.values[j];
-
-			buffer = zbx_strdup(buffer, item->key_proto);
+			row_key_local.parent_itemid = item->parent_itemid;
+			row_key_local.key = item->key;
 
-			if (SUCCEED != substitute_key_macros(&buffer, NULL, NULL, &lld_row->jp_row, lld_macro_paths,
-					MACRO_TYPE_ITEM_KEY, NULL, 0))
+			if (NULL != (row_key = (zbx_lld_item_row_key_t *)zbx_hashset_search(&row_keys, &row_key_local)))
+				item_index_local.lld_row = row_key->lld_row;
+		}
+		else
+		{
+			/* the item was discovered before the prototype key was changed, */
+			/* match it by the key of the prototype it was created from       */
+			for (j = lld_rows->values_num - 1; j >= 0; j--)
 			{
-				continue;
-			}
+				lld_row = (zbx_lld_row_t *)lld_rows->values[j];
 
-			if (0 == strcmp(item->key, buffer))
-			{
-				item_index_local.parent_itemid = item->parent_itemid;
-				item_index_local.lld_row = lld_row;
-				item_index_local.item = item;
-				zbx_hashset_insert(items_index, &item_index_local, sizeof(item_index_local));
+				buffer = zbx_strdup(buffer, item->key_proto);
 
-				zbx_vector_ptr_remove_noorder(&item_prototype->lld_rows, j);
-				break;
+				if (SUCCEED != substitute_key_macros(&buffer, NULL, NULL, &lld_row->jp_row,
+						lld_macro_paths, MACRO_TYPE_ITEM_KEY, NULL, 0))
+				{
+					continue;
+				}
+
+				if (0 == strcmp(item->key, buffer))
+				{
+					item_index_local.lld_row = lld_row;
+					break;
+				}
 			}
 		}
+
+		/* an lld row can be matched by only one item of the same prototype */
+		if (NULL == item_index_local.lld_row || NULL != zbx_hashset_search(items_index, &item_index_local))
+			continue;
+
+		item_index_local.item = item;
+		zbx_hashset_insert(items_index, &item_index_local, sizeof(item_index_local));
 	}
 
+	zbx_hashset_destroy(&row_keys);
+	zbx_vector_uint64_destroy(&parent_itemids);
+
 	zbx_free(buffer);
+}
 
-	/* update/create discovered items */
-	for (i = 0; i < item_prototypes->values_num; i++)
-	{
-		item_prototype = (zbx_lld_item_prototype_t *)item_prototypes->values[i];
-		item_index_local.parent_itemid = item_prototype->itemid;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates existing items and creates new ones based on item         *
+ *          item prototypes and lld data                                      *
+ *                                                                            *
+ * Parameters: item_prototypes - [IN] the item prototypes                     *
+ *             lld_rows        - [IN] the lld data rows                       *
+ *             lld_macro_paths - [IN] use json path to extract from jp_row    *
+ *             items           - [IN/OUT] sorted list of items                *
+ *             items_index     - [OUT] index of items based on prototype ids  *
+ *                                     and lld rows. Used to quckly find an   *
+ *                                     item by prototype and lld_row.         *
+ *             error           - [IN/OUT] the lld error message               *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_items_make(const zbx_vector_ptr_t *item_prototypes, zbx_vector_ptr_t *lld_rows,
+		const zbx_vector_ptr_t *lld_macro_paths, zbx_vector_ptr_t *items, zbx_hashset_t *items_index,
+		char **error)
+{
+	zbx_lld_items_make_t	make;
 
-		for (j = 0; j < lld_rows->values_num; j++)
-		{
-			item_index_local.lld_row = (zbx_lld_row_t *)lld_rows->values[j];
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-			if (NULL == (item_index = (zbx_lld_item_index_t *)zbx_hashset_search(items_index, &item_index_local)))
-			{
-				if (NULL != (item = lld_item_make(item_prototype, item_index_local.lld_row,
-						lld_macro_paths, error)))
-				{
-					/* add the created item to items vector and update index */
-					zbx_vector_ptr_append(items, item);
-					item_index_local.item = item;
-					zbx_hashset_insert(items_index, &item_index_local, sizeof(item_index_local));
-				}
-			}
-			else
-				lld_item_update(item_prototype, item_index_local.lld_row, lld_macro_paths, item_index->item, error);
-		}
-	}
+	lld_items_index(item_prototypes, lld_rows, lld_macro_paths, items, items_index);
+
+	/* update/create discovered items */
+	make.item_prototypes = item_prototypes;
+	make.lld_rows = lld_rows;
+	make.lld_macro_paths = lld_macro_paths;
+	make.items = items;
+	make.items_index = items_index;
+	make.error = error;
+
+	lld_make_sharded(lld_rows->values_num, lld_items_make_rows, lld_items_make_serialize, lld_items_make_merge,
+			&make);
 
 	zbx_vector_ptr_sort(items, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
 
@@ -2786,10 +3370,12 @@ static void	lld_item_save(zbx_uint64_t hostid, const zbx_vector_ptr_t *item_prot
 
 /******************************************************************************
  *                                                                            *
- * Purpose: prepare sql to update LLD item                                    *
+ * Purpose: prepare sql to update LLD item, the update condition must be      *
+ *          added by caller                                                   *
  *                                                                            *
  * Parameters: item_prototype       - [IN] item prototype                     *
  *             item                 - [IN] item to be updated                 *
+ *             flags                - [IN] the fields to update               *
  *             sql                  - [IN/OUT] sql buffer pointer used for    *
  *                                             update operations              *
  *             sql_alloc            - [IN/OUT] sql buffer already allocated   *
@@ -2799,199 +3385,199 @@ static void	lld_item_save(zbx_uint64_t hostid, const zbx_vector_ptr_t *item_prot
  *                                                                            *
  ******************************************************************************/
 static void	lld_item_prepare_update(const zbx_lld_item_prototype_t *item_prototype, const zbx_lld_item_t *item,
-		char **sql, size_t *sql_alloc, size_t *sql_offset)
+		zbx_uint64_t flags, char **sql, size_t *sql_alloc, size_t *sql_offset)
 {
 	char				*value_esc;
 	const char			*d = "";
 
 	zbx_strcpy_alloc(sql, sql_alloc, sql_offset, "update items set ");
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_NAME))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_NAME))
 	{
 		value_esc = DBdyn_escape_string(item->name);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "name='%s'", value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_KEY))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_KEY))
 	{
 		value_esc = DBdyn_escape_string(item->key);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%skey_='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_TYPE))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_TYPE))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%stype=%d", d, (int)item_prototype->type);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_VALUE_TYPE))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_VALUE_TYPE))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%svalue_type=%d", d, (int)item_prototype->value_type);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_DELAY))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_DELAY))
 	{
 		value_esc = DBdyn_escape_string(item->delay);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sdelay='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_HISTORY))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_HISTORY))
 	{
 		value_esc = DBdyn_escape_string(item->history);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%shistory='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_TRENDS))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_TRENDS))
 	{
 		value_esc = DBdyn_escape_string(item->trends);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%strends='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_TRAPPER_HOSTS))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_TRAPPER_HOSTS))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->trapper_hosts);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%strapper_hosts='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_UNITS))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_UNITS))
 	{
 		value_esc = DBdyn_escape_string(item->units);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sunits='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_FORMULA))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_FORMULA))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->formula);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sformula='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_LOGTIMEFMT))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_LOGTIMEFMT))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->logtimefmt);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%slogtimefmt='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_VALUEMAPID))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_VALUEMAPID))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%svaluemapid=%s",
 				d, DBsql_id_ins(item_prototype->valuemapid));
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_PARAMS))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_PARAMS))
 	{
 		value_esc = DBdyn_escape_string(item->params);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sparams='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_IPMI_SENSOR))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_IPMI_SENSOR))
 	{
 		value_esc = DBdyn_escape_string(item->ipmi_sensor);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sipmi_sensor='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMP_COMMUNITY))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMP_COMMUNITY))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->snmp_community);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%ssnmp_community='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMP_OID))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMP_OID))
 	{
 		value_esc = DBdyn_escape_string(item->snmp_oid);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%ssnmp_oid='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_PORT))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_PORT))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->port);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sport='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_SECURITYNAME))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_SECURITYNAME))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->snmpv3_securityname);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%ssnmpv3_securityname='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_SECURITYLEVEL))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_SECURITYLEVEL))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%ssnmpv3_securitylevel=%d", d,
 				(int)item_prototype->snmpv3_securitylevel);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_AUTHPROTOCOL))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_AUTHPROTOCOL))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%ssnmpv3_authprotocol=%d", d,
 				(int)item_prototype->snmpv3_authprotocol);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_AUTHPASSPHRASE))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_AUTHPASSPHRASE))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->snmpv3_authpassphrase);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%ssnmpv3_authpassphrase='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_PRIVPROTOCOL))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_PRIVPROTOCOL))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%ssnmpv3_privprotocol=%d", d,
 				(int)item_prototype->snmpv3_privprotocol);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_PRIVPASSPHRASE))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_PRIVPASSPHRASE))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->snmpv3_privpassphrase);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%ssnmpv3_privpassphrase='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_AUTHTYPE))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_AUTHTYPE))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sauthtype=%d", d, (int)item_prototype->authtype);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_USERNAME))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_USERNAME))
 	{
 		value_esc = DBdyn_escape_string(item->username);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%susername='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_PASSWORD))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_PASSWORD))
 	{
 		value_esc = DBdyn_escape_string(item->password);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%spassword='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_PUBLICKEY))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_PUBLICKEY))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->publickey);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%spublickey='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_PRIVATEKEY))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_PRIVATEKEY))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->privatekey);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sprivatekey='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_DESCRIPTION))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_DESCRIPTION))
 	{
 		value_esc = DBdyn_escape_string(item->description);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sdescription='%s'", d, value_esc);
@@ -2999,184 +3585,301 @@ static void	lld_item_prepare_update(const zbx_lld_item_prototype_t *item_prototy
 		d = ",";
 
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_INTERFACEID))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_INTERFACEID))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sinterfaceid=%s",
 				d, DBsql_id_ins(item_prototype->interfaceid));
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_CONTEXTNAME))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SNMPV3_CONTEXTNAME))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->snmpv3_contextname);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%ssnmpv3_contextname='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_JMX_ENDPOINT))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_JMX_ENDPOINT))
 	{
 		value_esc = DBdyn_escape_string(item->jmx_endpoint);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sjmx_endpoint='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_MASTER_ITEM))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_MASTER_ITEM))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%smaster_itemid=%s",
 				d, DBsql_id_ins(item->master_itemid));
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_TIMEOUT))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_TIMEOUT))
 	{
 		value_esc = DBdyn_escape_string(item->timeout);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%stimeout='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_URL))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_URL))
 	{
 		value_esc = DBdyn_escape_string(item->url);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%surl='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_QUERY_FIELDS))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_QUERY_FIELDS))
 	{
 		value_esc = DBdyn_escape_string(item->query_fields);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%squery_fields='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_POSTS))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_POSTS))
 	{
 		value_esc = DBdyn_escape_string(item->posts);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sposts='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_STATUS_CODES))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_STATUS_CODES))
 	{
 		value_esc = DBdyn_escape_string(item->status_codes);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sstatus_codes='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_FOLLOW_REDIRECTS))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_FOLLOW_REDIRECTS))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sfollow_redirects=%d", d,
 				(int)item_prototype->follow_redirects);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_POST_TYPE))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_POST_TYPE))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%spost_type=%d", d, (int)item_prototype->post_type);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_HTTP_PROXY))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_HTTP_PROXY))
 	{
 		value_esc = DBdyn_escape_string(item->http_proxy);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%shttp_proxy='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_HEADERS))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_HEADERS))
 	{
 		value_esc = DBdyn_escape_string(item->headers);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sheaders='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_RETRIEVE_MODE))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_RETRIEVE_MODE))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sretrieve_mode=%d", d,
 				(int)item_prototype->retrieve_mode);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_REQUEST_METHOD))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_REQUEST_METHOD))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%srequest_method=%d", d,
 				(int)item_prototype->request_method);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_OUTPUT_FORMAT))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_OUTPUT_FORMAT))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%soutput_format=%d", d,
 				(int)item_prototype->output_format);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SSL_CERT_FILE))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SSL_CERT_FILE))
 	{
 		value_esc = DBdyn_escape_string(item->ssl_cert_file);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sssl_cert_file='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SSL_KEY_FILE))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SSL_KEY_FILE))
 	{
 		value_esc = DBdyn_escape_string(item->ssl_key_file);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sssl_key_file='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_SSL_KEY_PASSWORD))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_SSL_KEY_PASSWORD))
 	{
 		value_esc = DBdyn_escape_string(item->ssl_key_password);
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sssl_key_password='%s'", d, value_esc);
 		zbx_free(value_esc);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_VERIFY_PEER))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_VERIFY_PEER))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sverify_peer=%d", d, (int)item_prototype->verify_peer);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_VERIFY_HOST))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_VERIFY_HOST))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sverify_host=%d", d, (int)item_prototype->verify_host);
 		d = ",";
 	}
-	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_ALLOW_TRAPS))
+	if (0 != (flags & ZBX_FLAG_LLD_ITEM_UPDATE_ALLOW_TRAPS))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sallow_traps=%d", d, (int)item_prototype->allow_traps);
 	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sorts items by prototype and prototype field update flags         *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_item_compare_prototype_update(const void *d1, const void *d2)
+{
+	const zbx_lld_item_t	*item1 = *(const zbx_lld_item_t **)d1;
+	const zbx_lld_item_t	*item2 = *(const zbx_lld_item_t **)d2;
 
-	zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " where itemid=" ZBX_FS_UI64 ";\n", item->itemid);
+	ZBX_RETURN_IF_NOT_EQUAL(item1->parent_itemid, item2->parent_itemid);
+	ZBX_RETURN_IF_NOT_EQUAL(item1->flags & (ZBX_FLAG_LLD_ITEM_UPDATE_PROTOTYPE | ZBX_FLAG_LLD_ITEM_UPDATE_KEY),
+			item2->flags & (ZBX_FLAG_LLD_ITEM_UPDATE_PROTOTYPE | ZBX_FLAG_LLD_ITEM_UPDATE_KEY));
+	ZBX_RETURN_IF_NOT_EQUAL(item1->itemid, item2->itemid);
 
-	DBexecute_overflowed_sql(sql, sql_alloc, sql_offset);
+	return 0;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: prepare sql to update key in LLD item discovery                   *
+ * Purpose: prepare sql to update fields copied from item prototype for a     *
+ *          group of items with the same prototype and updated fields         *
  *                                                                            *
- * Parameters: item_prototype       - [IN] item prototype                     *
- *             item                 - [IN] item to be updated                 *
- *             sql                  - [IN/OUT] sql buffer pointer used for    *
- *                                             update operations              *
- *             sql_alloc            - [IN/OUT] sql buffer already allocated   *
- *                                             memory                         *
- *             sql_offset           - [IN/OUT] offset for writing within sql  *
- *                                             buffer                         *
+ * Parameters: item_prototype - [IN] item prototype                           *
+ *             item           - [IN] the first item of the group              *
+ *             itemids        - [IN] identifiers of the group items           *
+ *             sql            - [IN/OUT] sql buffer pointer used for update   *
+ *                                       operations                           *
+ *             sql_alloc      - [IN/OUT] sql buffer already allocated memory  *
+ *             sql_offset     - [IN/OUT] offset for writing within sql buffer *
  *                                                                            *
  ******************************************************************************/
-static void lld_item_discovery_prepare_update(const zbx_lld_item_prototype_t *item_prototype,
-		const zbx_lld_item_t *item, char **sql, size_t *sql_alloc, size_t *sql_offset)
+static void	lld_items_prepare_prototype_update(const zbx_lld_item_prototype_t *item_prototype,
+		const zbx_lld_item_t *item, const zbx_vector_uint64_t *itemids, char **sql, size_t *sql_alloc,
+		size_t *sql_offset)
 {
 	char	*value_esc;
 
+	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_PROTOTYPE))
+	{
+		lld_item_prepare_update(item_prototype, item, item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_PROTOTYPE, sql,
+				sql_alloc, sql_offset);
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, " where");
+		DBadd_condition_alloc(sql, sql_alloc, sql_offset, "itemid", itemids->values, itemids->values_num);
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, ";\n");
+
+		DBexecute_overflowed_sql(sql, sql_alloc, sql_offset);
+	}
+
 	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_KEY))
 	{
 		value_esc = DBdyn_escape_string(item_prototype->key);
-		zbx_snprintf_alloc(sql, sql_alloc, sql_offset,
-				"update item_discovery"
-				" set key_='%s'"
-				" where itemid=" ZBX_FS_UI64 ";\n",
-				value_esc, item->itemid);
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "update item_discovery set key_='%s' where", value_esc);
 		zbx_free(value_esc);
+		DBadd_condition_alloc(sql, sql_alloc, sql_offset, "itemid", itemids->values, itemids->values_num);
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, ";\n");
 
 		DBexecute_overflowed_sql(sql, sql_alloc, sql_offset);
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare sql to update discovered items                            *
+ *                                                                            *
+ * Parameters: item_prototypes - [IN] item prototypes                         *
+ *             items           - [IN] items to update                         *
+ *             sql             - [IN/OUT] sql buffer pointer used for update  *
+ *                                        operations                          *
+ *             sql_alloc       - [IN/OUT] sql buffer already allocated memory *
+ *             sql_offset      - [IN/OUT] offset for writing within sql       *
+ *                                        buffer                              *
+ *                                                                            *
+ * Comments: Fields depending on lld macros are updated per item, while       *
+ *           fields copied from item prototype are updated with a single      *
+ *           statement for all items of the prototype having the same fields  *
+ *           changed.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_items_prepare_updates(const zbx_vector_ptr_t *item_prototypes, const zbx_vector_ptr_t *items,
+		char **sql, size_t *sql_alloc, size_t *sql_offset)
+{
+	int				i, j, index;
+	zbx_lld_item_t			*item;
+	zbx_lld_item_prototype_t	*item_prototype;
+	zbx_vector_ptr_t		upd_proto_items;
+	zbx_vector_uint64_t		upd_proto_itemids;
+
+	zbx_vector_ptr_create(&upd_proto_items);
+	zbx_vector_uint64_create(&upd_proto_itemids);
+
+	for (i = 0; i < items->values_num; i++)
+	{
+		item = (zbx_lld_item_t *)items->values[i];
+
+		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED) ||
+				0 == (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE))
+		{
+			continue;
+		}
+
+		if (FAIL == (index = zbx_vector_ptr_bsearch(item_prototypes, &item->parent_itemid,
+				ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			continue;
+		}
+
+		/* fields copied from item prototype are updated with a single statement per prototype */
+		if (0 != (item->flags & (ZBX_FLAG_LLD_ITEM_UPDATE_PROTOTYPE | ZBX_FLAG_LLD_ITEM_UPDATE_KEY)))
+			zbx_vector_ptr_append(&upd_proto_items, item);
+
+		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE & ~ZBX_FLAG_LLD_ITEM_UPDATE_PROTOTYPE))
+			continue;
+
+		item_prototype = item_prototypes->values[index];
+
+		lld_item_prepare_update(item_prototype, item, item->flags & ~ZBX_FLAG_LLD_ITEM_UPDATE_PROTOTYPE,
+				sql, sql_alloc, sql_offset);
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " where itemid=" ZBX_FS_UI64 ";\n", item->itemid);
+
+		DBexecute_overflowed_sql(sql, sql_alloc, sql_offset);
+	}
+
+	zbx_vector_ptr_sort(&upd_proto_items, lld_item_compare_prototype_update);
+
+	for (i = 0; i < upd_proto_items.values_num; i = j)
+	{
+		item = (zbx_lld_item_t *)upd_proto_items.values[i];
+		zbx_vector_uint64_clear(&upd_proto_itemids);
+
+		for (j = i; j < upd_proto_items.values_num; j++)
+		{
+			zbx_lld_item_t	*item_next = (zbx_lld_item_t *)upd_proto_items.values[j];
+
+			if (item->parent_itemid != item_next->parent_itemid || 0 != ((item->flags ^ item_next->flags) &
+					(ZBX_FLAG_LLD_ITEM_UPDATE_PROTOTYPE | ZBX_FLAG_LLD_ITEM_UPDATE_KEY)))
+			{
+				break;
+			}
+
+			zbx_vector_uint64_append(&upd_proto_itemids, item_next->itemid);
+		}
+
+		index = zbx_vector_ptr_bsearch(item_prototypes, &item->parent_itemid, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
+		item_prototype = item_prototypes->values[index];
+
+		lld_items_prepare_prototype_update(item_prototype, item, &upd_proto_itemids, sql, sql_alloc, sql_offset);
+	}
+
+	zbx_vector_uint64_destroy(&upd_proto_itemids);
+	zbx_vector_ptr_destroy(&upd_proto_items);
+}
+
 /******************************************************************************
  *                                                                            *
  * Parameters: hostid          - [IN] parent host id                          *
@@ -3348,34 +4051,10 @@ static int	lld_items_save(zbx_uint64_t hostid, const zbx_vector_ptr_t *item_prot
 
 	if (0 != upd_items)
 	{
-		int	index;
-
 		sql_offset = 0;
 
 		DBbegin_multiple_update(&sql, &sql_alloc, &sql_offset);
-
-		for (i = 0; i < items->values_num; i++)
-		{
-			item = (zbx_lld_item_t *)items->values[i];
-
-			if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED) ||
-					0 == (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE))
-			{
-				continue;
-			}
-
-			if (FAIL == (index = zbx_vector_ptr_bsearch(item_prototypes, &item->parent_itemid,
-					ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
-			{
-				THIS_SHOULD_NEVER_HAPPEN;
-				continue;
-			}
-
-			item_prototype = item_prototypes->values[index];
-
-			lld_item_prepare_update(item_prototype, item, &sql, &sql_alloc, &sql_offset);
-			lld_item_discovery_prepare_update(item_prototype, item, &sql, &sql_alloc, &sql_offset);
-		}
+		lld_items_prepare_updates(item_prototypes, items, &sql, &sql_alloc, &sql_offset);
 
 		DBend_multiple_update(&sql, &sql_alloc, &sql_offset);
 		if (sql_offset > 16)
@@ -5100,7 +5779,6 @@ static void	lld_item_prototypes_get(zbx_uint64_t lld_ruleid, zbx_vector_ptr_t *i
 		ZBX_STR2UCHAR(item_prototype->verify_host, row[51]);
 		ZBX_STR2UCHAR(item_prototype->allow_traps, row[52]);
 
-		zbx_vector_ptr_create(&item_prototype->lld_rows);
 		zbx_vector_ptr_create(&item_prototype->applications);
 		zbx_vector_ptr_create(&item_prototype->preproc_ops);
 
@@ -5306,3 +5984,7 @@ out:
 
 	return ret;
 }
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/zabbix_server/lld/lld_item_test.c"
+#endif
@@ -30,6 +30,7 @@ extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
 extern int	CONFIG_LLDWORKER_FORKS;
+extern int	CONFIG_LLD_SKIP_UNCHANGED_PERIOD;
 
 /*
  * The LLD queue is organized as a queue (rule_queue binary heap) of LLD rules,
@@ -44,6 +45,12 @@ extern int	CONFIG_LLDWORKER_FORKS;
  * values in the list the rule is removed from the index (rule_index hashset),
  * otherwise the rule is enqueued back in LLD queue.
  *
+ * Worker returns fingerprint of the processed discovery data with done response.
+ * Manager keeps it and sends with the next value of the same rule, allowing worker
+ * to skip processing of unchanged discovery data. Fingerprints expire after
+ * CONFIG_LLD_SKIP_UNCHANGED_PERIOD seconds since the last full processing, so changes
+ * in rule prototypes are eventually applied without a new discovery data.
+ *
  */
 
 typedef struct zbx_lld_value
@@ -78,6 +85,19 @@ typedef struct
 }
 zbx_lld_rule_t;
 
+/* fingerprint of discovery data processed by LLD rule */
+typedef struct
+{
+	/* the LLD rule id */
+	zbx_uint64_t	itemid;
+
+	zbx_uint64_t	fingerprint;
+
+	/* the time of the last full discovery data processing */
+	int		full_time;
+}
+zbx_lld_fingerprint_t;
+
 typedef struct
 {
 	/* workers vector, created during manager initialization */
@@ -101,6 +121,9 @@ typedef struct
 	/* the number of queued LLD rules */
 	zbx_uint64_t		queued_num;
 
+	/* fingerprints of the last processed discovery data, indexed by LLD rule ids */
+	zbx_hashset_t		fingerprints;
+
 }
 zbx_lld_manager_t;
 
@@ -108,6 +131,9 @@ typedef struct
 {
 	zbx_ipc_client_t	*client;
 	zbx_lld_rule_t		*rule;
+
+	/* the discovery data fingerprint sent with the task */
+	zbx_uint64_t		fingerprint;
 }
 zbx_lld_worker_t;
 
@@ -206,6 +232,8 @@ static void	lld_manager_init(zbx_lld_manager_t *manager)
 
 	zbx_binary_heap_create(&manager->rule_queue, rule_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
 
+	zbx_hashset_create(&manager->fingerprints, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
 	manager->next_worker_index = 0;
 
 	for (i = 0; i < CONFIG_LLDWORKER_FORKS; i++)
@@ -231,6 +259,7 @@ static void	lld_manager_init(zbx_lld_manager_t *manager)
  ******************************************************************************/
 static void	lld_manager_destroy(zbx_lld_manager_t *manager)
 {
+	zbx_hashset_destroy(&manager->fingerprints);
 	zbx_binary_heap_destroy(&manager->rule_queue);
 	zbx_hashset_destroy(&manager->rule_index);
 	zbx_queue_ptr_destroy(&manager->free_workers);
@@ -389,6 +418,93 @@ out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns fingerprint of discovery data processed by LLD rule last  *
+ *          time                                                              *
+ *                                                                            *
+ * Parameters: manager - [IN] the LLD manager                                 *
+ *             itemid  - [IN] the LLD rule id                                 *
+ *             now     - [IN] the current time                                *
+ *                                                                            *
+ * Return value: The fingerprint or 0 if discovery data must be processed     *
+ *               fully.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lld_get_fingerprint(zbx_lld_manager_t *manager, zbx_uint64_t itemid, int now)
+{
+	zbx_lld_fingerprint_t	*fingerprint;
+
+	if (0 == CONFIG_LLD_SKIP_UNCHANGED_PERIOD)
+		return 0;
+
+	if (NULL == (fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_search(&manager->fingerprints, &itemid)))
+		return 0;
+
+	if (fingerprint->full_time + CONFIG_LLD_SKIP_UNCHANGED_PERIOD <= now)
+		return 0;
+
+	return fingerprint->fingerprint;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stores fingerprint of discovery data processed by LLD rule        *
+ *                                                                            *
+ * Parameters: manager          - [IN] the LLD manager                        *
+ *             itemid           - [IN] the LLD rule id                        *
+ *             fingerprint      - [IN] the fingerprint returned by worker     *
+ *             fingerprint_sent - [IN] the fingerprint sent to worker         *
+ *             now              - [IN] the current time                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_set_fingerprint(zbx_lld_manager_t *manager, zbx_uint64_t itemid, zbx_uint64_t fingerprint,
+		zbx_uint64_t fingerprint_sent, int now)
+{
+	zbx_lld_fingerprint_t	*lld_fingerprint, fingerprint_local;
+
+	if (0 == fingerprint || 0 == CONFIG_LLD_SKIP_UNCHANGED_PERIOD)
+	{
+		zbx_hashset_remove(&manager->fingerprints, &itemid);
+		return;
+	}
+
+	/* fingerprint match means that discovery data processing was skipped */
+	if (fingerprint == fingerprint_sent)
+		return;
+
+	if (NULL == (lld_fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_search(&manager->fingerprints, &itemid)))
+	{
+		fingerprint_local.itemid = itemid;
+		lld_fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_insert(&manager->fingerprints,
+				&fingerprint_local, sizeof(fingerprint_local));
+	}
+
+	lld_fingerprint->fingerprint = fingerprint;
+	lld_fingerprint->full_time = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes expired discovery data fingerprints                       *
+ *                                                                            *
+ * Parameters: manager - [IN] the LLD manager                                 *
+ *             now     - [IN] the current time                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_remove_expired_fingerprints(zbx_lld_manager_t *manager, int now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_lld_fingerprint_t	*fingerprint;
+
+	zbx_hashset_iter_reset(&manager->fingerprints, &iter);
+	while (NULL != (fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (fingerprint->full_time + CONFIG_LLD_SKIP_UNCHANGED_PERIOD <= now)
+			zbx_hashset_iter_remove(&iter);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes next LLD request from queue                             *
@@ -409,8 +525,10 @@ static void	lld_process_next_request(zbx_lld_manager_t *manager, zbx_lld_worker_
 	zbx_binary_heap_remove_min(&manager->rule_queue);
 
 	data = worker->rule->head;
-	buf_len = zbx_lld_serialize_item_value(&buf, data->itemid, 0, data->value, &data->ts, data->meta,
-			data->lastlogsize, data->mtime, data->error);
+	worker->fingerprint = lld_get_fingerprint(manager, data->itemid, (int)time(NULL));
+
+	buf_len = zbx_lld_serialize_task(&buf, data->itemid, data->value, &data->ts, data->meta, data->lastlogsize,
+			data->mtime, data->error, worker->fingerprint);
 	zbx_ipc_client_send(worker->client, ZBX_IPC_LLD_TASK, buf, buf_len);
 	zbx_free(buf);
 }
@@ -441,13 +559,17 @@ static void	lld_process_queue(zbx_lld_manager_t *manager)
  *                                                                            *
  * Parameters: manager - [IN] the LLD manager                                 *
  * Parameters: client  - [IN] the worker's IPC client connection              *
+ *             message - [IN] the done response with discovery data           *
+ *                            fingerprint                                     *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client)
+static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
 {
 	zbx_lld_worker_t	*worker;
 	zbx_lld_rule_t		*rule;
 	zbx_lld_data_t		*data;
+	zbx_uint64_t		fingerprint = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -461,6 +583,11 @@ static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *cli
 	data = rule->head;
 	rule->head = rule->head->next;
 
+	if (sizeof(fingerprint) == message->size)
+		memcpy(&fingerprint, message->data, sizeof(fingerprint));
+
+	lld_set_fingerprint(manager, data->itemid, fingerprint, worker->fingerprint, (int)time(NULL));
+
 	if (NULL == rule->head)
 	{
 		zbx_hashset_remove_direct(&manager->rule_index, rule);
@@ -495,7 +622,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 	char			*error = NULL;
 	zbx_ipc_client_t	*client;
 	zbx_ipc_message_t	*message;
-	double			time_stat, time_now, sec, time_idle = 0;
+	double			time_stat, time_now, sec, time_idle = 0, time_cleanup;
 	zbx_lld_manager_t	manager;
 	zbx_uint64_t		processed_num = 0;
 	int			ret;
@@ -520,6 +647,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 
 	/* initialize statistics */
 	time_stat = zbx_time();
+	time_cleanup = time_stat;
 
 	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
 
@@ -563,7 +691,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 					lld_process_queue(&manager);
 					break;
 				case ZBX_IPC_LLD_DONE:
-					lld_process_result(&manager, client);
+					lld_process_result(&manager, client, message);
 					processed_num++;
 					manager.queued_num--;
 					break;
@@ -578,6 +706,12 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 
 		if (NULL != client)
 			zbx_ipc_client_release(client);
+
+		if (SEC_PER_HOUR < sec - time_cleanup)
+		{
+			lld_remove_expired_fingerprints(&manager, (int)sec);
+			time_cleanup = sec;
+		}
 	}
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
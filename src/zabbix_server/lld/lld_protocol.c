@@ -88,6 +88,42 @@ void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *ite
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes LLD task sent by manager to worker                     *
+ *                                                                            *
+ * Comments: The task contains the rule value followed by the fingerprint of  *
+ *           discovery data processed last time by the rule.                  *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_lld_serialize_task(unsigned char **data, zbx_uint64_t itemid, const char *value,
+		const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime, const char *error,
+		zbx_uint64_t fingerprint)
+{
+	zbx_uint32_t	data_len;
+
+	data_len = zbx_lld_serialize_item_value(data, itemid, 0, value, ts, meta, lastlogsize, mtime, error);
+	*data = (unsigned char *)zbx_realloc(*data, data_len + sizeof(fingerprint));
+	(void)zbx_serialize_value(*data + data_len, fingerprint);
+
+	return data_len + sizeof(fingerprint);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: deserializes LLD task                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_lld_deserialize_task(const unsigned char *data, zbx_uint32_t size, zbx_uint64_t *itemid, char **value,
+		zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime, char **error,
+		zbx_uint64_t *fingerprint)
+{
+	zbx_uint64_t	hostid;
+
+	zbx_lld_deserialize_item_value(data, itemid, &hostid, value, ts, meta, lastlogsize, mtime, error);
+	(void)zbx_deserialize_value(data + size - sizeof(*fingerprint), fingerprint);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: process low level discovery value/error                           *
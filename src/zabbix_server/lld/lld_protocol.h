@@ -45,4 +45,12 @@ void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *ite
 		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
 		char **error);
 
+zbx_uint32_t	zbx_lld_serialize_task(unsigned char **data, zbx_uint64_t itemid, const char *value,
+		const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime, const char *error,
+		zbx_uint64_t fingerprint);
+
+void	zbx_lld_deserialize_task(const unsigned char *data, zbx_uint32_t size, zbx_uint64_t *itemid, char **value,
+		zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime, char **error,
+		zbx_uint64_t *fingerprint);
+
 #endif
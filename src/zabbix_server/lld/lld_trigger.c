@@ -22,6 +22,7 @@
 #include "log.h"
 #include "zbxalgo.h"
 #include "zbxserver.h"
+#include "zbxserialize.h"
 
 typedef struct
 {
@@ -158,6 +159,50 @@ typedef struct
 }
 zbx_lld_item_t;
 
+/* trigger make data, passed to lld shard callbacks */
+typedef struct
+{
+	const zbx_vector_ptr_t	*trigger_prototypes;
+	zbx_vector_ptr_t	*triggers;
+	const zbx_vector_ptr_t	*items;
+	zbx_hashset_t		*items_triggers;
+	const zbx_vector_ptr_t	*lld_rows;
+	const zbx_vector_ptr_t	*lld_macro_paths;
+	char			**error;
+
+	/* existing triggers already made by the worker, shards do not see their changes */
+	zbx_hashset_t		triggers_made;
+}
+zbx_lld_triggers_make_t;
+
+#define ZBX_LLD_TRIGGER_SHARD_NONE	0
+#define ZBX_LLD_TRIGGER_SHARD_NEW	1
+#define ZBX_LLD_TRIGGER_SHARD_UPDATE	2
+
+/* trigger string fields set from trigger prototype with lld macros substituted */
+typedef struct
+{
+	size_t		offset;
+	size_t		orig_offset;
+	zbx_uint64_t	flag;
+}
+zbx_lld_trigger_field_t;
+
+#define LLD_TRIGGER_FIELD_DEF(field, orig, flag)	\
+		{offsetof(zbx_lld_trigger_t, field), offsetof(zbx_lld_trigger_t, orig), flag}
+#define LLD_TRIGGER_FIELD(trigger, offset)		((char **)((char *)(trigger) + (offset)))
+
+static const zbx_lld_trigger_field_t	lld_trigger_fields[] = {
+	LLD_TRIGGER_FIELD_DEF(description, description_orig, ZBX_FLAG_LLD_TRIGGER_UPDATE_DESCRIPTION),
+	LLD_TRIGGER_FIELD_DEF(expression, expression_orig, ZBX_FLAG_LLD_TRIGGER_UPDATE_EXPRESSION),
+	LLD_TRIGGER_FIELD_DEF(recovery_expression, recovery_expression_orig,
+			ZBX_FLAG_LLD_TRIGGER_UPDATE_RECOVERY_EXPRESSION),
+	LLD_TRIGGER_FIELD_DEF(comments, comments_orig, ZBX_FLAG_LLD_TRIGGER_UPDATE_COMMENTS),
+	LLD_TRIGGER_FIELD_DEF(url, url_orig, ZBX_FLAG_LLD_TRIGGER_UPDATE_URL),
+	LLD_TRIGGER_FIELD_DEF(correlation_tag, correlation_tag_orig, ZBX_FLAG_LLD_TRIGGER_UPDATE_CORRELATION_TAG),
+	LLD_TRIGGER_FIELD_DEF(opdata, opdata_orig, ZBX_FLAG_LLD_TRIGGER_UPDATE_OPDATA)
+};
+
 /* a reference to trigger which could be either existing trigger in database or */
 /* a just discovered trigger stored in memory                                   */
 typedef struct
@@ -1165,12 +1210,15 @@ out:
  *                                                                            *
  * Purpose: create a trigger based on lld rule and add it to the list         *
  *                                                                            *
+ * Return value: the created or updated trigger or NULL if trigger            *
+ *               expressions could not be made                                *
+ *                                                                            *
  ******************************************************************************/
-static void 	lld_trigger_make(const zbx_lld_trigger_prototype_t *trigger_prototype, zbx_vector_ptr_t *triggers,
-		const zbx_vector_ptr_t *items, zbx_hashset_t *items_triggers, const zbx_lld_row_t *lld_row,
-		const zbx_vector_ptr_t *lld_macros, char **error)
+static zbx_lld_trigger_t	*lld_trigger_make(const zbx_lld_trigger_prototype_t *trigger_prototype,
+		zbx_vector_ptr_t *triggers, const zbx_vector_ptr_t *items, zbx_hashset_t *items_triggers,
+		const zbx_lld_row_t *lld_row, const zbx_vector_ptr_t *lld_macros, char **error)
 {
-	zbx_lld_trigger_t		*trigger;
+	zbx_lld_trigger_t		*trigger, *trigger_made = NULL;
 	char				*buffer = NULL, *expression = NULL, *recovery_expression = NULL, err[64];
 	char				*err_msg = NULL;
 	const char			*operation_msg;
@@ -1317,6 +1365,8 @@ static void 	lld_trigger_make(const zbx_lld_trigger_prototype_t *trigger_prototy
 
 	zbx_free(buffer);
 
+	trigger_made = trigger;
+
 	if (SUCCEED != lld_functions_make(&trigger_prototype->functions, &trigger->functions, items,
 			&lld_row->item_links, jp_row, lld_macros, &err_msg))
 	{
@@ -1334,6 +1384,8 @@ out:
 	zbx_free(expression);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return trigger_made;
 }
 
 static zbx_hash_t	items_triggers_hash_func(const void *data)
@@ -1357,16 +1409,414 @@ static int	items_triggers_compare_func(const void *d1, const void *d2)
 	return 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes trigger of the specified prototype and lld row pair         *
+ *                                                                            *
+ * Parameters: make  - [IN] the trigger make data                             *
+ *             index - [IN] the pair index, prototypes are iterated in outer  *
+ *                          loop and lld rows in inner loop                   *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_lld_trigger_t	*lld_trigger_make_by_index(zbx_lld_triggers_make_t *make, int index, char **error)
+{
+	int	rows_num = make->lld_rows->values_num;
+
+	return lld_trigger_make((const zbx_lld_trigger_prototype_t *)make->trigger_prototypes->values[index / rows_num],
+			make->triggers, make->items, make->items_triggers,
+			(const zbx_lld_row_t *)make->lld_rows->values[index % rows_num], make->lld_macro_paths, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes triggers of the specified prototype and lld row pair range  *
+ *                                                                            *
+ * Parameters: data       - [IN] the trigger make data                        *
+ *             index_from - [IN] the first pair index                         *
+ *             index_to   - [IN] the index after the last pair                *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_triggers_make_rows(void *data, int index_from, int index_to)
+{
+	zbx_lld_triggers_make_t	*make = (zbx_lld_triggers_make_t *)data;
+	zbx_lld_trigger_t	*trigger;
+	int			i;
+
+	for (i = index_from; i < index_to; i++)
+	{
+		if (NULL != (trigger = lld_trigger_make_by_index(make, i, make->error)) && 0 != trigger->triggerid)
+			zbx_hashset_insert(&make->triggers_made, &trigger, sizeof(trigger));
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes trigger made from one prototype and lld row pair       *
+ *                                                                            *
+ * Parameters: data        - [IN/OUT] the serialization buffer                *
+ *             data_alloc  - [IN/OUT] the buffer size                         *
+ *             data_offset - [IN/OUT] the buffer offset                       *
+ *             index       - [IN] the prototype and lld row pair index        *
+ *             error       - [IN] the error message, can be NULL              *
+ *             trigger     - [IN] the trigger, NULL if no trigger was made    *
+ *                                                                            *
+ * Comments: New triggers are serialized with all fields, existing triggers   *
+ *           only with the updated fields. All trigger functions are          *
+ *           serialized as existing functions can be only updated and new     *
+ *           functions are appended.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_trigger_shard_serialize(unsigned char **data, zbx_uint32_t *data_alloc, zbx_uint32_t *data_offset,
+		int index, const char *error, zbx_lld_trigger_t *trigger)
+{
+	zbx_uint32_t	len = 0, error_len, fields_len[ARRSIZE(lld_trigger_fields)], *functions_len = NULL;
+	unsigned char	*ptr, op;
+	const char	*values[ARRSIZE(lld_trigger_fields)];
+	size_t		i;
+	int		j;
+
+	if (NULL == trigger)
+		op = ZBX_LLD_TRIGGER_SHARD_NONE;
+	else if (0 == trigger->triggerid)
+		op = ZBX_LLD_TRIGGER_SHARD_NEW;
+	else
+		op = ZBX_LLD_TRIGGER_SHARD_UPDATE;
+
+	zbx_serialize_prepare_value(len, index);
+	zbx_serialize_prepare_value(len, op);
+	zbx_serialize_prepare_str_len(len, error, error_len);
+
+	if (ZBX_LLD_TRIGGER_SHARD_NONE != op)
+	{
+		zbx_serialize_prepare_value(len, trigger->flags);
+
+		for (i = 0; i < ARRSIZE(lld_trigger_fields); i++)
+		{
+			if (ZBX_LLD_TRIGGER_SHARD_NEW == op || 0 != (trigger->flags & lld_trigger_fields[i].flag))
+				values[i] = *LLD_TRIGGER_FIELD(trigger, lld_trigger_fields[i].offset);
+			else
+				values[i] = NULL;
+
+			zbx_serialize_prepare_str_len(len, values[i], fields_len[i]);
+		}
+
+		zbx_serialize_prepare_value(len, trigger->functions.values_num);
+
+		functions_len = (zbx_uint32_t *)zbx_malloc(NULL, sizeof(zbx_uint32_t) *
+				(trigger->functions.values_num * 2 + 1));
+
+		for (j = 0; j < trigger->functions.values_num; j++)
+		{
+			const zbx_lld_function_t	*function = (const zbx_lld_function_t *)trigger->functions.values[j];
+
+			zbx_serialize_prepare_value(len, function->index);
+			zbx_serialize_prepare_value(len, function->itemid);
+			zbx_serialize_prepare_str_len(len, function->function, functions_len[j * 2]);
+			zbx_serialize_prepare_str_len(len, function->parameter, functions_len[j * 2 + 1]);
+			zbx_serialize_prepare_value(len, function->flags);
+		}
+	}
+
+	while (len > *data_alloc - *data_offset)
+	{
+		*data_alloc *= 2;
+		*data = (unsigned char *)zbx_realloc(*data, *data_alloc);
+	}
+
+	ptr = *data + *data_offset;
+	*data_offset += len;
+
+	ptr += zbx_serialize_value(ptr, index);
+	ptr += zbx_serialize_value(ptr, op);
+	ptr += zbx_serialize_str(ptr, error, error_len);
+
+	if (ZBX_LLD_TRIGGER_SHARD_NONE == op)
+		return;
+
+	ptr += zbx_serialize_value(ptr, trigger->flags);
+
+	for (i = 0; i < ARRSIZE(lld_trigger_fields); i++)
+		ptr += zbx_serialize_str(ptr, values[i], fields_len[i]);
+
+	ptr += zbx_serialize_value(ptr, trigger->functions.values_num);
+
+	for (j = 0; j < trigger->functions.values_num; j++)
+	{
+		const zbx_lld_function_t	*function = (const zbx_lld_function_t *)trigger->functions.values[j];
+
+		ptr += zbx_serialize_value(ptr, function->index);
+		ptr += zbx_serialize_value(ptr, function->itemid);
+		ptr += zbx_serialize_str(ptr, function->function, functions_len[j * 2]);
+		ptr += zbx_serialize_str(ptr, function->parameter, functions_len[j * 2 + 1]);
+		ptr += zbx_serialize_value(ptr, function->flags);
+	}
+
+	zbx_free(functions_len);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes triggers of the specified prototype and lld row pair range  *
+ *          and serializes them                                               *
+ *                                                                            *
+ * Parameters: data       - [IN] the trigger make data                        *
+ *             index_from - [IN] the first pair index                         *
+ *             index_to   - [IN] the index after the last pair                *
+ *             result     - [OUT] the serialized triggers                     *
+ *             result_len - [OUT] the result length                           *
+ *                                                                            *
+ * Comments: This function is called in lld shard process. Every pair is      *
+ *           serialized with the state of the trigger right after it was      *
+ *           made.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_triggers_make_serialize(void *data, int index_from, int index_to, unsigned char **result,
+		zbx_uint32_t *result_len)
+{
+	zbx_lld_triggers_make_t	*make = (zbx_lld_triggers_make_t *)data;
+	zbx_lld_trigger_t	*trigger;
+	char			*error;
+	int			i;
+	zbx_uint32_t		result_alloc = ZBX_KIBIBYTE * 64;
+
+	*result = (unsigned char *)zbx_malloc(NULL, result_alloc);
+	*result_len = 0;
+
+	for (i = index_from; i < index_to; i++)
+	{
+		error = NULL;
+		trigger = lld_trigger_make_by_index(make, i, &error);
+		lld_trigger_shard_serialize(result, &result_alloc, result_len, i, error, trigger);
+		zbx_free(error);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: deserializes trigger made by lld shard process                    *
+ *                                                                            *
+ * Parameters: data    - [IN] the serialized trigger                          *
+ *             trigger - [OUT] the deserialized trigger                       *
+ *                                                                            *
+ * Return value: the number of bytes parsed                                   *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	lld_trigger_shard_deserialize(const unsigned char *data, zbx_lld_trigger_t **trigger)
+{
+	const unsigned char	*ptr = data;
+	zbx_uint32_t		value_len;
+	size_t			i;
+	int			j, functions_num;
+
+	*trigger = (zbx_lld_trigger_t *)zbx_malloc(NULL, sizeof(zbx_lld_trigger_t));
+	(*trigger)->triggerid = 0;
+	(*trigger)->parent_triggerid = 0;
+	zbx_vector_ptr_create(&(*trigger)->functions);
+	zbx_vector_ptr_create(&(*trigger)->dependencies);
+	zbx_vector_ptr_create(&(*trigger)->dependents);
+	zbx_vector_ptr_create(&(*trigger)->tags);
+
+	ptr += zbx_deserialize_value(ptr, &(*trigger)->flags);
+
+	for (i = 0; i < ARRSIZE(lld_trigger_fields); i++)
+	{
+		ptr += zbx_deserialize_str(ptr, LLD_TRIGGER_FIELD(*trigger, lld_trigger_fields[i].offset), value_len);
+		*LLD_TRIGGER_FIELD(*trigger, lld_trigger_fields[i].orig_offset) = NULL;
+	}
+
+	ptr += zbx_deserialize_value(ptr, &functions_num);
+
+	for (j = 0; j < functions_num; j++)
+	{
+		zbx_lld_function_t	*function;
+
+		function = (zbx_lld_function_t *)zbx_malloc(NULL, sizeof(zbx_lld_function_t));
+		function->functionid = 0;
+		function->itemid_orig = 0;
+		function->function_orig = NULL;
+		function->parameter_orig = NULL;
+
+		ptr += zbx_deserialize_value(ptr, &function->index);
+		ptr += zbx_deserialize_value(ptr, &function->itemid);
+		ptr += zbx_deserialize_str(ptr, &function->function, value_len);
+		ptr += zbx_deserialize_str(ptr, &function->parameter, value_len);
+		ptr += zbx_deserialize_value(ptr, &function->flags);
+
+		zbx_vector_ptr_append(&(*trigger)->functions, function);
+	}
+
+	return (zbx_uint32_t)(ptr - data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies trigger made by lld shard process to existing trigger     *
+ *                                                                            *
+ * Parameters: trigger      - [IN/OUT] the existing trigger                   *
+ *             trigger_made - [IN/OUT] the trigger made by shard, its data    *
+ *                                     are moved to the existing trigger      *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_trigger_shard_apply(zbx_lld_trigger_t *trigger, zbx_lld_trigger_t *trigger_made)
+{
+	char		**field, **field_made;
+	size_t		i;
+	int		j;
+
+	for (i = 0; i < ARRSIZE(lld_trigger_fields); i++)
+	{
+		if (0 == (trigger_made->flags & lld_trigger_fields[i].flag))
+			continue;
+
+		field = LLD_TRIGGER_FIELD(trigger, lld_trigger_fields[i].offset);
+		field_made = LLD_TRIGGER_FIELD(trigger_made, lld_trigger_fields[i].offset);
+		*LLD_TRIGGER_FIELD(trigger, lld_trigger_fields[i].orig_offset) = *field;
+		*field = *field_made;
+		*field_made = NULL;
+	}
+
+	trigger->flags = trigger_made->flags;
+
+	/* existing functions are updated in place, the rest are new */
+	for (j = 0; j < trigger_made->functions.values_num; j++)
+	{
+		zbx_lld_function_t	*function, *function_made = (zbx_lld_function_t *)trigger_made->functions.values[j];
+
+		if (j >= trigger->functions.values_num)
+		{
+			zbx_vector_ptr_append(&trigger->functions, function_made);
+			trigger_made->functions.values[j] = NULL;
+			continue;
+		}
+
+		function = (zbx_lld_function_t *)trigger->functions.values[j];
+
+		if (0 != (function_made->flags & ZBX_FLAG_LLD_FUNCTION_UPDATE_ITEMID))
+		{
+			function->itemid_orig = function->itemid;
+			function->itemid = function_made->itemid;
+		}
+
+		if (0 != (function_made->flags & ZBX_FLAG_LLD_FUNCTION_UPDATE_FUNCTION))
+		{
+			function->function_orig = function->function;
+			function->function = function_made->function;
+			function_made->function = NULL;
+		}
+
+		if (0 != (function_made->flags & ZBX_FLAG_LLD_FUNCTION_UPDATE_PARAMETER))
+		{
+			function->parameter_orig = function->parameter;
+			function->parameter = function_made->parameter;
+			function_made->parameter = NULL;
+		}
+
+		function->flags = function_made->flags;
+	}
+
+	for (j = 0; j < trigger_made->functions.values_num; j++)
+	{
+		if (NULL != trigger_made->functions.values[j])
+			lld_function_free((zbx_lld_function_t *)trigger_made->functions.values[j]);
+	}
+
+	trigger_made->functions.values_num = 0;
+	lld_trigger_free(trigger_made);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies triggers made by lld shard process                        *
+ *                                                                            *
+ * Parameters: data       - [IN] the trigger make data                        *
+ *             index_from - [IN] the first pair index                         *
+ *             index_to   - [IN] the index after the last pair                *
+ *             result     - [IN] the serialized triggers                      *
+ *             result_len - [IN] the result length                            *
+ *                                                                            *
+ * Comments: Existing triggers are matched by item links only, so shard finds *
+ *           the same trigger as the worker. Shard does not see changes made  *
+ *           to existing trigger by the preceding shards, so trigger that was *
+ *           already made by the worker is made again by the worker.          *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_triggers_make_merge(void *data, int index_from, int index_to, const unsigned char *result,
+		zbx_uint32_t result_len)
+{
+	zbx_lld_triggers_make_t			*make = (zbx_lld_triggers_make_t *)data;
+	const unsigned char			*ptr = result, *end = result + result_len;
+	const zbx_lld_trigger_prototype_t	*trigger_prototype;
+	const zbx_lld_row_t			*lld_row;
+	zbx_lld_trigger_t			*trigger, *trigger_made;
+	char					*error;
+	int					index, rows_num = make->lld_rows->values_num;
+	unsigned char				op;
+	zbx_uint32_t				value_len;
+
+	ZBX_UNUSED(index_from);
+	ZBX_UNUSED(index_to);
+
+	while (ptr < end)
+	{
+		ptr += zbx_deserialize_value(ptr, &index);
+		ptr += zbx_deserialize_value(ptr, &op);
+		ptr += zbx_deserialize_str(ptr, &error, value_len);
+
+		if (ZBX_LLD_TRIGGER_SHARD_NONE == op)
+		{
+			if (NULL != error)
+				*make->error = zbx_strdcat(*make->error, error);
+
+			zbx_free(error);
+			continue;
+		}
+
+		ptr += lld_trigger_shard_deserialize(ptr, &trigger_made);
+
+		trigger_prototype = (const zbx_lld_trigger_prototype_t *)make->trigger_prototypes->values[index / rows_num];
+		lld_row = (const zbx_lld_row_t *)make->lld_rows->values[index % rows_num];
+
+		if (ZBX_LLD_TRIGGER_SHARD_NEW == op)
+		{
+			trigger = NULL;
+		}
+		else if (NULL == (trigger = lld_trigger_get(trigger_prototype->triggerid, make->items_triggers,
+				&lld_row->item_links)) || NULL != zbx_hashset_search(&make->triggers_made, &trigger))
+		{
+			lld_trigger_free(trigger_made);
+			zbx_free(error);
+			lld_triggers_make_rows(make, index, index + 1);
+			continue;
+		}
+
+		if (NULL != error)
+			*make->error = zbx_strdcat(*make->error, error);
+
+		zbx_free(error);
+
+		if (NULL == trigger)
+		{
+			trigger_made->parent_triggerid = trigger_prototype->triggerid;
+			zbx_vector_ptr_append(make->triggers, trigger_made);
+			continue;
+		}
+
+		lld_trigger_shard_apply(trigger, trigger_made);
+		zbx_hashset_insert(&make->triggers_made, &trigger, sizeof(trigger));
+	}
+}
+
 static void	lld_triggers_make(const zbx_vector_ptr_t *trigger_prototypes, zbx_vector_ptr_t *triggers,
 		const zbx_vector_ptr_t *items, const zbx_vector_ptr_t *lld_rows,
 		const zbx_vector_ptr_t *lld_macro_paths, char **error)
 {
-	const zbx_lld_trigger_prototype_t	*trigger_prototype;
-	int					i, j;
-	zbx_hashset_t				items_triggers;
-	zbx_lld_trigger_t			*trigger;
-	const zbx_lld_function_t		*function;
-	zbx_lld_item_trigger_t			item_trigger;
+	int				i, j;
+	zbx_hashset_t			items_triggers;
+	zbx_lld_trigger_t		*trigger;
+	const zbx_lld_function_t	*function;
+	zbx_lld_item_trigger_t		item_trigger;
+	zbx_lld_triggers_make_t		make;
 
 	/* used for fast search of trigger by item prototype */
 	zbx_hashset_create(&items_triggers, 512, items_triggers_hash_func, items_triggers_compare_func);
@@ -1386,19 +1836,19 @@ static void	lld_triggers_make(const zbx_vector_ptr_t *trigger_prototypes, zbx_ve
 		}
 	}
 
-	for (i = 0; i < trigger_prototypes->values_num; i++)
-	{
-		trigger_prototype = (zbx_lld_trigger_prototype_t *)trigger_prototypes->values[i];
+	make.trigger_prototypes = trigger_prototypes;
+	make.triggers = triggers;
+	make.items = items;
+	make.items_triggers = &items_triggers;
+	make.lld_rows = lld_rows;
+	make.lld_macro_paths = lld_macro_paths;
+	make.error = error;
+	zbx_hashset_create(&make.triggers_made, 0, ZBX_DEFAULT_PTR_HASH_FUNC, ZBX_DEFAULT_PTR_COMPARE_FUNC);
 
-		for (j = 0; j < lld_rows->values_num; j++)
-		{
-			zbx_lld_row_t	*lld_row = (zbx_lld_row_t *)lld_rows->values[j];
-
-			lld_trigger_make(trigger_prototype, triggers, items, &items_triggers, lld_row, lld_macro_paths,
-					error);
-		}
-	}
+	lld_make_sharded(trigger_prototypes->values_num * lld_rows->values_num, lld_triggers_make_rows,
+			lld_triggers_make_serialize, lld_triggers_make_merge, &make);
 
+	zbx_hashset_destroy(&make.triggers_made);
 	zbx_hashset_destroy(&items_triggers);
 
 	zbx_vector_ptr_sort(triggers, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
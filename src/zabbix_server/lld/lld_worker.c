@@ -54,12 +54,15 @@ static void	lld_register_worker(zbx_ipc_socket_t *socket)
  * Purpose: processes lld task and updates rule state/error in configuration  *
  *          cache and database                                                *
  *                                                                            *
- * Parameters: message - [IN] the message with LLD request                    *
+ * Parameters: message     - [IN] the message with LLD request                *
+ *             fingerprint - [OUT] fingerprint of the processed discovery     *
+ *                                 data, 0 if it must be fully processed next *
+ *                                 time                                       *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_task(zbx_ipc_message_t *message)
+static void	lld_process_task(zbx_ipc_message_t *message, zbx_uint64_t *fingerprint)
 {
-	zbx_uint64_t		itemid, hostid, lastlogsize;
+	zbx_uint64_t		itemid, lastlogsize;
 	char			*value, *error;
 	zbx_timespec_t		ts;
 	zbx_item_diff_t		diff;
@@ -69,11 +72,15 @@ static void	lld_process_task(zbx_ipc_message_t *message)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_lld_deserialize_item_value(message->data, &itemid, &hostid, &value, &ts, &meta, &lastlogsize, &mtime, &error);
+	zbx_lld_deserialize_task(message->data, message->size, &itemid, &value, &ts, &meta, &lastlogsize, &mtime,
+			&error, fingerprint);
 
 	DCconfig_get_items_by_itemids(&item, &itemid, &errcode, 1);
 	if (SUCCEED != errcode)
+	{
+		*fingerprint = 0;
 		goto out;
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "processing discovery rule:" ZBX_FS_UI64, itemid);
 
@@ -81,10 +88,15 @@ static void	lld_process_task(zbx_ipc_message_t *message)
 
 	if (NULL != error || NULL != value)
 	{
-		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, &error))
+		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, fingerprint, &error))
+		{
 			state = ITEM_STATE_NORMAL;
+		}
 		else
+		{
 			state = ITEM_STATE_NOTSUPPORTED;
+			*fingerprint = 0;
+		}
 
 		if (state != item.state)
 		{
@@ -175,7 +187,7 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 	zbx_ipc_socket_t	lld_socket;
 	zbx_ipc_message_t	message;
 	double			time_stat, time_idle = 0, time_now, time_read;
-	zbx_uint64_t		processed_num = 0;
+	zbx_uint64_t		processed_num = 0, fingerprint;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -235,8 +247,9 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 		switch (message.code)
 		{
 			case ZBX_IPC_LLD_TASK:
-				lld_process_task(&message);
-				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, NULL, 0);
+				lld_process_task(&message, &fingerprint);
+				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, (unsigned char *)&fingerprint,
+						sizeof(fingerprint));
 				processed_num++;
 				break;
 		}
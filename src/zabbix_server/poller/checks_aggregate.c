@@ -273,7 +273,7 @@ static void	aggregate_quote_groups(char **str, size_t *str_alloc, size_t *str_of
  * Purpose: get array of items specified by key for selected groups           *
  *          (including nested groups)                                         *
  *                                                                            *
- * Parameters: itemids - [OUT] list of item ids                               *
+ * Parameters: items   - [OUT] list of item id and value type pairs           *
  *             groups  - [IN] list of host groups                             *
  *             itemkey - [IN] item key to aggregate                           *
  *             error   - [OUT] the error message                              *
@@ -281,25 +281,19 @@ static void	aggregate_quote_groups(char **str, size_t *str_alloc, size_t *str_of
  * Return value: SUCCEED - item identifier(s) were retrieved successfully     *
  *               FAIL    - no items matching the specified groups or keys     *
  *                                                                            *
+ * Comments: Group members are resolved in configuration cache, only active   *
+ *           numeric items in normal state on monitored hosts are returned.   *
+ *                                                                            *
  ******************************************************************************/
-static int	aggregate_get_items(zbx_vector_uint64_t *itemids, zbx_vector_str_t *groups, const char *itemkey,
+static int	aggregate_get_items(zbx_vector_uint64_pair_t *items, zbx_vector_str_t *groups, const char *itemkey,
 		char **error)
 {
-	char			*esc;
-	DB_RESULT		result;
-	DB_ROW			row;
-	zbx_uint64_t		itemid;
-	char			*sql = NULL;
-	size_t			sql_alloc = ZBX_KIBIBYTE, sql_offset = 0, error_alloc = 0, error_offset = 0;
-	int			ret = FAIL;
-	zbx_vector_uint64_t	groupids;
+	size_t	error_alloc = 0, error_offset = 0;
+	int	ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemkey:'%s'", __func__, itemkey);
 
-	zbx_vector_uint64_create(&groupids);
-	zbx_dc_get_nested_hostgroupids_by_names(groups, &groupids);
-
-	if (0 == groupids.values_num)
+	if (SUCCEED != zbx_dc_get_aggregate_items(groups, itemkey, items))
 	{
 		zbx_strcpy_alloc(error, &error_alloc, &error_offset, "None of the groups in list ");
 		aggregate_quote_groups(error, &error_alloc, &error_offset, groups);
@@ -307,36 +301,7 @@ static int	aggregate_get_items(zbx_vector_uint64_t *itemids, zbx_vector_str_t *g
 		goto out;
 	}
 
-	sql = (char *)zbx_malloc(sql, sql_alloc);
-	esc = DBdyn_escape_string(itemkey);
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-			"select distinct i.itemid"
-			" from items i,hosts h,hosts_groups hg,item_rtdata ir"
-			" where i.hostid=h.hostid"
-				" and h.hostid=hg.hostid"
-				" and i.key_='%s'"
-				" and i.status=%d"
-				" and ir.itemid=i.itemid"
-				" and ir.state=%d"
-				" and h.status=%d"
-				" and",
-			esc, ITEM_STATUS_ACTIVE, ITEM_STATE_NORMAL, HOST_STATUS_MONITORED);
-
-	zbx_free(esc);
-
-	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "hg.groupid", groupids.values, groupids.values_num);
-	result = DBselect("%s", sql);
-	zbx_free(sql);
-
-	while (NULL != (row = DBfetch(result)))
-	{
-		ZBX_STR2UINT64(itemid, row[0]);
-		zbx_vector_uint64_append(itemids, itemid);
-	}
-	DBfree_result(result);
-
-	if (0 == itemids->values_num)
+	if (0 == items->values_num)
 	{
 		zbx_snprintf_alloc(error, &error_alloc, &error_offset, "No items for key \"%s\" in group(s) ", itemkey);
 		aggregate_quote_groups(error, &error_alloc, &error_offset, groups);
@@ -344,14 +309,9 @@ static int	aggregate_get_items(zbx_vector_uint64_t *itemids, zbx_vector_str_t *g
 		goto out;
 	}
 
-	zbx_vector_uint64_sort(itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
 	ret = SUCCEED;
-
 out:
-	zbx_vector_uint64_destroy(&groupids);
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() items:%d", __func__, items->values_num);
 
 	return ret;
 }
@@ -372,11 +332,10 @@ out:
 static int	evaluate_aggregate(DC_ITEM *item, AGENT_RESULT *res, int grp_func, zbx_vector_str_t *groups,
 		const char *itemkey, int item_func, const char *param)
 {
-	zbx_vector_uint64_t		itemids;
+	zbx_vector_uint64_pair_t	items;
 	history_value_t			value, item_result;
 	zbx_history_record_t		group_value;
-	int				ret = FAIL, *errcodes = NULL, i, count, seconds;
-	DC_ITEM				*items = NULL;
+	int				ret = FAIL, i, count, seconds, value_type;
 	zbx_vector_history_record_t	values, group_values;
 	char				*error = NULL;
 	zbx_timespec_t			ts;
@@ -385,9 +344,9 @@ static int	evaluate_aggregate(DC_ITEM *item, AGENT_RESULT *res, int grp_func, zb
 			__func__, grp_func, itemkey, item_func, ZBX_NULL2STR(param));
 
 	zbx_timespec(&ts);
-	zbx_vector_uint64_create(&itemids);
+	zbx_vector_uint64_pair_create(&items);
 
-	if (FAIL == aggregate_get_items(&itemids, groups, itemkey, &error))
+	if (FAIL == aggregate_get_items(&items, groups, itemkey, &error))
 	{
 		SET_MSG_RESULT(res, error);
 		goto clean1;
@@ -396,11 +355,6 @@ static int	evaluate_aggregate(DC_ITEM *item, AGENT_RESULT *res, int grp_func, zb
 	memset(&value, 0, sizeof(value));
 	zbx_history_record_vector_create(&group_values);
 
-	items = (DC_ITEM *)zbx_malloc(items, sizeof(DC_ITEM) * itemids.values_num);
-	errcodes = (int *)zbx_malloc(errcodes, sizeof(int) * itemids.values_num);
-
-	DCconfig_get_items_by_itemids(items, itemids.values, errcodes, itemids.values_num);
-
 	if (ZBX_VALUE_FUNC_LAST == item_func)
 	{
 		count = 1;
@@ -416,28 +370,19 @@ static int	evaluate_aggregate(DC_ITEM *item, AGENT_RESULT *res, int grp_func, zb
 		count = 0;
 	}
 
-	for (i = 0; i < itemids.values_num; i++)
+	/* value cache is locked per item, so that it is not held while values missing in cache are read from database */
+	for (i = 0; i < items.values_num; i++)
 	{
-		if (SUCCEED != errcodes[i])
-			continue;
-
-		if (ITEM_STATUS_ACTIVE != items[i].status)
-			continue;
-
-		if (HOST_STATUS_MONITORED != items[i].host.status)
-			continue;
-
-		if (ITEM_VALUE_TYPE_FLOAT != items[i].value_type && ITEM_VALUE_TYPE_UINT64 != items[i].value_type)
-			continue;
+		value_type = (int)items.values[i].second;
 
 		zbx_history_record_vector_create(&values);
 
-		if (SUCCEED == zbx_vc_get_values(items[i].itemid, items[i].value_type, &values, seconds, count, &ts) &&
+		if (SUCCEED == zbx_vc_get_values(items.values[i].first, value_type, &values, seconds, count, &ts) &&
 				0 < values.values_num)
 		{
-			evaluate_history_func(&values, items[i].value_type, item_func, &item_result);
+			evaluate_history_func(&values, value_type, item_func, &item_result);
 
-			if (item->value_type == items[i].value_type)
+			if (item->value_type == value_type)
 				group_value.value = item_result;
 			else
 			{
@@ -450,7 +395,7 @@ static int	evaluate_aggregate(DC_ITEM *item, AGENT_RESULT *res, int grp_func, zb
 			zbx_vector_history_record_append_ptr(&group_values, &group_value);
 		}
 
-		zbx_history_record_vector_destroy(&values, items[i].value_type);
+		zbx_history_record_vector_destroy(&values, value_type);
 	}
 
 	if (0 == group_values.values_num)
@@ -474,13 +419,9 @@ static int	evaluate_aggregate(DC_ITEM *item, AGENT_RESULT *res, int grp_func, zb
 
 	ret = SUCCEED;
 clean2:
-	DCconfig_clean_items(items, errcodes, itemids.values_num);
-
-	zbx_free(errcodes);
-	zbx_free(items);
 	zbx_history_record_vector_destroy(&group_values, item->value_type);
 clean1:
-	zbx_vector_uint64_destroy(&itemids);
+	zbx_vector_uint64_pair_destroy(&items);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -152,11 +152,7 @@ static int	calcitem_parse_expression(DC_ITEM *dc_item, expression_t *exp, char *
 
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() expression:'%s'", __func__, exp->exp);
 
-	if (SUCCEED == substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, &dc_item->host, NULL, NULL, NULL,
-			&exp->exp, MACRO_TYPE_ITEM_EXPRESSION, error, max_error_len))
-	{
-		ret = SUCCEED;
-	}
+	ret = SUCCEED;
 out:
 	zbx_free(buf);
 
@@ -165,206 +161,503 @@ out:
 	return ret;
 }
 
-static int	calcitem_evaluate_expression(expression_t *exp, char *error, size_t max_error_len,
-		zbx_vector_ptr_t *unknown_msgs)
+/* parsed formulas are dropped if the calculated item was not polled for a day */
+#define ZBX_CALCITEM_TTL		SEC_PER_DAY
+
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	char		*formula;	/* the formula the expression was parsed from */
+	char		*host;		/* the host of function references without host name */
+	expression_t	exp;
+	int		lastaccess;
+}
+zbx_calcitem_t;
+
+#define ZBX_CALC_FUNCTION_VALUE		0
+#define ZBX_CALC_FUNCTION_UNKNOWN	1
+#define ZBX_CALC_FUNCTION_ERROR		2
+
+/* function reference shared by calculated items of the same batch */
+typedef struct
+{
+	const char	*host;
+	const char	*key;
+	const char	*func;
+	const char	*params;
+	char		*value;		/* function value, 'unknown' message or error message */
+	int		item_index;	/* index of the referenced item in batch items */
+	int		state;		/* ZBX_CALC_FUNCTION_* */
+}
+zbx_calc_function_t;
+
+static zbx_hashset_t	calcitems;
+static int		calcitems_cleanup_time = 0;
+
+static zbx_hash_t	calc_function_hash(const void *data)
 {
-	function_t	*f = NULL;
-	char		*buf, replace[16], *errstr = NULL;
-	int		i, ret = SUCCEED;
-	zbx_host_key_t	*keys = NULL;
-	DC_ITEM		*items = NULL;
-	int		*errcodes = NULL;
-	zbx_timespec_t	ts;
+	const zbx_calc_function_t	*f = (const zbx_calc_function_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_FUNC(f->host);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(f->key, strlen(f->key), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(f->func, strlen(f->func), hash);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	return ZBX_DEFAULT_STRING_HASH_ALGO(f->params, strlen(f->params), hash);
+}
+
+static int	calc_function_compare(const void *d1, const void *d2)
+{
+	const zbx_calc_function_t	*f1 = (const zbx_calc_function_t *)d1;
+	const zbx_calc_function_t	*f2 = (const zbx_calc_function_t *)d2;
+	int				ret;
 
-	if (0 == exp->functions_num)
+	if (0 != (ret = strcmp(f1->host, f2->host)))
 		return ret;
 
-	keys = (zbx_host_key_t *)zbx_malloc(keys, sizeof(zbx_host_key_t) * (size_t)exp->functions_num);
-	items = (DC_ITEM *)zbx_malloc(items, sizeof(DC_ITEM) * (size_t)exp->functions_num);
-	errcodes = (int *)zbx_malloc(errcodes, sizeof(int) * (size_t)exp->functions_num);
+	if (0 != (ret = strcmp(f1->key, f2->key)))
+		return ret;
 
-	for (i = 0; i < exp->functions_num; i++)
-	{
-		keys[i].host = exp->functions[i].host;
-		keys[i].key = exp->functions[i].key;
-	}
+	if (0 != (ret = strcmp(f1->func, f2->func)))
+		return ret;
 
-	DCconfig_get_items_by_keys(items, keys, errcodes, exp->functions_num);
+	return strcmp(f1->params, f2->params);
+}
 
-	zbx_timespec(&ts);
+static int	calc_function_compare_host_key(const void *d1, const void *d2)
+{
+	const zbx_calc_function_t	*f1 = *(const zbx_calc_function_t * const *)d1;
+	const zbx_calc_function_t	*f2 = *(const zbx_calc_function_t * const *)d2;
+	int				ret;
 
-	for (i = 0; i < exp->functions_num; i++)
+	if (0 != (ret = strcmp(f1->host, f2->host)))
+		return ret;
+
+	return strcmp(f1->key, f2->key);
+}
+
+static void	calcitem_clean(zbx_calcitem_t *calcitem)
+{
+	zbx_free(calcitem->formula);
+	zbx_free(calcitem->host);
+	free_expression(&calcitem->exp);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes parsed formulas of calculated items that are not polled   *
+ *          anymore                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	calcitems_cleanup(int now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_calcitem_t		*calcitem;
+
+	zbx_hashset_iter_reset(&calcitems, &iter);
+
+	while (NULL != (calcitem = (zbx_calcitem_t *)zbx_hashset_iter_next(&iter)))
 	{
-		int	ret_unknown = 0;	/* flag raised if current function evaluates to ZBX_UNKNOWN */
-		char	*unknown_msg;
+		if (calcitem->lastaccess + ZBX_CALCITEM_TTL > now)
+			continue;
 
-		f = &exp->functions[i];
+		calcitem_clean(calcitem);
+		zbx_hashset_iter_remove(&iter);
+	}
+}
 
-		if (SUCCEED != errcodes[i])
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets parsed formula of calculated item                            *
+ *                                                                            *
+ * Parameters: dc_item       - [IN] the calculated item                       *
+ *             now           - [IN] the current time                          *
+ *             error         - [OUT] the error message                        *
+ *             max_error_len - [IN] the size of error message buffer          *
+ *                                                                            *
+ * Return value: the parsed formula or NULL if the formula is invalid         *
+ *                                                                            *
+ * Comments: The formula is parsed once and reused until the item formula or  *
+ *           host name is changed in configuration cache.                     *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_calcitem_t	*calcitem_get(DC_ITEM *dc_item, int now, char *error, int max_error_len)
+{
+	zbx_calcitem_t	*calcitem, calcitem_local;
+
+	if (NULL != (calcitem = (zbx_calcitem_t *)zbx_hashset_search(&calcitems, &dc_item->itemid)))
+	{
+		if (0 == strcmp(calcitem->formula, dc_item->params) && 0 == strcmp(calcitem->host, dc_item->host.host))
 		{
-			zbx_snprintf(error, max_error_len,
-					"Cannot evaluate function \"%s(%s)\":"
-					" item \"%s:%s\" does not exist.",
-					f->func, f->params, f->host, f->key);
-			ret = NOTSUPPORTED;
-			break;
+			calcitem->lastaccess = now;
+			return calcitem;
 		}
 
-		/* do not evaluate if the item is disabled or belongs to a disabled host */
+		calcitem_clean(calcitem);
+		zbx_hashset_remove_direct(&calcitems, calcitem);
+	}
 
-		if (ITEM_STATUS_ACTIVE != items[i].status)
-		{
-			zbx_snprintf(error, max_error_len,
-					"Cannot evaluate function \"%s(%s)\":"
-					" item \"%s:%s\" is disabled.",
-					f->func, f->params, f->host, f->key);
-			ret = NOTSUPPORTED;
-			break;
-		}
+	memset(&calcitem_local, 0, sizeof(calcitem_local));
+	calcitem_local.itemid = dc_item->itemid;
 
-		if (HOST_STATUS_MONITORED != items[i].host.status)
-		{
-			zbx_snprintf(error, max_error_len,
-					"Cannot evaluate function \"%s(%s)\":"
-					" item \"%s:%s\" belongs to a disabled host.",
-					f->func, f->params, f->host, f->key);
-			ret = NOTSUPPORTED;
-			break;
-		}
+	if (SUCCEED != calcitem_parse_expression(dc_item, &calcitem_local.exp, error, max_error_len))
+	{
+		free_expression(&calcitem_local.exp);
+		return NULL;
+	}
 
-		/* If the item is NOTSUPPORTED then evaluation is allowed for:   */
-		/*   - functions white-listed in evaluatable_for_notsupported(). */
-		/*     Their values can be evaluated to regular numbers even for */
-		/*     NOTSUPPORTED items. */
-		/*   - other functions. Result of evaluation is ZBX_UNKNOWN.     */
+	calcitem_local.formula = zbx_strdup(NULL, dc_item->params);
+	calcitem_local.host = zbx_strdup(NULL, dc_item->host.host);
+	calcitem_local.lastaccess = now;
 
-		if (ITEM_STATE_NOTSUPPORTED == items[i].state && FAIL == evaluatable_for_notsupported(f->func))
-		{
-			/* compose and store 'unknown' message for future use */
-			unknown_msg = zbx_dsprintf(NULL,
-					"Cannot evaluate function \"%s(%s)\": item \"%s:%s\" not supported.",
-					f->func, f->params, f->host, f->key);
+	return (zbx_calcitem_t *)zbx_hashset_insert(&calcitems, &calcitem_local, sizeof(calcitem_local));
+}
 
-			zbx_vector_ptr_append(unknown_msgs, unknown_msg);
-			ret_unknown = 1;
-		}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: evaluates function referenced by calculated items                 *
+ *                                                                            *
+ * Parameters: f       - [IN/OUT] the function reference                      *
+ *             item    - [IN] the referenced item                             *
+ *             errcode - [IN] the referenced item lookup result               *
+ *             ts      - [IN] the evaluation timestamp                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	calc_function_evaluate(zbx_calc_function_t *f, DC_ITEM *item, int errcode, const zbx_timespec_t *ts)
+{
+	char	*errstr = NULL;
 
-		f->value = (char *)zbx_malloc(f->value, MAX_BUFFER_LEN);
+	if (SUCCEED != errcode)
+	{
+		f->value = zbx_dsprintf(NULL, "Cannot evaluate function \"%s(%s)\": item \"%s:%s\" does not exist.",
+				f->func, f->params, f->host, f->key);
+		f->state = ZBX_CALC_FUNCTION_ERROR;
+		return;
+	}
 
-		if (0 == ret_unknown &&
-				SUCCEED != evaluate_function(f->value, &items[i], f->func, f->params, &ts, &errstr))
-		{
-			/* compose and store error message for future use */
-			if (NULL != errstr)
-			{
-				unknown_msg = zbx_dsprintf(NULL, "Cannot evaluate function \"%s(%s)\": %s.",
-						f->func, f->params, errstr);
-				zbx_free(errstr);
-			}
-			else
-			{
-				unknown_msg = zbx_dsprintf(NULL, "Cannot evaluate function \"%s(%s)\".",
-						f->func, f->params);
-			}
+	/* do not evaluate if the item is disabled or belongs to a disabled host */
 
-			zbx_vector_ptr_append(unknown_msgs, unknown_msg);
-			ret_unknown = 1;
-		}
+	if (ITEM_STATUS_ACTIVE != item->status)
+	{
+		f->value = zbx_dsprintf(NULL, "Cannot evaluate function \"%s(%s)\": item \"%s:%s\" is disabled.",
+				f->func, f->params, f->host, f->key);
+		f->state = ZBX_CALC_FUNCTION_ERROR;
+		return;
+	}
 
-		if (1 == ret_unknown || SUCCEED != is_double_suffix(f->value, ZBX_FLAG_DOUBLE_SUFFIX) || '-' == *f->value)
-		{
-			char	*wrapped;
+	if (HOST_STATUS_MONITORED != item->host.status)
+	{
+		f->value = zbx_dsprintf(NULL, "Cannot evaluate function \"%s(%s)\":"
+				" item \"%s:%s\" belongs to a disabled host.", f->func, f->params, f->host, f->key);
+		f->state = ZBX_CALC_FUNCTION_ERROR;
+		return;
+	}
 
-			if (0 == ret_unknown)
-			{
-				wrapped = zbx_dsprintf(NULL, "(%s)", f->value);
-			}
-			else
-			{
-				/* write a special token of unknown value with 'unknown' message number, like */
-				/* ZBX_UNKNOWN0, ZBX_UNKNOWN1 etc. not wrapped in () */
-				wrapped = zbx_dsprintf(NULL, ZBX_UNKNOWN_STR "%d", unknown_msgs->values_num - 1);
-			}
+	/* If the item is NOTSUPPORTED then evaluation is allowed for:   */
+	/*   - functions white-listed in evaluatable_for_notsupported(). */
+	/*     Their values can be evaluated to regular numbers even for */
+	/*     NOTSUPPORTED items. */
+	/*   - other functions. Result of evaluation is ZBX_UNKNOWN.     */
+
+	if (ITEM_STATE_NOTSUPPORTED == item->state && FAIL == evaluatable_for_notsupported(f->func))
+	{
+		/* compose and store 'unknown' message for future use */
+		f->value = zbx_dsprintf(NULL, "Cannot evaluate function \"%s(%s)\": item \"%s:%s\" not supported.",
+				f->func, f->params, f->host, f->key);
+		f->state = ZBX_CALC_FUNCTION_UNKNOWN;
+		return;
+	}
+
+	f->value = (char *)zbx_malloc(f->value, MAX_BUFFER_LEN);
 
-			zbx_free(f->value);
-			f->value = wrapped;
+	if (SUCCEED != evaluate_function(f->value, item, f->func, f->params, ts, &errstr))
+	{
+		zbx_free(f->value);
+
+		/* compose and store error message for future use */
+		if (NULL != errstr)
+		{
+			f->value = zbx_dsprintf(NULL, "Cannot evaluate function \"%s(%s)\": %s.", f->func, f->params,
+					errstr);
+			zbx_free(errstr);
 		}
 		else
-			f->value = (char *)zbx_realloc(f->value, strlen(f->value) + 1);
+			f->value = zbx_dsprintf(NULL, "Cannot evaluate function \"%s(%s)\".", f->func, f->params);
 
-		zbx_snprintf(replace, sizeof(replace), "{%d}", f->functionid);
-		buf = string_replace(exp->exp, replace, f->value);
-		zbx_free(exp->exp);
-		exp->exp = buf;
+		f->state = ZBX_CALC_FUNCTION_UNKNOWN;
+		return;
 	}
 
-	DCconfig_clean_items(items, errcodes, exp->functions_num);
-
-	zbx_free(errcodes);
-	zbx_free(items);
-	zbx_free(keys);
+	if (SUCCEED != is_double_suffix(f->value, ZBX_FLAG_DOUBLE_SUFFIX) || '-' == *f->value)
+	{
+		char	*wrapped;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+		wrapped = zbx_dsprintf(NULL, "(%s)", f->value);
+		zbx_free(f->value);
+		f->value = wrapped;
+	}
+	else
+		f->value = (char *)zbx_realloc(f->value, strlen(f->value) + 1);
 
-	return ret;
+	f->state = ZBX_CALC_FUNCTION_VALUE;
 }
 
-int	get_value_calculated(DC_ITEM *dc_item, AGENT_RESULT *result)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: substitutes function values in calculated item expression and     *
+ *          evaluates it                                                      *
+ *                                                                            *
+ * Parameters: dc_item   - [IN] the calculated item                           *
+ *             calcitem  - [IN] the parsed item formula                       *
+ *             functions - [IN] the evaluated functions referenced by formula *
+ *             result    - [OUT] the item value or error message              *
+ *                                                                            *
+ * Return value: SUCCEED - the expression was evaluated successfully          *
+ *               NOTSUPPORTED - otherwise                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	calcitem_evaluate_expression(DC_ITEM *dc_item, const zbx_calcitem_t *calcitem,
+		zbx_calc_function_t **functions, AGENT_RESULT *result)
 {
-	expression_t		exp;
-	int			ret;
-	char			error[MAX_STRING_LEN];
+	char			*exp, *buf, replace[16], error[MAX_STRING_LEN];
+	int			i, ret = NOTSUPPORTED;
 	double			value;
 	zbx_vector_ptr_t	unknown_msgs;		/* pointers to messages about origins of 'unknown' values */
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' expression:'%s'", __func__, dc_item->key_orig, dc_item->params);
+	/* Assumption: most often there will be no NOTSUPPORTED items and function errors. */
+	/* Therefore initialize error messages vector but do not reserve any space. */
+	zbx_vector_ptr_create(&unknown_msgs);
 
-	memset(&exp, 0, sizeof(exp));
+	exp = zbx_strdup(NULL, calcitem->exp.exp);
 
-	if (SUCCEED != (ret = calcitem_parse_expression(dc_item, &exp, error, sizeof(error))))
+	if (SUCCEED != substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, &dc_item->host, NULL, NULL, NULL,
+			&exp, MACRO_TYPE_ITEM_EXPRESSION, error, sizeof(error)))
 	{
-		SET_MSG_RESULT(result, strdup(error));
-		goto clean1;
+		SET_MSG_RESULT(result, zbx_strdup(NULL, error));
+		goto out;
 	}
 
-	/* Assumption: most often there will be no NOTSUPPORTED items and function errors. */
-	/* Therefore initialize error messages vector but do not reserve any space. */
-	zbx_vector_ptr_create(&unknown_msgs);
-
-	if (SUCCEED != (ret = calcitem_evaluate_expression(&exp, error, sizeof(error), &unknown_msgs)))
+	for (i = 0; i < calcitem->exp.functions_num; i++)
 	{
-		SET_MSG_RESULT(result, strdup(error));
-		goto clean;
+		zbx_calc_function_t	*f = functions[i];
+		char			*value_str;
+
+		switch (f->state)
+		{
+			case ZBX_CALC_FUNCTION_ERROR:
+				SET_MSG_RESULT(result, zbx_strdup(NULL, f->value));
+				goto out;
+			case ZBX_CALC_FUNCTION_UNKNOWN:
+				zbx_vector_ptr_append(&unknown_msgs, zbx_strdup(NULL, f->value));
+
+				/* write a special token of unknown value with 'unknown' message number, like */
+				/* ZBX_UNKNOWN0, ZBX_UNKNOWN1 etc. not wrapped in () */
+				value_str = zbx_dsprintf(NULL, ZBX_UNKNOWN_STR "%d", unknown_msgs.values_num - 1);
+				break;
+			default:
+				value_str = zbx_strdup(NULL, f->value);
+		}
+
+		zbx_snprintf(replace, sizeof(replace), "{%d}", calcitem->exp.functions[i].functionid);
+		buf = string_replace(exp, replace, value_str);
+		zbx_free(exp);
+		zbx_free(value_str);
+		exp = buf;
 	}
 
-	if (SUCCEED != evaluate(&value, exp.exp, error, sizeof(error), &unknown_msgs))
+	if (SUCCEED != evaluate(&value, exp, error, sizeof(error), &unknown_msgs))
 	{
-		SET_MSG_RESULT(result, strdup(error));
-		ret = NOTSUPPORTED;
-		goto clean;
+		SET_MSG_RESULT(result, zbx_strdup(NULL, error));
+		goto out;
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "%s() value:" ZBX_FS_DBL, __func__, value);
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() itemid:" ZBX_FS_UI64 " value:" ZBX_FS_DBL, __func__, dc_item->itemid,
+			value);
 
 	if (ITEM_VALUE_TYPE_UINT64 == dc_item->value_type && 0 > value)
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received value [" ZBX_FS_DBL "]"
 				" is not suitable for value type [%s].",
 				value, zbx_item_value_type_string((zbx_item_value_type_t)dc_item->value_type)));
-		ret = NOTSUPPORTED;
-		goto clean;
+		goto out;
 	}
 
 	SET_DBL_RESULT(result, value);
-clean:
+	ret = SUCCEED;
+out:
+	zbx_free(exp);
 	zbx_vector_ptr_clear_ext(&unknown_msgs, zbx_ptr_free);
 	zbx_vector_ptr_destroy(&unknown_msgs);
-clean1:
-	free_expression(&exp);
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates values of calculated items                             *
+ *                                                                            *
+ * Parameters: items    - [IN] the calculated items                           *
+ *             results  - [OUT] the item values or error messages             *
+ *             errcodes - [IN/OUT] the item errors, only items with SUCCEED   *
+ *                        error code are calculated                           *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: Formulas are parsed once per item and cached in the poller, see  *
+ *           calcitem_get(). Referenced items of the whole batch are resolved *
+ *           with a single configuration cache lookup and functions with the  *
+ *           same item and parameters are evaluated only once per batch.      *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_calculated(DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	const zbx_calcitem_t	**calcitems_batch;
+	zbx_calc_function_t	***functions, *f, f_local;
+	zbx_hashset_t		functions_uniq;
+	zbx_hashset_iter_t	iter;
+	zbx_vector_ptr_t	functions_sorted;
+	zbx_host_key_t		*keys;
+	DC_ITEM			*ref_items;
+	int			*ref_errcodes, i, j, keys_num = 0, now;
+	char			error[MAX_STRING_LEN];
+	zbx_timespec_t		ts;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	now = time(NULL);
+
+	if (0 == calcitems_cleanup_time)
+	{
+		zbx_hashset_create(&calcitems, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		calcitems_cleanup_time = now + SEC_PER_HOUR;
+	}
+	else if (calcitems_cleanup_time <= now)
+	{
+		calcitems_cleanup(now);
+		calcitems_cleanup_time = now + SEC_PER_HOUR;
+	}
+
+	calcitems_batch = (const zbx_calcitem_t **)zbx_malloc(NULL, sizeof(zbx_calcitem_t *) * (size_t)num);
+	functions = (zbx_calc_function_t ***)zbx_malloc(NULL, sizeof(zbx_calc_function_t **) * (size_t)num);
+	zbx_hashset_create(&functions_uniq, (size_t)num, calc_function_hash, calc_function_compare);
+
+	/* get parsed formulas and collect unique function references */
+	for (i = 0; i < num; i++)
+	{
+		calcitems_batch[i] = NULL;
+		functions[i] = NULL;
+
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() key:'%s' expression:'%s'", __func__, items[i].key_orig,
+				items[i].params);
+
+		if (NULL == (calcitems_batch[i] = calcitem_get(&items[i], now, error, sizeof(error))))
+		{
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, error));
+			errcodes[i] = NOTSUPPORTED;
+			continue;
+		}
+
+		if (0 == calcitems_batch[i]->exp.functions_num)
+			continue;
+
+		functions[i] = (zbx_calc_function_t **)zbx_malloc(NULL, sizeof(zbx_calc_function_t *) *
+				(size_t)calcitems_batch[i]->exp.functions_num);
+
+		for (j = 0; j < calcitems_batch[i]->exp.functions_num; j++)
+		{
+			const function_t	*function = &calcitems_batch[i]->exp.functions[j];
+
+			f_local.host = function->host;
+			f_local.key = function->key;
+			f_local.func = function->func;
+			f_local.params = function->params;
+
+			if (NULL == (f = (zbx_calc_function_t *)zbx_hashset_search(&functions_uniq, &f_local)))
+			{
+				f_local.value = NULL;
+				f_local.item_index = 0;
+				f_local.state = ZBX_CALC_FUNCTION_VALUE;
+				f = (zbx_calc_function_t *)zbx_hashset_insert(&functions_uniq, &f_local, sizeof(f_local));
+			}
+
+			functions[i][j] = f;
+		}
+	}
+
+	/* resolve referenced items, functions are sorted by host and key to look up every item once */
+	zbx_vector_ptr_create(&functions_sorted);
+	zbx_vector_ptr_reserve(&functions_sorted, (size_t)functions_uniq.num_data);
+
+	zbx_hashset_iter_reset(&functions_uniq, &iter);
+	while (NULL != (f = (zbx_calc_function_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_ptr_append(&functions_sorted, f);
+
+	zbx_vector_ptr_sort(&functions_sorted, calc_function_compare_host_key);
+
+	keys = (zbx_host_key_t *)zbx_malloc(NULL, sizeof(zbx_host_key_t) * (size_t)functions_sorted.values_num);
+
+	for (i = 0; i < functions_sorted.values_num; i++)
+	{
+		f = (zbx_calc_function_t *)functions_sorted.values[i];
+
+		if (0 == keys_num || 0 != strcmp(keys[keys_num - 1].host, f->host) ||
+				0 != strcmp(keys[keys_num - 1].key, f->key))
+		{
+			keys[keys_num].host = (char *)f->host;
+			keys[keys_num].key = (char *)f->key;
+			keys_num++;
+		}
+
+		f->item_index = keys_num - 1;
+	}
+
+	ref_items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)keys_num);
+	ref_errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)keys_num);
+
+	DCconfig_get_items_by_keys(ref_items, keys, ref_errcodes, (size_t)keys_num);
+
+	/* evaluate every unique function once */
+	zbx_timespec(&ts);
+
+	for (i = 0; i < functions_sorted.values_num; i++)
+	{
+		f = (zbx_calc_function_t *)functions_sorted.values[i];
+		calc_function_evaluate(f, &ref_items[f->item_index], ref_errcodes[f->item_index], &ts);
+	}
+
+	for (i = 0; i < num; i++)
+	{
+		if (NULL == calcitems_batch[i])
+			continue;
+
+		errcodes[i] = calcitem_evaluate_expression(&items[i], calcitems_batch[i], functions[i], &results[i]);
+		zbx_free(functions[i]);
+	}
+
+	DCconfig_clean_items(ref_items, ref_errcodes, (size_t)keys_num);
+	zbx_free(ref_errcodes);
+	zbx_free(ref_items);
+	zbx_free(keys);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() functions:%d items:%d", __func__, functions_sorted.values_num,
+			keys_num);
+
+	for (i = 0; i < functions_sorted.values_num; i++)
+		zbx_free(((zbx_calc_function_t *)functions_sorted.values[i])->value);
+
+	zbx_vector_ptr_destroy(&functions_sorted);
+	zbx_hashset_destroy(&functions_uniq);
+	zbx_free(functions);
+	zbx_free(calcitems_batch);
+}
+
+int	get_value_calculated(DC_ITEM *dc_item, AGENT_RESULT *result)
+{
+	int	errcode = SUCCEED;
+
+	get_values_calculated(dc_item, result, &errcode, 1);
+
+	return errcode;
+}
@@ -25,5 +25,6 @@
 #include "sysinfo.h"
 
 int	get_value_calculated(DC_ITEM *dc_item, AGENT_RESULT *result);
+void	get_values_calculated(DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num);
 
 #endif
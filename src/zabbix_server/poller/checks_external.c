@@ -20,6 +20,7 @@
 #include "common.h"
 #include "log.h"
 #include "zbxexec.h"
+#include "../forkserver/forkserver.h"
 
 #include "checks_external.h"
 
@@ -27,26 +28,22 @@ extern char	*CONFIG_EXTERNALSCRIPTS;
 
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieve data from script executed on Zabbix server               *
- *                                                                            *
- * Parameters: item - item we are interested in                               *
+ * Purpose: build the command line of external check                          *
  *                                                                            *
- * Return value: SUCCEED - data successfully retrieved and stored in result   *
- *                         and result_str (as string)                         *
- *               NOTSUPPORTED - requested item is not supported               *
+ * Parameters: item   - [IN] the external check item                          *
+ *             result - [OUT] the error message on failure                    *
+ *             cmd    - [OUT] the command line                                *
  *                                                                            *
- * Author: Mike Nestor, rewritten by Alexander Vladishev                      *
+ * Return value: SUCCEED - the command line was built successfully            *
+ *               NOTSUPPORTED - invalid key or script cannot be executed      *
  *                                                                            *
  ******************************************************************************/
-int	get_value_external(DC_ITEM *item, AGENT_RESULT *result)
+static int	external_get_command(const DC_ITEM *item, AGENT_RESULT *result, char **cmd)
 {
-	char		error[ITEM_ERROR_LEN_MAX], *cmd = NULL, *buf = NULL;
 	size_t		cmd_alloc = ZBX_KIBIBYTE, cmd_offset = 0;
 	int		i, ret = NOTSUPPORTED;
 	AGENT_REQUEST	request;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s'", __func__, item->key);
-
 	init_request(&request);
 
 	if (SUCCEED != parse_item_key(item->key, &request))
@@ -55,12 +52,13 @@ int	get_value_external(DC_ITEM *item, AGENT_RESULT *result)
 		goto out;
 	}
 
-	cmd = (char *)zbx_malloc(cmd, cmd_alloc);
-	zbx_snprintf_alloc(&cmd, &cmd_alloc, &cmd_offset, "%s/%s", CONFIG_EXTERNALSCRIPTS, get_rkey(&request));
+	*cmd = (char *)zbx_malloc(*cmd, cmd_alloc);
+	zbx_snprintf_alloc(cmd, &cmd_alloc, &cmd_offset, "%s/%s", CONFIG_EXTERNALSCRIPTS, get_rkey(&request));
 
-	if (-1 == access(cmd, X_OK))
+	if (-1 == access(*cmd, X_OK))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s: %s", cmd, zbx_strerror(errno)));
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s: %s", *cmd, zbx_strerror(errno)));
+		zbx_free(*cmd);
 		goto out;
 	}
 
@@ -72,31 +70,112 @@ int	get_value_external(DC_ITEM *item, AGENT_RESULT *result)
 		param = get_rparam(&request, i);
 
 		param_esc = zbx_dyn_escape_shell_single_quote(param);
-		zbx_snprintf_alloc(&cmd, &cmd_alloc, &cmd_offset, " '%s'", param_esc);
+		zbx_snprintf_alloc(cmd, &cmd_alloc, &cmd_offset, " '%s'", param_esc);
 		zbx_free(param_esc);
 	}
 
-	if (SUCCEED == (ret = zbx_execute(cmd, &buf, error, sizeof(error), CONFIG_TIMEOUT,
-			ZBX_EXIT_CODE_CHECKS_DISABLED, NULL)))
+	ret = SUCCEED;
+out:
+	free_request(&request);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieve data from scripts executed on Zabbix server              *
+ *                                                                            *
+ * Parameters: items    - [IN] the external check items                       *
+ *             results  - [OUT] the item values or error messages             *
+ *             errcodes - [IN/OUT] the item error codes, only items with      *
+ *                        SUCCEED error code are checked                      *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: The scripts are executed concurrently by the fork server, each   *
+ *           of them limited by the configured timeout.                       *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_external(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	zbx_forkserver_request_t	*requests;
+	char				**cmds;
+	int				*indexes, i, requests_num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	requests = (zbx_forkserver_request_t *)zbx_malloc(NULL, sizeof(zbx_forkserver_request_t) * num);
+	cmds = (char **)zbx_malloc(NULL, sizeof(char *) * num);
+	indexes = (int *)zbx_malloc(NULL, sizeof(int) * num);
+
+	for (i = 0; i < num; i++)
 	{
-		zbx_rtrim(buf, ZBX_WHITESPACE);
+		char	*cmd = NULL;
 
-		set_result_type(result, ITEM_VALUE_TYPE_TEXT, buf);
-		zbx_free(buf);
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		if (SUCCEED != (errcodes[i] = external_get_command(&items[i], &results[i], &cmd)))
+			continue;
+
+		requests[requests_num].command = cmd;
+		cmds[requests_num] = cmd;
+		indexes[requests_num++] = i;
 	}
-	else
+
+	zbx_forkserver_execute_batch(requests, requests_num, CONFIG_TIMEOUT, ZBX_EXIT_CODE_CHECKS_DISABLED);
+
+	for (i = 0; i < requests_num; i++)
 	{
-		if (SIG_ERROR != ret)
-			ret = NOTSUPPORTED;
+		zbx_forkserver_request_t	*request = &requests[i];
+		int				index = indexes[i];
+
+		if (SUCCEED == request->ret)
+		{
+			zbx_rtrim(request->output, ZBX_WHITESPACE);
+
+			set_result_type(&results[index], ITEM_VALUE_TYPE_TEXT, request->output);
+		}
+		else
+		{
+			errcodes[index] = (SIG_ERROR != request->ret ? NOTSUPPORTED : SIG_ERROR);
+
+			SET_MSG_RESULT(&results[index], zbx_strdup(NULL, request->error));
+		}
 
-		SET_MSG_RESULT(result, zbx_strdup(NULL, error));
+		zbx_free(request->output);
+		zbx_free(request->error);
+		zbx_free(cmds[i]);
 	}
-out:
-	zbx_free(cmd);
 
-	free_request(&request);
+	zbx_free(indexes);
+	zbx_free(cmds);
+	zbx_free(requests);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
 
-	return ret;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieve data from script executed on Zabbix server               *
+ *                                                                            *
+ * Parameters: item - item we are interested in                               *
+ *                                                                            *
+ * Return value: SUCCEED - data successfully retrieved and stored in result   *
+ *                         and result_str (as string)                         *
+ *               NOTSUPPORTED - requested item is not supported               *
+ *                                                                            *
+ * Author: Mike Nestor, rewritten by Alexander Vladishev                      *
+ *                                                                            *
+ ******************************************************************************/
+int	get_value_external(DC_ITEM *item, AGENT_RESULT *result)
+{
+	int	errcode = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s'", __func__, item->key);
+
+	get_values_external(item, result, &errcode, 1);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(errcode));
+
+	return errcode;
 }
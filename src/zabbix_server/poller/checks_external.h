@@ -24,5 +24,6 @@
 #include "sysinfo.h"
 
 int     get_value_external(DC_ITEM *item, AGENT_RESULT *result);
+void	get_values_external(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num);
 
 #endif
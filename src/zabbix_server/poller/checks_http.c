@@ -21,6 +21,7 @@
 #include "zbxhttp.h"
 #include "zbxjson.h"
 #include "log.h"
+#include "../dnsresolver/dnsresolver.h"
 #ifdef HAVE_LIBCURL
 
 #define HTTP_REQUEST_GET	0
@@ -31,13 +32,8 @@
 #define HTTP_STORE_RAW		0
 #define HTTP_STORE_JSON		1
 
-typedef struct
-{
-	char	*data;
-	size_t	allocated;
-	size_t	offset;
-}
-zbx_http_response_t;
+static CURLM	*curl_multi = NULL;
+static CURLSH	*curl_share = NULL;
 
 static const char	*zbx_request_string(int result)
 {
@@ -210,28 +206,36 @@ static void	http_output_json(unsigned char retrieve_mode, char **buffer, zbx_htt
 	zbx_json_free(&json);
 }
 
-int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare cURL easy handle for HTTP agent item request              *
+ *                                                                            *
+ * Parameters: context - [OUT] the request context                            *
+ *             item    - [IN] the HTTP agent item                             *
+ *             error   - [OUT] the error message                              *
+ *                                                                            *
+ * Return value: SUCCEED - the request was prepared successfully              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The context must be freed with zbx_http_context_clean() also if  *
+ *           this function fails.                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_http_request_prepare(zbx_http_context_t *context, const DC_ITEM *item, char **error)
 {
-	CURL			*easyhandle;
-	CURLcode		err;
-	char			url[ITEM_URL_LEN_MAX], errbuf[CURL_ERROR_SIZE], *error = NULL, *headers, *line, *buffer;
-	int			ret = NOTSUPPORTED, timeout_seconds, found = FAIL;
-	long			response_code;
-	struct curl_slist	*headers_slist = NULL;
-	struct zbx_json		json;
-	zbx_http_response_t	body = {0}, header = {0};
-	size_t			(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
-	char			application_json[] = {"Content-Type: application/json"};
-	char			application_xml[] = {"Content-Type: application/xml"};
+	CURLcode	err;
+	char		url[ITEM_URL_LEN_MAX], *headers, *line;
+	int		timeout_seconds, found = FAIL;
+	size_t		(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
+	char		application_json[] = {"Content-Type: application/json"};
+	char		application_xml[] = {"Content-Type: application/xml"};
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() request method '%s' URL '%s%s' headers '%s' message body '%s'",
-			__func__, zbx_request_string(item->request_method), item->url, item->query_fields,
-			item->headers, item->posts);
+	memset(context, 0, sizeof(zbx_http_context_t));
 
-	if (NULL == (easyhandle = curl_easy_init()))
+	if (NULL == (context->easyhandle = curl_easy_init()))
 	{
-		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot initialize cURL library"));
-		goto clean;
+		*error = zbx_strdup(*error, "Cannot initialize cURL library");
+		return FAIL;
 	}
 
 	switch (item->retrieve_mode)
@@ -245,98 +249,91 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 			break;
 		default:
 			THIS_SHOULD_NEVER_HAPPEN;
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Invalid retrieve mode"));
-			goto clean;
+			*error = zbx_strdup(*error, "Invalid retrieve mode");
+			return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERFUNCTION, curl_write_cb)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_HEADERFUNCTION, curl_write_cb)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set header function: %s",
-				curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot set header function: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERDATA, &header)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_HEADERDATA, &context->header)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set header callback: %s",
-				curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot set header callback: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set write function: %s", curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot set write function: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEDATA, &body)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_WRITEDATA, &context->body)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set write callback: %s", curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot set write callback: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ERRORBUFFER, errbuf)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_ERRORBUFFER, context->errbuf)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set error buffer: %s", curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot set error buffer: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROXY, item->http_proxy)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PROXY, item->http_proxy)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set proxy: %s", curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot set proxy: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_FOLLOWLOCATION,
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_FOLLOWLOCATION,
 			0 == item->follow_redirects ? 0L : 1L)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set follow redirects: %s", curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot set follow redirects: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	if (0 != item->follow_redirects &&
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
+	if (0 != item->follow_redirects && CURLE_OK != (err = curl_easy_setopt(context->easyhandle,
+			CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set number of redirects allowed: %s",
-				curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot set number of redirects allowed: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
 	if (FAIL == is_time_suffix(item->timeout, &timeout_seconds, strlen(item->timeout)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Invalid timeout: %s", item->timeout));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Invalid timeout: %s", item->timeout);
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, (long)timeout_seconds)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_TIMEOUT, (long)timeout_seconds)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot specify timeout: %s", curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot specify timeout: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	if (SUCCEED != zbx_http_prepare_ssl(easyhandle, item->ssl_cert_file, item->ssl_key_file, item->ssl_key_password,
-			item->verify_peer, item->verify_host, &error))
+	if (SUCCEED != zbx_http_prepare_ssl(context->easyhandle, item->ssl_cert_file, item->ssl_key_file,
+			item->ssl_key_password, item->verify_peer, item->verify_host, error))
 	{
-		SET_MSG_RESULT(result, error);
-		goto clean;
+		return FAIL;
 	}
 
-	if (SUCCEED != zbx_http_prepare_auth(easyhandle, item->authtype, item->username, item->password, &error))
+	if (SUCCEED != zbx_http_prepare_auth(context->easyhandle, item->authtype, item->username, item->password,
+			error))
 	{
-		SET_MSG_RESULT(result, error);
-		goto clean;
+		return FAIL;
 	}
 
-	if (SUCCEED != http_prepare_request(easyhandle, item->posts, item->request_method, &error))
-	{
-		SET_MSG_RESULT(result, error);
-		goto clean;
-	}
+	if (SUCCEED != http_prepare_request(context->easyhandle, item->posts, item->request_method, error))
+		return FAIL;
 
 	headers = item->headers;
 	while (NULL != (line = zbx_http_get_header(&headers)))
 	{
-		headers_slist = curl_slist_append(headers_slist, line);
+		context->headers_slist = curl_slist_append(context->headers_slist, line);
 
 		if (FAIL == found && 0 == strncmp(line, "Content-Type:", ZBX_CONST_STRLEN("Content-Type:")))
 			found = SUCCEED;
@@ -347,120 +344,149 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 	if (FAIL == found)
 	{
 		if (ZBX_POSTTYPE_JSON == item->post_type)
-			headers_slist = curl_slist_append(headers_slist, application_json);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_json);
 		else if (ZBX_POSTTYPE_XML == item->post_type)
-			headers_slist = curl_slist_append(headers_slist, application_xml);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_xml);
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, headers_slist)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_HTTPHEADER, context->headers_slist)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot specify headers: %s", curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot specify headers: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
 #if LIBCURL_VERSION_NUM >= 0x071304
 	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PROTOCOLS,
+			CURLPROTO_HTTP | CURLPROTO_HTTPS)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set allowed protocols: %s", curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot set allowed protocols: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 #endif
 
 	zbx_snprintf(url, sizeof(url),"%s%s", item->url, item->query_fields);
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, url)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_URL, url)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot specify URL: %s", curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot specify URL: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")))
+	if (SUCCEED != zbx_dns_cache_set_curl_resolve(context->easyhandle, url, item->http_proxy,
+			&context->resolve_slist, error))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set cURL encoding option: %s",
-				curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_COOKIEFILE, "")))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot enable cURL cookie engine: %s",
-				curl_easy_strerror(err)));
-		goto clean;
+		*error = zbx_dsprintf(*error, "Cannot set cURL encoding option: %s", curl_easy_strerror(err));
+		return FAIL;
+	}
+
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_COOKIEFILE, "")))
+	{
+		*error = zbx_dsprintf(*error, "Cannot enable cURL cookie engine: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	*errbuf = '\0';
+	*context->errbuf = '\0';
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: convert the response of finished HTTP agent request into item     *
+ *          value                                                             *
+ *                                                                            *
+ * Parameters: context - [IN] the request context with transfer result set    *
+ *             item    - [IN] the HTTP agent item                             *
+ *             result  - [OUT] the item value or error message                *
+ *                                                                            *
+ * Return value: SUCCEED - the value was retrieved successfully               *
+ *               NOTSUPPORTED - otherwise                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_http_request_process(zbx_http_context_t *context, const DC_ITEM *item, AGENT_RESULT *result)
+{
+	CURLcode		err;
+	char			*headers, *line, *buffer;
+	long			response_code;
+	struct zbx_json		json;
+	zbx_http_response_t	*body = &context->body, *header = &context->header;
 
-	if (CURLE_OK != (err = curl_easy_perform(easyhandle)))
+	if (CURLE_OK != context->err)
 	{
-		if (CURLE_WRITE_ERROR == err)
+		if (CURLE_WRITE_ERROR == context->err)
 		{
 			SET_MSG_RESULT(result, zbx_strdup(NULL, "The requested value is too large"));
 		}
 		else
 		{
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot perform request: %s",
-					'\0' == *errbuf ? curl_easy_strerror(err) : errbuf));
+					'\0' == *context->errbuf ? curl_easy_strerror(context->err) : context->errbuf));
 		}
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &response_code)))
+	if (CURLE_OK != (err = curl_easy_getinfo(context->easyhandle, CURLINFO_RESPONSE_CODE, &response_code)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot get the response code: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if ('\0' != *item->status_codes && FAIL == int_in_list(item->status_codes, response_code))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Response code \"%ld\" did not match any of the"
 				" required status codes \"%s\"", response_code, item->status_codes));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (NULL == header.data)
+	if (NULL == header->data)
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned empty header"));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	switch (item->retrieve_mode)
 	{
 		case ZBX_RETRIEVE_MODE_CONTENT:
-			if (NULL == body.data)
+			if (NULL == body->data)
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned empty content"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
-			if (FAIL == zbx_is_utf8(body.data))
+			if (FAIL == zbx_is_utf8(body->data))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
 			if (HTTP_STORE_JSON == item->output_format)
 			{
-				http_output_json(item->retrieve_mode, &buffer, &header, &body);
+				http_output_json(item->retrieve_mode, &buffer, header, body);
 				SET_TEXT_RESULT(result, buffer);
 			}
 			else
 			{
-				SET_TEXT_RESULT(result, body.data);
-				body.data = NULL;
+				SET_TEXT_RESULT(result, body->data);
+				body->data = NULL;
 			}
 			break;
 		case ZBX_RETRIEVE_MODE_HEADERS:
-			if (FAIL == zbx_is_utf8(header.data))
+			if (FAIL == zbx_is_utf8(header->data))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
 			if (HTTP_STORE_JSON == item->output_format)
 			{
 				zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 				zbx_json_addobject(&json, "header");
-				headers = header.data;
+				headers = header->data;
 				while (NULL != (line = zbx_http_get_header(&headers)))
 				{
 					http_add_json_header(&json, line);
@@ -471,40 +497,184 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 			}
 			else
 			{
-				SET_TEXT_RESULT(result, header.data);
-				header.data = NULL;
+				SET_TEXT_RESULT(result, header->data);
+				header->data = NULL;
 			}
 			break;
 		case ZBX_RETRIEVE_MODE_BOTH:
-			if (FAIL == zbx_is_utf8(header.data) || (NULL != body.data && FAIL == zbx_is_utf8(body.data)))
+			if (FAIL == zbx_is_utf8(header->data) || (NULL != body->data && FAIL == zbx_is_utf8(body->data)))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
 			if (HTTP_STORE_JSON == item->output_format)
 			{
-				http_output_json(item->retrieve_mode, &buffer, &header, &body);
+				http_output_json(item->retrieve_mode, &buffer, header, body);
 				SET_TEXT_RESULT(result, buffer);
 			}
 			else
 			{
-				zbx_strncpy_alloc(&header.data, &header.allocated, &header.offset,
-						body.data, body.offset);
-				SET_TEXT_RESULT(result, header.data);
-				header.data = NULL;
+				zbx_strncpy_alloc(&header->data, &header->allocated, &header->offset,
+						body->data, body->offset);
+				SET_TEXT_RESULT(result, header->data);
+				header->data = NULL;
 			}
 			break;
 	}
 
-	ret = SUCCEED;
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free resources allocated by HTTP agent request                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_http_context_clean(zbx_http_context_t *context)
+{
+	curl_slist_free_all(context->headers_slist);	/* must be called after curl_easy_perform() */
+	curl_slist_free_all(context->resolve_slist);
+	curl_easy_cleanup(context->easyhandle);
+	zbx_free(context->body.data);
+	zbx_free(context->header.data);
+}
+
+int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
+{
+	zbx_http_context_t	context;
+	char			*error = NULL;
+	int			ret = NOTSUPPORTED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() request method '%s' URL '%s%s' headers '%s' message body '%s'",
+			__func__, zbx_request_string(item->request_method), item->url, item->query_fields,
+			item->headers, item->posts);
+
+	if (SUCCEED != zbx_http_request_prepare(&context, item, &error))
+	{
+		SET_MSG_RESULT(result, error);
+		goto clean;
+	}
+
+	context.err = curl_easy_perform(context.easyhandle);
+	ret = zbx_http_request_process(&context, item, result);
 clean:
-	curl_slist_free_all(headers_slist);	/* must be called after curl_easy_perform() */
-	curl_easy_cleanup(easyhandle);
-	zbx_free(body.data);
-	zbx_free(header.data);
+	zbx_http_context_clean(&context);
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create cURL multi interface for concurrent HTTP agent requests    *
+ *                                                                            *
+ * Parameters: max_connections - [IN] the number of connections kept open     *
+ *             error           - [OUT] the error message                      *
+ *                                                                            *
+ * Return value: SUCCEED - the multi interface was created                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_http_requests_init(int max_connections, char **error)
+{
+	return zbx_http_multi_create(&curl_multi, &curl_share, max_connections, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start prepared HTTP agent request in the multi interface          *
+ *                                                                            *
+ * Parameters: context - [IN] the request context                             *
+ *             error   - [OUT] the error message                              *
+ *                                                                            *
+ * Return value: SUCCEED - the request was started                            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_http_request_start(zbx_http_context_t *context, char **error)
+{
+	CURLcode	err;
+	CURLMcode	m_err;
+
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_SHARE, curl_share)))
+	{
+		*error = zbx_dsprintf(*error, "Cannot set share handle: %s", curl_easy_strerror(err));
+		return FAIL;
+	}
+
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PRIVATE, context)))
+	{
+		*error = zbx_dsprintf(*error, "Cannot set private data: %s", curl_easy_strerror(err));
+		return FAIL;
+	}
+
+	if (CURLM_OK != (m_err = curl_multi_add_handle(curl_multi, context->easyhandle)))
+	{
+		*error = zbx_dsprintf(*error, "Cannot add request: %s", curl_multi_strerror(m_err));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for activity on connections of started requests              *
+ *                                                                            *
+ * Parameters: timeout_ms - [IN] the maximum time to wait in milliseconds     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_http_requests_wait(int timeout_ms)
+{
+	zbx_http_multi_wait(curl_multi, timeout_ms);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: advance started requests and collect the finished ones            *
+ *                                                                            *
+ * Parameters: finished - [OUT] the contexts of finished requests             *
+ *             error    - [OUT] the error message                             *
+ *                                                                            *
+ * Return value: SUCCEED - the requests were processed                        *
+ *               FAIL    - multi interface failure                            *
+ *                                                                            *
+ * Comments: Finished requests are removed from the multi interface, their    *
+ *           transfer result is stored in context err field.                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_http_requests_perform(zbx_vector_ptr_t *finished, char **error)
+{
+	CURLMcode	m_err;
+	CURLMsg		*msg;
+	int		running, queued;
+
+	while (CURLM_CALL_MULTI_PERFORM == (m_err = curl_multi_perform(curl_multi, &running)))
+		;
+
+	if (CURLM_OK != m_err)
+	{
+		*error = zbx_dsprintf(*error, "Cannot perform requests: %s", curl_multi_strerror(m_err));
+		return FAIL;
+	}
+
+	while (NULL != (msg = curl_multi_info_read(curl_multi, &queued)))
+	{
+		zbx_http_context_t	*context;
+		char			*ptr = NULL;
+
+		if (CURLMSG_DONE != msg->msg)
+			continue;
+
+		curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &ptr);
+		context = (zbx_http_context_t *)ptr;
+		context->err = msg->data.result;
+
+		curl_multi_remove_handle(curl_multi, msg->easy_handle);
+		zbx_vector_ptr_append(finished, context);
+	}
+
+	return SUCCEED;
+}
 #endif
@@ -25,7 +25,37 @@
 #ifdef HAVE_LIBCURL
 #include "dbcache.h"
 
+typedef struct
+{
+	char	*data;
+	size_t	allocated;
+	size_t	offset;
+}
+zbx_http_response_t;
+
+typedef struct
+{
+	CURL			*easyhandle;
+	struct curl_slist	*headers_slist;
+	struct curl_slist	*resolve_slist;
+	zbx_http_response_t	body;
+	zbx_http_response_t	header;
+	char			errbuf[CURL_ERROR_SIZE];
+	CURLcode		err;	/* result of the finished transfer */
+	void			*data;	/* request owner data */
+}
+zbx_http_context_t;
+
+int	zbx_http_request_prepare(zbx_http_context_t *context, const DC_ITEM *item, char **error);
+int	zbx_http_request_process(zbx_http_context_t *context, const DC_ITEM *item, AGENT_RESULT *result);
+void	zbx_http_context_clean(zbx_http_context_t *context);
+
 int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result);
+
+int	zbx_http_requests_init(int max_connections, char **error);
+int	zbx_http_request_start(zbx_http_context_t *context, char **error);
+void	zbx_http_requests_wait(int timeout_ms);
+int	zbx_http_requests_perform(zbx_vector_ptr_t *finished, char **error);
 #endif
 
 #endif
@@ -25,6 +25,8 @@
 #include "proxy.h"
 
 #include "../vmware/vmware.h"
+#include "../dnsresolver/dnsresolver.h"
+#include "../trapper/trapper_manager.h"
 #include "../../libs/zbxserver/zabbix_stats.h"
 #include "../../libs/zbxsysinfo/common/zabbix_stats.h"
 
@@ -449,6 +451,42 @@ int	get_value_internal(DC_ITEM *item, AGENT_RESULT *result)
 
 			SET_UI64_RESULT(result, process_forks);
 		}
+		else if (0 == strcmp(tmp, "lock_wait"))	/* zabbix["process",<type>,"lock_wait"] */
+		{
+			unsigned char	poller_type;
+
+			if (4 == nparams)
+			{
+				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+				goto out;
+			}
+
+			/* only the pollers taking items from configuration cache queues are measured */
+			switch (process_type)
+			{
+				case ZBX_PROCESS_TYPE_POLLER:
+					poller_type = ZBX_POLLER_TYPE_NORMAL;
+					break;
+				case ZBX_PROCESS_TYPE_UNREACHABLE:
+					poller_type = ZBX_POLLER_TYPE_UNREACHABLE;
+					break;
+				case ZBX_PROCESS_TYPE_PINGER:
+					poller_type = ZBX_POLLER_TYPE_PINGER;
+					break;
+				case ZBX_PROCESS_TYPE_JAVAPOLLER:
+					poller_type = ZBX_POLLER_TYPE_JAVA;
+					break;
+				case ZBX_PROCESS_TYPE_HTTPAGENTPOLLER:
+					poller_type = ZBX_POLLER_TYPE_HTTPAGENT;
+					break;
+				default:
+					SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+					goto out;
+			}
+
+			/* return cumulative seconds, the average number of waiting processes is its change per second */
+			SET_DBL_RESULT(result, zbx_dc_get_poller_lock_wait(poller_type));
+		}
 		else
 		{
 			unsigned char	aggr_func, state;
@@ -529,6 +567,24 @@ int	get_value_internal(DC_ITEM *item, AGENT_RESULT *result)
 				goto out;
 			}
 		}
+		else if (0 == strcmp(tmp, "functions"))
+		{
+			if (0 == (program_type & ZBX_PROGRAM_TYPE_SERVER))
+			{
+				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+				goto out;
+			}
+
+			if (NULL == tmp1 || '\0' == *tmp1 || 0 == strcmp(tmp1, "evaluated"))
+				SET_UI64_RESULT(result, *(zbx_uint64_t *)DCget_stats(ZBX_STATS_FUNCTIONS_EVALUATED));
+			else if (0 == strcmp(tmp1, "cached"))
+				SET_UI64_RESULT(result, *(zbx_uint64_t *)DCget_stats(ZBX_STATS_FUNCTIONS_CACHED));
+			else
+			{
+				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+				goto out;
+			}
+		}
 		else if (0 == strcmp(tmp, "history"))
 		{
 			if (NULL == tmp1 || '\0' == *tmp1 || 0 == strcmp(tmp1, "pfree"))
@@ -800,6 +856,183 @@ int	get_value_internal(DC_ITEM *item, AGENT_RESULT *result)
 
 		SET_UI64_RESULT(result, zbx_preprocessor_get_queue_size());
 	}
+	else if (0 == strcmp(tmp, "trapper_queue"))			/* zabbix["trapper_queue"] */
+	{
+		zbx_trapper_stats_t	stats;
+		char			*error = NULL;
+
+		if (1 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		if (FAIL == zbx_trapper_get_stats(&stats, &error))
+		{
+			SET_MSG_RESULT(result, error);
+			goto out;
+		}
+
+		SET_UI64_RESULT(result, stats.queue);
+	}
+	else if (0 == strcmp(tmp, "trapper_latency"))		/* zabbix["trapper_latency",<type>,<bucket>] */
+	{
+		zbx_trapper_stats_t	stats;
+		char			*error = NULL;
+		int			type, bucket;
+
+		if (3 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		tmp = get_rparam(&request, 1);
+
+		if (0 == strcmp(tmp, "wait"))
+			type = ZBX_TRAPPER_LATENCY_WAIT;
+		else if (0 == strcmp(tmp, "processing"))
+			type = ZBX_TRAPPER_LATENCY_PROCESSING;
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		if (FAIL == (bucket = zbx_histogram_get_bucket(&zbx_latency_buckets, get_rparam(&request, 2))))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+			goto out;
+		}
+
+		if (FAIL == zbx_trapper_get_stats(&stats, &error))
+		{
+			SET_MSG_RESULT(result, error);
+			goto out;
+		}
+
+		/* return cumulative number of connections with latency up to the bucket bound */
+		SET_UI64_RESULT(result, zbx_histogram_get_cumulative(stats.latency[type], bucket));
+	}
+	else if (0 == strcmp(tmp, "httptest_lag"))		/* zabbix["httptest_lag",<bucket>] */
+	{
+		zbx_uint64_t	value;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		/* return cumulative number of web scenarios started with lag up to the bucket bound */
+		if (SUCCEED != zbx_dc_get_httptest_lag(get_rparam(&request, 1), &value))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		SET_UI64_RESULT(result, value);
+	}
+	else if (0 == strcmp(tmp, "poller_lateness"))		/* zabbix["poller_lateness",<type>,<bucket>] */
+	{
+		unsigned char	poller_type;
+		zbx_uint64_t	value;
+
+		if (3 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		switch (get_process_type_by_name(get_rparam(&request, 1)))
+		{
+			case ZBX_PROCESS_TYPE_POLLER:
+				poller_type = ZBX_POLLER_TYPE_NORMAL;
+				break;
+			case ZBX_PROCESS_TYPE_UNREACHABLE:
+				poller_type = ZBX_POLLER_TYPE_UNREACHABLE;
+				break;
+			case ZBX_PROCESS_TYPE_IPMIPOLLER:
+				poller_type = ZBX_POLLER_TYPE_IPMI;
+				break;
+			case ZBX_PROCESS_TYPE_PINGER:
+				poller_type = ZBX_POLLER_TYPE_PINGER;
+				break;
+			case ZBX_PROCESS_TYPE_JAVAPOLLER:
+				poller_type = ZBX_POLLER_TYPE_JAVA;
+				break;
+			case ZBX_PROCESS_TYPE_HTTPAGENTPOLLER:
+				poller_type = ZBX_POLLER_TYPE_HTTPAGENT;
+				break;
+			default:
+				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+				goto out;
+		}
+
+		/* return cumulative number of item checks with lateness up to the bucket bound */
+		if (SUCCEED != zbx_dc_get_poller_lateness(poller_type, get_rparam(&request, 2), &value))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+			goto out;
+		}
+
+		SET_UI64_RESULT(result, value);
+	}
+	else if (0 == strcmp(tmp, "dns_cache"))			/* zabbix["dns_cache",<mode>] */
+	{
+		zbx_dns_cache_stats_t	stats;
+		zbx_uint64_t		lookups;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		if (SUCCEED != zbx_dns_cache_get_stats(&stats))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "DNS cache is disabled."));
+			goto out;
+		}
+
+		tmp = get_rparam(&request, 1);
+
+		if (0 == strcmp(tmp, "hits"))
+		{
+			SET_UI64_RESULT(result, stats.hits);
+		}
+		else if (0 == strcmp(tmp, "misses"))
+		{
+			SET_UI64_RESULT(result, stats.misses);
+		}
+		else if (0 == strcmp(tmp, "negative"))
+		{
+			SET_UI64_RESULT(result, stats.negative);
+		}
+		else if (0 == strcmp(tmp, "phits"))
+		{
+			/* percentage of lookups answered from the cache, including cached failures */
+			lookups = stats.hits + stats.negative + stats.misses;
+			SET_DBL_RESULT(result, 0 == lookups ? 0 : (double)(stats.hits + stats.negative) / lookups * 100);
+		}
+		else if (0 == strcmp(tmp, "refreshes"))
+		{
+			SET_UI64_RESULT(result, stats.refreshes);
+		}
+		else if (0 == strcmp(tmp, "entries"))
+		{
+			SET_UI64_RESULT(result, stats.entries);
+		}
+		else if (0 == strcmp(tmp, "pfree"))
+		{
+			SET_DBL_RESULT(result, (double)(stats.memory_total - stats.memory_used) / stats.memory_total * 100);
+		}
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+	}
 	else
 	{
 		SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid first parameter."));
@@ -22,6 +22,7 @@
 #include "preproc.h"
 #include "zbxlld.h"
 #include "checks_internal.h"
+#include "../alerter/alerter_protocol.h"
 
 /******************************************************************************
  *                                                                            *
@@ -189,6 +190,41 @@ int	zbx_get_value_internal_ext(const char *param1, const AGENT_REQUEST *request,
 
 		SET_UI64_RESULT(result, value);
 	}
+	else if (0 == strcmp(param1, "alerter_latency"))	/* zabbix["alerter_latency",<mediatypeid>,<bucket>] */
+	{
+		zbx_uint64_t	mediatypeid, latency[ZBX_ALERTER_LATENCY_BUCKETS];
+		char		*error = NULL;
+		int		bucket;
+
+		if (3 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		param2 = get_rparam(request, 1);
+
+		if (SUCCEED != is_uint64(param2, &mediatypeid))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		if (FAIL == (bucket = zbx_histogram_get_bucket(&zbx_latency_buckets, get_rparam(request, 2))))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+			goto out;
+		}
+
+		if (FAIL == zbx_alerter_get_latency(mediatypeid, latency, &error))
+		{
+			SET_MSG_RESULT(result, error);
+			goto out;
+		}
+
+		/* return cumulative number of alerts with queue latency up to the bucket bound */
+		SET_UI64_RESULT(result, zbx_histogram_get_cumulative(latency, bucket));
+	}
 	else
 	{
 		ret = FAIL;
@@ -25,14 +25,33 @@
 
 #include "checks_java.h"
 
-static int	parse_response(AGENT_RESULT *results, int *errcodes, int num, char *response,
-		char *error, int max_error_len)
+/* items of one batch requested from the same JMX endpoint with the same credentials */
+typedef struct
+{
+	int	*index;
+	int	index_num;
+	char	*request;
+}
+zbx_java_request_t;
+
+#define ZBX_JAVA_HEADER_DATA	"ZBXD"
+#define ZBX_JAVA_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_JAVA_HEADER_DATA)
+
+/* the connection to Java gateway is kept open between JMX requests */
+static zbx_socket_t	gateway_socket;
+static int		gateway_connected = FAIL;
+
+/* the number of responses received over the current connection */
+static int		gateway_responses;
+
+static int	parse_response(AGENT_RESULT *results, int *errcodes, const int *index, int index_num,
+		char *response, char *error, int max_error_len)
 {
 	const char		*p;
 	struct zbx_json_parse	jp, jp_data, jp_row;
 	char			*value = NULL;
 	size_t			value_alloc = 0;
-	int			i, ret = GATEWAY_ERROR;
+	int			i, k, ret = GATEWAY_ERROR;
 
 	if (SUCCEED == zbx_json_open(response, &jp))
 	{
@@ -52,10 +71,9 @@ static int	parse_response(AGENT_RESULT *results, int *errcodes, int num, char *r
 
 			p = NULL;
 
-			for (i = 0; i < num; i++)
+			for (k = 0; k < index_num; k++)
 			{
-				if (SUCCEED != errcodes[i])
-					continue;
+				i = index[k];
 
 				if (NULL == (p = zbx_json_next(&jp_data, p)))
 				{
@@ -126,55 +144,278 @@ int	get_value_java(unsigned char request, const DC_ITEM *item, AGENT_RESULT *res
 	return errcode;
 }
 
-void	get_values_java(unsigned char request, const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+static void	java_set_error(AGENT_RESULT *results, int *errcodes, const int *index, int index_num, int err,
+		const char *error)
 {
-	zbx_socket_t	s;
-	struct zbx_json	json;
-	char		error[MAX_STRING_LEN];
-	int		i, j, err = SUCCEED;
+	int	k;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() jmx_endpoint:'%s' num:%d", __func__, items[0].jmx_endpoint, num);
+	zabbix_log(LOG_LEVEL_DEBUG, "getting Java values failed: %s", error);
 
-	for (j = 0; j < num; j++)	/* locate first supported item to use as a reference */
+	for (k = 0; k < index_num; k++)
 	{
-		if (SUCCEED == errcodes[j])
-			break;
+		SET_MSG_RESULT(&results[index[k]], zbx_strdup(NULL, error));
+		errcodes[index[k]] = err;
 	}
+}
 
-	if (j == num)	/* all items already NOTSUPPORTED (with invalid key or port) */
-		goto out;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads the specified number of bytes from Java gateway connection  *
+ *                                                                            *
+ * Comments: Unlike zbx_tcp_recv() does not read ahead, so the responses to   *
+ *           pipelined requests are left in the socket until requested.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	java_read(zbx_socket_t *s, char *buf, size_t len, char *error, size_t max_error_len)
+{
+	ssize_t	nbytes;
+	size_t	offset = 0;
 
-	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+	while (offset < len)
+	{
+		if (ZBX_PROTO_ERROR == (nbytes = ZBX_TCP_READ(s->socket, buf + offset, len - offset)))
+		{
+			if (EINTR == errno && SUCCEED != zbx_alarm_timed_out())
+				continue;
 
-	if (NULL == CONFIG_JAVA_GATEWAY || '\0' == *CONFIG_JAVA_GATEWAY)
+			if (SUCCEED == zbx_alarm_timed_out())
+				zbx_strlcpy(error, "ZBX_TCP_READ() timed out", max_error_len);
+			else
+				zbx_snprintf(error, max_error_len, "ZBX_TCP_READ() failed: %s", zbx_strerror(errno));
+
+			return FAIL;
+		}
+
+		if (0 == nbytes)
+		{
+			zbx_strlcpy(error, "Connection closed by Java gateway", max_error_len);
+			return FAIL;
+		}
+
+		offset += (size_t)nbytes;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads one response from Java gateway connection                   *
+ *                                                                            *
+ * Parameters: s             - [IN] the Java gateway connection               *
+ *             response      - [OUT] the response data                        *
+ *             error         - [OUT] the error message                        *
+ *             max_error_len - [IN] the size of error buffer                  *
+ *                                                                            *
+ * Return value: SUCCEED - the response was read                              *
+ *               FAIL    - the connection cannot be used anymore              *
+ *                                                                            *
+ ******************************************************************************/
+static int	java_read_response(zbx_socket_t *s, char **response, char *error, size_t max_error_len)
+{
+	char		header[ZBX_JAVA_HEADER_LEN + 1 + sizeof(zbx_uint32_t) * 2];
+	zbx_uint32_t	len, reserved;
+
+	if (SUCCEED != java_read(s, header, sizeof(header), error, max_error_len))
+		return FAIL;
+
+	if (0 != memcmp(header, ZBX_JAVA_HEADER_DATA, ZBX_JAVA_HEADER_LEN) ||
+			ZBX_TCP_PROTOCOL != header[ZBX_JAVA_HEADER_LEN])
 	{
-		err = GATEWAY_ERROR;
-		strscpy(error, "JavaGateway configuration parameter not set or empty");
-		goto exit;
+		zbx_strlcpy(error, "Received message with invalid header from Java gateway", max_error_len);
+		return FAIL;
 	}
 
-	if (ZBX_JAVA_GATEWAY_REQUEST_INTERNAL == request)
+	memcpy(&len, header + ZBX_JAVA_HEADER_LEN + 1, sizeof(len));
+	memcpy(&reserved, header + ZBX_JAVA_HEADER_LEN + 1 + sizeof(len), sizeof(reserved));
+	len = zbx_letoh_uint32(len);
+
+	if (0 != reserved || ZBX_MAX_RECV_DATA_SIZE < len)
 	{
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_JAVA_GATEWAY_INTERNAL,
-				ZBX_JSON_TYPE_STRING);
+		zbx_strlcpy(error, "Received message from Java gateway exceeds the maximum size", max_error_len);
+		return FAIL;
 	}
-	else if (ZBX_JAVA_GATEWAY_REQUEST_JMX == request)
+
+	*response = (char *)zbx_malloc(NULL, (size_t)len + 1);
+
+	if (SUCCEED != java_read(s, *response, len, error, max_error_len))
 	{
-		for (i = j + 1; i < num; i++)
+		zbx_free(*response);
+		return FAIL;
+	}
+
+	(*response)[len] = '\0';
+
+	return SUCCEED;
+}
+
+static int	java_gateway_connect(char *error, size_t max_error_len)
+{
+	if (SUCCEED == gateway_connected)
+		return SUCCEED;
+
+	/* the connection is made within the timeout set by poller */
+	if (SUCCEED != zbx_tcp_connect(&gateway_socket, CONFIG_SOURCE_IP, CONFIG_JAVA_GATEWAY,
+			CONFIG_JAVA_GATEWAY_PORT, 0, ZBX_TCP_SEC_UNENCRYPTED, NULL, NULL))
+	{
+		zbx_strlcpy(error, zbx_socket_strerror(), max_error_len);
+		return FAIL;
+	}
+
+	gateway_connected = SUCCEED;
+	gateway_responses = 0;
+
+	return SUCCEED;
+}
+
+static void	java_gateway_disconnect(void)
+{
+	if (SUCCEED != gateway_connected)
+		return;
+
+	zbx_tcp_close(&gateway_socket);
+	gateway_connected = FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends JMX requests to Java gateway over persistent connection     *
+ *                                                                            *
+ * Parameters: requests     - [IN] the requests of the batch                  *
+ *             requests_num - [IN] the number of requests                     *
+ *             results      - [OUT] the item values                           *
+ *             errcodes     - [OUT] the item error codes                      *
+ *                                                                            *
+ * Comments: Gateways without pipelining support close connection after the   *
+ *           first response and reset it if more requests were sent, losing   *
+ *           the response. So requests are sent one by one until the gateway  *
+ *           has responded twice over the same connection. After that all     *
+ *           requests are written before reading the responses, so that Java  *
+ *           gateway can process requests to different endpoints              *
+ *           concurrently. Responses are returned in the order of requests.   *
+ *           The connection is reestablished if Java gateway closes it after  *
+ *           responding or if a connection kept from the previous batch was   *
+ *           broken.                                                          *
+ *           On timeout only the request awaited for fails, the unanswered    *
+ *           requests after it are set SIG_ERROR to be checked again later.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	java_send_requests(zbx_java_request_t *requests, int requests_num, AGENT_RESULT *results,
+		int *errcodes)
+{
+	char	error[MAX_STRING_LEN], *response;
+	int	i, err, sent, sent_max, received = 0, reused;
+
+	while (received < requests_num)
+	{
+		int	connection_received = 0;
+
+		reused = gateway_connected;
+
+		if (SUCCEED != java_gateway_connect(error, sizeof(error)))
+			break;
+
+		while (received < requests_num)
 		{
-			if (SUCCEED != errcodes[i])
-				continue;
+			sent_max = (2 <= gateway_responses ? requests_num : received + 1);
 
-			if (0 != strcmp(items[j].username, items[i].username) ||
-					0 != strcmp(items[j].password, items[i].password) ||
-					0 != strcmp(items[j].jmx_endpoint, items[i].jmx_endpoint))
+			for (sent = received; sent < sent_max; sent++)
 			{
-				err = GATEWAY_ERROR;
-				strscpy(error, "Java poller received items with different connection parameters");
-				goto exit;
+				zabbix_log(LOG_LEVEL_DEBUG, "JSON before sending [%s]", requests[sent].request);
+
+				if (SUCCEED != zbx_tcp_send(&gateway_socket, requests[sent].request))
+				{
+					zbx_strlcpy(error, zbx_socket_strerror(), sizeof(error));
+					break;
+				}
+			}
+
+			while (received < sent)
+			{
+				zbx_java_request_t	*request = &requests[received];
+
+				if (SUCCEED != java_read_response(&gateway_socket, &response, error, sizeof(error)))
+					break;
+
+				zabbix_log(LOG_LEVEL_DEBUG, "JSON back [%s]", response);
+
+				if (SUCCEED != (err = parse_response(results, errcodes, request->index,
+						request->index_num, response, error, sizeof(error))))
+				{
+					java_set_error(results, errcodes, request->index, request->index_num, err, error);
+				}
+
+				zbx_free(response);
+				received++;
+				connection_received++;
+				gateway_responses++;
 			}
+
+			if (received != sent_max)
+				break;
 		}
 
+		if (received == requests_num)
+			break;
+
+		java_gateway_disconnect();
+
+		if (SUCCEED == zbx_alarm_timed_out())
+			break;
+
+		/* retry once with a new connection if the old one was found to be broken */
+		if (0 == connection_received && SUCCEED != reused)
+			break;
+	}
+
+	if (received == requests_num)
+		return;
+
+	java_set_error(results, errcodes, requests[received].index, requests[received].index_num, GATEWAY_ERROR,
+			error);
+
+	if (SUCCEED == zbx_alarm_timed_out())
+	{
+		/* the requests are processed concurrently by Java gateway, so only the awaited one is known to be */
+		/* slow, the following ones are returned to queue without affecting availability of their hosts   */
+		err = SIG_ERROR;
+		zbx_strlcpy(error, "Timeout while waiting for response to another request", sizeof(error));
+	}
+	else
+		err = GATEWAY_ERROR;
+
+	for (i = received + 1; i < requests_num; i++)
+		java_set_error(results, errcodes, requests[i].index, requests[i].index_num, err, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves JMX item values from Java gateway                       *
+ *                                                                            *
+ * Comments: Items are grouped into one request per JMX endpoint and          *
+ *           credentials, the requests are pipelined over the same            *
+ *           connection.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	get_values_jmx(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	zbx_java_request_t	*requests;
+	int			i, j, requests_num = 0, *index, index_num;
+	unsigned char		*grouped;
+
+	requests = (zbx_java_request_t *)zbx_malloc(NULL, sizeof(zbx_java_request_t) * num);
+	index = (int *)zbx_malloc(NULL, sizeof(int) * num);
+	grouped = (unsigned char *)zbx_calloc(NULL, num, sizeof(unsigned char));
+
+	for (index_num = 0, j = 0; j < num; j++)
+	{
+		struct zbx_json	json;
+
+		if (SUCCEED != errcodes[j] || 0 != grouped[j])
+			continue;
+
+		zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+
 		zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_JAVA_GATEWAY_JMX, ZBX_JSON_TYPE_STRING);
 
 		if ('\0' != *items[j].username)
@@ -190,10 +431,85 @@ void	get_values_java(unsigned char request, const DC_ITEM *items, AGENT_RESULT *
 			zbx_json_addstring(&json, ZBX_PROTO_TAG_JMX_ENDPOINT, items[j].jmx_endpoint,
 					ZBX_JSON_TYPE_STRING);
 		}
+
+		requests[requests_num].index = index + index_num;
+		requests[requests_num].index_num = 0;
+
+		zbx_json_addarray(&json, ZBX_PROTO_TAG_KEYS);
+		for (i = j; i < num; i++)
+		{
+			if (SUCCEED != errcodes[i] || 0 != grouped[i])
+				continue;
+
+			if (0 != strcmp(items[j].username, items[i].username) ||
+					0 != strcmp(items[j].password, items[i].password) ||
+					0 != strcmp(items[j].jmx_endpoint, items[i].jmx_endpoint))
+			{
+				continue;
+			}
+
+			zbx_json_addstring(&json, NULL, items[i].key, ZBX_JSON_TYPE_STRING);
+			grouped[i] = 1;
+			index[index_num++] = i;
+			requests[requests_num].index_num++;
+		}
+		zbx_json_close(&json);
+
+		requests[requests_num++].request = zbx_strdup(NULL, json.buffer);
+		zbx_json_free(&json);
 	}
-	else
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() requests:%d", __func__, requests_num);
+
+	if (0 != requests_num)
+		java_send_requests(requests, requests_num, results, errcodes);
+
+	for (i = 0; i < requests_num; i++)
+		zbx_free(requests[i].request);
+
+	zbx_free(grouped);
+	zbx_free(index);
+	zbx_free(requests);
+}
+
+void	get_values_java(unsigned char request, const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	zbx_socket_t	s;
+	struct zbx_json	json;
+	char		error[MAX_STRING_LEN];
+	int		i, j, err = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	for (j = 0; j < num; j++)	/* locate first supported item to use as a reference */
+	{
+		if (SUCCEED == errcodes[j])
+			break;
+	}
+
+	if (j == num)	/* all items already NOTSUPPORTED (with invalid key or port) */
+		goto out;
+
+	if (NULL == CONFIG_JAVA_GATEWAY || '\0' == *CONFIG_JAVA_GATEWAY)
+	{
+		err = GATEWAY_ERROR;
+		strscpy(error, "JavaGateway configuration parameter not set or empty");
+		goto exit;
+	}
+
+	if (ZBX_JAVA_GATEWAY_REQUEST_JMX == request)
+	{
+		get_values_jmx(items, results, errcodes, num);
+		goto out;
+	}
+
+	if (ZBX_JAVA_GATEWAY_REQUEST_INTERNAL != request)
 		assert(0);
 
+	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+
+	zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_JAVA_GATEWAY_INTERNAL, ZBX_JSON_TYPE_STRING);
+
 	zbx_json_addarray(&json, ZBX_PROTO_TAG_KEYS);
 	for (i = j; i < num; i++)
 	{
@@ -213,9 +529,20 @@ void	get_values_java(unsigned char request, const DC_ITEM *items, AGENT_RESULT *
 		{
 			if (SUCCEED == (err = zbx_tcp_recv(&s)))
 			{
+				int	*index, index_num = 0;
+
 				zabbix_log(LOG_LEVEL_DEBUG, "JSON back [%s]", s.buffer);
 
-				err = parse_response(results, errcodes, num, s.buffer, error, sizeof(error));
+				index = (int *)zbx_malloc(NULL, sizeof(int) * num);
+
+				for (i = j; i < num; i++)
+				{
+					if (SUCCEED == errcodes[i])
+						index[index_num++] = i;
+				}
+
+				err = parse_response(results, errcodes, index, index_num, s.buffer, error, sizeof(error));
+				zbx_free(index);
 			}
 		}
 
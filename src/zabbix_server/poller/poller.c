@@ -47,11 +47,69 @@
 
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
+extern int		CONFIG_POLLER_SMOOTHING;
+extern int		CONFIG_POLLER_SMOOTHING_QUEUE;
 
 #ifdef HAVE_NETSNMP
 static volatile sig_atomic_t	snmp_cache_reload_requested;
 #endif
 
+#ifdef HAVE_LIBCURL
+#define ZBX_HTTPAGENT_POLLER_MAX_REQUESTS	512	/* the maximum number of concurrent HTTP agent requests */
+
+typedef struct
+{
+	DC_ITEM		*items;
+	AGENT_RESULT	results[MAX_HTTPAGENT_ITEMS];
+	int		errcodes[MAX_HTTPAGENT_ITEMS];
+	int		num;
+	int		pending;	/* the number of items with values not processed yet */
+}
+zbx_http_batch_t;
+
+typedef struct
+{
+	zbx_http_context_t	context;
+	zbx_http_batch_t	*batch;
+	int			index;
+}
+zbx_http_request_t;
+
+/* processed items of different batches returned to poller queue at once */
+typedef struct
+{
+	zbx_uint64_t	itemids[ZBX_HTTPAGENT_POLLER_MAX_REQUESTS];
+	unsigned char	states[ZBX_HTTPAGENT_POLLER_MAX_REQUESTS];
+	int		lastclocks[ZBX_HTTPAGENT_POLLER_MAX_REQUESTS];
+	int		errcodes[ZBX_HTTPAGENT_POLLER_MAX_REQUESTS];
+	int		num;
+}
+zbx_http_requeue_t;
+
+static int	http_requests_num = 0;
+#endif
+
+/* the maximum number of item fields besides key with macros expanded by prepare_items() */
+#define ZBX_POLLER_ITEM_FIELDS_MAX	6
+
+/* the maximum number of items with cached fields, items above it are expanded on every check */
+#define ZBX_POLLER_ITEMS_CACHE_MAX	10000
+
+/* item key and connection parameters with expanded macros */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	char		*key;
+	char		*fields[ZBX_POLLER_ITEM_FIELDS_MAX];
+	int		fields_num;
+	unsigned short	port;
+}
+zbx_poller_item_t;
+
+/* expanded item fields are reused until configuration cache poller revision changes */
+static zbx_hashset_t	poller_items;
+static zbx_uint64_t	poller_items_revision = 0;
+
 /******************************************************************************
  *                                                                            *
  * Purpose: write host availability changes into database                     *
@@ -480,45 +538,172 @@ static int	parse_query_fields(const DC_ITEM *item, char **query_fields)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieve values of metrics from monitored hosts                   *
+ * Purpose: gets item fields with macros expanded by prepare_items()          *
  *                                                                            *
- * Parameters: poller_type - [IN] poller type (ZBX_POLLER_TYPE_...)           *
+ * Parameters: item   - [IN] the item                                         *
+ *             fields - [OUT] the addresses of item fields                    *
  *                                                                            *
- * Return value: number of items processed                                    *
+ * Return value: the number of fields or FAIL if expanded fields of the item  *
+ *               type are not cached                                          *
  *                                                                            *
- * Author: Alexei Vladishev                                                   *
+ ******************************************************************************/
+static int	poller_item_fields(DC_ITEM *item, char **fields[ZBX_POLLER_ITEM_FIELDS_MAX])
+{
+	int	fields_num = 0;
+
+	switch (item->type)
+	{
+		case ITEM_TYPE_SNMPv3:
+			fields[fields_num++] = &item->snmpv3_securityname;
+			fields[fields_num++] = &item->snmpv3_authpassphrase;
+			fields[fields_num++] = &item->snmpv3_privpassphrase;
+			fields[fields_num++] = &item->snmpv3_contextname;
+			ZBX_FALLTHROUGH;
+		case ITEM_TYPE_SNMPv1:
+		case ITEM_TYPE_SNMPv2c:
+			fields[fields_num++] = &item->snmp_community;
+			fields[fields_num++] = &item->snmp_oid;
+			break;
+		case ITEM_TYPE_SSH:
+			fields[fields_num++] = &item->publickey;
+			fields[fields_num++] = &item->privatekey;
+			ZBX_FALLTHROUGH;
+		case ITEM_TYPE_TELNET:
+		case ITEM_TYPE_DB_MONITOR:
+			fields[fields_num++] = &item->params;
+			ZBX_FALLTHROUGH;
+		case ITEM_TYPE_SIMPLE:
+			fields[fields_num++] = &item->username;
+			fields[fields_num++] = &item->password;
+			break;
+		case ITEM_TYPE_JMX:
+			fields[fields_num++] = &item->username;
+			fields[fields_num++] = &item->password;
+			fields[fields_num++] = &item->jmx_endpoint;
+			break;
+		case ITEM_TYPE_HTTPAGENT:
+			/* URL, query fields and posts are processed beyond macro expansion */
+			return FAIL;
+	}
+
+	return fields_num;
+}
+
+static void	poller_item_clean(zbx_poller_item_t *poller_item)
+{
+	int	i;
+
+	zbx_free(poller_item->key);
+
+	for (i = 0; i < poller_item->fields_num; i++)
+		zbx_free(poller_item->fields[i]);
+}
+
+/******************************************************************************
  *                                                                            *
- * Comments: processes single item at a time except for Java, SNMP items,     *
- *           see DCconfig_get_poller_items()                                  *
+ * Purpose: drops expanded item fields if configuration affecting them was    *
+ *          changed                                                           *
  *                                                                            *
  ******************************************************************************/
-static int	get_values(unsigned char poller_type, int *nextcheck)
+static void	poller_items_validate(void)
 {
-	DC_ITEM			item ,*items;
-	AGENT_RESULT		results[MAX_POLLER_ITEMS];
-	int			errcodes[MAX_POLLER_ITEMS];
-	zbx_timespec_t		timespec;
-	char			*port = NULL, error[ITEM_ERROR_LEN_MAX];
-	int			i, num, last_available = HOST_AVAILABLE_UNKNOWN;
-	zbx_vector_ptr_t	add_results;
+	zbx_hashset_iter_t	iter;
+	zbx_poller_item_t	*poller_item;
+	zbx_uint64_t		revision;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	if (poller_items_revision == (revision = DCconfig_get_poller_revision()))
+		return;
 
-	items = &item;
-	num = DCconfig_get_poller_items(poller_type, &items);
+	zbx_hashset_iter_reset(&poller_items, &iter);
+	while (NULL != (poller_item = (zbx_poller_item_t *)zbx_hashset_iter_next(&iter)))
+		poller_item_clean(poller_item);
 
-	if (0 == num)
-	{
-		*nextcheck = DCconfig_get_poller_nextcheck(poller_type);
-		goto exit;
-	}
+	zbx_hashset_clear(&poller_items);
+	poller_items_revision = revision;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies cached expanded fields into item                           *
+ *                                                                            *
+ * Return value: SUCCEED - the item fields were restored                      *
+ *               FAIL    - the item fields must be expanded                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	poller_item_restore(DC_ITEM *item)
+{
+	zbx_poller_item_t	*poller_item;
+	char			**fields[ZBX_POLLER_ITEM_FIELDS_MAX];
+	int			i;
+
+	if (NULL == (poller_item = (zbx_poller_item_t *)zbx_hashset_search(&poller_items, &item->itemid)))
+		return FAIL;
+
+	if (poller_item->fields_num != poller_item_fields(item, fields))
+		return FAIL;
+
+	ZBX_STRDUP(item->key, poller_item->key);
+	item->interface.port = poller_item->port;
+
+	for (i = 0; i < poller_item->fields_num; i++)
+		ZBX_STRDUP(*fields[i], poller_item->fields[i]);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: caches expanded fields of successfully prepared item              *
+ *                                                                            *
+ ******************************************************************************/
+static void	poller_item_store(DC_ITEM *item)
+{
+	zbx_poller_item_t	poller_item_local, *poller_item;
+	char			**fields[ZBX_POLLER_ITEM_FIELDS_MAX];
+	int			i;
+
+	if (FAIL == (poller_item_local.fields_num = poller_item_fields(item, fields)))
+		return;
+
+	if (ZBX_POLLER_ITEMS_CACHE_MAX <= poller_items.num_data)
+		return;
+
+	poller_item_local.itemid = item->itemid;
+	poller_item = (zbx_poller_item_t *)zbx_hashset_insert(&poller_items, &poller_item_local,
+			sizeof(poller_item_local));
+
+	poller_item->key = zbx_strdup(NULL, item->key);
+	poller_item->port = item->interface.port;
+
+	for (i = 0; i < poller_item->fields_num; i++)
+		poller_item->fields[i] = zbx_strdup(NULL, *fields[i]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: expand macros in item fields used for retrieving values           *
+ *                                                                            *
+ * Parameters: items    - [IN/OUT] the items                                  *
+ *             results  - [OUT] the initialized item results                  *
+ *             errcodes - [OUT] SUCCEED or CONFIG_ERROR for each item         *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	prepare_items(DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	char	*port = NULL, error[ITEM_ERROR_LEN_MAX];
+	int	i;
+
+	poller_items_validate();
 
-	/* prepare items */
 	for (i = 0; i < num; i++)
 	{
 		init_result(&results[i]);
 		errcodes[i] = SUCCEED;
 
+		if (SUCCEED == poller_item_restore(&items[i]))
+			continue;
+
 		ZBX_STRDUP(items[i].key, items[i].key_orig);
 		if (SUCCEED != substitute_key_macros(&items[i].key, NULL, &items[i], NULL, NULL,
 				MACRO_TYPE_ITEM_KEY, error, sizeof(error)))
@@ -690,46 +875,71 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 						NULL, NULL, NULL, &items[i].password, MACRO_TYPE_COMMON, NULL, 0);
 				break;
 		}
+
+		poller_item_store(&items[i]);
 	}
 
 	zbx_free(port);
+}
 
-	zbx_vector_ptr_create(&add_results);
-
-	/* retrieve item values */
-	if (SUCCEED == is_snmp_type(items[0].type))
-	{
-#ifdef HAVE_NETSNMP
-		/* SNMP checks use their own timeouts */
-		get_values_snmp(items, results, errcodes, num, poller_type);
-#else
-		for (i = 0; i < num; i++)
-		{
-			if (SUCCEED != errcodes[i])
-				continue;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get availability of host set by the current batch of items        *
+ *                                                                            *
+ * Parameters: hosts  - [IN/OUT] the host availabilities (hostid, available)  *
+ *             hostid - [IN] the host identifier                              *
+ *                                                                            *
+ * Return value: the host availability entry, added as unknown if the batch   *
+ *               has no items of this host processed yet                      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_pair_t	*batch_host_availability(zbx_vector_uint64_pair_t *hosts, zbx_uint64_t hostid)
+{
+	int			i;
+	zbx_uint64_pair_t	pair;
 
-			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "Support for SNMP checks was not compiled in."));
-			errcodes[i] = CONFIG_ERROR;
-		}
-#endif
-	}
-	else if (ITEM_TYPE_JMX == items[0].type)
-	{
-		zbx_alarm_on(CONFIG_TIMEOUT);
-		get_values_java(ZBX_JAVA_GATEWAY_REQUEST_JMX, items, results, errcodes, num);
-		zbx_alarm_off();
-	}
-	else if (1 == num)
+	for (i = 0; i < hosts->values_num; i++)
 	{
-		if (SUCCEED == errcodes[0])
-			errcodes[0] = get_value(&items[0], &results[0], &add_results);
+		if (hosts->values[i].first == hostid)
+			return &hosts->values[i];
 	}
-	else
-		THIS_SHOULD_NEVER_HAPPEN;
 
-	zbx_timespec(&timespec);
+	pair.first = hostid;
+	pair.second = HOST_AVAILABLE_UNKNOWN;
+	zbx_vector_uint64_pair_append(hosts, pair);
+
+	return &hosts->values[hosts->values_num - 1];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: update host availability and pass item values to preprocessing    *
+ *                                                                            *
+ * Parameters: items       - [IN/OUT] the items                               *
+ *             results     - [IN] the item results                            *
+ *             errcodes    - [IN] the item retrieval result codes             *
+ *             num         - [IN] the number of items                         *
+ *             timespec    - [IN] the timestamp of item values                *
+ *             add_results - [IN] the additional values of single item        *
+ *             itemids     - [OUT] the item identifiers                       *
+ *             states      - [OUT] the item states                            *
+ *             lastclocks  - [OUT] the item value timestamps                  *
+ *                                                                            *
+ * Comments: Fields allocated by prepare_items() and results are freed. The   *
+ *           output arrays must have room for num items, the caller returns   *
+ *           items to poller queue with them.                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_items(DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num, zbx_timespec_t *timespec,
+		zbx_vector_ptr_t *add_results, zbx_uint64_t *itemids, unsigned char *states, int *lastclocks)
+{
+	int				i;
+	zbx_vector_uint64_pair_t	hosts;
+	zbx_uint64_pair_t		*host;
+
+	/* batches of Java pollers can have items of different hosts */
+	zbx_vector_uint64_pair_create(&hosts);
 
-	/* process item values */
 	for (i = 0; i < num; i++)
 	{
 		switch (errcodes[i])
@@ -737,19 +947,23 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 			case SUCCEED:
 			case NOTSUPPORTED:
 			case AGENT_ERROR:
-				if (HOST_AVAILABLE_TRUE != last_available)
+				host = batch_host_availability(&hosts, items[i].host.hostid);
+
+				if (HOST_AVAILABLE_TRUE != host->second)
 				{
-					zbx_activate_item_host(&items[i], &timespec);
-					last_available = HOST_AVAILABLE_TRUE;
+					zbx_activate_item_host(&items[i], timespec);
+					host->second = HOST_AVAILABLE_TRUE;
 				}
 				break;
 			case NETWORK_ERROR:
 			case GATEWAY_ERROR:
 			case TIMEOUT_ERROR:
-				if (HOST_AVAILABLE_FALSE != last_available)
+				host = batch_host_availability(&hosts, items[i].host.hostid);
+
+				if (HOST_AVAILABLE_FALSE != host->second)
 				{
-					zbx_deactivate_item_host(&items[i], &timespec, results[i].msg);
-					last_available = HOST_AVAILABLE_FALSE;
+					zbx_deactivate_item_host(&items[i], timespec, results[i].msg);
+					host->second = HOST_AVAILABLE_FALSE;
 				}
 				break;
 			case CONFIG_ERROR:
@@ -765,22 +979,22 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 
 		if (SUCCEED == errcodes[i])
 		{
-			if (0 == add_results.values_num)
+			if (0 == add_results->values_num)
 			{
 				items[i].state = ITEM_STATE_NORMAL;
 				zbx_preprocess_item_value(items[i].itemid, items[i].host.hostid, items[i].value_type,
-						items[i].flags, &results[i], &timespec, items[i].state, NULL);
+						items[i].flags, &results[i], timespec, items[i].state, NULL);
 			}
 			else
 			{
 				/* vmware.eventlog item returns vector of AGENT_RESULT representing events */
 
 				int		j;
-				zbx_timespec_t	ts_tmp = timespec;
+				zbx_timespec_t	ts_tmp = *timespec;
 
-				for (j = 0; j < add_results.values_num; j++)
+				for (j = 0; j < add_results->values_num; j++)
 				{
-					AGENT_RESULT	*add_result = (AGENT_RESULT *)add_results.values[j];
+					AGENT_RESULT	*add_result = (AGENT_RESULT *)add_results->values[j];
 
 					if (ISSET_MSG(add_result))
 					{
@@ -810,11 +1024,12 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 		{
 			items[i].state = ITEM_STATE_NOTSUPPORTED;
 			zbx_preprocess_item_value(items[i].itemid, items[i].host.hostid, items[i].value_type,
-					items[i].flags, NULL, &timespec, items[i].state, results[i].msg);
+					items[i].flags, NULL, timespec, items[i].state, results[i].msg);
 		}
 
-		DCpoller_requeue_items(&items[i].itemid, &items[i].state, &timespec.sec, &errcodes[i], 1, poller_type,
-				nextcheck);
+		itemids[i] = items[i].itemid;
+		states[i] = items[i].state;
+		lastclocks[i] = timespec->sec;
 
 		zbx_free(items[i].key);
 
@@ -863,6 +1078,96 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 		free_result(&results[i]);
 	}
 
+	zbx_vector_uint64_pair_destroy(&hosts);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieve values of metrics from monitored hosts                   *
+ *                                                                            *
+ * Parameters: poller_type - [IN] poller type (ZBX_POLLER_TYPE_...)           *
+ *                                                                            *
+ * Return value: number of items processed                                    *
+ *                                                                            *
+ * Author: Alexei Vladishev                                                   *
+ *                                                                            *
+ * Comments: processes single item at a time except for Java, SNMP items,     *
+ *           see DCconfig_get_poller_items()                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_values(unsigned char poller_type, int *nextcheck)
+{
+	DC_ITEM			item ,*items;
+	AGENT_RESULT		results[MAX_POLLER_ITEMS];
+	int			errcodes[MAX_POLLER_ITEMS], lastclocks[MAX_POLLER_ITEMS];
+	zbx_uint64_t		itemids[MAX_POLLER_ITEMS];
+	unsigned char		states[MAX_POLLER_ITEMS];
+	zbx_timespec_t		timespec;
+	int			i, num;
+	zbx_vector_ptr_t	add_results;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	items = &item;
+	num = DCconfig_get_poller_items(poller_type, &items);
+
+	if (0 == num)
+	{
+		*nextcheck = DCconfig_get_poller_nextcheck(poller_type);
+		goto exit;
+	}
+
+	prepare_items(items, results, errcodes, num);
+
+	zbx_vector_ptr_create(&add_results);
+
+	/* retrieve item values */
+	if (SUCCEED == is_snmp_type(items[0].type))
+	{
+#ifdef HAVE_NETSNMP
+		/* SNMP checks use their own timeouts */
+		get_values_snmp(items, results, errcodes, num, poller_type);
+#else
+		for (i = 0; i < num; i++)
+		{
+			if (SUCCEED != errcodes[i])
+				continue;
+
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "Support for SNMP checks was not compiled in."));
+			errcodes[i] = CONFIG_ERROR;
+		}
+#endif
+	}
+	else if (ITEM_TYPE_JMX == items[0].type)
+	{
+		zbx_alarm_on(CONFIG_TIMEOUT);
+		get_values_java(ZBX_JAVA_GATEWAY_REQUEST_JMX, items, results, errcodes, num);
+		zbx_alarm_off();
+	}
+	else if (ITEM_TYPE_CALCULATED == items[0].type)
+	{
+		get_values_calculated(items, results, errcodes, num);
+	}
+	else if (ITEM_TYPE_EXTERNAL == items[0].type)
+	{
+		/* external checks use their own timeouts */
+		get_values_external(items, results, errcodes, num);
+	}
+	else if (1 == num)
+	{
+		if (SUCCEED == errcodes[0])
+			errcodes[0] = get_value(&items[0], &results[0], &add_results);
+	}
+	else
+		THIS_SHOULD_NEVER_HAPPEN;
+
+	zbx_timespec(&timespec);
+
+	process_items(items, results, errcodes, num, &timespec, &add_results, itemids, states, lastclocks);
+
+	/* return all items to queue at once to lock configuration cache only once per batch */
+	DCpoller_requeue_items(itemids, states, lastclocks, errcodes, num, poller_type, nextcheck);
+
 	zbx_preprocessor_flush();
 	zbx_vector_ptr_clear_ext(&add_results, (zbx_mem_free_func_t)free_result_ptr);
 	zbx_vector_ptr_destroy(&add_results);
@@ -876,6 +1181,301 @@ exit:
 	return num;
 }
 
+#ifdef HAVE_LIBCURL
+/******************************************************************************
+ *                                                                            *
+ * Purpose: return processed HTTP agent items to poller queue                 *
+ *                                                                            *
+ * Parameters: requeue     - [IN/OUT] the processed items                     *
+ *             poller_type - [IN] the poller type (ZBX_POLLER_TYPE_...)       *
+ *             nextcheck   - [OUT] the next scheduled check in poller queue,  *
+ *                                 not changed if there are no items          *
+ *                                                                            *
+ ******************************************************************************/
+static void	http_requeue_flush(zbx_http_requeue_t *requeue, unsigned char poller_type, int *nextcheck)
+{
+	if (0 == requeue->num)
+		return;
+
+	DCpoller_requeue_items(requeue->itemids, requeue->states, requeue->lastclocks, requeue->errcodes,
+			requeue->num, poller_type, nextcheck);
+
+	requeue->num = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process value of a single item of HTTP agent poller batch         *
+ *                                                                            *
+ * Parameters: batch   - [IN/OUT] the batch of items                          *
+ *             index   - [IN] the item index in batch                         *
+ *             requeue - [IN/OUT] the processed items to return to queue      *
+ *                                                                            *
+ * Comments: The batch is freed after its last item is processed. The item    *
+ *           is returned to poller queue by http_requeue_flush().             *
+ *                                                                            *
+ ******************************************************************************/
+static void	http_batch_item_done(zbx_http_batch_t *batch, int index, zbx_http_requeue_t *requeue)
+{
+	zbx_timespec_t		timespec;
+	zbx_vector_ptr_t	add_results;
+	int			n = requeue->num++;
+
+	if (SUCCEED != batch->errcodes[index])
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "Item [%s:%s] error: %s", batch->items[index].host.host,
+				batch->items[index].key_orig, batch->results[index].msg);
+	}
+
+	zbx_vector_ptr_create(&add_results);
+	zbx_timespec(&timespec);
+
+	requeue->errcodes[n] = batch->errcodes[index];
+
+	process_items(&batch->items[index], &batch->results[index], &batch->errcodes[index], 1, &timespec,
+			&add_results, &requeue->itemids[n], &requeue->states[n], &requeue->lastclocks[n]);
+
+	zbx_vector_ptr_destroy(&add_results);
+
+	if (0 == --batch->pending)
+	{
+		DCconfig_clean_items(batch->items, NULL, batch->num);
+		zbx_free(batch->items);
+		zbx_free(batch);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: take due HTTP agent items from poller queue and start their       *
+ *          requests                                                          *
+ *                                                                            *
+ * Parameters: poller_type - [IN] the poller type (ZBX_POLLER_TYPE_...)       *
+ *             nextcheck   - [OUT] the next scheduled check in poller queue,  *
+ *                                 not changed if all requests were started   *
+ *                                                                            *
+ * Return value: number of items processed without starting request           *
+ *                                                                            *
+ ******************************************************************************/
+static int	http_requests_start(unsigned char poller_type, int *nextcheck)
+{
+	DC_ITEM			*items;
+	zbx_http_batch_t	*batch;
+	zbx_http_requeue_t	requeue;
+	int			i, num, processed = 0;
+
+	requeue.num = 0;
+
+	while (ZBX_HTTPAGENT_POLLER_MAX_REQUESTS >= http_requests_num + MAX_HTTPAGENT_ITEMS)
+	{
+		if (ZBX_HTTPAGENT_POLLER_MAX_REQUESTS < requeue.num + MAX_HTTPAGENT_ITEMS)
+			http_requeue_flush(&requeue, poller_type, nextcheck);
+
+		if (0 == (num = DCconfig_get_poller_items(poller_type, &items)))
+			break;
+
+		batch = (zbx_http_batch_t *)zbx_malloc(NULL, sizeof(zbx_http_batch_t));
+		batch->items = items;
+		batch->num = num;
+		batch->pending = num;
+
+		prepare_items(items, batch->results, batch->errcodes, num);
+
+		for (i = 0; i < num; i++)
+		{
+			zbx_http_request_t	*request;
+			char			*error = NULL;
+
+			if (SUCCEED == batch->errcodes[i])
+			{
+				request = (zbx_http_request_t *)zbx_malloc(NULL, sizeof(zbx_http_request_t));
+				request->batch = batch;
+				request->index = i;
+
+				if (SUCCEED == zbx_http_request_prepare(&request->context, &items[i], &error))
+				{
+					request->context.data = request;
+
+					if (SUCCEED == zbx_http_request_start(&request->context, &error))
+					{
+						http_requests_num++;
+						continue;
+					}
+				}
+
+				SET_MSG_RESULT(&batch->results[i], error);
+				batch->errcodes[i] = NOTSUPPORTED;
+				zbx_http_context_clean(&request->context);
+				zbx_free(request);
+			}
+
+			http_batch_item_done(batch, i, &requeue);
+			processed++;
+		}
+	}
+
+	http_requeue_flush(&requeue, poller_type, nextcheck);
+
+	return processed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for started HTTP agent requests and process values of the    *
+ *          finished ones                                                     *
+ *                                                                            *
+ * Parameters: poller_type - [IN] the poller type (ZBX_POLLER_TYPE_...)       *
+ *             timeout_ms  - [IN] the maximum time to wait in milliseconds    *
+ *             nextcheck   - [OUT] the next scheduled check in poller queue,  *
+ *                                 not changed if no requests finished        *
+ *                                                                            *
+ * Return value: number of items processed                                    *
+ *                                                                            *
+ * Comments: Items of all finished requests are returned to poller queue at   *
+ *           once, configuration cache is locked only once per call.          *
+ *                                                                            *
+ ******************************************************************************/
+static int	http_requests_finish(unsigned char poller_type, int timeout_ms, int *nextcheck)
+{
+	zbx_vector_ptr_t	finished;
+	zbx_http_requeue_t	requeue;
+	char			*error = NULL;
+	int			i, processed;
+
+	update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
+	zbx_http_requests_wait(timeout_ms);
+	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+	zbx_vector_ptr_create(&finished);
+	requeue.num = 0;
+
+	if (SUCCEED != zbx_http_requests_perform(&finished, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "%s", error);
+		zbx_free(error);
+	}
+
+	for (i = 0; i < finished.values_num; i++)
+	{
+		zbx_http_request_t	*request = (zbx_http_request_t *)((zbx_http_context_t *)finished.values[i])->data;
+		zbx_http_batch_t	*batch = request->batch;
+
+		batch->errcodes[request->index] = zbx_http_request_process(&request->context,
+				&batch->items[request->index], &batch->results[request->index]);
+
+		zbx_http_context_clean(&request->context);
+		http_requests_num--;
+
+		http_batch_item_done(batch, request->index, &requeue);
+		zbx_free(request);
+	}
+
+	http_requeue_flush(&requeue, poller_type, nextcheck);
+
+	processed = finished.values_num;
+	zbx_vector_ptr_destroy(&finished);
+
+	return processed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieve values of HTTP agent items concurrently                  *
+ *                                                                            *
+ * Parameters: poller_type - [IN] poller type (ZBX_POLLER_TYPE_...)           *
+ *             nextcheck   - [OUT] the next time to call this function        *
+ *                                                                            *
+ * Return value: number of items processed                                    *
+ *                                                                            *
+ * Comments: Requests are not waited for to finish, due items are taken from  *
+ *           poller queue while there are less than                           *
+ *           ZBX_HTTPAGENT_POLLER_MAX_REQUESTS requests in progress. All      *
+ *           requests share connection, DNS and TLS session caches, see       *
+ *           zbx_http_multi_create().                                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_values_http(unsigned char poller_type, int *nextcheck)
+{
+	int	processed, timeout_ms = 1000, queue_nextcheck = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() requests:%d", __func__, http_requests_num);
+
+	processed = http_requests_start(poller_type, &queue_nextcheck);
+
+	if (0 != http_requests_num)
+	{
+		/* wake up when next items become due if there is room for their requests */
+		if (ZBX_HTTPAGENT_POLLER_MAX_REQUESTS >= http_requests_num + MAX_HTTPAGENT_ITEMS)
+		{
+			if (FAIL == queue_nextcheck)
+				queue_nextcheck = DCconfig_get_poller_nextcheck(poller_type);
+
+			if (FAIL != queue_nextcheck)
+			{
+				double	delay_ms = (queue_nextcheck - zbx_time()) * 1000;
+
+				if (delay_ms < timeout_ms)
+					timeout_ms = 0 < delay_ms ? (int)delay_ms : 0;
+			}
+		}
+
+		processed += http_requests_finish(poller_type, timeout_ms, &queue_nextcheck);
+	}
+
+	if (0 != processed)
+		zbx_preprocessor_flush();
+
+	if (0 != http_requests_num)
+		*nextcheck = (int)time(NULL);
+	else if (FAIL != queue_nextcheck)
+		*nextcheck = queue_nextcheck;
+	else
+		*nextcheck = DCconfig_get_poller_nextcheck(poller_type);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d requests:%d", __func__, processed, http_requests_num);
+
+	return processed;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if poller must stop taking new items until preprocessing   *
+ *          manager processes the values already queued                       *
+ *                                                                            *
+ * Parameters: now - [IN] the current time                                    *
+ *                                                                            *
+ * Return value: SUCCEED - preprocessing queue is full, items must be left in *
+ *                         poller queue                                       *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Preprocessing queue size published by preprocessing manager in   *
+ *           history cache is checked at most once per second.                *
+ *                                                                            *
+ ******************************************************************************/
+static int	poller_preprocessing_overloaded(time_t now)
+{
+	static time_t	checked = 0;
+	static int	overloaded = FAIL;
+
+#ifdef HAVE_LIBCURL
+	/* running HTTP agent requests must be finished before they time out */
+	if (0 != http_requests_num)
+		return FAIL;
+#endif
+	if (now != checked)
+	{
+		overloaded = ((zbx_uint64_t)CONFIG_POLLER_SMOOTHING_QUEUE < zbx_hc_get_preprocessing_queue() ?
+				SUCCEED : FAIL);
+		checked = now;
+
+		if (SUCCEED == overloaded)
+			zabbix_log(LOG_LEVEL_DEBUG, "preprocessing queue is full, postponing item checks");
+	}
+
+	return overloaded;
+}
+
 static void	zbx_poller_sigusr_handler(int flags)
 {
 #ifdef HAVE_NETSNMP
@@ -889,9 +1489,12 @@ static void	zbx_poller_sigusr_handler(int flags)
 ZBX_THREAD_ENTRY(poller_thread, args)
 {
 	int		nextcheck, sleeptime = -1, processed = 0, old_processed = 0;
-	double		sec, total_sec = 0.0, old_total_sec = 0.0;
+	double		sec, total_sec = 0.0, old_total_sec = 0.0, lock_sec = 0.0, old_lock_sec = 0.0;
 	time_t		last_stat_time;
 	unsigned char	poller_type;
+#ifdef HAVE_LIBCURL
+	char		*error = NULL;
+#endif
 
 #define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
 				/* once in STAT_INTERVAL seconds */
@@ -914,8 +1517,19 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
 
+#ifdef HAVE_LIBCURL
+	if (ZBX_POLLER_TYPE_HTTPAGENT == poller_type &&
+			SUCCEED != zbx_http_requests_init(ZBX_HTTPAGENT_POLLER_MAX_REQUESTS, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize HTTP agent requests: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+#endif
 	zbx_set_sigusr_handler(zbx_poller_sigusr_handler);
 
+	zbx_hashset_create(&poller_items, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
 	while (ZBX_IS_RUNNING())
 	{
 		sec = zbx_time();
@@ -932,13 +1546,21 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 
 		if (0 != sleeptime)
 		{
-			zbx_setproctitle("%s #%d [got %d values in " ZBX_FS_DBL " sec, getting values]",
-					get_process_type_string(process_type), process_num, old_processed,
-					old_total_sec);
+			zbx_setproctitle("%s #%d [got %d values in " ZBX_FS_DBL " sec, config lock wait " ZBX_FS_DBL
+					" sec, getting values]", get_process_type_string(process_type), process_num,
+					old_processed, old_total_sec, old_lock_sec);
 		}
 
-		processed += get_values(poller_type, &nextcheck);
+		if (0 != CONFIG_POLLER_SMOOTHING && SUCCEED == poller_preprocessing_overloaded((time_t)sec))
+			nextcheck = (int)sec + 1;
+#ifdef HAVE_LIBCURL
+		else if (ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+			processed += get_values_http(poller_type, &nextcheck);
+#endif
+		else
+			processed += get_values(poller_type, &nextcheck);
 		total_sec += zbx_time() - sec;
+		lock_sec += DCconfig_get_poller_lock_wait();
 
 		sleeptime = calculate_sleeptime(nextcheck, POLLER_DELAY);
 
@@ -946,19 +1568,22 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 		{
 			if (0 == sleeptime)
 			{
-				zbx_setproctitle("%s #%d [got %d values in " ZBX_FS_DBL " sec, getting values]",
-					get_process_type_string(process_type), process_num, processed, total_sec);
+				zbx_setproctitle("%s #%d [got %d values in " ZBX_FS_DBL " sec, config lock wait "
+					ZBX_FS_DBL " sec, getting values]", get_process_type_string(process_type),
+					process_num, processed, total_sec, lock_sec);
 			}
 			else
 			{
-				zbx_setproctitle("%s #%d [got %d values in " ZBX_FS_DBL " sec, idle %d sec]",
-					get_process_type_string(process_type), process_num, processed, total_sec,
-					sleeptime);
+				zbx_setproctitle("%s #%d [got %d values in " ZBX_FS_DBL " sec, config lock wait "
+					ZBX_FS_DBL " sec, idle %d sec]", get_process_type_string(process_type),
+					process_num, processed, total_sec, lock_sec, sleeptime);
 				old_processed = processed;
 				old_total_sec = total_sec;
+				old_lock_sec = lock_sec;
 			}
 			processed = 0;
 			total_sec = 0.0;
+			lock_sec = 0.0;
 			last_stat_time = time(NULL);
 		}
 
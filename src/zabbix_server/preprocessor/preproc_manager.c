@@ -1230,7 +1230,7 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 	zbx_ipc_message_t		*message;
 	zbx_preprocessing_manager_t	manager;
 	int				ret;
-	double				time_stat, time_idle = 0, time_now, time_flush, sec;
+	double				time_stat, time_idle = 0, time_now, time_flush, time_queue, sec;
 
 #define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
 				/* once in STAT_INTERVAL seconds */
@@ -1258,6 +1258,7 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 	/* initialize statistics */
 	time_stat = zbx_time();
 	time_flush = time_stat;
+	time_queue = time_stat;
 
 	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
 
@@ -1322,6 +1323,13 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 			dc_flush_history();
 			time_flush = time_now;
 		}
+
+		/* pollers check the published queue size instead of requesting it */
+		if (1 <= time_now - time_queue)
+		{
+			zbx_hc_set_preprocessing_queue(manager.queued_num);
+			time_queue = time_now;
+		}
 	}
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
@@ -22,6 +22,7 @@
 #include "../ipmi/ipmi.h"
 #include "../poller/checks_ssh.h"
 #include "../poller/checks_telnet.h"
+#include "../forkserver/forkserver.h"
 #include "zbxexec.h"
 #include "zbxserver.h"
 #include "db.h"
@@ -441,8 +442,8 @@ int	zbx_script_execute(const zbx_script_t *script, const DC_HOST *host, char **r
 					break;
 				case ZBX_SCRIPT_EXECUTE_ON_SERVER:
 				case ZBX_SCRIPT_EXECUTE_ON_PROXY:
-					if (SUCCEED != (ret = zbx_execute(script->command, result, error, max_error_len,
-							CONFIG_TRAPPER_TIMEOUT, ZBX_EXIT_CODE_CHECKS_ENABLED, NULL)))
+					if (SUCCEED != (ret = zbx_forkserver_execute(script->command, result, error,
+							max_error_len, CONFIG_TRAPPER_TIMEOUT, ZBX_EXIT_CODE_CHECKS_ENABLED)))
 					{
 						ret = FAIL;
 					}
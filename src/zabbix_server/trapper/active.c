@@ -541,8 +541,8 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 	char			host[HOST_HOST_LEN_MAX], tmp[MAX_STRING_LEN], ip[INTERFACE_IP_LEN_MAX],
 				error[MAX_STRING_LEN], *host_metadata = NULL, *interface = NULL;
 	struct zbx_json		json;
-	int			ret = FAIL, i, version;
-	zbx_uint64_t		hostid;
+	int			ret = FAIL, i, version, has_revision = 0;
+	zbx_uint64_t		hostid, revision, agent_revision;
 	size_t			host_metadata_alloc = 1;	/* for at least NUL-termination char */
 	size_t			interface_alloc = 1;		/* for at least NUL-termination char */
 	unsigned short		port;
@@ -620,6 +620,23 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 		version = ZBX_COMPONENT_VERSION(4, 2);
 	}
 
+	if (ZBX_COMPONENT_VERSION(4, 4) <= version && SUCCEED == DCget_active_checks_revision(hostid, &revision))
+	{
+		has_revision = 1;
+
+		/* the agent already has the current list, reply without building it again */
+		if (SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_CONFIG_REVISION, tmp, sizeof(tmp), NULL) &&
+				SUCCEED == is_uint64(tmp, &agent_revision) && revision == agent_revision)
+		{
+			zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+			zbx_json_addstring(&json, ZBX_PROTO_TAG_RESPONSE, ZBX_PROTO_VALUE_SUCCESS,
+					ZBX_JSON_TYPE_STRING);
+			zbx_json_adduint64(&json, ZBX_PROTO_TAG_CONFIG_REVISION, revision);
+
+			goto send;
+		}
+	}
+
 	zbx_vector_uint64_create(&itemids);
 	zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_REFRESH_UNSUPPORTED);
 
@@ -751,6 +768,9 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 		zbx_json_close(&json);
 	}
 
+	if (0 != has_revision)
+		zbx_json_adduint64(&json, ZBX_PROTO_TAG_CONFIG_REVISION, revision);
+send:
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() sending [%s]", __func__, json.buffer);
 
 	if (SUCCEED != zbx_tcp_send_ext(sock, json.buffer, json.buffer_size, sock->protocol, CONFIG_TIMEOUT))
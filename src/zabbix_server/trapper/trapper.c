@@ -34,6 +34,7 @@
 #include "proxydata.h"
 #include "../alerter/alerter_protocol.h"
 #include "trapper_preproc.h"
+#include "trapper_manager.h"
 
 #include "daemon.h"
 #include "zbxcrypto.h"
@@ -1282,9 +1283,11 @@ static void	zbx_trapper_sigusr_handler(int flags)
 
 ZBX_THREAD_ENTRY(trapper_thread, args)
 {
-	double		sec = 0.0;
-	zbx_socket_t	s;
-	int		ret;
+	double			sec = 0.0;
+	zbx_socket_t		s;
+	zbx_ipc_socket_t	manager_socket;
+	zbx_timespec_t		ts;
+	int			ret;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -1307,6 +1310,10 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 
 	zbx_set_sigusr_handler(zbx_trapper_sigusr_handler);
 
+	/* with trapper manager the connections are accepted by manager and passed to free trappers */
+	if (0 != CONFIG_TRAPPERMAN_FORKS && SUCCEED != zbx_trapper_worker_register(&manager_socket))
+		exit(EXIT_FAILURE);
+
 	while (ZBX_IS_RUNNING())
 	{
 #ifdef HAVE_NETSNMP
@@ -1324,16 +1331,23 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 		/* Trapper has to accept all types of connections it can accept with the specified configuration. */
 		/* Only after receiving data it is known who has sent them and one can decide to accept or discard */
 		/* the data. */
-		ret = zbx_tcp_accept(&s, ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK | ZBX_TCP_SEC_UNENCRYPTED);
-		zbx_update_env(zbx_time());
-
-		if (SUCCEED == ret)
+		if (0 != CONFIG_TRAPPERMAN_FORKS)
+		{
+			ret = zbx_trapper_worker_accept(&manager_socket, &s,
+					ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK | ZBX_TCP_SEC_UNENCRYPTED, &ts);
+		}
+		else
 		{
-			zbx_timespec_t	ts;
+			ret = zbx_tcp_accept(&s, ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK | ZBX_TCP_SEC_UNENCRYPTED);
 
 			/* get connection timestamp */
 			zbx_timespec(&ts);
+		}
+
+		zbx_update_env(zbx_time());
 
+		if (SUCCEED == ret)
+		{
 			update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
 
 			zbx_setproctitle("%s #%d [processing data]", get_process_type_string(process_type),
@@ -1344,8 +1358,11 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 			sec = zbx_time() - sec;
 
 			zbx_tcp_unaccept(&s);
+
+			if (0 != CONFIG_TRAPPERMAN_FORKS)
+				zbx_trapper_worker_done(&manager_socket, sec);
 		}
-		else if (EINTR != zbx_socket_last_error())
+		else if (0 == CONFIG_TRAPPERMAN_FORKS && EINTR != zbx_socket_last_error())
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
 					zbx_socket_strerror());
@@ -0,0 +1,647 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+
+#ifdef HAVE_LIBEVENT
+#	include <event.h>
+#endif
+
+#include "log.h"
+#include "zbxself.h"
+#include "daemon.h"
+#include "zbxalgo.h"
+#include "zbxipcservice.h"
+#include "trapper_manager.h"
+
+extern unsigned char	process_type, program_type;
+extern int		server_num, process_num;
+
+extern int	CONFIG_TRAPPER_TIMEOUT;
+extern int	CONFIG_TCP_MAX_BACKLOG_SIZE;
+
+#if !defined(LIBEVENT_VERSION_NUMBER) || LIBEVENT_VERSION_NUMBER < 0x2000000
+typedef int evutil_socket_t;
+
+static struct event	*event_new(struct event_base *ev, evutil_socket_t fd, short what,
+		void(*cb_func)(int, short, void *), void *cb_arg)
+{
+	struct event	*event;
+
+	event = zbx_malloc(NULL, sizeof(struct event));
+	event_set(event, fd, what, cb_func, cb_arg);
+	event_base_set(ev, event);
+
+	return event;
+}
+
+static void	event_free(struct event *event)
+{
+	event_del(event);
+	zbx_free(event);
+}
+
+#endif
+
+/* the channel used to pass accepted connections from manager to trappers: */
+/*   [0] - manager side, [1] - trapper side                                */
+static int	trapper_channel[2] = {-1, -1};
+
+typedef struct
+{
+	struct event_base	*ev;
+	zbx_socket_t		*listen_sock;
+	struct event		**accept_events;
+	int			accepting;
+
+	/* number of registered trappers waiting for a connection */
+	int			free_num;
+
+	/* number of accepted connections waiting for the first data */
+	int			pending_num;
+
+	/* connections with data waiting for a free trapper */
+	zbx_queue_ptr_t		queue;
+
+	zbx_uint64_t		accepted_num;
+	zbx_uint64_t		dispatched_num;
+
+	zbx_trapper_stats_t	stats;
+}
+zbx_trapper_manager_t;
+
+typedef struct
+{
+	ZBX_SOCKET		fd;
+	zbx_timespec_t		ts;
+	double			time_accepted;
+	struct event		*ev;
+	zbx_trapper_manager_t	*manager;
+}
+zbx_trapper_conn_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates channel for passing accepted connections to trappers      *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the channel was created successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: must be called by the main process before forking trappers and  *
+ *           trapper manager                                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_trapper_manager_init(char **error)
+{
+	if (-1 == socketpair(AF_UNIX, SOCK_SEQPACKET, 0, trapper_channel))
+	{
+		*error = zbx_dsprintf(*error, "cannot create socket pair: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enables or disables accepting of new connections                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_manager_set_accepting(zbx_trapper_manager_t *manager, int accepting)
+{
+	int	i;
+
+	if (accepting == manager->accepting)
+		return;
+
+	for (i = 0; i < manager->listen_sock->num_socks; i++)
+	{
+		if (0 != accepting)
+			event_add(manager->accept_events[i], NULL);
+		else
+			event_del(manager->accept_events[i]);
+	}
+
+	manager->accepting = accepting;
+
+	if (0 == accepting)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "trapper manager connection limit %d reached, pausing accept",
+				CONFIG_TCP_MAX_BACKLOG_SIZE);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pauses accepting new connections when too many connections are    *
+ *          already waiting and resumes it when the backlog drains            *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_manager_update_accepting(zbx_trapper_manager_t *manager)
+{
+	int	conn_num;
+
+	conn_num = manager->pending_num + zbx_queue_ptr_values_num(&manager->queue);
+	trapper_manager_set_accepting(manager, conn_num < CONFIG_TCP_MAX_BACKLOG_SIZE ? 1 : 0);
+}
+
+static void	trapper_conn_free(zbx_trapper_conn_t *conn)
+{
+	if (NULL != conn->ev)
+		event_free(conn->ev);
+
+	if (ZBX_SOCKET_ERROR != conn->fd)
+		zbx_socket_close(conn->fd);
+
+	zbx_free(conn);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: passes queued connections to free trappers                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_manager_dispatch(zbx_trapper_manager_t *manager)
+{
+	zbx_trapper_conn_t	*conn;
+	struct msghdr		msg;
+	struct iovec		iov;
+	struct cmsghdr		*cmsg;
+	union
+	{
+		struct cmsghdr	align;
+		char		buf[CMSG_SPACE(sizeof(int))];
+	}
+	control;
+	double			now;
+
+	while (0 < manager->free_num && NULL != (conn = (zbx_trapper_conn_t *)zbx_queue_ptr_pop(&manager->queue)))
+	{
+		memset(&msg, 0, sizeof(msg));
+		memset(&control, 0, sizeof(control));
+
+		iov.iov_base = &conn->ts;
+		iov.iov_len = sizeof(conn->ts);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(cmsg), &conn->fd, sizeof(int));
+
+		if (-1 == sendmsg(trapper_channel[0], &msg, 0))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot pass connection to trapper: %s", zbx_strerror(errno));
+		}
+		else
+		{
+			now = zbx_time();
+			zbx_histogram_add(&zbx_latency_buckets, manager->stats.latency[ZBX_TRAPPER_LATENCY_WAIT],
+					now - conn->time_accepted);
+			manager->free_num--;
+			manager->dispatched_num++;
+		}
+
+		trapper_conn_free(conn);
+	}
+
+	trapper_manager_update_accepting(manager);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: queues connection for processing once the first data arrive, or   *
+ *          drops it if nothing was received within trapper timeout          *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_conn_read_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_trapper_conn_t	*conn = (zbx_trapper_conn_t *)arg;
+	zbx_trapper_manager_t	*manager = conn->manager;
+
+	ZBX_UNUSED(fd);
+
+	manager->pending_num--;
+
+	if (0 != (what & EV_TIMEOUT))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "dropping connection without data after %d seconds",
+				CONFIG_TRAPPER_TIMEOUT);
+		trapper_conn_free(conn);
+		trapper_manager_update_accepting(manager);
+		return;
+	}
+
+	event_free(conn->ev);
+	conn->ev = NULL;
+
+	zbx_queue_ptr_push(&manager->queue, conn);
+	trapper_manager_dispatch(manager);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: accepts all pending connections on a listening socket             *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_accept_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_trapper_manager_t	*manager = (zbx_trapper_manager_t *)arg;
+	zbx_trapper_conn_t	*conn;
+	ZBX_SOCKET		accepted_socket;
+	struct timeval		tv = {CONFIG_TRAPPER_TIMEOUT, 0};
+
+	ZBX_UNUSED(what);
+
+	while (0 != manager->accepting)
+	{
+		if (ZBX_SOCKET_ERROR == (accepted_socket = (ZBX_SOCKET)accept(fd, NULL, NULL)))
+		{
+			if (EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno)
+				zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
+						zbx_strerror(errno));
+			break;
+		}
+
+		conn = (zbx_trapper_conn_t *)zbx_malloc(NULL, sizeof(zbx_trapper_conn_t));
+		conn->fd = accepted_socket;
+		conn->manager = manager;
+		zbx_timespec(&conn->ts);
+		conn->time_accepted = zbx_time();
+
+		conn->ev = event_new(manager->ev, accepted_socket, EV_READ,
+				trapper_conn_read_cb, conn);
+		event_add(conn->ev, &tv);
+
+		manager->pending_num++;
+		manager->accepted_num++;
+
+		trapper_manager_update_accepting(manager);
+	}
+}
+
+static void	trapper_manager_init(zbx_trapper_manager_t *manager, zbx_ipc_service_t *service,
+		zbx_socket_t *listen_sock)
+{
+	int	i;
+
+	memset(manager, 0, sizeof(zbx_trapper_manager_t));
+
+	manager->ev = service->ev;
+	manager->listen_sock = listen_sock;
+	zbx_queue_ptr_create(&manager->queue);
+
+	manager->accept_events = (struct event **)zbx_malloc(NULL, sizeof(struct event *) * listen_sock->num_socks);
+
+	for (i = 0; i < listen_sock->num_socks; i++)
+	{
+		int	flags;
+
+		if (-1 == (flags = fcntl(listen_sock->sockets[i], F_GETFL, 0)) ||
+				-1 == fcntl(listen_sock->sockets[i], F_SETFL, flags | O_NONBLOCK))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot set listening socket to non-blocking mode: %s",
+					zbx_strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+
+		manager->accept_events[i] = event_new(service->ev, listen_sock->sockets[i], EV_READ | EV_PERSIST,
+				trapper_accept_cb, manager);
+	}
+
+	trapper_manager_set_accepting(manager, 1);
+}
+
+static void	trapper_manager_destroy(zbx_trapper_manager_t *manager)
+{
+	zbx_trapper_conn_t	*conn;
+	int			i;
+
+	while (NULL != (conn = (zbx_trapper_conn_t *)zbx_queue_ptr_pop(&manager->queue)))
+		trapper_conn_free(conn);
+
+	zbx_queue_ptr_destroy(&manager->queue);
+
+	for (i = 0; i < manager->listen_sock->num_socks; i++)
+		event_free(manager->accept_events[i]);
+
+	zbx_free(manager->accept_events);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: registers trapper as available for processing connections        *
+ *                                                                            *
+ * Parameters: ipc_socket - [OUT] the connection to trapper manager           *
+ *                                                                            *
+ * Return value: SUCCEED - the trapper was registered                         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_trapper_worker_register(zbx_ipc_socket_t *ipc_socket)
+{
+	char	*error = NULL;
+
+	if (FAIL == zbx_ipc_socket_open(ipc_socket, ZBX_IPC_SERVICE_TRAPPER, SEC_PER_MIN, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to trapper manager service: %s", error);
+		zbx_free(error);
+		return FAIL;
+	}
+
+	if (FAIL == zbx_ipc_socket_write(ipc_socket, ZBX_IPC_TRAPPER_REGISTER, NULL, 0))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot register in trapper manager service");
+		zbx_ipc_socket_close(ipc_socket);
+		return FAIL;
+	}
+
+	close(trapper_channel[0]);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: waits for a connection passed by trapper manager                  *
+ *                                                                            *
+ * Parameters: ipc_socket - [IN] the connection to trapper manager          *
+ *             s          - [IN/OUT] the listening socket, on success the     *
+ *                                   connection is attached to it             *
+ *             tls_accept - [IN] allowed connection types                     *
+ *             ts         - [OUT] the connection timestamp                    *
+ *                                                                            *
+ * Return value: SUCCEED - the connection was received and accepted           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The errors except interruption by signal are logged here. If the *
+ *           received connection is rejected the trapper is reported as free  *
+ *           again without processing time.                                   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_trapper_worker_accept(zbx_ipc_socket_t *ipc_socket, zbx_socket_t *s, unsigned int tls_accept,
+		zbx_timespec_t *ts)
+{
+	struct msghdr	msg;
+	struct iovec	iov;
+	struct cmsghdr	*cmsg;
+	union
+	{
+		struct cmsghdr	align;
+		char		buf[CMSG_SPACE(sizeof(int))];
+	}
+	control;
+	ssize_t		n;
+	int		fd;
+
+	memset(&msg, 0, sizeof(msg));
+
+	iov.iov_base = ts;
+	iov.iov_len = sizeof(zbx_timespec_t);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	if (-1 == (n = recvmsg(trapper_channel[1], &msg, 0)))
+	{
+		if (EINTR != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot receive connection from trapper manager: %s",
+					zbx_strerror(errno));
+			zbx_sleep(1);
+		}
+
+		return FAIL;
+	}
+
+	if (sizeof(zbx_timespec_t) != n || NULL == (cmsg = CMSG_FIRSTHDR(&msg)) || SOL_SOCKET != cmsg->cmsg_level ||
+			SCM_RIGHTS != cmsg->cmsg_type || CMSG_LEN(sizeof(int)) != cmsg->cmsg_len)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return FAIL;
+	}
+
+	memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+
+	if (SUCCEED != zbx_tcp_accept_connection(s, fd, tls_accept))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s", zbx_socket_strerror());
+
+		if (FAIL == zbx_ipc_socket_write(ipc_socket, ZBX_IPC_TRAPPER_DONE, NULL, 0))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot send processing result to trapper manager service");
+			exit(EXIT_FAILURE);
+		}
+
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: notifies trapper manager that connection has been processed       *
+ *                                                                            *
+ * Parameters: ipc_socket      - [IN] the connection to trapper manager       *
+ *             time_processing - [IN] the connection processing time          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_trapper_worker_done(zbx_ipc_socket_t *ipc_socket, double time_processing)
+{
+	if (FAIL == zbx_ipc_socket_write(ipc_socket, ZBX_IPC_TRAPPER_DONE, (unsigned char *)&time_processing,
+			sizeof(time_processing)))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot send processing result to trapper manager service");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets trapper manager queue and latency statistics                 *
+ *                                                                            *
+ * Parameters: stats - [OUT] the statistics                                   *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the statistics were returned successfully          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_trapper_get_stats(zbx_trapper_stats_t *stats, char **error)
+{
+	zbx_ipc_message_t	message;
+	zbx_ipc_socket_t	trapper_socket;
+	int			ret = FAIL;
+
+	if (0 == CONFIG_TRAPPERMAN_FORKS)
+	{
+		*error = zbx_strdup(NULL, "Trapper manager is not running.");
+		return FAIL;
+	}
+
+	if (FAIL == zbx_ipc_socket_open(&trapper_socket, ZBX_IPC_SERVICE_TRAPPER, SEC_PER_MIN, error))
+		return FAIL;
+
+	zbx_ipc_message_init(&message);
+
+	if (FAIL == zbx_ipc_socket_write(&trapper_socket, ZBX_IPC_TRAPPER_STATS, NULL, 0))
+	{
+		*error = zbx_strdup(NULL, "cannot send statistics request to trapper manager service");
+		goto out;
+	}
+
+	if (FAIL == zbx_ipc_socket_read(&trapper_socket, &message) || sizeof(zbx_trapper_stats_t) != message.size)
+	{
+		*error = zbx_strdup(NULL, "cannot read statistics response from trapper manager service");
+		goto out;
+	}
+
+	memcpy(stats, message.data, sizeof(zbx_trapper_stats_t));
+	ret = SUCCEED;
+out:
+	zbx_ipc_socket_close(&trapper_socket);
+	zbx_ipc_message_clean(&message);
+
+	return ret;
+}
+
+static void	trapper_manager_process_done(zbx_trapper_manager_t *manager, const zbx_ipc_message_t *message)
+{
+	double	time_processing;
+
+	if (sizeof(time_processing) == message->size)
+	{
+		memcpy(&time_processing, message->data, sizeof(time_processing));
+		zbx_histogram_add(&zbx_latency_buckets, manager->stats.latency[ZBX_TRAPPER_LATENCY_PROCESSING], time_processing);
+	}
+
+	manager->free_num++;
+	trapper_manager_dispatch(manager);
+}
+
+ZBX_THREAD_ENTRY(trapper_manager_thread, args)
+{
+#define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
+				/* once in STAT_INTERVAL seconds */
+
+	zbx_ipc_service_t	trapper_service;
+	char			*error = NULL;
+	zbx_ipc_client_t	*client;
+	zbx_ipc_message_t	*message;
+	double			time_stat, time_now, sec, time_idle = 0;
+	zbx_trapper_manager_t	manager;
+	int			ret;
+
+	process_type = ((zbx_thread_args_t *)args)->process_type;
+	server_num = ((zbx_thread_args_t *)args)->server_num;
+	process_num = ((zbx_thread_args_t *)args)->process_num;
+
+	zbx_setproctitle("%s #%d starting", get_process_type_string(process_type), process_num);
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(program_type),
+			server_num, get_process_type_string(process_type), process_num);
+
+	if (FAIL == zbx_ipc_service_start(&trapper_service, ZBX_IPC_SERVICE_TRAPPER, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot start trapper manager service: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
+	close(trapper_channel[1]);
+
+	trapper_manager_init(&manager, &trapper_service, (zbx_socket_t *)((zbx_thread_args_t *)args)->args);
+
+	/* initialize statistics */
+	time_stat = zbx_time();
+
+	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
+
+	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+	while (ZBX_IS_RUNNING())
+	{
+		time_now = zbx_time();
+
+		if (STAT_INTERVAL < time_now - time_stat)
+		{
+			zbx_setproctitle("%s #%d [accepted " ZBX_FS_UI64 ", dispatched " ZBX_FS_UI64 " connections,"
+					" queued %d, idle " ZBX_FS_DBL " sec during " ZBX_FS_DBL " sec]",
+					get_process_type_string(process_type), process_num, manager.accepted_num,
+					manager.dispatched_num, zbx_queue_ptr_values_num(&manager.queue), time_idle,
+					time_now - time_stat);
+
+			time_stat = time_now;
+			time_idle = 0;
+			manager.accepted_num = 0;
+			manager.dispatched_num = 0;
+		}
+
+		update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
+		ret = zbx_ipc_service_recv(&trapper_service, 1, &client, &message);
+		update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+		sec = zbx_time();
+		zbx_update_env(sec);
+
+		if (ZBX_IPC_RECV_IMMEDIATE != ret)
+			time_idle += sec - time_now;
+
+		if (NULL != message)
+		{
+			switch (message->code)
+			{
+				case ZBX_IPC_TRAPPER_REGISTER:
+					manager.free_num++;
+					trapper_manager_dispatch(&manager);
+					break;
+				case ZBX_IPC_TRAPPER_DONE:
+					trapper_manager_process_done(&manager, message);
+					break;
+				case ZBX_IPC_TRAPPER_STATS:
+					manager.stats.queue = (zbx_uint64_t)zbx_queue_ptr_values_num(&manager.queue);
+					zbx_ipc_client_send(client, message->code, (unsigned char *)&manager.stats,
+							sizeof(manager.stats));
+					break;
+			}
+
+			zbx_ipc_message_free(message);
+		}
+
+		if (NULL != client)
+			zbx_ipc_client_release(client);
+	}
+
+	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
+
+	while (1)
+		zbx_sleep(SEC_PER_MIN);
+
+	zbx_ipc_service_close(&trapper_service);
+	trapper_manager_destroy(&manager);
+#undef STAT_INTERVAL
+}
@@ -0,0 +1,65 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_TRAPPER_MANAGER_H
+#define ZABBIX_TRAPPER_MANAGER_H
+
+#include "comms.h"
+#include "threads.h"
+#include "zbxipcservice.h"
+
+#define ZBX_IPC_SERVICE_TRAPPER	"trapper"
+
+/* trapper -> manager */
+#define ZBX_IPC_TRAPPER_REGISTER	1000
+#define ZBX_IPC_TRAPPER_DONE		1001
+
+/* internal checks -> manager */
+#define ZBX_IPC_TRAPPER_STATS		1100
+
+#define ZBX_TRAPPER_LATENCY_WAIT	0
+#define ZBX_TRAPPER_LATENCY_PROCESSING	1
+#define ZBX_TRAPPER_LATENCY_COUNT	2
+
+#define ZBX_TRAPPER_LATENCY_BUCKETS	ZBX_LATENCY_BUCKETS
+
+typedef struct
+{
+	/* connections with data waiting for a free trapper */
+	zbx_uint64_t	queue;
+
+	/* non-cumulative latency histograms of queue waiting and processing times */
+	zbx_uint64_t	latency[ZBX_TRAPPER_LATENCY_COUNT][ZBX_TRAPPER_LATENCY_BUCKETS];
+}
+zbx_trapper_stats_t;
+
+extern int	CONFIG_TRAPPERMAN_FORKS;
+
+int	zbx_trapper_manager_init(char **error);
+
+int	zbx_trapper_worker_register(zbx_ipc_socket_t *ipc_socket);
+int	zbx_trapper_worker_accept(zbx_ipc_socket_t *ipc_socket, zbx_socket_t *s, unsigned int tls_accept,
+		zbx_timespec_t *ts);
+void	zbx_trapper_worker_done(zbx_ipc_socket_t *ipc_socket, double time_processing);
+
+int	zbx_trapper_get_stats(zbx_trapper_stats_t *stats, char **error);
+
+ZBX_THREAD_ENTRY(trapper_manager_thread, args);
+
+#endif
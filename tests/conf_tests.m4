@@ -34,10 +34,16 @@ AC_DEFUN([CONF_TESTS],[
 		tests/libs/zbxcommshigh/Makefile
 		tests/libs/zbxalgo/Makefile
 		tests/libs/zbxprometheus/Makefile
+		tests/libs/zbxserver/Makefile
 		tests/zabbix_server/Makefile
+		tests/zabbix_server/dnsresolver/Makefile
+		tests/zabbix_server/lld/Makefile
+		tests/zabbix_server/poller/Makefile
 		tests/zabbix_server/preprocessor/Makefile
 		tests/libs/zbxcomms/Makefile
 		tests/zabbix_server/trapper/Makefile
+		tests/zabbix_agent/Makefile
+		tests/zabbix_agent/logfiles/Makefile
 		tests/mocks/Makefile
 		tests/mocks/configcache/Makefile
 		tests/mocks/valuecache/Makefile
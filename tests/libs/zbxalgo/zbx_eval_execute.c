@@ -0,0 +1,193 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+#define EVAL_VALUES_MAX	16
+
+/* convert function value the same way as trigger expressions do before executing compiled code */
+static void	eval_value_parse(const char *str, zbx_eval_value_t *value)
+{
+	if (0 == strncmp(str, ZBX_UNKNOWN_STR, ZBX_UNKNOWN_STR_LEN))
+	{
+		value->value = ZBX_UNKNOWN;
+		value->unknown_idx = atoi(str + ZBX_UNKNOWN_STR_LEN);
+		return;
+	}
+
+	value->value = evaluate_string_to_double(str);
+	value->unknown_idx = -1;
+
+	if (ZBX_INFINITY == value->value)
+		fail_msg("invalid function value \"%s\"", str);
+}
+
+/* substitute function values into expression the same way as substitute_expression_functions_results() */
+static char	*eval_substitute(const char *expression, const char **values, int values_num)
+{
+	char		*out = NULL;
+	size_t		out_alloc = 0, out_offset = 0;
+	const char	*ptr;
+	zbx_uint64_t	functionid;
+	int		len;
+
+	for (ptr = expression; '\0' != *ptr; ptr += len)
+	{
+		for (len = 1; '{' == *ptr && 0 != isdigit((unsigned char)ptr[len]); len++)
+			;
+
+		if (1 == len || '}' != ptr[len])
+		{
+			len = 1;
+			zbx_chrcpy_alloc(&out, &out_alloc, &out_offset, *ptr);
+			continue;
+		}
+
+		if (SUCCEED != is_uint64_n(ptr + 1, (size_t)len - 1, &functionid) || 0 == functionid ||
+				(zbx_uint64_t)values_num < functionid)
+		{
+			fail_msg("no value for function reference in \"%s\"", ptr);
+		}
+
+		if (SUCCEED != is_double_suffix(values[functionid - 1], ZBX_FLAG_DOUBLE_SUFFIX) ||
+				'-' == *values[functionid - 1])
+		{
+			zbx_chrcpy_alloc(&out, &out_alloc, &out_offset, '(');
+			zbx_strcpy_alloc(&out, &out_alloc, &out_offset, values[functionid - 1]);
+			zbx_chrcpy_alloc(&out, &out_alloc, &out_offset, ')');
+		}
+		else
+			zbx_strcpy_alloc(&out, &out_alloc, &out_offset, values[functionid - 1]);
+
+		len++;
+	}
+
+	if (NULL == out)
+		out = zbx_strdup(NULL, "");
+
+	return out;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char		*expression, *values[EVAL_VALUES_MAX];
+	char			error[MAX_STRING_LEN], expected_error[MAX_STRING_LEN], *text;
+	int			i, values_num = 0, expected_ret, ret, evaluate_ret;
+	double			evaluate_value;
+	zbx_eval_code_t		code;
+	zbx_eval_value_t	function_values[EVAL_VALUES_MAX], result;
+	zbx_vector_ptr_t	unknown_msgs;
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_mock_error_t	err;
+
+	ZBX_UNUSED(state);
+
+	expression = zbx_mock_get_parameter_string("in.expression");
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return"));
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.values"))
+	{
+		hvalues = zbx_mock_get_parameter_handle("in.values");
+
+		while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hvalues, &hvalue)))
+		{
+			if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue,
+					&values[values_num])))
+			{
+				fail_msg("Cannot read function value: %s", zbx_mock_error_string(err));
+			}
+
+			if (EVAL_VALUES_MAX == ++values_num)
+				fail_msg("too many function values");
+		}
+	}
+
+	zbx_vector_ptr_create(&unknown_msgs);
+
+	for (i = 0; i < EVAL_VALUES_MAX; i++)
+		zbx_vector_ptr_append(&unknown_msgs, zbx_dsprintf(NULL, "unknown value %d", i));
+
+	/* the compiled code result, with unknown mapped to error as evaluate() does */
+	if (SUCCEED != zbx_eval_compile(expression, &code, error, sizeof(error)))
+	{
+		ret = NOTSUPPORTED;
+	}
+	else
+	{
+		for (i = 0; i < code.functionids.values_num; i++)
+		{
+			if (0 == code.functionids.values[i] || (zbx_uint64_t)values_num < code.functionids.values[i])
+				fail_msg("no value for function {" ZBX_FS_UI64 "}", code.functionids.values[i]);
+
+			eval_value_parse(values[code.functionids.values[i] - 1], &function_values[i]);
+		}
+
+		if (SUCCEED == (ret = zbx_eval_execute(&code, function_values, &result, error, sizeof(error))) &&
+				ZBX_UNKNOWN == result.value)
+		{
+			zbx_snprintf(error, sizeof(error), "Cannot evaluate expression: \"%s\".",
+					(char *)unknown_msgs.values[result.unknown_idx]);
+			ret = FAIL;
+		}
+	}
+
+	zbx_eval_code_clear(&code);
+
+	if (expected_ret != ret)
+	{
+		fail_msg("expected %s while got %s (%s)", zbx_result_string(expected_ret), zbx_result_string(ret),
+				NOTSUPPORTED == ret ? "compilation or execution failed" : error);
+	}
+
+	/* the code that was executed must give the same result as the expression with substituted values */
+	if (NOTSUPPORTED != ret)
+	{
+		text = eval_substitute(expression, values, values_num);
+		*expected_error = '\0';
+
+		evaluate_ret = evaluate(&evaluate_value, text, expected_error, sizeof(expected_error), &unknown_msgs);
+
+		if (evaluate_ret != ret)
+		{
+			fail_msg("evaluate(\"%s\") returned %s (%s) while compiled code %s (%s)", text,
+					zbx_result_string(evaluate_ret), expected_error, zbx_result_string(ret), error);
+		}
+
+		if (SUCCEED == ret && SUCCEED != zbx_double_compare(evaluate_value, result.value))
+		{
+			fail_msg("evaluate(\"%s\") returned " ZBX_FS_DBL " while compiled code " ZBX_FS_DBL, text,
+					evaluate_value, result.value);
+		}
+
+		if (FAIL == ret && 0 != strcmp(expected_error, error))
+		{
+			fail_msg("evaluate(\"%s\") failed with \"%s\" while compiled code with \"%s\"", text,
+					expected_error, error);
+		}
+
+		zbx_free(text);
+	}
+
+	zbx_vector_ptr_clear_ext(&unknown_msgs, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&unknown_msgs);
+}
@@ -0,0 +1,147 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "mutexs.h"
+#include "zbxalgo.h"
+#include "dbcache.h"
+
+#define ZBX_DBCONFIG_IMPL
+#include "dbconfig.h"
+#include "dc_item_nextcheck_test.h"
+
+extern int	CONFIG_POLLER_SMOOTHING;
+
+static unsigned char	get_poller_type(const char *poller_type)
+{
+	const char	*poller_types[] = {"NORMAL", "UNREACHABLE", "IPMI", "PINGER", "JAVA", "HTTPAGENT", NULL};
+	int		i;
+
+	for (i = 0; NULL != poller_types[i]; i++)
+	{
+		if (0 == strcmp(poller_types[i], poller_type))
+			return (unsigned char)i;
+	}
+
+	fail_msg("Unknown poller type: %s", poller_type);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Comments: The item is scheduled at the start time and then taken from the  *
+ *           poller queue with the specified lateness at every step. The      *
+ *           nextcheck seed shift and the item rescheduled after collecting   *
+ *           value are compared with the expected ones after each step.       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hsteps, hstep, hbuckets, hbucket;
+	ZBX_DC_CONFIG		dc_config;
+	ZBX_DC_INTERFACE	interface;
+	ZBX_DC_ITEM		item;
+	unsigned char		poller_type;
+	char			*error = NULL, msg[MAX_STRING_LEN];
+	int			now, step = 0, i;
+	zbx_uint64_t		count;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_POLLER_SMOOTHING = (int)zbx_mock_get_parameter_uint64("in.smoothing");
+	poller_type = get_poller_type(zbx_mock_get_parameter_string("in.poller"));
+
+	memset(&dc_config, 0, sizeof(dc_config));
+	config = &dc_config;
+
+	zbx_hashset_create(&config->interfaces, 1, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	memset(&item, 0, sizeof(item));
+	item.itemid = zbx_mock_get_parameter_uint64("in.item.itemid");
+	item.interfaceid = zbx_mock_get_parameter_uint64("in.item.interfaceid");
+	item.type = (unsigned char)zbx_mock_str_to_item_type(zbx_mock_get_parameter_string("in.item.type"));
+	item.key = zbx_mock_get_parameter_string("in.item.key");
+	item.delay = zbx_mock_get_parameter_string("in.item.delay");
+
+	memset(&interface, 0, sizeof(interface));
+	interface.interfaceid = item.interfaceid;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.item.bulk"))
+		interface.bulk = (unsigned char)zbx_mock_get_parameter_uint64("in.item.bulk");
+
+	zbx_hashset_insert(&config->interfaces, &interface, sizeof(interface));
+
+	if (SUCCEED != DCitem_nextcheck_update_test(&item, (int)zbx_mock_get_parameter_uint64("in.now"), &error))
+		fail_msg("Cannot schedule item: %s", error);
+
+	zbx_mock_assert_int_eq("initial nextcheck", (int)zbx_mock_get_parameter_uint64("in.nextcheck"),
+			item.nextcheck);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsteps, &hstep)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read step #%d: %s", step, zbx_mock_error_string(err));
+
+		step++;
+
+		now = item.nextcheck + (int)zbx_mock_get_object_member_uint64(hstep, "lateness");
+
+		dc_poller_item_taken_test(&item, poller_type, now);
+
+		zbx_snprintf(msg, sizeof(msg), "step #%d: nextcheck shift", step);
+		zbx_mock_assert_int_eq(msg, (int)zbx_mock_get_object_member_uint64(hstep, "shift"),
+				(int)item.nextcheck_shift);
+
+		if (SUCCEED != DCitem_nextcheck_update_test(&item, now, &error))
+			fail_msg("Cannot reschedule item at step #%d: %s", step, error);
+
+		zbx_snprintf(msg, sizeof(msg), "step #%d: nextcheck", step);
+		zbx_mock_assert_int_eq(msg, (int)zbx_mock_get_object_member_uint64(hstep, "nextcheck"),
+				item.nextcheck);
+	}
+
+	hbuckets = zbx_mock_get_parameter_handle("out.lateness");
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hbuckets, &hbucket)); i++)
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hbucket, &count)))
+			fail_msg("Cannot read lateness bucket #%d: %s", i, zbx_mock_error_string(err));
+
+		if (ZBX_POLLER_LATENESS_BUCKETS <= i)
+			fail_msg("Too many lateness buckets");
+
+		zbx_snprintf(msg, sizeof(msg), "lateness bucket #%d", i);
+		zbx_mock_assert_uint64_eq(msg, count, config->poller_lateness[poller_type][i]);
+	}
+
+	if (ZBX_POLLER_LATENESS_BUCKETS != i)
+		fail_msg("Expected %d lateness buckets while got %d", ZBX_POLLER_LATENESS_BUCKETS, i);
+
+	zbx_hashset_destroy(&config->interfaces);
+	config = NULL;
+}
@@ -0,0 +1,126 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "mutexs.h"
+#include "zbxalgo.h"
+#include "dbcache.h"
+
+#define ZBX_DBCONFIG_IMPL
+#include "dbconfig.h"
+#include "dc_interface_breaker_test.h"
+
+extern int	CONFIG_TIMEOUT;
+extern int	CONFIG_UNAVAILABLE_DELAY;
+
+#define BREAKER_INTERFACEID	1
+
+/******************************************************************************
+ *                                                                            *
+ * Comments: Every step either asks breaker whether the item can be checked   *
+ *           or reports the item check result. Breaker state is compared with *
+ *           the expected state after each step.                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hsteps, hstep, htype;
+	ZBX_DC_CONFIG		dc_config;
+	ZBX_DC_INTERFACE	interface_local, *interface;
+	ZBX_DC_ITEM		item;
+	const char		*action, *type;
+	int			now, step = 0, ret;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_TIMEOUT = (int)zbx_mock_get_parameter_uint64("in.timeout");
+	CONFIG_UNAVAILABLE_DELAY = (int)zbx_mock_get_parameter_uint64("in.unavailable_delay");
+
+	memset(&dc_config, 0, sizeof(dc_config));
+	config = &dc_config;
+
+	zbx_hashset_create(&config->interfaces, 1, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	memset(&interface_local, 0, sizeof(interface_local));
+	interface_local.interfaceid = BREAKER_INTERFACEID;
+	interface = (ZBX_DC_INTERFACE *)zbx_hashset_insert(&config->interfaces, &interface_local,
+			sizeof(interface_local));
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsteps, &hstep)))
+	{
+		char	msg[MAX_STRING_LEN];
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read step #%d: %s", step, zbx_mock_error_string(err));
+
+		step++;
+
+		memset(&item, 0, sizeof(item));
+		item.itemid = zbx_mock_get_object_member_uint64(hstep, "itemid");
+		item.interfaceid = BREAKER_INTERFACEID;
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "type", &htype))
+		{
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(htype, &type)))
+				fail_msg("Cannot read item type of step #%d: %s", step, zbx_mock_error_string(err));
+
+			item.type = (unsigned char)zbx_mock_str_to_item_type(type);
+		}
+		else
+			item.type = ITEM_TYPE_ZABBIX;
+
+		now = (int)zbx_mock_get_object_member_uint64(hstep, "time");
+		action = zbx_mock_get_object_member_string(hstep, "action");
+
+		if (0 == strcmp(action, "allow"))
+		{
+			ret = dc_interface_breaker_allow_test(&item, now);
+
+			zbx_snprintf(msg, sizeof(msg), "step #%d: allow() return value", step);
+			zbx_mock_assert_result_eq(msg, zbx_mock_str_to_return_code(
+					zbx_mock_get_object_member_string(hstep, "return")), ret);
+		}
+		else if (0 == strcmp(action, "update"))
+		{
+			dc_interface_breaker_update_test(&item, zbx_mock_str_to_return_code(
+					zbx_mock_get_object_member_string(hstep, "errcode")), now);
+		}
+		else
+			fail_msg("step #%d: unknown action \"%s\"", step, action);
+
+		zbx_snprintf(msg, sizeof(msg), "step #%d: failed probes", step);
+		zbx_mock_assert_int_eq(msg, (int)zbx_mock_get_object_member_uint64(hstep, "failures"),
+				interface->breaker_failures);
+
+		zbx_snprintf(msg, sizeof(msg), "step #%d: checks held until", step);
+		zbx_mock_assert_int_eq(msg, (int)zbx_mock_get_object_member_uint64(hstep, "until"),
+				interface->breaker_until);
+	}
+
+	zbx_hashset_destroy(&config->interfaces);
+	config = NULL;
+}
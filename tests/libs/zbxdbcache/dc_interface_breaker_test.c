@@ -0,0 +1,30 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "dc_interface_breaker_test.h"
+
+int	dc_interface_breaker_allow_test(const ZBX_DC_ITEM *item, int now)
+{
+	return dc_interface_breaker_allow(item, now);
+}
+
+void	dc_interface_breaker_update_test(const ZBX_DC_ITEM *item, int errcode, int now)
+{
+	dc_interface_breaker_update(item, errcode, now);
+}
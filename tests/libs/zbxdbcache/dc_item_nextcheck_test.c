@@ -0,0 +1,30 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "dc_item_nextcheck_test.h"
+
+void	dc_poller_item_taken_test(ZBX_DC_ITEM *dc_item, unsigned char poller_type, int now)
+{
+	dc_poller_item_taken(dc_item, poller_type, now);
+}
+
+int	DCitem_nextcheck_update_test(ZBX_DC_ITEM *item, int now, char **error)
+{
+	return DCitem_nextcheck_update(item, NULL, ITEM_STATE_NORMAL, ZBX_ITEM_COLLECTED, now, error);
+}
@@ -0,0 +1,196 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "mutexs.h"
+#include "zbxalgo.h"
+#include "dbcache.h"
+
+#define ZBX_DBCONFIG_IMPL
+#include "dbconfig.h"
+#include "dc_timer_trigger_test.h"
+
+static void	mock_read_functions(zbx_hashset_t *functions)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hfunctions, hfunction;
+	ZBX_DC_FUNCTION		function;
+
+	hfunctions = zbx_mock_get_parameter_handle("in.functions");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hfunctions, &hfunction)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read function: %s", zbx_mock_error_string(err));
+
+		memset(&function, 0, sizeof(function));
+		function.functionid = zbx_mock_get_object_member_uint64(hfunction, "functionid");
+		function.itemid = zbx_mock_get_object_member_uint64(hfunction, "itemid");
+		function.function = zbx_mock_get_object_member_string(hfunction, "function");
+		function.parameter = zbx_mock_get_object_member_string(hfunction, "parameter");
+		function.timer = (unsigned char)zbx_mock_get_object_member_uint64(hfunction, "timer");
+
+		zbx_hashset_insert(functions, &function, sizeof(function));
+	}
+}
+
+static void	mock_read_items(zbx_hashset_t *items)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hitems, hitem;
+	ZBX_DC_ITEM		item;
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitems, &hitem)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read item: %s", zbx_mock_error_string(err));
+
+		memset(&item, 0, sizeof(item));
+		item.itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+		item.value_ts.sec = (int)zbx_mock_get_object_member_uint64(hitem, "value clock");
+
+		zbx_hashset_insert(items, &item, sizeof(item));
+	}
+}
+
+static void	mock_read_triggers(zbx_hashset_t *triggers)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	htriggers, htrigger, hmember;
+	ZBX_DC_TRIGGER		trigger_local, *trigger;
+	zbx_binary_heap_elem_t	elem;
+
+	htriggers = zbx_mock_get_parameter_handle("in.triggers");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(htriggers, &htrigger)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read trigger: %s", zbx_mock_error_string(err));
+
+		memset(&trigger_local, 0, sizeof(trigger_local));
+		trigger_local.triggerid = zbx_mock_get_object_member_uint64(htrigger, "triggerid");
+		trigger_local.expression = zbx_mock_get_object_member_string(htrigger, "expression");
+		trigger_local.recovery_expression = "";
+		trigger_local.recovery_mode = TRIGGER_RECOVERY_MODE_EXPRESSION;
+		trigger_local.nextcheck = (int)zbx_mock_get_object_member_uint64(htrigger, "nextcheck");
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(htrigger, "recovery expression", &hmember))
+		{
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hmember, &trigger_local.recovery_expression)))
+				fail_msg("Cannot read trigger recovery expression: %s", zbx_mock_error_string(err));
+
+			trigger_local.recovery_mode = TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION;
+		}
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(htrigger, "locked", &hmember))
+			trigger_local.locked = (unsigned char)zbx_mock_get_object_member_uint64(htrigger, "locked");
+
+		trigger = (ZBX_DC_TRIGGER *)zbx_hashset_insert(triggers, &trigger_local, sizeof(trigger_local));
+
+		elem.key = trigger->triggerid;
+		elem.data = (void *)trigger;
+		zbx_binary_heap_insert(&config->timer_queue, &elem);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Comments: Timer triggers are taken from the timer queue at the specified   *
+ *           time. The returned triggers and the trigger schedule after that  *
+ *           are compared with the expected ones.                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hids, hid, htriggers, htrigger;
+	ZBX_DC_CONFIG		dc_config;
+	ZBX_DC_TRIGGER		*trigger;
+	zbx_hashset_t		triggers;
+	zbx_vector_uint64_t	triggerids;
+	zbx_uint64_t		triggerid;
+	char			msg[MAX_STRING_LEN];
+	int			i;
+
+	ZBX_UNUSED(state);
+
+	memset(&dc_config, 0, sizeof(dc_config));
+	config = &dc_config;
+
+	zbx_hashset_create(&config->functions, 10, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&config->items, 10, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&triggers, 10, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	dc_timer_queue_create_test();
+
+	mock_read_functions(&config->functions);
+	mock_read_items(&config->items);
+	mock_read_triggers(&triggers);
+
+	zbx_vector_uint64_create(&triggerids);
+
+	zbx_dc_get_timer_triggerids(&triggerids, (int)zbx_mock_get_parameter_uint64("in.now"),
+			(int)zbx_mock_get_parameter_uint64("in.limit"));
+
+	hids = zbx_mock_get_parameter_handle("out.triggerids");
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hids, &hid)); i++)
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hid, &triggerid)))
+			fail_msg("Cannot read expected triggerid #%d: %s", i, zbx_mock_error_string(err));
+
+		if (i >= triggerids.values_num)
+			fail_msg("Expected triggerid " ZBX_FS_UI64 " was not returned", triggerid);
+
+		zbx_snprintf(msg, sizeof(msg), "returned triggerid #%d", i);
+		zbx_mock_assert_uint64_eq(msg, triggerid, triggerids.values[i]);
+	}
+
+	zbx_mock_assert_int_eq("returned triggerids", i, triggerids.values_num);
+
+	htriggers = zbx_mock_get_parameter_handle("out.triggers");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(htriggers, &htrigger)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read expected trigger: %s", zbx_mock_error_string(err));
+
+		triggerid = zbx_mock_get_object_member_uint64(htrigger, "triggerid");
+
+		if (NULL == (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&triggers, &triggerid)))
+			fail_msg("Unknown trigger " ZBX_FS_UI64, triggerid);
+
+		zbx_snprintf(msg, sizeof(msg), "trigger " ZBX_FS_UI64 " nextcheck", triggerid);
+		zbx_mock_assert_int_eq(msg, (int)zbx_mock_get_object_member_uint64(htrigger, "nextcheck"),
+				trigger->nextcheck);
+	}
+
+	zbx_vector_uint64_destroy(&triggerids);
+	zbx_binary_heap_destroy(&config->timer_queue);
+	zbx_hashset_destroy(&triggers);
+	zbx_hashset_destroy(&config->items);
+	zbx_hashset_destroy(&config->functions);
+	config = NULL;
+}
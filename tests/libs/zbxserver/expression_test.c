@@ -0,0 +1,48 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "expression_test.h"
+
+static void	func_init(zbx_func_t *func, zbx_uint64_t itemid, const char *function, const char *parameter,
+		const zbx_timespec_t *ts)
+{
+	func->itemid = itemid;
+	func->function = (char *)function;
+	func->parameter = (char *)parameter;
+	func->timespec = *ts;
+}
+
+int	func_result_get_test(zbx_uint64_t itemid, const char *function, const char *parameter,
+		const zbx_timespec_t *ts, const DC_ITEM *item, char *value)
+{
+	zbx_func_t	func;
+
+	func_init(&func, itemid, function, parameter, ts);
+
+	return func_result_get(&func, item, value);
+}
+
+void	func_result_set_test(zbx_uint64_t itemid, const char *function, const char *parameter,
+		const zbx_timespec_t *ts, const DC_ITEM *item, const char *value)
+{
+	zbx_func_t	func;
+
+	func_init(&func, itemid, function, parameter, ts);
+	func_result_set(&func, item, value);
+}
@@ -0,0 +1,116 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "dbcache.h"
+
+#include "expression_test.h"
+
+#define FUNC_RESULT_ITEMID	1
+
+/******************************************************************************
+ *                                                                            *
+ * Comments: Every step either caches the function result evaluated for the   *
+ *           item or gets the cached result back. Steps share the same item   *
+ *           with value revision, value type, state and the newest value      *
+ *           timestamp given in each step.                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hsteps, hstep, hmember;
+	DC_ITEM			item;
+	zbx_timespec_t		ts;
+	const char		*action, *function, *parameter, *str;
+	char			value[MAX_BUFFER_LEN], msg[MAX_STRING_LEN];
+	int			step = 0, ret;
+
+	ZBX_UNUSED(state);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsteps, &hstep)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read step #%d: %s", step, zbx_mock_error_string(err));
+
+		step++;
+
+		memset(&item, 0, sizeof(item));
+		item.itemid = FUNC_RESULT_ITEMID;
+		item.value_revision = zbx_mock_get_object_member_uint64(hstep, "revision");
+		item.value_ts.sec = (int)zbx_mock_get_object_member_uint64(hstep, "value clock");
+		item.value_type = ITEM_VALUE_TYPE_FLOAT;
+		item.state = ITEM_STATE_NORMAL;
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "value type", &hmember))
+		{
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hmember, &str)))
+				fail_msg("Cannot read value type of step #%d: %s", step, zbx_mock_error_string(err));
+
+			item.value_type = zbx_mock_str_to_value_type(str);
+		}
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "state", &hmember))
+		{
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hmember, &str)))
+				fail_msg("Cannot read item state of step #%d: %s", step, zbx_mock_error_string(err));
+
+			if (0 == strcmp(str, "ITEM_STATE_NOTSUPPORTED"))
+				item.state = ITEM_STATE_NOTSUPPORTED;
+			else if (0 != strcmp(str, "ITEM_STATE_NORMAL"))
+				fail_msg("step #%d: unknown item state \"%s\"", step, str);
+		}
+
+		function = zbx_mock_get_object_member_string(hstep, "function");
+		parameter = zbx_mock_get_object_member_string(hstep, "parameter");
+		ts.sec = (int)zbx_mock_get_object_member_uint64(hstep, "clock");
+		ts.ns = 0;
+
+		action = zbx_mock_get_object_member_string(hstep, "action");
+
+		if (0 == strcmp(action, "set"))
+		{
+			func_result_set_test(FUNC_RESULT_ITEMID, function, parameter, &ts, &item,
+					zbx_mock_get_object_member_string(hstep, "value"));
+		}
+		else if (0 == strcmp(action, "get"))
+		{
+			ret = func_result_get_test(FUNC_RESULT_ITEMID, function, parameter, &ts, &item, value);
+
+			zbx_snprintf(msg, sizeof(msg), "step #%d: get() return value", step);
+			zbx_mock_assert_result_eq(msg, zbx_mock_str_to_return_code(
+					zbx_mock_get_object_member_string(hstep, "return")), ret);
+
+			if (SUCCEED == ret)
+			{
+				zbx_snprintf(msg, sizeof(msg), "step #%d: cached value", step);
+				zbx_mock_assert_str_eq(msg, zbx_mock_get_object_member_string(hstep, "value"), value);
+			}
+		}
+		else
+			fail_msg("step #%d: unknown action \"%s\"", step, action);
+	}
+}
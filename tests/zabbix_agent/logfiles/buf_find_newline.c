@@ -0,0 +1,178 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockutil.h"
+#include "zbxmockassert.h"
+
+#include "common.h"
+#include "logfiles_test.h"
+
+/* byte by byte scan used before vectorized scanning was introduced, the results must match */
+static char	*buf_find_newline_ref(char *p, char **p_next, const char *p_end, const char *cr, const char *lf,
+		size_t szbyte)
+{
+	if (1 == szbyte)
+	{
+		for (; p < p_end; p++)
+		{
+			if (0x0 == *p)
+			{
+				*p = '?';
+				continue;
+			}
+
+			if (0xd < *p || 0xa > *p)
+				continue;
+
+			if (0xa == *p)
+			{
+				*p_next = p + 1;
+				return p;
+			}
+
+			if (0xd == *p)
+			{
+				if (p < p_end - 1 && 0xa == *(p + 1))
+				{
+					*p_next = p + 2;
+					return p;
+				}
+
+				*p_next = p + 1;
+				return p;
+			}
+		}
+		return NULL;
+	}
+
+	while (p <= p_end - szbyte)
+	{
+		if (2 == szbyte && 0x0 == *p && 0x0 == *(p + 1))
+		{
+			if (0x0 == *cr)
+				p[1] = '?';
+			else
+				*p = '?';
+		}
+
+		if (0 == memcmp(p, lf, szbyte))
+		{
+			*p_next = p + szbyte;
+			return p;
+		}
+
+		if (0 == memcmp(p, cr, szbyte))
+		{
+			if (p <= p_end - szbyte - szbyte && 0 == memcmp(p + szbyte, lf, szbyte))
+			{
+				*p_next = p + szbyte + szbyte;
+				return p;
+			}
+
+			*p_next = p + szbyte;
+			return p;
+		}
+
+		p += szbyte;
+	}
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: splits buffer into lines with both scan implementations and       *
+ *          compares line ends and the NULL characters replaced in buffer     *
+ *                                                                            *
+ * Return value: the number of lines found                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	compare_scan(const char *data, size_t start, size_t end, const char *cr, const char *lf, size_t szbyte)
+{
+	char	*buf, *buf_ref, *p, *p_ref, *p_next = NULL, *p_next_ref = NULL, *nl, *nl_ref,
+		msg[MAX_STRING_LEN];
+	int	lines = 0;
+
+	buf = (char *)zbx_malloc(NULL, end);
+	buf_ref = (char *)zbx_malloc(NULL, end);
+	memcpy(buf, data, end);
+	memcpy(buf_ref, data, end);
+
+	for (p = buf + start, p_ref = buf_ref + start;; p = p_next, p_ref = p_next_ref, lines++)
+	{
+		nl = buf_find_newline_test(p, &p_next, buf + end, cr, lf, szbyte);
+		nl_ref = buf_find_newline_ref(p_ref, &p_next_ref, buf_ref + end, cr, lf, szbyte);
+
+		zbx_snprintf(msg, sizeof(msg), "range %d-%d line #%d: end of line", (int)start, (int)end, lines + 1);
+
+		if (NULL == nl_ref)
+		{
+			zbx_mock_assert_ptr_eq(msg, NULL, nl);
+			break;
+		}
+
+		zbx_mock_assert_ptr_ne(msg, NULL, nl);
+		zbx_mock_assert_int_eq(msg, (int)(nl_ref - buf_ref), (int)(nl - buf));
+
+		zbx_snprintf(msg, sizeof(msg), "range %d-%d line #%d: next line", (int)start, (int)end, lines + 1);
+		zbx_mock_assert_int_eq(msg, (int)(p_next_ref - buf_ref), (int)(p_next - buf));
+	}
+
+	zbx_snprintf(msg, sizeof(msg), "range %d-%d: replaced NULL characters", (int)start, (int)end);
+	zbx_mock_assert_int_eq(msg, 0, memcmp(buf, buf_ref, end));
+
+	zbx_free(buf_ref);
+	zbx_free(buf);
+
+	return lines;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char		*data, *cr, *lf;
+	size_t			data_len, cr_len, lf_len, szbyte, start, end;
+	zbx_mock_error_t	err;
+
+	ZBX_UNUSED(state);
+
+	if (ZBX_MOCK_SUCCESS != (err = zbx_mock_binary(zbx_mock_get_parameter_handle("in.data"), &data, &data_len)))
+		fail_msg("Cannot read data: %s", zbx_mock_error_string(err));
+
+	if (ZBX_MOCK_SUCCESS != (err = zbx_mock_binary(zbx_mock_get_parameter_handle("in.cr"), &cr, &cr_len)))
+		fail_msg("Cannot read CR: %s", zbx_mock_error_string(err));
+
+	if (ZBX_MOCK_SUCCESS != (err = zbx_mock_binary(zbx_mock_get_parameter_handle("in.lf"), &lf, &lf_len)))
+		fail_msg("Cannot read LF: %s", zbx_mock_error_string(err));
+
+	szbyte = (size_t)zbx_mock_get_parameter_uint64("in.szbyte");
+
+	if (cr_len != szbyte || lf_len != szbyte || 0 != data_len % szbyte)
+		fail_msg("Malformed test case data: CR, LF and data length must be multiples of character size");
+
+	zbx_mock_assert_int_eq("number of lines", (int)zbx_mock_get_parameter_uint64("out.lines"),
+			compare_scan(data, 0, data_len, cr, lf, szbyte));
+
+	/* every start and end position shifts the line ends relatively to vector boundaries */
+	for (start = 0; start < data_len; start += szbyte)
+	{
+		for (end = start + szbyte; end <= data_len; end += szbyte)
+			compare_scan(data, start, end, cr, lf, szbyte);
+	}
+}
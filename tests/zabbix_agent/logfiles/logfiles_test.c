@@ -0,0 +1,37 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "logfiles_test.h"
+
+char	*regexp_literal_prefix_test(const char *pattern)
+{
+	return regexp_literal_prefix(pattern);
+}
+
+int	regexp_sub_prefiltered_test(const zbx_vector_ptr_t *regexps, const char *value, const char *pattern,
+		const char *literal, int *pattern_checked, const char *output_template, char **output)
+{
+	return regexp_sub_prefiltered(regexps, value, pattern, literal, pattern_checked, output_template, output);
+}
+
+char	*buf_find_newline_test(char *p, char **p_next, const char *p_end, const char *cr, const char *lf,
+		size_t szbyte)
+{
+	return buf_find_newline(p, p_next, p_end, cr, lf, szbyte);
+}
@@ -0,0 +1,96 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockutil.h"
+#include "zbxmockassert.h"
+
+#include "common.h"
+#include "zbxregexp.h"
+#include "logfiles_test.h"
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char		*pattern, *exp_literal = NULL, *output_template = NULL, *line;
+	char			*literal, *exp_output, *output, msg[MAX_STRING_LEN];
+	int			pattern_checked = FAIL, exp_ret, ret, line_num = 0;
+	zbx_vector_ptr_t	regexps;
+	zbx_mock_handle_t	handle, hlines, hline;
+	zbx_mock_error_t	err;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_ptr_create(&regexps);
+
+	pattern = zbx_mock_get_parameter_string("in.pattern");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.template", &handle) &&
+			ZBX_MOCK_SUCCESS != (err = zbx_mock_string(handle, &output_template)))
+	{
+		fail_msg("Cannot read output template: %s", zbx_mock_error_string(err));
+	}
+
+	/* absent literal means that no prefix can be extracted from the pattern */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("out.literal", &handle) &&
+			ZBX_MOCK_SUCCESS != (err = zbx_mock_string(handle, &exp_literal)))
+	{
+		fail_msg("Cannot read expected literal: %s", zbx_mock_error_string(err));
+	}
+
+	literal = regexp_literal_prefix_test(pattern);
+
+	if (NULL == exp_literal)
+		zbx_mock_assert_ptr_eq("literal prefix", NULL, literal);
+	else
+		zbx_mock_assert_str_eq("literal prefix", exp_literal, literal);
+
+	/* the prefiltered match must give the same results as the regular expression alone */
+	hlines = zbx_mock_get_parameter_handle("in.lines");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hlines, &hline)))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hline, &line)))
+			fail_msg("Cannot read line #%d: %s", line_num + 1, zbx_mock_error_string(err));
+
+		line_num++;
+		exp_output = NULL;
+		output = NULL;
+
+		exp_ret = regexp_sub_ex(&regexps, line, pattern, ZBX_CASE_SENSITIVE, output_template, &exp_output);
+		ret = regexp_sub_prefiltered_test(&regexps, line, pattern, literal, &pattern_checked, output_template,
+				&output);
+
+		zbx_snprintf(msg, sizeof(msg), "line #%d \"%s\": return value", line_num, line);
+		zbx_mock_assert_int_eq(msg, exp_ret, ret);
+
+		zbx_snprintf(msg, sizeof(msg), "line #%d \"%s\": output", line_num, line);
+
+		if (NULL == exp_output)
+			zbx_mock_assert_ptr_eq(msg, NULL, output);
+		else
+			zbx_mock_assert_str_eq(msg, exp_output, output);
+
+		zbx_free(exp_output);
+		zbx_free(output);
+	}
+
+	zbx_free(literal);
+	zbx_vector_ptr_destroy(&regexps);
+}
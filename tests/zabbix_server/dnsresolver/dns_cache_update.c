@@ -0,0 +1,97 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "comms.h"
+#include "../../../src/zabbix_server/dnsresolver/dnsresolver.h"
+#include "dnscache_test.h"
+
+zbx_uint64_t	CONFIG_DNSCACHE_SIZE = ZBX_MEBIBYTE;
+int		CONFIG_DNSCACHE_TTL;
+
+static const char	*dns_get_optional_string(zbx_mock_handle_t object, const char *name)
+{
+	zbx_mock_handle_t	hmember;
+	const char		*value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(object, name, &hmember) ||
+			ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &value))
+	{
+		return NULL;
+	}
+
+	return value;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hsteps, hstep, hcached;
+	zbx_mock_error_t	err;
+	const char		*host;
+	char			*error = NULL, addr[ZBX_RESOLVE_ADDRS_LEN];
+	int			now, nextcheck, expires, step = 0;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_DNSCACHE_TTL = (int)zbx_mock_get_parameter_uint64("in.ttl");
+
+	if (SUCCEED != dns_cache_init_test(&error))
+		fail_msg("cannot initialize DNS cache: %s", error);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hsteps, &hstep)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read step %d: %s", step, zbx_mock_error_string(err));
+
+		host = zbx_mock_get_object_member_string(hstep, "host");
+		now = (int)zbx_mock_get_object_member_uint64(hstep, "now");
+
+		dns_cache_update_test(host, dns_get_optional_string(hstep, "addr"), now,
+				(int)zbx_mock_get_object_member_uint64(hstep, "create"));
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hstep, "cached", &hcached))
+		{
+			if (SUCCEED == dns_cache_get_test(host, addr, sizeof(addr), &nextcheck, &expires))
+				fail_msg("step %d: host \"%s\" must not be cached", step, host);
+		}
+		else
+		{
+			if (SUCCEED != dns_cache_get_test(host, addr, sizeof(addr), &nextcheck, &expires))
+				fail_msg("step %d: host \"%s\" is not cached", step, host);
+
+			zbx_mock_assert_str_eq("cached address", zbx_mock_get_object_member_string(hcached, "addr"),
+					addr);
+			zbx_mock_assert_int_eq("next resolution time",
+					(int)zbx_mock_get_object_member_uint64(hcached, "nextcheck"), nextcheck);
+			zbx_mock_assert_int_eq("expiration time",
+					(int)zbx_mock_get_object_member_uint64(hcached, "expires"), expires);
+		}
+
+		step++;
+	}
+
+	zbx_dns_cache_destroy();
+}
@@ -0,0 +1,58 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "dnscache_test.h"
+
+zbx_uint64_t	CONFIG_DNSCACHE_SIZE = 0;
+int		CONFIG_DNSCACHE_TTL = 0;
+
+void	zbx_mock_test_entry(void **state)
+{
+#if defined(HAVE_LIBCURL) && LIBCURL_VERSION_NUM >= 0x071503
+	char		host[MAX_ZBX_DNSNAME_LEN + 1];
+	size_t		host_len = sizeof(host);
+	unsigned short	port;
+	int		returned_ret, expected_ret;
+
+	ZBX_UNUSED(state);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.host_len"))
+		host_len = (size_t)zbx_mock_get_parameter_uint64("in.host_len");
+
+	returned_ret = dns_parse_url_test(zbx_mock_get_parameter_string("in.url"), host, host_len, &port);
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return"));
+	zbx_mock_assert_result_eq("dns_parse_url() return value", expected_ret, returned_ret);
+
+	if (SUCCEED == returned_ret)
+	{
+		zbx_mock_assert_str_eq("host name", zbx_mock_get_parameter_string("out.host"), host);
+		zbx_mock_assert_uint64_eq("port", zbx_mock_get_parameter_uint64("out.port"), port);
+	}
+#else
+	ZBX_UNUSED(state);
+
+	skip();
+#endif
+}
@@ -0,0 +1,56 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "dnscache_test.h"
+
+int	dns_cache_init_test(char **error)
+{
+	if (SUCCEED != zbx_locks_create(error))
+		return FAIL;
+
+	return zbx_dns_cache_init(error);
+}
+
+void	dns_cache_update_test(const char *host, const char *addr, int now, int create)
+{
+	dns_cache_update(host, addr, now, create);
+}
+
+int	dns_cache_get_test(const char *host, char *addr, size_t addr_len, int *nextcheck, int *expires)
+{
+	zbx_dns_entry_t	*entry, entry_local;
+
+	entry_local.host = host;
+
+	if (NULL == (entry = (zbx_dns_entry_t *)zbx_hashset_search(&dns_cache->entries, &entry_local)))
+		return FAIL;
+
+	zbx_strlcpy(addr, entry->addr, addr_len);
+	*nextcheck = entry->nextcheck;
+	*expires = entry->expires;
+
+	return SUCCEED;
+}
+
+#if defined(HAVE_LIBCURL) && LIBCURL_VERSION_NUM >= 0x071503
+int	dns_parse_url_test(const char *url, char *host, size_t host_len, unsigned short *port)
+{
+	return dns_parse_url(url, host, host_len, port);
+}
+#endif
@@ -0,0 +1,33 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef DNSCACHE_TEST_H
+#define DNSCACHE_TEST_H
+
+#include "common.h"
+
+int	dns_cache_init_test(char **error);
+void	dns_cache_update_test(const char *host, const char *addr, int now, int create);
+int	dns_cache_get_test(const char *host, char *addr, size_t addr_len, int *nextcheck, int *expires);
+
+#if defined(HAVE_LIBCURL) && LIBCURL_VERSION_NUM >= 0x071503
+int	dns_parse_url_test(const char *url, char *host, size_t host_len, unsigned short *port);
+#endif
+
+#endif
@@ -0,0 +1,320 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "lld_item_test.h"
+
+static const struct
+{
+	const char	*field;
+	zbx_uint64_t	flag;
+}
+lld_item_update_flags[] = {
+	{"name", ZBX_FLAG_LLD_ITEM_UPDATE_NAME},
+	{"key", ZBX_FLAG_LLD_ITEM_UPDATE_KEY},
+	{"delay", ZBX_FLAG_LLD_ITEM_UPDATE_DELAY},
+	{"type", ZBX_FLAG_LLD_ITEM_UPDATE_TYPE},
+	{"value_type", ZBX_FLAG_LLD_ITEM_UPDATE_VALUE_TYPE},
+	{"port", ZBX_FLAG_LLD_ITEM_UPDATE_PORT},
+	{"trapper_hosts", ZBX_FLAG_LLD_ITEM_UPDATE_TRAPPER_HOSTS},
+	{NULL, ZBX_FLAG_LLD_ITEM_UNSET}
+};
+
+zbx_uint64_t	lld_item_update_flag_test(const char *field)
+{
+	int	i;
+
+	for (i = 0; NULL != lld_item_update_flags[i].field; i++)
+	{
+		if (0 == strcmp(lld_item_update_flags[i].field, field))
+			return lld_item_update_flags[i].flag;
+	}
+
+	return ZBX_FLAG_LLD_ITEM_UNSET;
+}
+
+static void	lld_item_prototypes_create_test(const zbx_lld_item_prototype_test_t *prototypes, int prototypes_num,
+		zbx_vector_ptr_t *item_prototypes)
+{
+	int				i;
+	zbx_lld_item_prototype_t	*item_prototype;
+
+	for (i = 0; i < prototypes_num; i++)
+	{
+		item_prototype = (zbx_lld_item_prototype_t *)zbx_malloc(NULL, sizeof(zbx_lld_item_prototype_t));
+		memset(item_prototype, 0, sizeof(zbx_lld_item_prototype_t));
+
+		item_prototype->itemid = prototypes[i].itemid;
+		item_prototype->key = zbx_strdup(NULL, prototypes[i].key);
+		item_prototype->port = zbx_strdup(NULL, ZBX_NULL2EMPTY_STR(prototypes[i].port));
+		item_prototype->trapper_hosts = zbx_strdup(NULL, ZBX_NULL2EMPTY_STR(prototypes[i].trapper_hosts));
+		item_prototype->type = prototypes[i].type;
+		item_prototype->value_type = prototypes[i].value_type;
+
+		zbx_vector_ptr_append(item_prototypes, item_prototype);
+	}
+
+	zbx_vector_ptr_sort(item_prototypes, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
+}
+
+static void	lld_item_prototype_free_test(zbx_lld_item_prototype_t *item_prototype)
+{
+	zbx_free(item_prototype->key);
+	zbx_free(item_prototype->port);
+	zbx_free(item_prototype->trapper_hosts);
+	zbx_free(item_prototype);
+}
+
+static void	lld_items_create_test(const zbx_lld_item_test_t *items_test, int items_num, zbx_vector_ptr_t *items)
+{
+	int		i;
+	zbx_lld_item_t	*item;
+
+	for (i = 0; i < items_num; i++)
+	{
+		item = (zbx_lld_item_t *)zbx_malloc(NULL, sizeof(zbx_lld_item_t));
+		memset(item, 0, sizeof(zbx_lld_item_t));
+
+		item->itemid = items_test[i].itemid;
+		item->parent_itemid = items_test[i].parent_itemid;
+		item->key_proto = zbx_strdup(NULL, items_test[i].key_proto);
+		item->key = zbx_strdup(NULL, items_test[i].key);
+		item->name = zbx_strdup(NULL, ZBX_NULL2EMPTY_STR(items_test[i].name));
+		item->delay = zbx_strdup(NULL, ZBX_NULL2EMPTY_STR(items_test[i].delay));
+		item->flags = items_test[i].flags | ZBX_FLAG_LLD_ITEM_DISCOVERED;
+
+		zbx_vector_ptr_append(items, item);
+	}
+
+	zbx_vector_ptr_sort(items, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
+}
+
+static void	lld_item_free_test(zbx_lld_item_t *item)
+{
+	zbx_free(item->key_proto);
+	zbx_free(item->key);
+	zbx_free(item->name);
+	zbx_free(item->delay);
+	zbx_free(item);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: matches existing items to lld rows by substituting item keys      *
+ *          with every lld row, as done before the rows were indexed by keys  *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_items_index_per_item(const zbx_vector_ptr_t *item_prototypes, const zbx_vector_ptr_t *lld_rows,
+		const zbx_vector_ptr_t *lld_macro_paths, const zbx_vector_ptr_t *items, zbx_hashset_t *items_index)
+{
+	int			i, j, index;
+	zbx_vector_ptr_t	*prototype_rows;
+	zbx_lld_item_t		*item;
+	zbx_lld_row_t		*lld_row;
+	zbx_lld_item_index_t	item_index_local;
+	char			*buffer = NULL;
+
+	prototype_rows = (zbx_vector_ptr_t *)zbx_malloc(NULL, sizeof(zbx_vector_ptr_t) *
+			(size_t)(item_prototypes->values_num + 1));
+
+	for (i = 0; i < item_prototypes->values_num; i++)
+	{
+		zbx_vector_ptr_create(&prototype_rows[i]);
+
+		for (j = 0; j < lld_rows->values_num; j++)
+			zbx_vector_ptr_append(&prototype_rows[i], lld_rows->values[j]);
+	}
+
+	for (i = items->values_num - 1; i >= 0; i--)
+	{
+		item = (zbx_lld_item_t *)items->values[i];
+
+		if (FAIL == (index = zbx_vector_ptr_bsearch(item_prototypes, &item->parent_itemid,
+				ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+		{
+			continue;
+		}
+
+		for (j = prototype_rows[index].values_num - 1; j >= 0; j--)
+		{
+			lld_row = (zbx_lld_row_t *)prototype_rows[index].values[j];
+
+			buffer = zbx_strdup(buffer, item->key_proto);
+
+			if (SUCCEED != substitute_key_macros(&buffer, NULL, NULL, &lld_row->jp_row, lld_macro_paths,
+					MACRO_TYPE_ITEM_KEY, NULL, 0))
+			{
+				continue;
+			}
+
+			if (0 == strcmp(item->key, buffer))
+			{
+				item_index_local.parent_itemid = item->parent_itemid;
+				item_index_local.lld_row = lld_row;
+				item_index_local.item = item;
+				zbx_hashset_insert(items_index, &item_index_local, sizeof(item_index_local));
+
+				zbx_vector_ptr_remove_noorder(&prototype_rows[index], j);
+				break;
+			}
+		}
+	}
+
+	for (i = 0; i < item_prototypes->values_num; i++)
+		zbx_vector_ptr_destroy(&prototype_rows[i]);
+
+	zbx_free(prototype_rows);
+	zbx_free(buffer);
+}
+
+void	lld_items_index_test(const zbx_lld_item_prototype_test_t *prototypes, int prototypes_num,
+		const char **rows, int rows_num, const zbx_lld_item_test_t *items_test, int items_num, int mode,
+		int *items_rows)
+{
+	int			i, j;
+	zbx_vector_ptr_t	item_prototypes, lld_rows, lld_macro_paths, items;
+	zbx_lld_row_t		*lld_row_buf;
+	zbx_hashset_t		items_index;
+	zbx_hashset_iter_t	iter;
+	zbx_lld_item_index_t	*item_index;
+
+	zbx_vector_ptr_create(&item_prototypes);
+	zbx_vector_ptr_create(&lld_rows);
+	zbx_vector_ptr_create(&lld_macro_paths);
+	zbx_vector_ptr_create(&items);
+	zbx_hashset_create(&items_index, (size_t)items_num, lld_item_index_hash_func, lld_item_index_compare_func);
+
+	lld_item_prototypes_create_test(prototypes, prototypes_num, &item_prototypes);
+	lld_items_create_test(items_test, items_num, &items);
+
+	lld_row_buf = (zbx_lld_row_t *)zbx_malloc(NULL, sizeof(zbx_lld_row_t) * (size_t)(rows_num + 1));
+
+	for (i = 0; i < rows_num; i++)
+	{
+		if (SUCCEED != zbx_json_open(rows[i], &lld_row_buf[i].jp_row))
+			THIS_SHOULD_NEVER_HAPPEN;
+
+		zbx_vector_ptr_append(&lld_rows, &lld_row_buf[i]);
+	}
+
+	if (ZBX_LLD_ITEM_TEST_PER_ITEM == mode)
+		lld_items_index_per_item(&item_prototypes, &lld_rows, &lld_macro_paths, &items, &items_index);
+	else
+		lld_items_index(&item_prototypes, &lld_rows, &lld_macro_paths, &items, &items_index);
+
+	for (i = 0; i < items_num; i++)
+	{
+		items_rows[i] = -1;
+
+		zbx_hashset_iter_reset(&items_index, &iter);
+		while (NULL != (item_index = (zbx_lld_item_index_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (item_index->item->itemid != items_test[i].itemid)
+				continue;
+
+			for (j = 0; j < rows_num; j++)
+			{
+				if (item_index->lld_row == &lld_row_buf[j])
+					items_rows[i] = j;
+			}
+		}
+	}
+
+	zbx_free(lld_row_buf);
+	zbx_hashset_destroy(&items_index);
+	zbx_vector_ptr_clear_ext(&items, (zbx_clean_func_t)lld_item_free_test);
+	zbx_vector_ptr_destroy(&items);
+	zbx_vector_ptr_destroy(&lld_macro_paths);
+	zbx_vector_ptr_destroy(&lld_rows);
+	zbx_vector_ptr_clear_ext(&item_prototypes, (zbx_clean_func_t)lld_item_prototype_free_test);
+	zbx_vector_ptr_destroy(&item_prototypes);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare sql to update discovered items with one statement per     *
+ *          item, as done before prototype fields were updated in groups      *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_items_prepare_updates_per_item(const zbx_vector_ptr_t *item_prototypes,
+		const zbx_vector_ptr_t *items, char **sql, size_t *sql_alloc, size_t *sql_offset)
+{
+	int				i, index;
+	zbx_lld_item_t			*item;
+	zbx_lld_item_prototype_t	*item_prototype;
+	char				*value_esc;
+
+	for (i = 0; i < items->values_num; i++)
+	{
+		item = (zbx_lld_item_t *)items->values[i];
+
+		if (0 == (item->flags & ZBX_FLAG_LLD_ITEM_DISCOVERED) ||
+				0 == (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE))
+		{
+			continue;
+		}
+
+		if (FAIL == (index = zbx_vector_ptr_bsearch(item_prototypes, &item->parent_itemid,
+				ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+		{
+			continue;
+		}
+
+		item_prototype = (zbx_lld_item_prototype_t *)item_prototypes->values[index];
+
+		lld_item_prepare_update(item_prototype, item, item->flags, sql, sql_alloc, sql_offset);
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " where itemid=" ZBX_FS_UI64 ";\n", item->itemid);
+
+		if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_KEY))
+		{
+			value_esc = DBdyn_escape_string(item_prototype->key);
+			zbx_snprintf_alloc(sql, sql_alloc, sql_offset,
+					"update item_discovery set key_='%s' where itemid=" ZBX_FS_UI64 ";\n",
+					value_esc, item->itemid);
+			zbx_free(value_esc);
+		}
+	}
+}
+
+char	*lld_items_prepare_updates_test(const zbx_lld_item_prototype_test_t *prototypes, int prototypes_num,
+		const zbx_lld_item_test_t *items_test, int items_num, int mode)
+{
+	zbx_vector_ptr_t	item_prototypes, items;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+
+	zbx_vector_ptr_create(&item_prototypes);
+	zbx_vector_ptr_create(&items);
+
+	lld_item_prototypes_create_test(prototypes, prototypes_num, &item_prototypes);
+	lld_items_create_test(items_test, items_num, &items);
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "");
+
+	if (ZBX_LLD_ITEM_TEST_PER_ITEM == mode)
+		lld_items_prepare_updates_per_item(&item_prototypes, &items, &sql, &sql_alloc, &sql_offset);
+	else
+		lld_items_prepare_updates(&item_prototypes, &items, &sql, &sql_alloc, &sql_offset);
+
+	zbx_vector_ptr_clear_ext(&items, (zbx_clean_func_t)lld_item_free_test);
+	zbx_vector_ptr_destroy(&items);
+	zbx_vector_ptr_clear_ext(&item_prototypes, (zbx_clean_func_t)lld_item_prototype_free_test);
+	zbx_vector_ptr_destroy(&item_prototypes);
+
+	return sql;
+}
@@ -0,0 +1,61 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef LLD_ITEM_TEST_H
+#define LLD_ITEM_TEST_H
+
+#include "common.h"
+
+/* item prototype fields used by lld item tests */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	const char	*key;
+	const char	*port;
+	const char	*trapper_hosts;
+	unsigned char	type;
+	unsigned char	value_type;
+}
+zbx_lld_item_prototype_test_t;
+
+/* discovered item fields used by lld item tests */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	parent_itemid;
+	const char	*key_proto;
+	const char	*key;
+	const char	*name;
+	const char	*delay;
+	zbx_uint64_t	flags;
+}
+zbx_lld_item_test_t;
+
+/* run the current implementation or the previous per item implementation */
+#define ZBX_LLD_ITEM_TEST_INDEXED	0
+#define ZBX_LLD_ITEM_TEST_PER_ITEM	1
+
+zbx_uint64_t	lld_item_update_flag_test(const char *field);
+void	lld_items_index_test(const zbx_lld_item_prototype_test_t *prototypes, int prototypes_num,
+		const char **rows, int rows_num, const zbx_lld_item_test_t *items, int items_num, int mode,
+		int *items_rows);
+char	*lld_items_prepare_updates_test(const zbx_lld_item_prototype_test_t *prototypes, int prototypes_num,
+		const zbx_lld_item_test_t *items, int items_num, int mode);
+
+#endif
@@ -0,0 +1,154 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "lld_item_test.h"
+
+#define LLD_TEST_MAX	32
+
+static int	lld_read_prototypes(zbx_lld_item_prototype_test_t *prototypes)
+{
+	zbx_mock_handle_t	hprototypes, hprototype;
+	zbx_mock_error_t	err;
+	int			num = 0;
+
+	hprototypes = zbx_mock_get_parameter_handle("in.prototypes");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hprototypes, &hprototype)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item prototype: %s", zbx_mock_error_string(err));
+
+		if (LLD_TEST_MAX == num)
+			fail_msg("too many item prototypes");
+
+		memset(&prototypes[num], 0, sizeof(zbx_lld_item_prototype_test_t));
+		prototypes[num].itemid = zbx_mock_get_object_member_uint64(hprototype, "itemid");
+		prototypes[num].key = zbx_mock_get_object_member_string(hprototype, "key");
+		num++;
+	}
+
+	return num;
+}
+
+static int	lld_read_rows(const char **rows)
+{
+	zbx_mock_handle_t	hrows, hrow;
+	zbx_mock_error_t	err;
+	int			num = 0;
+
+	hrows = zbx_mock_get_parameter_handle("in.rows");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hrows, &hrow)))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hrow, &rows[num])))
+			fail_msg("cannot read lld row: %s", zbx_mock_error_string(err));
+
+		if (LLD_TEST_MAX == ++num)
+			fail_msg("too many lld rows");
+	}
+
+	return num;
+}
+
+static int	lld_read_items(zbx_lld_item_test_t *items)
+{
+	zbx_mock_handle_t	hitems, hitem;
+	zbx_mock_error_t	err;
+	int			num = 0;
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitems, &hitem)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		if (LLD_TEST_MAX == num)
+			fail_msg("too many items");
+
+		memset(&items[num], 0, sizeof(zbx_lld_item_test_t));
+		items[num].itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+		items[num].parent_itemid = zbx_mock_get_object_member_uint64(hitem, "parent");
+		items[num].key_proto = zbx_mock_get_object_member_string(hitem, "key_proto");
+		items[num].key = zbx_mock_get_object_member_string(hitem, "key");
+		num++;
+	}
+
+	return num;
+}
+
+static void	lld_check_rows(const char *path, const char *prefix, const zbx_lld_item_test_t *items, int items_num,
+		const int *items_rows)
+{
+	zbx_mock_handle_t	hrows, hrow;
+	zbx_mock_error_t	err;
+	const char		*row;
+	int			i;
+
+	hrows = zbx_mock_get_parameter_handle(path);
+
+	for (i = 0; i < items_num; i++)
+	{
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(hrows, &hrow)) ||
+				ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hrow, &row)))
+		{
+			fail_msg("cannot read expected lld row of item " ZBX_FS_UI64 ": %s", items[i].itemid,
+					zbx_mock_error_string(err));
+		}
+
+		zbx_mock_assert_int_eq(prefix, atoi(row), items_rows[i]);
+	}
+
+	if (ZBX_MOCK_END_OF_VECTOR != zbx_mock_vector_element(hrows, &hrow))
+		fail_msg("too many expected lld rows");
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_lld_item_prototype_test_t	prototypes[LLD_TEST_MAX];
+	zbx_lld_item_test_t		items[LLD_TEST_MAX];
+	const char			*rows[LLD_TEST_MAX];
+	int				prototypes_num, rows_num, items_num, indexed[LLD_TEST_MAX],
+					per_item[LLD_TEST_MAX];
+
+	ZBX_UNUSED(state);
+
+	prototypes_num = lld_read_prototypes(prototypes);
+	rows_num = lld_read_rows(rows);
+	items_num = lld_read_items(items);
+
+	lld_items_index_test(prototypes, prototypes_num, rows, rows_num, items, items_num,
+			ZBX_LLD_ITEM_TEST_INDEXED, indexed);
+	lld_items_index_test(prototypes, prototypes_num, rows, rows_num, items, items_num,
+			ZBX_LLD_ITEM_TEST_PER_ITEM, per_item);
+
+	lld_check_rows("out.rows", "lld row matched by key index", items, items_num, indexed);
+
+	/* the previous implementation matched duplicate keys depending on the order of already matched rows */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.per_item_rows"))
+		lld_check_rows("out.per_item_rows", "lld row matched per item", items, items_num, per_item);
+	else
+		lld_check_rows("out.rows", "lld row matched per item", items, items_num, per_item);
+}
@@ -0,0 +1,264 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxalgo.h"
+#include "lld_item_test.h"
+
+#define LLD_TEST_MAX	32
+
+static const char	*lld_get_optional_string(zbx_mock_handle_t object, const char *name)
+{
+	zbx_mock_handle_t	hmember;
+	const char		*value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(object, name, &hmember) ||
+			ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &value))
+	{
+		return NULL;
+	}
+
+	return value;
+}
+
+static unsigned char	lld_get_optional_uchar(zbx_mock_handle_t object, const char *name)
+{
+	const char	*value;
+
+	if (NULL == (value = lld_get_optional_string(object, name)))
+		return 0;
+
+	return (unsigned char)atoi(value);
+}
+
+static int	lld_read_prototypes(zbx_lld_item_prototype_test_t *prototypes)
+{
+	zbx_mock_handle_t	hprototypes, hprototype;
+	zbx_mock_error_t	err;
+	int			num = 0;
+
+	hprototypes = zbx_mock_get_parameter_handle("in.prototypes");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hprototypes, &hprototype)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item prototype: %s", zbx_mock_error_string(err));
+
+		if (LLD_TEST_MAX == num)
+			fail_msg("too many item prototypes");
+
+		prototypes[num].itemid = zbx_mock_get_object_member_uint64(hprototype, "itemid");
+		prototypes[num].key = zbx_mock_get_object_member_string(hprototype, "key");
+		prototypes[num].port = lld_get_optional_string(hprototype, "port");
+		prototypes[num].trapper_hosts = lld_get_optional_string(hprototype, "trapper_hosts");
+		prototypes[num].type = lld_get_optional_uchar(hprototype, "type");
+		prototypes[num].value_type = lld_get_optional_uchar(hprototype, "value_type");
+		num++;
+	}
+
+	return num;
+}
+
+static int	lld_read_items(zbx_lld_item_test_t *items)
+{
+	zbx_mock_handle_t	hitems, hitem, hfields, hfield;
+	zbx_mock_error_t	err;
+	const char		*field;
+	zbx_uint64_t		flag;
+	int			num = 0;
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitems, &hitem)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		if (LLD_TEST_MAX == num)
+			fail_msg("too many items");
+
+		items[num].itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+		items[num].parent_itemid = zbx_mock_get_object_member_uint64(hitem, "parent");
+		items[num].key_proto = zbx_mock_get_object_member_string(hitem, "key_proto");
+		items[num].key = zbx_mock_get_object_member_string(hitem, "key");
+		items[num].name = lld_get_optional_string(hitem, "name");
+		items[num].delay = lld_get_optional_string(hitem, "delay");
+		items[num].flags = 0;
+
+		hfields = zbx_mock_get_object_member_handle(hitem, "update");
+
+		while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hfields, &hfield)))
+		{
+			if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hfield, &field)))
+				fail_msg("cannot read updated item field: %s", zbx_mock_error_string(err));
+
+			if (0 == (flag = lld_item_update_flag_test(field)))
+				fail_msg("unknown updated item field \"%s\"", field);
+
+			items[num].flags |= flag;
+		}
+
+		num++;
+	}
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: splits update statements into table, itemid and field assignment  *
+ *          triplets, so updates of single and multiple items can be compared *
+ *                                                                            *
+ * Parameters: sql         - [IN] the update statements                       *
+ *             assignments - [OUT] the sorted assignments                     *
+ *                                                                            *
+ * Return value: the number of update statements                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_split_updates(const char *sql, zbx_vector_str_t *assignments)
+{
+	const char		*ptr, *end, *where, *set, *field;
+	char			*table, *assignment;
+	int			statements = 0, quoted;
+	zbx_vector_str_t	fields;
+	zbx_vector_uint64_t	itemids;
+	zbx_uint64_t		itemid;
+	int			i, j;
+
+	zbx_vector_str_create(&fields);
+	zbx_vector_uint64_create(&itemids);
+
+	for (ptr = sql; '\0' != *ptr; ptr = end + 2)
+	{
+		if (NULL == (end = strstr(ptr, ";\n")))
+			fail_msg("unterminated sql statement \"%s\"", ptr);
+
+		if (0 != strncmp(ptr, "update ", ZBX_CONST_STRLEN("update ")) ||
+				NULL == (set = strstr(ptr, " set ")) || set > end)
+		{
+			fail_msg("unexpected sql statement \"%.*s\"", (int)(end - ptr), ptr);
+		}
+
+		table = zbx_dsprintf(NULL, "%.*s", (int)(set - ptr - ZBX_CONST_STRLEN("update ")),
+				ptr + ZBX_CONST_STRLEN("update "));
+		set += ZBX_CONST_STRLEN(" set ");
+
+		/* split assignments by commas outside of quoted values */
+		for (field = set, quoted = 0, where = set; where < end; where++)
+		{
+			if ('\'' == *where)
+			{
+				quoted = !quoted;
+			}
+			else if (0 == quoted && (',' == *where || 0 == strncmp(where, " where", 6)))
+			{
+				zbx_vector_str_append(&fields, zbx_dsprintf(NULL, "%.*s", (int)(where - field),
+						field));
+
+				if (',' != *where)
+					break;
+
+				field = where + 1;
+			}
+		}
+
+		if (where == end)
+			fail_msg("missing update condition in \"%.*s\"", (int)(end - ptr), ptr);
+
+		/* collect item identifiers from itemid=N or itemid in (N,...) conditions */
+		for (where += ZBX_CONST_STRLEN(" where"); where < end; where++)
+		{
+			if (0 == isdigit((unsigned char)*where))
+				continue;
+
+			for (itemid = 0; where < end && 0 != isdigit((unsigned char)*where); where++)
+				itemid = itemid * 10 + (zbx_uint64_t)(*where - '0');
+
+			zbx_vector_uint64_append(&itemids, itemid);
+		}
+
+		for (i = 0; i < itemids.values_num; i++)
+		{
+			for (j = 0; j < fields.values_num; j++)
+			{
+				assignment = zbx_dsprintf(NULL, "%s " ZBX_FS_UI64 " %s", table, itemids.values[i],
+						fields.values[j]);
+				zbx_vector_str_append(assignments, assignment);
+			}
+		}
+
+		zbx_vector_str_clear_ext(&fields, zbx_str_free);
+		zbx_vector_uint64_clear(&itemids);
+		zbx_free(table);
+		statements++;
+	}
+
+	zbx_vector_str_sort(assignments, ZBX_DEFAULT_STR_COMPARE_FUNC);
+
+	zbx_vector_uint64_destroy(&itemids);
+	zbx_vector_str_destroy(&fields);
+
+	return statements;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_lld_item_prototype_test_t	prototypes[LLD_TEST_MAX];
+	zbx_lld_item_test_t		items[LLD_TEST_MAX];
+	int				prototypes_num, items_num, statements, i;
+	char				*grouped_sql, *per_item_sql;
+	zbx_vector_str_t		grouped, per_item;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_str_create(&grouped);
+	zbx_vector_str_create(&per_item);
+
+	prototypes_num = lld_read_prototypes(prototypes);
+	items_num = lld_read_items(items);
+
+	grouped_sql = lld_items_prepare_updates_test(prototypes, prototypes_num, items, items_num,
+			ZBX_LLD_ITEM_TEST_INDEXED);
+	per_item_sql = lld_items_prepare_updates_test(prototypes, prototypes_num, items, items_num,
+			ZBX_LLD_ITEM_TEST_PER_ITEM);
+
+	statements = lld_split_updates(grouped_sql, &grouped);
+	zbx_mock_assert_int_eq("number of update statements", (int)zbx_mock_get_parameter_uint64("out.statements"),
+			statements);
+
+	lld_split_updates(per_item_sql, &per_item);
+
+	for (i = 0; i < grouped.values_num && i < per_item.values_num; i++)
+		zbx_mock_assert_str_eq("updated item field", per_item.values[i], grouped.values[i]);
+
+	zbx_mock_assert_int_eq("number of updated item fields", per_item.values_num, grouped.values_num);
+
+	zbx_vector_str_clear_ext(&per_item, zbx_str_free);
+	zbx_vector_str_destroy(&per_item);
+	zbx_vector_str_clear_ext(&grouped, zbx_str_free);
+	zbx_vector_str_destroy(&grouped);
+
+	zbx_free(per_item_sql);
+	zbx_free(grouped_sql);
+}
@@ -0,0 +1,212 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxalgo.h"
+#include "../../../src/zabbix_server/lld/lld.h"
+
+extern int	CONFIG_LLD_MAX_SHARDS;
+
+#define LLD_ROW_NONE	0
+#define LLD_ROW_WORKER	1
+#define LLD_ROW_SHARD	2
+
+typedef struct
+{
+	/* the process that made object of each row */
+	unsigned char		*rows;
+	int			rows_num;
+
+	/* the row ranges processed by worker and merged from shards in the order of calls */
+	zbx_vector_uint64_pair_t	processed;
+	zbx_vector_uint64_pair_t	merged;
+
+	/* the first rows of shards that fail */
+	zbx_vector_uint64_t	failed;
+}
+zbx_lld_shard_test_t;
+
+static void	lld_mark_rows(zbx_lld_shard_test_t *test, int row_from, int row_to, unsigned char process)
+{
+	int	i;
+
+	for (i = row_from; i < row_to; i++)
+	{
+		if (LLD_ROW_NONE != test->rows[i])
+			fail_msg("row %d was already made", i);
+
+		test->rows[i] = process;
+	}
+}
+
+static void	lld_shard_process(void *data, int row_from, int row_to)
+{
+	zbx_lld_shard_test_t	*test = (zbx_lld_shard_test_t *)data;
+	zbx_uint64_pair_t	range = {(zbx_uint64_t)row_from, (zbx_uint64_t)row_to};
+
+	zbx_vector_uint64_pair_append(&test->processed, range);
+	lld_mark_rows(test, row_from, row_to, LLD_ROW_WORKER);
+}
+
+/* runs in the forked shard process, the result consists of the made row numbers */
+static void	lld_shard_serialize(void *data, int row_from, int row_to, unsigned char **result,
+		zbx_uint32_t *result_len)
+{
+	zbx_lld_shard_test_t	*test = (zbx_lld_shard_test_t *)data;
+	int			i, *rows;
+
+	if (FAIL != zbx_vector_uint64_search(&test->failed, (zbx_uint64_t)row_from, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		_exit(EXIT_FAILURE);
+
+	*result_len = (zbx_uint32_t)(sizeof(int) * (row_to - row_from));
+	*result = (unsigned char *)zbx_malloc(NULL, *result_len);
+	rows = (int *)*result;
+
+	for (i = row_from; i < row_to; i++)
+		rows[i - row_from] = i;
+}
+
+static void	lld_shard_merge(void *data, int row_from, int row_to, const unsigned char *result,
+		zbx_uint32_t result_len)
+{
+	zbx_lld_shard_test_t	*test = (zbx_lld_shard_test_t *)data;
+	zbx_uint64_pair_t	range = {(zbx_uint64_t)row_from, (zbx_uint64_t)row_to};
+	const int		*rows = (const int *)result;
+	int			i;
+
+	zbx_mock_assert_int_eq("shard result length", (int)(sizeof(int) * (row_to - row_from)), (int)result_len);
+
+	for (i = row_from; i < row_to; i++)
+		zbx_mock_assert_int_eq("shard result row", i, rows[i - row_from]);
+
+	zbx_vector_uint64_pair_append(&test->merged, range);
+	lld_mark_rows(test, row_from, row_to, LLD_ROW_SHARD);
+}
+
+static void	mock_read_ranges(const char *path, zbx_vector_uint64_pair_t *ranges)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hranges, hrange;
+	zbx_uint64_pair_t	range;
+
+	hranges = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hranges, &hrange)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read %s range: %s", path, zbx_mock_error_string(err));
+
+		range.first = zbx_mock_get_object_member_uint64(hrange, "from");
+		range.second = zbx_mock_get_object_member_uint64(hrange, "to");
+		zbx_vector_uint64_pair_append(ranges, range);
+	}
+}
+
+static void	compare_ranges(const char *name, const zbx_vector_uint64_pair_t *expected,
+		const zbx_vector_uint64_pair_t *returned)
+{
+	char	msg[MAX_STRING_LEN];
+	int	i;
+
+	zbx_snprintf(msg, sizeof(msg), "number of %s ranges", name);
+	zbx_mock_assert_int_eq(msg, expected->values_num, returned->values_num);
+
+	for (i = 0; i < expected->values_num; i++)
+	{
+		zbx_snprintf(msg, sizeof(msg), "%s range #%d start", name, i);
+		zbx_mock_assert_uint64_eq(msg, expected->values[i].first, returned->values[i].first);
+
+		zbx_snprintf(msg, sizeof(msg), "%s range #%d end", name, i);
+		zbx_mock_assert_uint64_eq(msg, expected->values[i].second, returned->values[i].second);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Comments: Rows are made by worker callback or by forked shard processes    *
+ *           and merged back. Every row must be made exactly once and the row *
+ *           ranges processed by worker and merged from shards must match the *
+ *           expected ones.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_lld_shard_test_t		test;
+	zbx_vector_uint64_pair_t	processed, merged;
+	zbx_mock_handle_t		hfailed, hrow;
+	zbx_mock_error_t		err;
+	zbx_uint64_t			row;
+	int				i;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_LLD_MAX_SHARDS = (int)zbx_mock_get_parameter_uint64("in.shards");
+
+	test.rows_num = (int)zbx_mock_get_parameter_uint64("in.rows");
+	test.rows = (unsigned char *)zbx_malloc(NULL, (size_t)test.rows_num + 1);
+	memset(test.rows, LLD_ROW_NONE, (size_t)test.rows_num + 1);
+
+	zbx_vector_uint64_pair_create(&test.processed);
+	zbx_vector_uint64_pair_create(&test.merged);
+	zbx_vector_uint64_create(&test.failed);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.failed"))
+	{
+		hfailed = zbx_mock_get_parameter_handle("in.failed");
+
+		while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hfailed, &hrow)))
+		{
+			if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hrow, &row)))
+				fail_msg("Cannot read failed shard row: %s", zbx_mock_error_string(err));
+
+			zbx_vector_uint64_append(&test.failed, row);
+		}
+
+		zbx_vector_uint64_sort(&test.failed, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	lld_make_sharded(test.rows_num, lld_shard_process, lld_shard_serialize, lld_shard_merge, &test);
+
+	for (i = 0; i < test.rows_num; i++)
+	{
+		if (LLD_ROW_NONE == test.rows[i])
+			fail_msg("row %d was not made", i);
+	}
+
+	zbx_vector_uint64_pair_create(&processed);
+	zbx_vector_uint64_pair_create(&merged);
+
+	mock_read_ranges("out.processed", &processed);
+	mock_read_ranges("out.merged", &merged);
+
+	compare_ranges("processed", &processed, &test.processed);
+	compare_ranges("merged", &merged, &test.merged);
+
+	zbx_vector_uint64_pair_destroy(&merged);
+	zbx_vector_uint64_pair_destroy(&processed);
+	zbx_vector_uint64_destroy(&test.failed);
+	zbx_vector_uint64_pair_destroy(&test.merged);
+	zbx_vector_uint64_pair_destroy(&test.processed);
+	zbx_free(test.rows);
+}
@@ -0,0 +1,325 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2022 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "dbcache.h"
+#include "../../../src/zabbix_server/poller/checks_calculated.h"
+
+/* function evaluation counter */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	const char	*func;
+	const char	*params;
+	int		count;
+}
+calc_evaluation_t;
+
+static zbx_vector_ptr_t	evaluations;
+static int		lookups;
+
+void	__wrap_DCconfig_get_items_by_keys(DC_ITEM *items, zbx_host_key_t *keys, int *errcodes, size_t num);
+void	__wrap_DCconfig_clean_items(DC_ITEM *items, int *errcodes, size_t num);
+int	__wrap_evaluate_function(char *value, DC_ITEM *item, const char *function, const char *parameter,
+		const zbx_timespec_t *ts, char **error);
+
+static const char	*calc_get_optional_string(zbx_mock_handle_t object, const char *name)
+{
+	zbx_mock_handle_t	hmember;
+	const char		*value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(object, name, &hmember) ||
+			ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &value))
+	{
+		return NULL;
+	}
+
+	return value;
+}
+
+static unsigned char	calc_get_optional_uint8(zbx_mock_handle_t object, const char *name, unsigned char value)
+{
+	zbx_mock_handle_t	hmember;
+	zbx_uint64_t		value_ui64;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(object, name, &hmember))
+		return value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hmember, &value_ui64))
+		fail_msg("invalid \"%s\" value", name);
+
+	return (unsigned char)value_ui64;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Comments: referenced items are looked up in in.refs list by host and key   *
+ *                                                                            *
+ ******************************************************************************/
+void	__wrap_DCconfig_get_items_by_keys(DC_ITEM *items, zbx_host_key_t *keys, int *errcodes, size_t num)
+{
+	zbx_mock_handle_t	hrefs, href;
+	size_t			i;
+
+	lookups++;
+
+	for (i = 0; i < num; i++)
+	{
+		errcodes[i] = FAIL;
+
+		hrefs = zbx_mock_get_parameter_handle("in.refs");
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrefs, &href))
+		{
+			if (0 != strcmp(zbx_mock_get_object_member_string(href, "host"), keys[i].host) ||
+					0 != strcmp(zbx_mock_get_object_member_string(href, "key"), keys[i].key))
+			{
+				continue;
+			}
+
+			memset(&items[i], 0, sizeof(DC_ITEM));
+			items[i].itemid = zbx_mock_get_object_member_uint64(href, "itemid");
+			zbx_strlcpy(items[i].host.host, keys[i].host, sizeof(items[i].host.host));
+			zbx_strlcpy(items[i].key_orig, keys[i].key, sizeof(items[i].key_orig));
+			items[i].value_type = ITEM_VALUE_TYPE_FLOAT;
+			items[i].status = calc_get_optional_uint8(href, "status", ITEM_STATUS_ACTIVE);
+			items[i].state = calc_get_optional_uint8(href, "state", ITEM_STATE_NORMAL);
+			items[i].host.status = calc_get_optional_uint8(href, "host status", HOST_STATUS_MONITORED);
+			errcodes[i] = SUCCEED;
+			break;
+		}
+	}
+}
+
+void	__wrap_DCconfig_clean_items(DC_ITEM *items, int *errcodes, size_t num)
+{
+	ZBX_UNUSED(items);
+	ZBX_UNUSED(errcodes);
+	ZBX_UNUSED(num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Comments: function values are taken from functions list of the referenced  *
+ *           item, functions without value fail with optional error message   *
+ *                                                                            *
+ ******************************************************************************/
+int	__wrap_evaluate_function(char *value, DC_ITEM *item, const char *function, const char *parameter,
+		const zbx_timespec_t *ts, char **error)
+{
+	zbx_mock_handle_t	hrefs, href, hfunctions, hfunction;
+	calc_evaluation_t	*evaluation;
+	const char		*str;
+	int			i;
+
+	ZBX_UNUSED(ts);
+
+	for (i = 0; i < evaluations.values_num; i++)
+	{
+		evaluation = (calc_evaluation_t *)evaluations.values[i];
+
+		if (evaluation->itemid == item->itemid && 0 == strcmp(evaluation->func, function) &&
+				0 == strcmp(evaluation->params, parameter))
+		{
+			break;
+		}
+	}
+
+	if (i == evaluations.values_num)
+	{
+		evaluation = (calc_evaluation_t *)zbx_malloc(NULL, sizeof(calc_evaluation_t));
+		evaluation->itemid = item->itemid;
+		evaluation->func = function;
+		evaluation->params = parameter;
+		evaluation->count = 0;
+		zbx_vector_ptr_append(&evaluations, evaluation);
+	}
+
+	evaluation->count++;
+
+	hrefs = zbx_mock_get_parameter_handle("in.refs");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrefs, &href))
+	{
+		if (item->itemid != zbx_mock_get_object_member_uint64(href, "itemid"))
+			continue;
+
+		hfunctions = zbx_mock_get_object_member_handle(href, "functions");
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hfunctions, &hfunction))
+		{
+			if (0 != strcmp(zbx_mock_get_object_member_string(hfunction, "func"), function) ||
+					0 != strcmp(zbx_mock_get_object_member_string(hfunction, "params"), parameter))
+			{
+				continue;
+			}
+
+			if (NULL != (str = calc_get_optional_string(hfunction, "value")))
+			{
+				zbx_strlcpy(value, str, MAX_BUFFER_LEN);
+				return SUCCEED;
+			}
+
+			if (NULL != (str = calc_get_optional_string(hfunction, "error")))
+				*error = zbx_strdup(NULL, str);
+
+			return FAIL;
+		}
+	}
+
+	fail_msg("unexpected evaluation of function \"%s(%s)\" of item " ZBX_FS_UI64, function, parameter,
+			item->itemid);
+
+	return FAIL;
+}
+
+static void	calc_check_result(const char *prefix, zbx_mock_handle_t hexpected, int errcode, AGENT_RESULT *result)
+{
+	char	msg[MAX_STRING_LEN];
+
+	zbx_snprintf(msg, sizeof(msg), "%s return value", prefix);
+	zbx_mock_assert_result_eq(msg, zbx_mock_str_to_return_code(
+			zbx_mock_get_object_member_string(hexpected, "return")), errcode);
+
+	if (SUCCEED == errcode)
+	{
+		zbx_snprintf(msg, sizeof(msg), "%s value", prefix);
+
+		if (!ISSET_DBL(result))
+			fail_msg("%s is not set", msg);
+
+		zbx_mock_assert_double_eq(msg, zbx_mock_get_object_member_float(hexpected, "value"), result->dbl);
+	}
+	else
+	{
+		zbx_snprintf(msg, sizeof(msg), "%s error", prefix);
+
+		if (!ISSET_MSG(result))
+			fail_msg("%s is not set", msg);
+
+		zbx_mock_assert_str_eq(msg, zbx_mock_get_object_member_string(hexpected, "error"), result->msg);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Comments: Calculated items are calculated in one batch and then one by one *
+ *           with the same results expected. Every function referenced by the *
+ *           batch must be evaluated exactly once.                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hitems, hitem, hresults, hresult;
+	zbx_mock_error_t	err;
+	DC_ITEM			*items;
+	AGENT_RESULT		*results, result;
+	int			*errcodes, i, num = 0, errcode;
+	char			prefix[MAX_STRING_LEN];
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_ptr_create(&evaluations);
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hitems, &hitem)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read item #%d: %s", num, zbx_mock_error_string(err));
+		num++;
+	}
+
+	items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)num);
+	results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * (size_t)num);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	for (i = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hitems, &hitem); i++)
+	{
+		memset(&items[i], 0, sizeof(DC_ITEM));
+		items[i].itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+		items[i].host.hostid = zbx_mock_get_object_member_uint64(hitem, "hostid");
+		zbx_strlcpy(items[i].host.host, zbx_mock_get_object_member_string(hitem, "host"),
+				sizeof(items[i].host.host));
+		zbx_strlcpy(items[i].key_orig, zbx_mock_get_object_member_string(hitem, "key"),
+				sizeof(items[i].key_orig));
+		items[i].params = zbx_strdup(NULL, zbx_mock_get_object_member_string(hitem, "formula"));
+		items[i].value_type = ITEM_VALUE_TYPE_FLOAT;
+
+		if (NULL != calc_get_optional_string(hitem, "value type"))
+		{
+			items[i].value_type = zbx_mock_str_to_value_type(
+					zbx_mock_get_object_member_string(hitem, "value type"));
+		}
+
+		init_result(&results[i]);
+		errcodes[i] = SUCCEED;
+	}
+
+	get_values_calculated(items, results, errcodes, num);
+
+	zbx_mock_assert_int_eq("configuration cache lookups", 1, lookups);
+	zbx_mock_assert_int_eq("evaluated functions", (int)zbx_mock_get_parameter_uint64("out.evaluations"),
+			evaluations.values_num);
+
+	for (i = 0; i < evaluations.values_num; i++)
+	{
+		calc_evaluation_t	*evaluation = (calc_evaluation_t *)evaluations.values[i];
+
+		zbx_snprintf(prefix, sizeof(prefix), "evaluations of function \"%s(%s)\" of item " ZBX_FS_UI64,
+				evaluation->func, evaluation->params, evaluation->itemid);
+		zbx_mock_assert_int_eq(prefix, 1, evaluation->count);
+	}
+
+	hresults = zbx_mock_get_parameter_handle("out.results");
+
+	for (i = 0; i < num; i++)
+	{
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(hresults, &hresult)))
+			fail_msg("Cannot read result #%d: %s", i + 1, zbx_mock_error_string(err));
+
+		zbx_snprintf(prefix, sizeof(prefix), "item #%d batch", i + 1);
+		calc_check_result(prefix, hresult, errcodes[i], &results[i]);
+
+		/* the same item calculated alone must get the same result */
+		init_result(&result);
+		errcode = get_value_calculated(&items[i], &result);
+
+		zbx_snprintf(prefix, sizeof(prefix), "item #%d single", i + 1);
+		calc_check_result(prefix, hresult, errcode, &result);
+
+		free_result(&result);
+		free_result(&results[i]);
+		zbx_free(items[i].params);
+	}
+
+	zbx_free(errcodes);
+	zbx_free(results);
+	zbx_free(items);
+
+	zbx_vector_ptr_clear_ext(&evaluations, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&evaluations);
+}
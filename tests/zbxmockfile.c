@@ -36,6 +36,7 @@
 void	*mock_streams[ZBX_MOCK_MAX_FILES];
 
 static zbx_mock_handle_t	fragments;
+static int			fragments_mocked = 0;
 
 struct zbx_mock_IO_FILE
 {
@@ -53,6 +54,7 @@ int	__wrap___xstat(int ver, const char *pathname, struct stat *buf);
 int	__wrap___fxstat(int __ver, int __fildes, struct stat *__stat_buf);
 
 int	__real_open(const char *path, int oflag, ...);
+ssize_t	__real_read(int fildes, void *buf, size_t nbyte);
 int	__real_stat(const char *path, struct stat *buf);
 int	__real___fxstat(int __ver, int __fildes, struct stat *__stat_buf);
 
@@ -179,6 +181,8 @@ int	__wrap_connect(int socket, __CONST_SOCKADDR_ARG addr, socklen_t address_len)
 	if (ZBX_MOCK_SUCCESS != (error = zbx_mock_in_parameter("fragments", &fragments)))
 		fail_msg("Cannot get fragments handle: %s", zbx_mock_error_string(error));
 
+	fragments_mocked = 1;
+
 	return 0;
 }
 
@@ -196,6 +200,7 @@ int	__wrap_open(const char *path, int oflag, ...)
 	}
 
 	fragments = zbx_mock_get_parameter_handle("in.fragments");
+	fragments_mocked = 1;
 
 	return INT_MAX;
 }
@@ -207,6 +212,8 @@ int	__wrap_open(const char *path, int oflag, ...)
  *           some safeguards must be added to implement pass-through          *
  *           functionality like it's done with open/fxstat etc functions for  *
  *           coverage builds.                                                 *
+ *           Reads are passed through until a mocked connection or file is    *
+ *           opened, so tests can use pipes between forked processes.         *
  *                                                                            *
  ******************************************************************************/
 ssize_t	__wrap_read(int fildes, void *buf, size_t nbyte)
@@ -217,7 +224,8 @@ ssize_t	__wrap_read(int fildes, void *buf, size_t nbyte)
 	zbx_mock_handle_t	fragment;
 	size_t			length;
 
-	ZBX_UNUSED(fildes);
+	if (0 == fragments_mocked)
+		return __real_read(fildes, buf, nbyte);
 
 	if (0 == remaining_length)
 	{